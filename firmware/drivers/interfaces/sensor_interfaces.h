@@ -56,6 +56,37 @@ typedef struct {
     uint16_t sequence;         ///< Sequence number for lost packet detection
 } ppg_sample_t;
 
+/**
+ * @brief Per-sample quality from ADC headroom
+ *
+ * A driver sees one sample at a time, so it scores only what one sample
+ * can show: near-zero counts (no tissue contact) and saturation score 0,
+ * ramping to 100 across the usable range. Perfusion, beat morphology and
+ * motion are scored per block by the pipeline SQI stage.
+ *
+ * @param counts Raw ADC counts
+ * @param full_scale ADC full-scale count (e.g. 0x3FFFF for 18 bits)
+ * @return Quality 0-100
+ */
+static inline uint8_t ppg_sample_quality(uint32_t counts, uint32_t full_scale)
+{
+    uint32_t lo_zero = full_scale / 100;          // ambient only
+    uint32_t lo_full = full_scale / 20;
+    uint32_t hi_full = full_scale - full_scale / 10;
+    uint32_t hi_zero = full_scale - full_scale / 50; // saturated
+
+    if (counts <= lo_zero || counts >= hi_zero) {
+        return 0;
+    }
+    if (counts < lo_full) {
+        return (uint8_t)((uint64_t)(counts - lo_zero) * 100 / (lo_full - lo_zero));
+    }
+    if (counts > hi_full) {
+        return (uint8_t)((uint64_t)(hi_zero - counts) * 100 / (hi_zero - hi_full));
+    }
+    return 100;
+}
+
 /**
  * @brief PPG Sensor Operations Interface
  * Pure C interface for sensor abstraction (equivalent to IPpgSensor)
@@ -40,76 +40,206 @@ typedef enum {
 // Pipeline Data Structures
 // =============================================================================
 
+#define PIPELINE_MAX_CHANNELS       4     ///< Channel rows per buffer (ppg_sample_t.channels)
+
 /**
  * @brief Generic signal data buffer
+ *
+ * A multi-channel buffer holds its channels as rows (struct of arrays):
+ * channel c starts at data + c * stride, so each row is contiguous and
+ * a view of samples [offset, offset + n) is data + offset with the same
+ * stride. channels 0 or 1 is a plain single-channel buffer. Stages that
+ * output samples carry every row; estimators read the rows they document.
+ * Only stages marked multichannel are accepted into multi-row pipelines.
  */
 typedef struct {
-    float* data;                      ///< Signal data array
-    uint32_t length;                  ///< Number of samples
+    float* data;                      ///< Signal data array (row 0)
+    uint32_t length;                  ///< Number of samples (per channel)
     uint32_t sample_rate;             ///< Sample rate in Hz
     uint32_t timestamp_start;         ///< Start timestamp
     float quality_score;              ///< Signal quality (0.0-1.0)
     void* metadata;                   ///< Stage-specific metadata
+    uint32_t channels;                ///< Channel rows (0 or 1: single channel)
+    uint32_t stride;                  ///< Samples from one row to the next
 } signal_buffer_t;
 
+/** Number of channel rows in a buffer */
+#define SIGNAL_CHANNEL_COUNT(buf)   ((buf)->channels > 1 ? (buf)->channels : 1u)
+
+/** First sample of channel row c */
+#define SIGNAL_CHANNEL(buf, c)      ((buf)->data + (c) * (buf)->stride)
+
+#define PIPELINE_STAGE_NAME_MAX     32    ///< Stage and algorithm name bytes, terminator included
+#define PIPELINE_MAX_PARAMS         16    ///< Algorithm parameter slots per stage config
+
 /**
  * @brief Pipeline stage configuration
  */
 typedef struct {
     bool enabled;                     ///< Stage enabled/disabled
-    uint32_t buffer_size;             ///< Required buffer size
-    float parameters[16];             ///< Algorithm parameters
+    uint32_t buffer_size;             ///< Largest output per row (0: never longer than the input)
+    float parameters[PIPELINE_MAX_PARAMS]; ///< Algorithm parameters
     uint32_t parameter_count;         ///< Number of active parameters
-    char algorithm_name[32];          ///< Algorithm identifier
+    char algorithm_name[PIPELINE_STAGE_NAME_MAX]; ///< Algorithm identifier (names the stage at bind)
 } pipeline_stage_config_t;
 
+typedef struct pipeline_stage pipeline_stage_t;
+
+#ifdef CONFIG_PIPELINE_PROFILING
+#define PIPELINE_PROFILE_BUCKETS    72    ///< 4 per octave from 16 to 2^22 ticks
+
+/**
+ * @brief Timing statistics of one stage (or whole blocks) in profiler ticks
+ *
+ * Ticks are CPU cycles on target (DWT) and nanoseconds on host.
+ */
+typedef struct {
+    uint32_t count;                   ///< Executions measured
+    uint32_t min;                     ///< Fastest execution
+    uint32_t max;                     ///< Slowest execution
+    uint32_t last;                    ///< Most recent execution
+    uint64_t total;                   ///< Sum for the average
+    uint32_t histogram[PIPELINE_PROFILE_BUCKETS]; ///< Log-scale histogram for percentiles
+} pipeline_profile_entry_t;
+#endif
+
 /**
  * @brief Pipeline stage operations
+ *
+ * Every operation receives its stage descriptor so one implementation can
+ * back several stage instances (e.g. one canceller per PPG channel).
  */
 typedef struct {
-    bool (*init)(const pipeline_stage_config_t* config);
-    bool (*process)(const signal_buffer_t* input, signal_buffer_t* output);
-    bool (*reset)(void);
-    bool (*update_config)(const pipeline_stage_config_t* config);
-    bool (*get_status)(float* quality, uint32_t* latency_us);
-    void (*cleanup)(void);
+    bool (*init)(pipeline_stage_t* stage, const pipeline_stage_config_t* config);
+    bool (*process)(pipeline_stage_t* stage, const signal_buffer_t* input, signal_buffer_t* output);
+    bool (*reset)(pipeline_stage_t* stage);
+    bool (*update_config)(pipeline_stage_t* stage, const pipeline_stage_config_t* config);
+    bool (*get_status)(pipeline_stage_t* stage, float* quality, uint32_t* latency_us);
+    void (*cleanup)(pipeline_stage_t* stage);
+
+    /** Write the warm state (delays, thresholds, windows); returns bytes, 0 if it does not fit */
+    uint32_t (*save_state)(pipeline_stage_t* stage, void* buffer, uint32_t capacity);
+    /** Resume from save_state() output after a gap in the signal */
+    bool (*restore_state)(pipeline_stage_t* stage, const void* buffer, uint32_t length);
 } pipeline_stage_ops_t;
 
 /**
  * @brief Pipeline stage descriptor
  */
-typedef struct {
+struct pipeline_stage {
     const char* name;                 ///< Stage name
+    char name_buffer[PIPELINE_STAGE_NAME_MAX]; ///< Owns name for bound stages; config swaps leave it alone
     pipeline_stage_type_t type;       ///< Stage type
     pipeline_stage_ops_t* ops;        ///< Operations
-    pipeline_stage_config_t config;   ///< Current configuration
+    pipeline_stage_config_t config;   ///< Active configuration
+    pipeline_stage_config_t pending_config; ///< Next configuration, swapped in at a block boundary
+    volatile uint32_t pending_sequence; ///< Bumped each time pending_config is written
+    uint32_t applied_sequence;        ///< pending_sequence last swapped in
     bool is_adaptive;                 ///< Supports adaptive parameter tuning
-    uint32_t processing_time_us;      ///< Last processing time
-} pipeline_stage_t;
+    bool multichannel;                ///< process() handles several channel rows (set at bind)
+    uint8_t input_count;              ///< Upstream buffers process() reads (set at bind; 0 means one)
+    uint32_t processing_time_us;      ///< Last processing time (CONFIG_PIPELINE_PROFILING)
+    void* context;                    ///< Stage-private algorithm state
+    uint32_t scratch_bytes;           ///< Per-block scratch the stage needs (set at bind)
+    void* scratch;                    ///< Scratch shared by all nodes, set by the pipeline
+#ifdef CONFIG_PIPELINE_PROFILING
+    pipeline_profile_entry_t profile; ///< process() timing (pipeline_profile.h)
+#endif
+};
 
 // =============================================================================
 // Complete Pipeline Definition
 // =============================================================================
 
+#define PIPELINE_MAX_STAGES         8     ///< Maximum stages (graph nodes) per pipeline
+#define PIPELINE_MAX_NODE_INPUTS    3     ///< Maximum upstream edges per node
+#define PIPELINE_MAX_SOURCES        2     ///< Maximum external input streams
+#define PIPELINE_DEFAULT_BLOCK_SIZE 32    ///< Default samples per processing block
+#define PIPELINE_CHECKPOINT_MAX_SIZE 2048 ///< Retained buffer for pipeline_checkpoint()
+
+/** Input reference naming external source n (e.g. Red = 0, IR = 1) */
+#define PIPELINE_SOURCE(n)          ((int8_t)(-1 - (n)))
+#define PIPELINE_IS_SOURCE(ref)     ((ref) < 0)
+#define PIPELINE_SOURCE_INDEX(ref)  ((uint8_t)(-1 - (ref)))
+
+/** Names usable in pipeline_node_desc_t.inputs for the external sources */
+#define PIPELINE_SOURCE_NAME_0      "source0"
+#define PIPELINE_SOURCE_NAME_1      "source1"
+
+/**
+ * @brief Graph node state for one stage
+ *
+ * Nodes with several inputs receive them as a contiguous array of
+ * input_count buffers through the process() input pointer.
+ */
+typedef struct {
+    int8_t inputs[PIPELINE_MAX_NODE_INPUTS]; ///< Upstream node index or PIPELINE_SOURCE(n)
+    uint8_t input_count;              ///< Number of upstream edges
+    uint8_t consumer_count;           ///< Number of downstream edges
+    bool is_output;                   ///< Output is held until the next block
+    int8_t buffer_slot;               ///< Pool slot holding this block's output (-1: none)
+    const signal_buffer_t* output;    ///< Output of the current block
+    uint32_t last_block;              ///< Block sequence of the last execution
+} pipeline_node_t;
+
+/**
+ * @brief Static node description for pipeline_create_graph()
+ */
+typedef struct {
+    pipeline_stage_t* stage;          ///< Stage to run at this node
+    const char* inputs[PIPELINE_MAX_NODE_INPUTS]; ///< Upstream stage names or source names
+    bool is_output;                   ///< Keep output readable after the block
+} pipeline_node_desc_t;
+
 /**
  * @brief Signal processing pipeline
+ *
+ * Stages form a directed acyclic graph: shared preprocessing and filter
+ * nodes fan out to several feature nodes. Intermediate buffers come from
+ * a reference-counted pool, so a buffer is recycled as soon as its last
+ * consumer has run.
  */
 typedef struct {
     pipeline_signal_type_t signal_type;
-    pipeline_stage_t* stages[8];      ///< Processing stages (max 8)
+    pipeline_stage_t* stages[PIPELINE_MAX_STAGES]; ///< Processing stages (max 8)
     uint32_t stage_count;             ///< Number of active stages
     
+    // Graph topology
+    pipeline_node_t nodes[PIPELINE_MAX_STAGES]; ///< Per-stage graph state
+    uint8_t exec_order[PIPELINE_MAX_STAGES];    ///< Topological execution order
+    uint32_t block_sequence;          ///< Current block number
+    
     // Buffers
     signal_buffer_t input_buffer;     ///< Input buffer
-    signal_buffer_t stage_buffers[8]; ///< Intermediate buffers
+    signal_buffer_t stage_buffers[PIPELINE_MAX_STAGES]; ///< Reference-counted buffer pool
+    uint8_t buffer_refs[PIPELINE_MAX_STAGES]; ///< Outstanding consumers per pool slot
+    uint32_t buffer_count;            ///< Pool slots allocated
+    uint32_t block_capacity;          ///< Samples per processing block
+    uint32_t buffer_samples;          ///< Capacity of each pool buffer row (>= block, stage buffer_size)
+    uint32_t channel_count;           ///< Channel rows per pool buffer (1..PIPELINE_MAX_CHANNELS)
+    uint8_t led_slots;                ///< LED slots the channel rows were created for (0: single channel)
+    void* scratch;                    ///< Stage scratch (nodes run one at a time, so shared)
+    uint32_t scratch_bytes;           ///< Size of scratch
     signal_buffer_t output_buffer;    ///< Final output
     
     // Performance metrics
-    uint32_t total_latency_us;        ///< Total processing latency
+    uint32_t total_latency_us;        ///< Last block, all nodes (CONFIG_PIPELINE_PROFILING)
     float overall_quality;            ///< Overall signal quality
     uint32_t samples_processed;       ///< Total samples processed
     uint32_t errors;                  ///< Error count
     
+    // Quality gating
+    pipeline_stage_t* gate_stage;     ///< Stage whose output quality gates feature nodes (NULL: off)
+    float gate_threshold;             ///< Gate closes below this quality
+    bool gate_open;                   ///< Gated nodes run this block
+    uint32_t gated_mask;              ///< Nodes skipped while the gate is closed (bit per node)
+    uint32_t gated_runs;              ///< Gated node executions
+    uint32_t gated_skips;             ///< Gated node executions skipped
+
+#ifdef CONFIG_PIPELINE_PROFILING
+    pipeline_profile_entry_t block_profile; ///< Whole-block timing
+#endif
+    
     // Adaptive tuning
     bool adaptive_tuning;             ///< Enable adaptive parameter tuning
     float target_quality;             ///< Target quality threshold
@@ -160,7 +290,8 @@ typedef struct {
         bool enable_adaptive_filter;  ///< Adaptive filtering
         float correlation_threshold;  ///< IMU-PPG correlation threshold
     } params;
-    signal_buffer_t* imu_buffer;      ///< Reference to IMU data
+    signal_buffer_t* imu_buffer;      ///< Accel reference, x/y/z interleaved in g,
+                                      ///< 3 * length samples aligned to the PPG block
 } ppg_artifact_removal_stage_t;
 
 /**
@@ -218,6 +349,9 @@ typedef struct {
 
 /**
  * @brief Create a new signal processing pipeline
+ *
+ * Takes a static pool slot; stages added later must fit its block size
+ * and arena.
  */
 signal_pipeline_t* pipeline_create(pipeline_signal_type_t signal_type);
 
@@ -226,16 +360,99 @@ signal_pipeline_t* pipeline_create(pipeline_signal_type_t signal_type);
  */
 bool pipeline_add_stage(signal_pipeline_t* pipeline, pipeline_stage_t* stage);
 
+/**
+ * @brief Name a stage at bind: its config's algorithm_name, or fallback if that is empty
+ *
+ * The name is copied into the stage, so a later config swap with another
+ * algorithm_name does not rename it.
+ */
+void pipeline_stage_set_name(pipeline_stage_t* stage, const char* fallback);
+
 /**
  * @brief Remove processing stage from pipeline
  */
 bool pipeline_remove_stage(signal_pipeline_t* pipeline, const char* stage_name);
 
+/**
+ * @brief Create a pipeline from a node graph
+ *
+ * The topology is validated here: every input must name a stage in the
+ * table or a source, and the graph must be acyclic and within the node and
+ * edge limits. Buffers for the peak number of live intermediate
+ * results, each sized for the largest stage buffer_size, and the stage
+ * scratch are reserved once from a static pool slot (pipeline_pool.h).
+ *
+ * @param signal_type Signal type
+ * @param nodes Node descriptions
+ * @param node_count Number of nodes
+ * @param block_size Samples per processing block (0 for default)
+ * @return Pipeline, or NULL if the topology is invalid
+ */
+signal_pipeline_t* pipeline_create_graph(pipeline_signal_type_t signal_type,
+                                         const pipeline_node_desc_t* nodes,
+                                         uint32_t node_count,
+                                         uint32_t block_size);
+
+/**
+ * @brief Create a pipeline that carries every active LED slot
+ *
+ * As pipeline_create_graph(), with one channel row per bit set in
+ * led_slots (ppg_sample_t.led_slots, lowest slot in row 0). Pool buffers
+ * hold all rows, so stages run each block of green, red and IR through
+ * one node instead of one pipeline per wavelength. Sources may carry
+ * fewer rows than the pipeline, never more. With more than one row,
+ * every stage must be multichannel.
+ *
+ * @param led_slots Active LED slots; at most PIPELINE_MAX_CHANNELS bits
+ * @return Pipeline, or NULL if the topology, slot mask or a stage is invalid
+ */
+signal_pipeline_t* pipeline_create_multichannel(pipeline_signal_type_t signal_type,
+                                                const pipeline_node_desc_t* nodes,
+                                                uint32_t node_count,
+                                                uint32_t block_size,
+                                                uint8_t led_slots);
+
+/**
+ * @brief Number of channel rows for an LED slot mask
+ */
+uint32_t pipeline_channels_from_slots(uint8_t led_slots);
+
+/**
+ * @brief Transpose driver samples into channel rows
+ *
+ * Copies ppg_sample_t.channels[] of every active slot into its own row
+ * of data (row r at data + r * stride), lowest slot first.
+ *
+ * @param samples Driver samples (array of structs)
+ * @param count Number of samples (<= stride)
+ * @param led_slots Slots to extract
+ * @param data Destination rows
+ * @param stride Row pitch in samples
+ * @return Number of rows written
+ */
+uint32_t pipeline_deinterleave_samples(const ppg_sample_t* samples, uint32_t count,
+                                       uint8_t led_slots, float* data, uint32_t stride);
+
 /**
  * @brief Process signal through complete pipeline
  */
 bool pipeline_process(signal_pipeline_t* pipeline, const signal_buffer_t* input);
 
+/**
+ * @brief Process one block of several time-aligned source streams
+ * @param pipeline Pipeline
+ * @param sources Array of source_count buffers (e.g. Red, IR)
+ * @param source_count Number of sources
+ */
+bool pipeline_process_sources(signal_pipeline_t* pipeline,
+                              const signal_buffer_t* sources,
+                              uint32_t source_count);
+
+/**
+ * @brief Get output of a named node from the last processed block
+ */
+const signal_buffer_t* pipeline_get_node_output(signal_pipeline_t* pipeline, const char* stage_name);
+
 /**
  * @brief Get pipeline output
  */
@@ -246,8 +463,51 @@ const signal_buffer_t* pipeline_get_output(signal_pipeline_t* pipeline);
  */
 bool pipeline_reset(signal_pipeline_t* pipeline);
 
+/**
+ * @brief Serialize warm stage state before sleep
+ *
+ * Every stage with save_state() writes a record tagged with its name;
+ * the buffer is meant to live in retained RAM (PIPELINE_RETAINED) so the
+ * pipeline can resume warm instead of re-converging filters, thresholds
+ * and HR windows on wake.
+ *
+ * @return Bytes written, 0 if the buffer is too small
+ */
+uint32_t pipeline_checkpoint(signal_pipeline_t* pipeline, void* buffer, uint32_t capacity);
+
+/**
+ * @brief Reset the pipeline and resume stages from a checkpoint
+ *
+ * The checkpoint is rejected whole if its magic, length or checksum do
+ * not match (e.g. retained RAM after a cold boot). Stages without a
+ * record, or whose record does not fit their current configuration,
+ * start cold. Beats and intervals never span the sleep gap.
+ *
+ * @return true if the checkpoint was valid
+ */
+bool pipeline_restore(signal_pipeline_t* pipeline, const void* buffer, uint32_t length);
+
+/**
+ * @brief Stage a new configuration for one stage
+ *
+ * Safe to call from another thread (e.g. a BLE write handler). The
+ * configuration is held as pending and swapped in at the start of the
+ * next block, before any node runs, so every staged change lands on the
+ * same block boundary. Stages apply it through update_config() and keep
+ * their filter and detector state, so the output has no gap. A second
+ * request before the boundary replaces the first.
+ */
+bool pipeline_request_config(signal_pipeline_t* pipeline,
+                             const char* stage_name,
+                             const pipeline_stage_config_t* config);
+
 /**
  * @brief Update pipeline configuration
+ *
+ * Format: "stage:index=value,index=value;stage:enabled=0". Indices are
+ * pipeline_stage_config_t.parameters entries; unnamed parameters keep
+ * their current values. The whole string is checked before anything is
+ * staged, then each stage is staged with pipeline_request_config().
  */
 bool pipeline_update_config(signal_pipeline_t* pipeline, const char* config_string);
 
@@ -259,6 +519,26 @@ bool pipeline_get_metrics(signal_pipeline_t* pipeline,
                          float* quality, 
                          uint32_t* throughput);
 
+/**
+ * @brief Skip feature and algorithm nodes on poor-quality blocks
+ *
+ * Feature-extract and algorithm nodes downstream of the named stage (and
+ * everything they feed) are skipped for blocks whose output quality_score
+ * from that stage is below threshold. Skipped nodes publish no output for
+ * the block and are reset when the gate reopens, since their input history
+ * has a gap.
+ *
+ * @param pipeline Pipeline
+ * @param stage_name Gating stage (e.g. the SQI node), NULL to disable
+ * @param threshold Minimum quality (0-1) to run gated nodes
+ */
+bool pipeline_set_quality_gate(signal_pipeline_t* pipeline, const char* stage_name, float threshold);
+
+/**
+ * @brief Gated node executions run and skipped since create/reset
+ */
+bool pipeline_get_gate_stats(const signal_pipeline_t* pipeline, uint32_t* runs, uint32_t* skipped);
+
 /**
  * @brief Enable/disable adaptive tuning
  */
@@ -282,9 +282,10 @@ static int max30101_read_fifo(ppg_sample_t* samples, int max_samples)
         samples[i].led_slots = 0x03;                 // Red + IR active
         samples[i].temperature = max30101_data.last_temperature;
         
-        // Simple signal quality based on amplitude
-        uint32_t amplitude = (red_raw > ir_raw) ? red_raw - ir_raw : ir_raw - red_raw;
-        samples[i].quality = (uint8_t)MIN(100, amplitude / 1000);
+        // Contact and headroom of the weaker channel; the SQI stage scores the pulse
+        uint8_t q_red = ppg_sample_quality(red_raw, 0x3FFFF);
+        uint8_t q_ir = ppg_sample_quality(ir_raw, 0x3FFFF);
+        samples[i].quality = MIN(q_red, q_ir);
         
         num_samples++;
     }
@@ -331,6 +331,11 @@ int max86141_read_fifo(max86141_device_t *dev, max86141_sample_t *samples,
         samples[i].led6 = (fifo_data[15] << 16) | (fifo_data[16] << 8) | fifo_data[17];
         samples[i].led6 &= 0x03FFFF;
         
+        /* Quality needs raw counts: calibration rescales them */
+        uint8_t q_red = ppg_sample_quality(samples[i].led1, 0x03FFFF);
+        uint8_t q_ir = ppg_sample_quality(samples[i].led2, 0x03FFFF);
+        samples[i].quality = q_red < q_ir ? q_red : q_ir;
+        
         /* Apply calibration */
         samples[i].led1 = max86141_convert_raw_value(samples[i].led1, dev->config.adc_range, dev->gain_correction[0]);
         samples[i].led2 = max86141_convert_raw_value(samples[i].led2, dev->config.adc_range, dev->gain_correction[1]);
@@ -465,7 +470,7 @@ static int max86141_sensor_read(void *dev_ctx, sensor_data_t *data)
     data->ppg.blue = sample.led4;
     data->temperature = sample.temperature;
     data->timestamp = sample.timestamp;
-    data->quality = 100; /* TODO: Calculate signal quality */
+    data->quality = sample.quality;
     
     return 0;
 }
@@ -196,6 +196,7 @@ typedef struct {
     float temperature;               /* Temperature in Celsius */
     uint64_t timestamp;              /* Sample timestamp */
     uint8_t active_leds;             /* Bitmask of active LEDs */
+    uint8_t quality;                 /* Contact/headroom of Red and IR (0-100) */
 } max86141_sample_t;
 
 /* Function Prototypes */
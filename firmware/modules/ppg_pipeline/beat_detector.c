@@ -0,0 +1,287 @@
+/*
+ * Beat Detector Implementation
+ *
+ * Streaming turning-point peak detector on band-passed PPG. The hysteresis
+ * follows the running signal level, so no calibration of the optical gain
+ * is needed and the per-sample cost is constant.
+ */
+
+#include "beat_detector.h"
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+
+#define LEVEL_TIME_CONSTANT_S   2.0f
+#define PEAK_TO_PEAK_PER_LEVEL  3.14159265f  /* p-p / mean|x| of a sinusoid */
+
+/* ==== PRIVATE FUNCTIONS ==== */
+
+static bool config_is_valid(const beat_detector_config_t* config)
+{
+    return config->min_interval_ms > 0.0f &&
+           config->max_interval_ms > config->min_interval_ms &&
+           config->hysteresis > 0.0f && config->hysteresis < 1.0f &&
+           config->hr_window > 0 &&
+           config->hr_window <= BEAT_DETECTOR_MAX_WINDOW;
+}
+
+static float parabolic_offset(float prev, float peak, float next)
+{
+    float denom = prev - 2.0f * peak + next;
+
+    if (denom >= 0.0f) {
+        return 0.0f;
+    }
+
+    float offset = 0.5f * (prev - next) / denom;
+    if (offset > 0.5f) {
+        offset = 0.5f;
+    } else if (offset < -0.5f) {
+        offset = -0.5f;
+    }
+    return offset;
+}
+
+/** HR from the median of the intervals in the window */
+static void update_hr(beat_detector_t* bd)
+{
+    float sorted[BEAT_DETECTOR_MAX_WINDOW];
+
+    // Median of a handful of intervals: insertion sort, once per beat
+    uint32_t n = bd->interval_count;
+    if (n == 0) {
+        return;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        float v = bd->intervals[i];
+        uint32_t j = i;
+        while (j > 0 && sorted[j - 1] > v) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = v;
+    }
+
+    float median = (n & 1) ? sorted[n / 2] : 0.5f * (sorted[n / 2 - 1] + sorted[n / 2]);
+    bd->hr_bpm = 60000.0f / median;
+}
+
+static void push_interval(beat_detector_t* bd, float interval_ms)
+{
+    uint32_t window = bd->config.hr_window;
+
+    bd->intervals[bd->interval_pos] = interval_ms;
+    bd->interval_pos = (bd->interval_pos + 1) % window;
+    if (bd->interval_count < window) {
+        bd->interval_count++;
+    }
+    update_hr(bd);
+}
+
+/* ==== PUBLIC FUNCTIONS ==== */
+
+bool beat_detector_init(beat_detector_t* bd, const beat_detector_config_t* config, uint32_t sample_rate)
+{
+    if (!bd || sample_rate == 0) {
+        return false;
+    }
+
+    const beat_detector_config_t* cfg = config ? config : &BEAT_DETECTOR_DEFAULT_CONFIG;
+    if (!config_is_valid(cfg)) {
+        return false;
+    }
+
+    memset(bd, 0, sizeof(beat_detector_t));
+    bd->config = *cfg;
+    bd->sample_rate = sample_rate;
+    bd->level_alpha = 1.0f / (LEVEL_TIME_CONSTANT_S * (float)sample_rate);
+    bd->rising = true;
+
+    return true;
+}
+
+void beat_detector_reset(beat_detector_t* bd)
+{
+    if (!bd) {
+        return;
+    }
+
+    beat_detector_config_t config = bd->config;
+    uint32_t sample_rate = bd->sample_rate;
+
+    beat_detector_init(bd, &config, sample_rate);
+}
+
+bool beat_detector_set_config(beat_detector_t* bd, const beat_detector_config_t* config)
+{
+    float recent[BEAT_DETECTOR_MAX_WINDOW];
+
+    if (!bd || !config || !config_is_valid(config)) {
+        return false;
+    }
+
+    // Re-pack the newest intervals (oldest first) for the new window length
+    uint32_t old_window = bd->config.hr_window;
+    uint32_t n = bd->interval_count < config->hr_window ? bd->interval_count : config->hr_window;
+    for (uint32_t i = 0; i < n; i++) {
+        recent[i] = bd->intervals[(bd->interval_pos + old_window - n + i) % old_window];
+    }
+    memcpy(bd->intervals, recent, n * sizeof(float));
+
+    bd->config = *config;
+    bd->interval_count = n;
+    bd->interval_pos = n % config->hr_window;
+    update_hr(bd);
+    return true;
+}
+
+uint32_t beat_detector_snapshot(const beat_detector_t* bd, beat_detector_snapshot_t* snapshot)
+{
+    if (!bd || !snapshot) {
+        return 0;
+    }
+
+    uint32_t window = bd->config.hr_window;
+    uint32_t n = bd->interval_count;
+    for (uint32_t i = 0; i < n; i++) {
+        snapshot->intervals[i] = bd->intervals[(bd->interval_pos + window - n + i) % window];
+    }
+    snapshot->level = bd->level;
+    snapshot->trough = bd->trough;
+    snapshot->interval_count = n;
+
+    return (uint32_t)(offsetof(beat_detector_snapshot_t, intervals) + n * sizeof(float));
+}
+
+bool beat_detector_resume(beat_detector_t* bd, const beat_detector_snapshot_t* snapshot)
+{
+    if (!bd || !snapshot || bd->sample_rate == 0 ||
+        snapshot->interval_count > BEAT_DETECTOR_MAX_WINDOW) {
+        return false;
+    }
+
+    beat_detector_reset(bd);
+
+    // Newest intervals that fit the current window, ring starting at 0
+    uint32_t n = snapshot->interval_count < bd->config.hr_window ?
+                 snapshot->interval_count : bd->config.hr_window;
+    memcpy(bd->intervals, &snapshot->intervals[snapshot->interval_count - n], n * sizeof(float));
+    bd->interval_count = n;
+    bd->interval_pos = n % bd->config.hr_window;
+    bd->level = snapshot->level;
+    bd->trough = snapshot->trough;
+    return true;
+}
+
+uint32_t beat_detector_process(beat_detector_t* bd,
+                               const float* samples,
+                               uint32_t length,
+                               ppg_beat_t* beats,
+                               uint32_t max_beats)
+{
+    if (!bd || !samples) {
+        return 0;
+    }
+
+    const float ms_per_sample = 1000.0f / (float)bd->sample_rate;
+    const float min_interval = bd->config.min_interval_ms / ms_per_sample;
+    const float max_interval = bd->config.max_interval_ms / ms_per_sample;
+    uint32_t found = 0;
+
+    for (uint32_t n = 0; n < length; n++) {
+        float x = samples[n];
+        uint32_t index = bd->sample_index++;
+
+        bd->level += bd->level_alpha * (fabsf(x) - bd->level);
+        float hysteresis = bd->config.hysteresis * PEAK_TO_PEAK_PER_LEVEL * bd->level;
+
+        if (bd->need_next) {
+            bd->extreme_next = x;
+            bd->need_next = false;
+        }
+
+        if (bd->rising) {
+            if (x > bd->extreme) {
+                bd->extreme = x;
+                bd->extreme_index = index;
+                bd->extreme_prev = bd->last_sample;
+                bd->need_next = true;
+            } else if (x < bd->extreme - hysteresis) {
+                float amplitude = bd->extreme - bd->trough;
+                float offset = parabolic_offset(bd->extreme_prev, bd->extreme, bd->extreme_next);
+                float position = (float)bd->extreme_index + offset;
+                float interval = bd->have_last_peak ? position - bd->last_peak_pos : 0.0f;
+
+                // Secondary peaks inside the refractory period are not beats
+                if (amplitude > hysteresis && (!bd->have_last_peak || interval >= min_interval)) {
+                    float interval_ms = 0.0f;
+
+                    if (bd->have_last_peak && interval <= max_interval) {
+                        interval_ms = interval * ms_per_sample;
+                        push_interval(bd, interval_ms);
+                    }
+
+                    if (beats && found < max_beats) {
+                        ppg_beat_t* beat = &beats[found];
+                        beat->sample_index = bd->extreme_index;
+                        beat->peak_offset = offset;
+                        beat->peak = bd->extreme;
+                        beat->trough = bd->trough;
+                        beat->amplitude = amplitude;
+                        beat->interval_ms = interval_ms;
+                        found++;
+                    }
+
+                    bd->have_last_peak = true;
+                    bd->last_peak_pos = position;
+                    bd->beat_count++;
+                }
+
+                bd->rising = false;
+                bd->extreme = x;
+                bd->extreme_index = index;
+            }
+        } else {
+            if (x < bd->extreme) {
+                bd->extreme = x;
+                bd->extreme_index = index;
+            } else if (x > bd->extreme + hysteresis) {
+                bd->trough = bd->extreme;
+                bd->rising = true;
+                bd->extreme = x;
+                bd->extreme_index = index;
+                bd->extreme_prev = bd->last_sample;
+                bd->need_next = true;
+            }
+        }
+
+        bd->last_sample = x;
+    }
+
+    return found;
+}
+
+float beat_detector_get_hr(const beat_detector_t* bd)
+{
+    return bd ? bd->hr_bpm : 0.0f;
+}
+
+float beat_detector_get_rmssd(const beat_detector_t* bd)
+{
+    if (!bd || bd->interval_count < 2) {
+        return 0.0f;
+    }
+
+    uint32_t window = bd->config.hr_window;
+    uint32_t n = bd->interval_count;
+    uint32_t start = (bd->interval_pos + window - n) % window;
+    float sum_sq = 0.0f;
+
+    for (uint32_t i = 1; i < n; i++) {
+        float a = bd->intervals[(start + i - 1) % window];
+        float b = bd->intervals[(start + i) % window];
+        sum_sq += (b - a) * (b - a);
+    }
+
+    return sqrtf(sum_sq / (float)(n - 1));
+}
@@ -0,0 +1,178 @@
+#ifndef BEAT_DETECTOR_H
+#define BEAT_DETECTOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @file beat_detector.h
+ * @brief Streaming systolic peak detector for band-passed PPG
+ *
+ * Turning-point detector with hysteresis scaled to the running signal
+ * level and a refractory period. Each confirmed beat carries its peak,
+ * preceding trough and peak-to-peak interval, which HR, SpO2 and
+ * respiration stages all build on.
+ */
+
+// =============================================================================
+// Limits
+// =============================================================================
+
+#define BEAT_DETECTOR_MAX_WINDOW     16    ///< Maximum intervals kept for HR/RMSSD
+
+// =============================================================================
+// Data Structures
+// =============================================================================
+
+/**
+ * @brief One detected heartbeat
+ */
+typedef struct {
+    uint32_t sample_index;            ///< Absolute sample index of the systolic peak
+    float peak_offset;                ///< Sub-sample peak position (-0.5..0.5)
+    float peak;                       ///< Peak value
+    float trough;                     ///< Preceding diastolic minimum
+    float amplitude;                  ///< Peak minus trough
+    float interval_ms;                ///< Peak-to-peak interval (0 after a gap)
+} ppg_beat_t;
+
+/**
+ * @brief Beats detected within one processing block
+ *
+ * Published by the feature stage through signal_buffer_t.metadata.
+ */
+typedef struct {
+    const ppg_beat_t* beats;          ///< Beats confirmed during the block
+    uint32_t count;                   ///< Number of beats
+    uint32_t block_start_index;       ///< Detector sample index of the block's first sample
+    float hr_bpm;                     ///< Current HR estimate (0 if unknown)
+} ppg_beat_block_t;
+
+/**
+ * @brief Detector configuration
+ */
+typedef struct {
+    float min_interval_ms;            ///< Refractory period after a beat
+    float max_interval_ms;            ///< Longer gaps do not produce an interval
+    float hysteresis;                 ///< Turning-point threshold, fraction of peak-to-peak level
+    uint32_t hr_window;               ///< Intervals in the HR median (1..BEAT_DETECTOR_MAX_WINDOW)
+} beat_detector_config_t;
+
+/**
+ * @brief Detector state
+ */
+typedef struct {
+    beat_detector_config_t config;
+    uint32_t sample_rate;             ///< Input sample rate in Hz
+    uint32_t sample_index;            ///< Absolute index of the next sample
+
+    float level;                      ///< Running mean of |x|
+    float level_alpha;                ///< Level smoothing (~2 s time constant)
+    bool rising;                      ///< Searching for a peak (else a trough)
+    float extreme;                    ///< Current max (rising) or min (falling)
+    uint32_t extreme_index;           ///< Sample index of extreme
+    float extreme_prev;               ///< Sample before the extreme
+    float extreme_next;               ///< Sample after the extreme
+    bool need_next;                   ///< extreme_next not yet captured
+    float last_sample;                ///< x[n-1]
+    float trough;                     ///< Last confirmed trough
+
+    bool have_last_peak;              ///< last_peak_pos is valid
+    float last_peak_pos;              ///< Sub-sample position of the previous beat
+
+    float intervals[BEAT_DETECTOR_MAX_WINDOW]; ///< Recent intervals in ms (ring)
+    uint32_t interval_pos;            ///< Next ring write position
+    uint32_t interval_count;          ///< Valid intervals in ring
+    float hr_bpm;                     ///< Median-interval HR
+    uint32_t beat_count;              ///< Total beats detected
+} beat_detector_t;
+
+/**
+ * @brief Detector state worth keeping across a gap in the signal
+ *
+ * Level and trough seed the thresholds, intervals (oldest first) the HR
+ * median. Peak search and sample positions are not kept: no interval is
+ * ever measured across the gap.
+ */
+typedef struct {
+    float level;                      ///< Running mean of |x|
+    float trough;                     ///< Last confirmed trough
+    uint32_t interval_count;          ///< Valid entries in intervals
+    float intervals[BEAT_DETECTOR_MAX_WINDOW]; ///< Recent intervals in ms, oldest first
+} beat_detector_snapshot_t;
+
+// Resting to sprint HR: 220 bpm refractory, 2 s gap, hysteresis at 30%
+// of the peak-to-peak level rejects the dicrotic notch.
+static const beat_detector_config_t BEAT_DETECTOR_DEFAULT_CONFIG = {
+    .min_interval_ms = 270.0f,
+    .max_interval_ms = 2000.0f,
+    .hysteresis = 0.3f,
+    .hr_window = 8
+};
+
+// =============================================================================
+// Detector Functions
+// =============================================================================
+
+/**
+ * @brief Initialize detector
+ * @param bd Detector instance
+ * @param config Configuration (NULL for BEAT_DETECTOR_DEFAULT_CONFIG)
+ * @param sample_rate Input sample rate in Hz
+ * @return true if the configuration is valid
+ */
+bool beat_detector_init(beat_detector_t* bd, const beat_detector_config_t* config, uint32_t sample_rate);
+
+/**
+ * @brief Clear detection state, keep configuration and sample rate
+ */
+void beat_detector_reset(beat_detector_t* bd);
+
+/**
+ * @brief Change thresholds and HR window without losing detection state
+ *
+ * The newest intervals that fit the new window are kept, so HR stays
+ * valid across the change.
+ */
+bool beat_detector_set_config(beat_detector_t* bd, const beat_detector_config_t* config);
+
+/**
+ * @brief Capture thresholds and interval history
+ * @return Snapshot bytes in use (intervals beyond interval_count omitted)
+ */
+uint32_t beat_detector_snapshot(const beat_detector_t* bd, beat_detector_snapshot_t* snapshot);
+
+/**
+ * @brief Resume an initialized detector from a snapshot
+ *
+ * HR reads 0 until the first new interval, which is then combined with
+ * the restored history.
+ */
+bool beat_detector_resume(beat_detector_t* bd, const beat_detector_snapshot_t* snapshot);
+
+/**
+ * @brief Run detector over one block of band-passed PPG
+ * @param bd Detector instance
+ * @param samples Input samples
+ * @param length Number of samples
+ * @param beats Output array for beats confirmed in this block
+ * @param max_beats Capacity of beats
+ * @return Number of beats written
+ */
+uint32_t beat_detector_process(beat_detector_t* bd,
+                               const float* samples,
+                               uint32_t length,
+                               ppg_beat_t* beats,
+                               uint32_t max_beats);
+
+/**
+ * @brief Heart rate from the median of recent intervals (0 if unknown)
+ */
+float beat_detector_get_hr(const beat_detector_t* bd);
+
+/**
+ * @brief RMSSD of recent consecutive intervals in ms (0 if unknown)
+ */
+float beat_detector_get_rmssd(const beat_detector_t* bd);
+
+#endif // BEAT_DETECTOR_H
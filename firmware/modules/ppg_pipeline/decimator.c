@@ -0,0 +1,298 @@
+/*
+ * Polyphase FIR Decimator Implementation
+ *
+ * Input sample n belongs to phase p = -n mod M. Phases arrive M-1, ...,
+ * 1, 0 within each output period; each sample is pushed onto its phase's
+ * delay line and dotted with that phase's sub-filter into the running
+ * output, which is emitted when phase 0 arrives.
+ */
+
+#include "decimator.h"
+#include <string.h>
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* ==== PRIVATE FUNCTIONS ==== */
+
+static bool config_is_valid(const decimator_config_t* config)
+{
+    return config->factor >= 1 && config->factor <= DECIMATOR_MAX_FACTOR &&
+           config->taps_per_phase >= 1 &&
+           config->factor * config->taps_per_phase <= DECIMATOR_MAX_TAPS &&
+           config->cutoff > 0.0f && config->cutoff <= 1.0f;
+}
+
+/** Hamming-windowed sinc low-pass with unity DC gain, stored per phase */
+static void design_filter(decimator_t* dec)
+{
+    uint32_t m = dec->config.factor;
+    uint32_t k = dec->config.taps_per_phase;
+    uint32_t taps = m * k;
+    float fc = dec->config.cutoff * 0.5f / (float)m;
+    float center = 0.5f * (float)(taps - 1);
+    float h[DECIMATOR_MAX_TAPS];
+    float sum = 0.0f;
+
+    for (uint32_t i = 0; i < taps; i++) {
+        float x = (float)i - center;
+        float sinc = fabsf(x) < 1e-6f ? 2.0f * fc : sinf(2.0f * (float)M_PI * fc * x) / ((float)M_PI * x);
+        float window = taps > 1 ? 0.54f - 0.46f * cosf(2.0f * (float)M_PI * (float)i / (float)(taps - 1)) : 1.0f;
+        h[i] = sinc * window;
+        sum += h[i];
+    }
+
+    for (uint32_t p = 0; p < m; p++) {
+        for (uint32_t j = 0; j < k; j++) {
+            dec->coeffs[p * k + (k - 1 - j)] = h[j * m + p] / sum;
+        }
+    }
+}
+
+/* ==== PUBLIC FUNCTIONS ==== */
+
+bool decimator_init(decimator_t* dec, const decimator_config_t* config)
+{
+    if (!dec) {
+        return false;
+    }
+
+    const decimator_config_t* cfg = config ? config : &DECIMATOR_DEFAULT_CONFIG;
+    if (!config_is_valid(cfg)) {
+        return false;
+    }
+
+    memset(dec, 0, sizeof(decimator_t));
+    dec->config = *cfg;
+    design_filter(dec);
+    return true;
+}
+
+void decimator_reset(decimator_t* dec)
+{
+    if (!dec) {
+        return;
+    }
+
+    memset(dec->delay, 0, sizeof(dec->delay));
+    memset(dec->acc, 0, sizeof(dec->acc));
+    dec->delay_pos = 0;
+    dec->phase = 0;
+    dec->samples_in = 0;
+    dec->samples_out = 0;
+}
+
+uint32_t decimator_process(decimator_t* dec, const float* input, uint32_t length, float* output)
+{
+    return decimator_process_rows(dec, input, 0, output, 0, 1, length);
+}
+
+uint32_t decimator_process_rows(decimator_t* dec, const float* input, uint32_t input_stride,
+                                float* output, uint32_t output_stride, uint32_t rows, uint32_t length)
+{
+    uint32_t produced = 0;
+    uint32_t phase = 0;
+    uint32_t delay_pos = 0;
+
+    if (!dec || !input || !output || rows == 0 || rows > PIPELINE_MAX_CHANNELS) {
+        return 0;
+    }
+
+    uint32_t m = dec->config.factor;
+    uint32_t k = dec->config.taps_per_phase;
+
+    // Every row starts from the shared phase and ends on the same one
+    for (uint32_t r = 0; r < rows; r++) {
+        const float* x = input + r * input_stride;
+        float* y = output + r * output_stride;
+        float acc = dec->acc[r];
+
+        phase = dec->phase;
+        delay_pos = dec->delay_pos;
+        produced = 0;
+
+        for (uint32_t n = 0; n < length; n++) {
+            float* line = &dec->delay[r][2 * k * phase];
+            const float* c = &dec->coeffs[k * phase];
+
+            // Mirrored line: line[pos + 1 .. pos + K] is oldest..newest
+            line[delay_pos] = x[n];
+            line[delay_pos + k] = x[n];
+
+            const float* window = &line[delay_pos + 1];
+            for (uint32_t j = 0; j < k; j++) {
+                acc += c[j] * window[j];
+            }
+
+            if (phase == 0) {
+                y[produced++] = acc;
+                acc = 0.0f;
+                phase = m - 1;
+                delay_pos = (delay_pos + 1) % k;
+            } else {
+                phase--;
+            }
+        }
+        dec->acc[r] = acc;
+    }
+
+    dec->phase = phase;
+    dec->delay_pos = delay_pos;
+    dec->samples_in += length;
+    dec->samples_out += produced;
+    return produced;
+}
+
+/* ==== PIPELINE STAGE BINDING ==== */
+
+static void stage_apply_config(decimator_config_t* cfg, const pipeline_stage_config_t* config)
+{
+    *cfg = DECIMATOR_DEFAULT_CONFIG;
+
+    if (config->parameter_count > DECIMATOR_PARAM_FACTOR && config->parameters[DECIMATOR_PARAM_FACTOR] > 0.0f) {
+        cfg->factor = (uint32_t)config->parameters[DECIMATOR_PARAM_FACTOR];
+        // Keep the default filter length where it fits the larger factor
+        if (cfg->factor * cfg->taps_per_phase > DECIMATOR_MAX_TAPS) {
+            cfg->taps_per_phase = DECIMATOR_MAX_TAPS / cfg->factor;
+        }
+    }
+    if (config->parameter_count > DECIMATOR_PARAM_TAPS_PER_PHASE &&
+        config->parameters[DECIMATOR_PARAM_TAPS_PER_PHASE] > 0.0f) {
+        cfg->taps_per_phase = (uint32_t)config->parameters[DECIMATOR_PARAM_TAPS_PER_PHASE];
+    }
+    if (config->parameter_count > DECIMATOR_PARAM_CUTOFF && config->parameters[DECIMATOR_PARAM_CUTOFF] > 0.0f) {
+        cfg->cutoff = config->parameters[DECIMATOR_PARAM_CUTOFF];
+    }
+}
+
+static bool stage_init(pipeline_stage_t* stage, const pipeline_stage_config_t* config)
+{
+    decimator_t* dec = (decimator_t*)stage->context;
+    decimator_config_t cfg;
+
+    if (!config) {
+        return false;
+    }
+
+    stage_apply_config(&cfg, config);
+    if (!decimator_init(dec, &cfg)) {
+        return false;
+    }
+
+    stage->config = *config;
+    return true;
+}
+
+static bool stage_process(pipeline_stage_t* stage, const signal_buffer_t* input, signal_buffer_t* output)
+{
+    decimator_t* dec = (decimator_t*)stage->context;
+    uint32_t m = dec->config.factor;
+
+    if (!input->data || input->sample_rate == 0 || input->sample_rate % m != 0) {
+        return false;
+    }
+
+    // History at another rate would be filtered with the wrong cutoff
+    if (dec->input_rate != input->sample_rate) {
+        decimator_reset(dec);
+        dec->input_rate = input->sample_rate;
+    }
+
+    // Phases count down, so the first output lands on input sample 'phase'
+    uint32_t first = dec->phase;
+
+    output->length = decimator_process_rows(dec, input->data, input->stride, output->data, output->stride,
+                                            SIGNAL_CHANNEL_COUNT(input), input->length);
+    output->channels = input->channels;
+    output->sample_rate = input->sample_rate / m;
+    output->timestamp_start = input->timestamp_start + (first * 1000) / input->sample_rate;
+    output->quality_score = input->quality_score;
+    output->metadata = input->metadata;
+    return true;
+}
+
+static bool stage_reset(pipeline_stage_t* stage)
+{
+    decimator_reset((decimator_t*)stage->context);
+    return true;
+}
+
+static bool stage_update_config(pipeline_stage_t* stage, const pipeline_stage_config_t* config)
+{
+    decimator_t* dec = (decimator_t*)stage->context;
+    decimator_config_t cfg;
+
+    if (!config) {
+        return false;
+    }
+
+    stage_apply_config(&cfg, config);
+    if (!config_is_valid(&cfg)) {
+        return false;
+    }
+
+    // Same phase layout: new coefficients over the running delay lines
+    if (cfg.factor == dec->config.factor && cfg.taps_per_phase == dec->config.taps_per_phase) {
+        dec->config = cfg;
+        design_filter(dec);
+    } else {
+        uint32_t rate = dec->input_rate;
+        decimator_init(dec, &cfg);
+        dec->input_rate = rate;
+    }
+
+    stage->config = *config;
+    return true;
+}
+
+static bool stage_get_status(pipeline_stage_t* stage, float* quality, uint32_t* latency_us)
+{
+    const decimator_t* dec = (const decimator_t*)stage->context;
+
+    if (quality) {
+        *quality = 1.0f;
+    }
+    if (latency_us) {
+        // Group delay of the linear-phase prototype
+        uint32_t taps = dec->config.factor * dec->config.taps_per_phase;
+        *latency_us = dec->input_rate ? (uint32_t)((taps - 1) * 500000ULL / dec->input_rate) : 0;
+    }
+    return true;
+}
+
+static void stage_cleanup(pipeline_stage_t* stage)
+{
+    decimator_reset((decimator_t*)stage->context);
+}
+
+pipeline_stage_ops_t decimator_stage_ops = {
+    .init = stage_init,
+    .process = stage_process,
+    .reset = stage_reset,
+    .update_config = stage_update_config,
+    .get_status = stage_get_status,
+    .cleanup = stage_cleanup,
+};
+
+bool decimator_stage_bind(pipeline_stage_t* stage,
+                          decimator_t* dec,
+                          const pipeline_stage_config_t* config)
+{
+    if (!stage || !dec || !config) {
+        return false;
+    }
+
+    memset(stage, 0, sizeof(pipeline_stage_t));
+    stage->type = PIPELINE_STAGE_FILTER;
+    stage->ops = &decimator_stage_ops;
+    stage->multichannel = true;
+    stage->context = dec;
+
+    if (!stage_init(stage, config)) {
+        return false;
+    }
+    pipeline_stage_set_name(stage, "decimator");
+    return true;
+}
@@ -0,0 +1,143 @@
+#ifndef DECIMATOR_H
+#define DECIMATOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "interfaces/signal_pipeline_interfaces.h"
+
+/**
+ * @file decimator.h
+ * @brief Polyphase FIR decimation stage
+ *
+ * Low-pass FIR and downsampling by an integer factor M in one step. The
+ * filter is split into M phase sub-filters of taps/M coefficients; each
+ * input sample is multiplied only against its own phase, so the cost is
+ * taps/M MACs per input sample, evenly spread, and no discarded output is
+ * ever computed.
+ *
+ * The output block is tagged with sample_rate / M, so stages can be
+ * chained (100 Hz -> 25 Hz for HR, -> 5 Hz for respiration) and every
+ * downstream stage designs itself for the rate it actually receives.
+ * Group delay is (taps - 1) / 2 input samples.
+ */
+
+// =============================================================================
+// Limits
+// =============================================================================
+
+#define DECIMATOR_MAX_FACTOR         8     ///< Largest factor per stage (chain for more)
+#define DECIMATOR_MAX_TAPS           64    ///< Prototype filter length
+
+/**
+ * @brief Index of decimator parameters in pipeline_stage_config_t.parameters
+ */
+typedef enum {
+    DECIMATOR_PARAM_FACTOR = 0,           ///< Integer decimation factor M
+    DECIMATOR_PARAM_TAPS_PER_PHASE,       ///< Sub-filter length (taps = M * this)
+    DECIMATOR_PARAM_CUTOFF,               ///< Pass-band edge, fraction of output Nyquist
+    DECIMATOR_PARAM_COUNT
+} decimator_param_t;
+
+// =============================================================================
+// Data Structures
+// =============================================================================
+
+/**
+ * @brief Decimator configuration
+ */
+typedef struct {
+    uint32_t factor;                  ///< Decimation factor M (1..DECIMATOR_MAX_FACTOR)
+    uint32_t taps_per_phase;          ///< Sub-filter length; factor * taps_per_phase <= DECIMATOR_MAX_TAPS
+    float cutoff;                     ///< Pass-band edge as a fraction of the output Nyquist (0..1)
+} decimator_config_t;
+
+/**
+ * @brief Decimator state (owned by caller, bound via context)
+ */
+typedef struct {
+    decimator_config_t config;
+    float coeffs[DECIMATOR_MAX_TAPS];       ///< Phase-major sub-filters, each reversed:
+                                            ///< coeffs[p * K + K-1-j] = h[j * M + p]
+    float delay[PIPELINE_MAX_CHANNELS][2 * DECIMATOR_MAX_TAPS]; ///< Per-row, per-phase delay lines,
+                                            ///< each mirrored (2K)
+    uint32_t delay_pos;               ///< Write position within each phase line (0..K-1)
+    uint32_t phase;                   ///< Phase of the next input sample
+    float acc[PIPELINE_MAX_CHANNELS]; ///< Partial output of each row being accumulated
+    uint32_t input_rate;              ///< Rate the state was primed for
+    uint32_t samples_in;              ///< Input samples consumed
+    uint32_t samples_out;             ///< Output samples produced
+} decimator_t;
+
+// Factor 4 (100 Hz -> 25 Hz); 32 Hamming-windowed taps put the -6 dB
+// point at 80% of the new Nyquist with >50 dB stop-band.
+static const decimator_config_t DECIMATOR_DEFAULT_CONFIG = {
+    .factor = 4,
+    .taps_per_phase = 8,
+    .cutoff = 0.8f
+};
+
+// =============================================================================
+// Decimator Functions
+// =============================================================================
+
+/**
+ * @brief Initialize decimator and design its filter
+ * @param dec Decimator instance
+ * @param config Configuration (NULL for DECIMATOR_DEFAULT_CONFIG)
+ * @return true if the configuration is valid
+ */
+bool decimator_init(decimator_t* dec, const decimator_config_t* config);
+
+/**
+ * @brief Clear delay lines and phase, keep configuration
+ */
+void decimator_reset(decimator_t* dec);
+
+/**
+ * @brief Filter and downsample a block
+ * @param dec Decimator instance
+ * @param input Input samples
+ * @param length Number of input samples
+ * @param output Output samples (up to length / factor + 1; may alias input)
+ * @return Number of output samples written
+ */
+uint32_t decimator_process(decimator_t* dec, const float* input, uint32_t length, float* output);
+
+/**
+ * @brief Filter and downsample every row of a multi-channel block
+ *
+ * Rows share the phase, each keeps its own delay lines, so row r gives
+ * the same samples as a decimator fed that row alone.
+ *
+ * @param input Row 0 of the input, row r at input + r * input_stride
+ * @param output Row 0 of the output, row r at output + r * output_stride
+ *               (may alias input if the strides are equal)
+ * @param rows Channel rows (1..PIPELINE_MAX_CHANNELS)
+ * @return Number of output samples written per row
+ */
+uint32_t decimator_process_rows(decimator_t* dec, const float* input, uint32_t input_stride,
+                                float* output, uint32_t output_stride, uint32_t rows, uint32_t length);
+
+// =============================================================================
+// Pipeline Stage Binding
+// =============================================================================
+
+/**
+ * @brief Stage operations for a decimation node
+ *
+ * The input rate must be a multiple of the factor so the output rate is an
+ * integer; other rates fail the block. Every channel row is decimated.
+ */
+extern pipeline_stage_ops_t decimator_stage_ops;
+
+/**
+ * @brief Bind a decimator to a filter-type stage
+ *
+ * Settings come from config->parameters (decimator_param_t); unset entries
+ * keep DECIMATOR_DEFAULT_CONFIG.
+ */
+bool decimator_stage_bind(pipeline_stage_t* stage,
+                          decimator_t* dec,
+                          const pipeline_stage_config_t* config);
+
+#endif // DECIMATOR_H
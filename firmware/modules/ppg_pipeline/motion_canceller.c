@@ -0,0 +1,508 @@
+/*
+ * Motion Artifact Canceller Implementation
+ *
+ * Multi-channel normalized LMS filter with the 3-axis accelerometer as
+ * noise reference. Used by the PPG artifact removal pipeline stage.
+ */
+
+#include "motion_canceller.h"
+#include <string.h>
+#include <math.h>
+
+#define CORRELATION_SMOOTHING   0.25f   /* EMA weight of the newest block */
+
+/* ==== PRIVATE FUNCTIONS ==== */
+
+static bool config_is_valid(const motion_canceller_config_t* config)
+{
+    return config->taps > 0 &&
+           config->taps <= MOTION_CANCELLER_MAX_TAPS &&
+           config->step_size > 0.0f && config->step_size < 2.0f &&
+           config->regularization > 0.0f &&
+           config->motion_threshold >= 0.0f &&
+           config->reference_alpha >= 0.0f && config->reference_alpha < 1.0f;
+}
+
+/**
+ * Mean per-axis variance of the raw accelerometer block (g^2).
+ * Variance ignores gravity, so orientation changes at rest do not count as motion.
+ */
+static float block_motion_energy(const float* accel_xyz, uint32_t length)
+{
+    float sum[MOTION_CANCELLER_AXES] = {0};
+    float sum_sq[MOTION_CANCELLER_AXES] = {0};
+
+    for (uint32_t n = 0; n < length; n++) {
+        for (int a = 0; a < MOTION_CANCELLER_AXES; a++) {
+            float v = accel_xyz[n * MOTION_CANCELLER_AXES + a];
+            sum[a] += v;
+            sum_sq[a] += v * v;
+        }
+    }
+
+    float energy = 0.0f;
+    float inv_len = 1.0f / (float)length;
+    for (int a = 0; a < MOTION_CANCELLER_AXES; a++) {
+        float mean = sum[a] * inv_len;
+        float var = sum_sq[a] * inv_len - mean * mean;
+        energy += (var > 0.0f) ? var : 0.0f;
+    }
+    return energy;
+}
+
+/**
+ * Push one accelerometer triple through the DC blockers into the delay lines.
+ * Keeps reference_power in step with the dropped and added tap values.
+ */
+static void push_reference(motion_canceller_t* mc, const float* xyz)
+{
+    const uint32_t taps = mc->config.taps;
+    const float alpha = mc->config.reference_alpha;
+
+    mc->history_pos = (mc->history_pos == 0) ? taps - 1 : mc->history_pos - 1;
+    const uint32_t pos = mc->history_pos;
+
+    for (int a = 0; a < MOTION_CANCELLER_AXES; a++) {
+        float y = xyz[a] - mc->ref_last_in[a] + alpha * mc->ref_last_out[a];
+        mc->ref_last_in[a] = xyz[a];
+        mc->ref_last_out[a] = y;
+
+        // Mirrored line: the slot being overwritten holds the sample leaving the window
+        float dropped = mc->history[a][pos];
+        mc->history[a][pos] = y;
+        mc->history[a][pos + taps] = y;
+        mc->reference_power += y * y - dropped * dropped;
+    }
+
+    if (mc->reference_power < 0.0f) {
+        mc->reference_power = 0.0f;
+    }
+}
+
+static float recompute_reference_power(const motion_canceller_t* mc)
+{
+    float power = 0.0f;
+    for (int a = 0; a < MOTION_CANCELLER_AXES; a++) {
+        const float* x = &mc->history[a][mc->history_pos];
+        for (uint32_t k = 0; k < mc->config.taps; k++) {
+            power += x[k] * x[k];
+        }
+    }
+    return power;
+}
+
+static float filter_estimate(const motion_canceller_t* mc)
+{
+    const uint32_t taps = mc->config.taps;
+    float y = 0.0f;
+
+    for (int a = 0; a < MOTION_CANCELLER_AXES; a++) {
+        const float* restrict w = &mc->weights[a * MOTION_CANCELLER_MAX_TAPS];
+        const float* restrict x = &mc->history[a][mc->history_pos];
+        for (uint32_t k = 0; k < taps; k++) {
+            y += w[k] * x[k];
+        }
+    }
+    return y;
+}
+
+static void update_weights(motion_canceller_t* mc, float gain)
+{
+    const uint32_t taps = mc->config.taps;
+
+    for (int a = 0; a < MOTION_CANCELLER_AXES; a++) {
+        float* restrict w = &mc->weights[a * MOTION_CANCELLER_MAX_TAPS];
+        const float* restrict x = &mc->history[a][mc->history_pos];
+        for (uint32_t k = 0; k < taps; k++) {
+            w[k] += gain * x[k];
+        }
+    }
+}
+
+/* ==== CANCELLER FUNCTIONS ==== */
+
+bool motion_canceller_init(motion_canceller_t* mc, const motion_canceller_config_t* config)
+{
+    if (!mc) {
+        return false;
+    }
+
+    if (!config) {
+        config = &MOTION_CANCELLER_DEFAULT_CONFIG;
+    }
+
+    if (!config_is_valid(config)) {
+        return false;
+    }
+
+    memset(mc, 0, sizeof(motion_canceller_t));
+    mc->config = *config;
+    mc->last_correlation = 1.0f;
+    mc->subtract = true;
+    return true;
+}
+
+void motion_canceller_reset(motion_canceller_t* mc)
+{
+    if (!mc) {
+        return;
+    }
+
+    motion_canceller_config_t config = mc->config;
+    motion_canceller_init(mc, &config);
+}
+
+bool motion_canceller_process(motion_canceller_t* mc,
+                              const float* ppg,
+                              const float* accel_xyz,
+                              float* output,
+                              uint32_t length)
+{
+    if (!mc || !ppg || !accel_xyz || !output) {
+        return false;
+    }
+
+    if (length == 0) {
+        return true;
+    }
+
+    if (!mc->primed) {
+        // Seed the DC blockers so gravity and the PPG baseline do not start as a step
+        for (int a = 0; a < MOTION_CANCELLER_AXES; a++) {
+            mc->ref_last_in[a] = accel_xyz[a];
+        }
+        mc->ppg_last_in = ppg[0];
+        mc->primed = true;
+    }
+
+    mc->blocks_processed++;
+    mc->motion_energy = block_motion_energy(accel_xyz, length);
+
+    if (mc->motion_energy >= mc->config.motion_threshold) {
+        mc->active = true;
+        mc->hangover = mc->config.hangover_blocks;
+    } else if (mc->hangover > 0) {
+        mc->active = true;
+        mc->hangover--;
+    } else {
+        mc->active = false;
+    }
+
+    if (!mc->active) {
+        // Resting arm: keep references warm, leave the PPG untouched
+        for (uint32_t n = 0; n < length; n++) {
+            push_reference(mc, &accel_xyz[n * MOTION_CANCELLER_AXES]);
+            output[n] = ppg[n];
+        }
+        mc->ppg_last_out = 0.0f;
+        mc->ppg_last_in = ppg[length - 1];
+        return true;
+    }
+
+    mc->blocks_adapted++;
+    mc->reference_power = recompute_reference_power(mc);
+
+    const float mu = mc->config.step_size;
+    const float eps = mc->config.regularization;
+    const float alpha = mc->config.reference_alpha;
+    const bool subtract = mc->subtract;
+    float sum_yd = 0.0f;
+    float sum_yy = 0.0f;
+    float sum_dd = 0.0f;
+
+    for (uint32_t n = 0; n < length; n++) {
+        push_reference(mc, &accel_xyz[n * MOTION_CANCELLER_AXES]);
+
+        float d = ppg[n];
+        float y = filter_estimate(mc);
+        float e = d - y;
+
+        // Adapt on the DC-free error so the PPG baseline does not bias the weights
+        float d_ac = d - mc->ppg_last_in + alpha * mc->ppg_last_out;
+        mc->ppg_last_in = d;
+        mc->ppg_last_out = d_ac;
+        update_weights(mc, mu * (d_ac - y) / (eps + mc->reference_power));
+
+        sum_yd += y * d_ac;
+        sum_yy += y * y;
+        sum_dd += d_ac * d_ac;
+        output[n] = subtract ? e : d;
+    }
+
+    // Subtraction for the next block follows how much of the PPG the estimate
+    // explains; smoothed so short blocks dominated by the pulse do not flap it
+    float denom = sqrtf(sum_yy * sum_dd);
+    float corr = (denom > 0.0f) ? fabsf(sum_yd) / denom : 0.0f;
+    mc->last_correlation += CORRELATION_SMOOTHING * (corr - mc->last_correlation);
+    mc->subtract = mc->last_correlation >= mc->config.correlation_threshold;
+
+    return true;
+}
+
+bool motion_canceller_align_accel(const imu_sample_t* imu,
+                                  uint32_t imu_count,
+                                  uint32_t start_ms,
+                                  uint32_t sample_rate,
+                                  uint32_t length,
+                                  float* accel_xyz)
+{
+    if (!imu || imu_count == 0 || sample_rate == 0 || !accel_xyz) {
+        return false;
+    }
+
+    const float period_ms = 1000.0f / (float)sample_rate;
+    uint32_t j = 0;
+
+    for (uint32_t n = 0; n < length; n++) {
+        float t = (float)start_ms + (float)n * period_ms;
+
+        while (j + 1 < imu_count && (float)imu[j + 1].timestamp <= t) {
+            j++;
+        }
+
+        float frac = 0.0f;
+        uint32_t k = j;
+        if (j + 1 < imu_count && (float)imu[j].timestamp <= t) {
+            float span = (float)(imu[j + 1].timestamp - imu[j].timestamp);
+            frac = (span > 0.0f) ? (t - (float)imu[j].timestamp) / span : 0.0f;
+            k = j + 1;
+        }
+
+        for (int a = 0; a < MOTION_CANCELLER_AXES; a++) {
+            float v0 = imu[j].accel[a] * 0.001f;
+            float v1 = imu[k].accel[a] * 0.001f;
+            accel_xyz[n * MOTION_CANCELLER_AXES + a] = v0 + frac * (v1 - v0);
+        }
+    }
+
+    return true;
+}
+
+/* ==== PIPELINE STAGE BINDING ==== */
+
+static void stage_params_to_config(const ppg_artifact_removal_stage_t* stage,
+                                   motion_canceller_config_t* config)
+{
+    const pipeline_stage_config_t* sc = &stage->base.config;
+
+    *config = MOTION_CANCELLER_DEFAULT_CONFIG;
+
+    if (sc->parameter_count > MOTION_CANCELLER_PARAM_TAPS &&
+        sc->parameters[MOTION_CANCELLER_PARAM_TAPS] > 0.0f) {
+        config->taps = (uint32_t)sc->parameters[MOTION_CANCELLER_PARAM_TAPS];
+    }
+    if (sc->parameter_count > MOTION_CANCELLER_PARAM_STEP_SIZE &&
+        sc->parameters[MOTION_CANCELLER_PARAM_STEP_SIZE] > 0.0f) {
+        config->step_size = sc->parameters[MOTION_CANCELLER_PARAM_STEP_SIZE];
+    }
+    if (sc->parameter_count > MOTION_CANCELLER_PARAM_HANGOVER) {
+        config->hangover_blocks = (uint32_t)sc->parameters[MOTION_CANCELLER_PARAM_HANGOVER];
+    }
+
+    config->motion_threshold = stage->params.motion_threshold;
+    config->correlation_threshold = stage->params.correlation_threshold;
+}
+
+static void stage_config_to_params(ppg_artifact_removal_stage_t* stage,
+                                   const pipeline_stage_config_t* config)
+{
+    stage->base.config = *config;
+
+    stage->params.use_imu_data = true;
+    stage->params.enable_adaptive_filter = config->enabled;
+    stage->params.motion_threshold = MOTION_CANCELLER_DEFAULT_CONFIG.motion_threshold;
+    stage->params.correlation_threshold = MOTION_CANCELLER_DEFAULT_CONFIG.correlation_threshold;
+    stage->params.artifact_window = config->buffer_size;
+
+    if (config->parameter_count > MOTION_CANCELLER_PARAM_MOTION_THRESHOLD) {
+        stage->params.motion_threshold = config->parameters[MOTION_CANCELLER_PARAM_MOTION_THRESHOLD];
+    }
+    if (config->parameter_count > MOTION_CANCELLER_PARAM_CORRELATION) {
+        stage->params.correlation_threshold = config->parameters[MOTION_CANCELLER_PARAM_CORRELATION];
+    }
+}
+
+static bool stage_init(pipeline_stage_t* stage, const pipeline_stage_config_t* config)
+{
+    ppg_artifact_removal_stage_t* artifact = (ppg_artifact_removal_stage_t*)stage;
+    motion_canceller_config_t mc_config;
+
+    if (config) {
+        stage_config_to_params(artifact, config);
+    }
+    stage_params_to_config(artifact, &mc_config);
+
+    return motion_canceller_init((motion_canceller_t*)stage->context, &mc_config);
+}
+
+static bool stage_process(pipeline_stage_t* stage, const signal_buffer_t* input, signal_buffer_t* output)
+{
+    ppg_artifact_removal_stage_t* artifact = (ppg_artifact_removal_stage_t*)stage;
+    motion_canceller_t* mc = (motion_canceller_t*)stage->context;
+    const signal_buffer_t* imu = artifact->imu_buffer;
+
+    if (!input || !output || !input->data || !output->data) {
+        return false;
+    }
+
+    output->length = input->length;
+    output->sample_rate = input->sample_rate;
+    output->timestamp_start = input->timestamp_start;
+    output->quality_score = input->quality_score;
+    output->channels = input->channels;
+
+    // The weights are learned on row 0; the other rows are carried unchanged
+    if (output->data != input->data) {
+        for (uint32_t r = 1; r < SIGNAL_CHANNEL_COUNT(input); r++) {
+            memcpy(SIGNAL_CHANNEL(output, r), SIGNAL_CHANNEL(input, r), input->length * sizeof(float));
+        }
+    }
+
+    bool have_reference = artifact->params.use_imu_data &&
+                          artifact->params.enable_adaptive_filter &&
+                          imu && imu->data &&
+                          imu->length >= input->length * MOTION_CANCELLER_AXES;
+
+    if (!have_reference) {
+        if (output->data != input->data) {
+            memcpy(output->data, input->data, input->length * sizeof(float));
+        }
+        return true;
+    }
+
+    return motion_canceller_process(mc, input->data, imu->data, output->data, input->length);
+}
+
+static bool stage_reset(pipeline_stage_t* stage)
+{
+    motion_canceller_reset((motion_canceller_t*)stage->context);
+    return true;
+}
+
+static bool stage_update_config(pipeline_stage_t* stage, const pipeline_stage_config_t* config)
+{
+    ppg_artifact_removal_stage_t* artifact = (ppg_artifact_removal_stage_t*)stage;
+    motion_canceller_t* mc = (motion_canceller_t*)stage->context;
+    motion_canceller_config_t mc_config;
+
+    if (!config) {
+        return false;
+    }
+
+    // Validate on a copy so a rejected update leaves the stage as it was
+    ppg_artifact_removal_stage_t candidate = *artifact;
+    stage_config_to_params(&candidate, config);
+    stage_params_to_config(&candidate, &mc_config);
+
+    if (!config_is_valid(&mc_config)) {
+        return false;
+    }
+    artifact->base.config = candidate.base.config;
+    artifact->params = candidate.params;
+
+    // Same tap layout: keep learned weights, only the adaptation settings change
+    if (mc_config.taps == mc->config.taps) {
+        mc->config = mc_config;
+        return true;
+    }
+
+    return motion_canceller_init(mc, &mc_config);
+}
+
+static bool stage_get_status(pipeline_stage_t* stage, float* quality, uint32_t* latency_us)
+{
+    const motion_canceller_t* mc = (const motion_canceller_t*)stage->context;
+
+    if (quality) {
+        // Heavy residual motion lowers confidence in the cleaned signal
+        float q = 1.0f;
+        if (mc->active && mc->config.motion_threshold > 0.0f) {
+            q = 1.0f - mc->motion_energy / (10.0f * mc->config.motion_threshold);
+        }
+        *quality = (q < 0.0f) ? 0.0f : q;
+    }
+    if (latency_us) {
+        *latency_us = stage->processing_time_us;
+    }
+    return true;
+}
+
+/** Learned coupling survives sleep; reference history and DC blockers do not */
+typedef struct {
+    uint32_t taps;
+    float last_correlation;
+    float weights[MOTION_CANCELLER_AXES * MOTION_CANCELLER_MAX_TAPS];
+} canceller_checkpoint_t;
+
+static uint32_t stage_save_state(pipeline_stage_t* stage, void* buffer, uint32_t capacity)
+{
+    const motion_canceller_t* mc = (const motion_canceller_t*)stage->context;
+    canceller_checkpoint_t cp = { .taps = mc->config.taps, .last_correlation = mc->last_correlation };
+
+    if (capacity < sizeof(cp)) {
+        return 0;
+    }
+    memcpy(cp.weights, mc->weights, sizeof(cp.weights));
+    memcpy(buffer, &cp, sizeof(cp));
+    return sizeof(cp);
+}
+
+static bool stage_restore_state(pipeline_stage_t* stage, const void* buffer, uint32_t length)
+{
+    motion_canceller_t* mc = (motion_canceller_t*)stage->context;
+    canceller_checkpoint_t cp;
+
+    if (length != sizeof(cp)) {
+        return false;
+    }
+    memcpy(&cp, buffer, sizeof(cp));
+    if (cp.taps != mc->config.taps) {
+        return false;
+    }
+
+    motion_canceller_reset(mc);
+    memcpy(mc->weights, cp.weights, sizeof(cp.weights));
+    mc->last_correlation = cp.last_correlation;
+    return true;
+}
+
+static void stage_cleanup(pipeline_stage_t* stage)
+{
+    motion_canceller_reset((motion_canceller_t*)stage->context);
+}
+
+pipeline_stage_ops_t motion_canceller_stage_ops = {
+    .init = stage_init,
+    .process = stage_process,
+    .reset = stage_reset,
+    .update_config = stage_update_config,
+    .get_status = stage_get_status,
+    .cleanup = stage_cleanup,
+    .save_state = stage_save_state,
+    .restore_state = stage_restore_state,
+};
+
+bool motion_canceller_stage_bind(ppg_artifact_removal_stage_t* stage,
+                                 motion_canceller_t* mc,
+                                 const pipeline_stage_config_t* config)
+{
+    if (!stage || !mc || !config) {
+        return false;
+    }
+
+    signal_buffer_t* imu_buffer = stage->imu_buffer;
+    memset(stage, 0, sizeof(ppg_artifact_removal_stage_t));
+    stage->imu_buffer = imu_buffer;
+
+    stage->base.type = PIPELINE_STAGE_ARTIFACT_REMOVAL;
+    stage->base.ops = &motion_canceller_stage_ops;
+    stage->base.is_adaptive = true;
+    stage->base.multichannel = true;
+    stage->base.context = mc;
+
+    if (!stage_init(&stage->base, config)) {
+        return false;
+    }
+    pipeline_stage_set_name(&stage->base, "motion_nlms");
+    return true;
+}
@@ -0,0 +1,177 @@
+#ifndef MOTION_CANCELLER_H
+#define MOTION_CANCELLER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "interfaces/signal_pipeline_interfaces.h"
+
+/**
+ * @file motion_canceller.h
+ * @brief Multi-channel NLMS motion artifact canceller
+ *
+ * Uses the three accelerometer axes as noise references for a normalized
+ * LMS adaptive filter and subtracts the motion-correlated part of the PPG.
+ * Adaptation is gated on the measured motion energy: while the upper arm
+ * is at rest the canceller only runs its reference DC blockers and passes
+ * the PPG through unchanged.
+ */
+
+// =============================================================================
+// Limits
+// =============================================================================
+
+#define MOTION_CANCELLER_AXES        3     ///< Accelerometer reference channels
+#define MOTION_CANCELLER_MAX_TAPS    16    ///< Maximum taps per reference axis
+
+/**
+ * @brief Index of canceller parameters in pipeline_stage_config_t.parameters
+ */
+typedef enum {
+    MOTION_CANCELLER_PARAM_TAPS = 0,          ///< Taps per axis
+    MOTION_CANCELLER_PARAM_STEP_SIZE,         ///< NLMS step size (mu)
+    MOTION_CANCELLER_PARAM_MOTION_THRESHOLD,  ///< Motion energy gate (g^2)
+    MOTION_CANCELLER_PARAM_CORRELATION,       ///< Min |corr(estimate, PPG)|
+    MOTION_CANCELLER_PARAM_HANGOVER,          ///< Blocks to keep adapting after motion
+    MOTION_CANCELLER_PARAM_COUNT
+} motion_canceller_param_t;
+
+// =============================================================================
+// Data Structures
+// =============================================================================
+
+/**
+ * @brief Canceller configuration
+ */
+typedef struct {
+    uint32_t taps;                    ///< Taps per axis (1..MOTION_CANCELLER_MAX_TAPS)
+    float step_size;                  ///< NLMS step size mu (0 < mu < 2)
+    float regularization;             ///< Regularization added to reference power
+    float motion_threshold;           ///< Accel variance (g^2, summed over axes) that enables adaptation
+    float correlation_threshold;      ///< Below this |corr| the estimate is not subtracted
+    float reference_alpha;            ///< DC blocker pole for accel references
+    uint32_t hangover_blocks;         ///< Blocks to stay active after motion stops
+} motion_canceller_config_t;
+
+/**
+ * @brief Canceller state
+ *
+ * Weights for all axes are stored back to back and each axis keeps a
+ * mirrored delay line, so every tap window is a contiguous array and the
+ * filter/update loops are straight dot products and AXPYs.
+ */
+typedef struct {
+    motion_canceller_config_t config;
+
+    float weights[MOTION_CANCELLER_AXES * MOTION_CANCELLER_MAX_TAPS];
+    float history[MOTION_CANCELLER_AXES][2 * MOTION_CANCELLER_MAX_TAPS];
+    uint32_t history_pos;             ///< Start of the newest tap window
+    float reference_power;            ///< Sum of squares over all tap windows
+
+    float ref_last_in[MOTION_CANCELLER_AXES];   ///< DC blocker x[n-1]
+    float ref_last_out[MOTION_CANCELLER_AXES];  ///< DC blocker y[n-1]
+    float ppg_last_in;                ///< PPG DC blocker x[n-1] (adaptation error only)
+    float ppg_last_out;               ///< PPG DC blocker y[n-1]
+
+    float motion_energy;              ///< Summed accel variance of last block (g^2)
+    float last_correlation;           ///< Smoothed |corr| of estimate vs. PPG
+    uint32_t hangover;                ///< Remaining hangover blocks
+    bool active;                      ///< Adaptation active for last block
+    bool subtract;                    ///< Estimate is subtracted (decided per block)
+    bool primed;                      ///< DC blockers seeded from the first samples
+
+    uint32_t blocks_processed;        ///< Total blocks seen
+    uint32_t blocks_adapted;          ///< Blocks where NLMS ran
+} motion_canceller_t;
+
+// Upper-arm defaults: 8 taps/axis at 25-100 Hz covers ~80-320 ms of
+// accel-to-PPG lag, gate at ~(0.05 g)^2 RMS motion.
+static const motion_canceller_config_t MOTION_CANCELLER_DEFAULT_CONFIG = {
+    .taps = 8,
+    .step_size = 0.01f,
+    .regularization = 1e-4f,
+    .motion_threshold = 2.5e-3f,
+    .correlation_threshold = 0.1f,
+    .reference_alpha = 0.98f,
+    .hangover_blocks = 2
+};
+
+// =============================================================================
+// Canceller Functions
+// =============================================================================
+
+/**
+ * @brief Initialize canceller state
+ * @param mc Canceller instance
+ * @param config Configuration (NULL for MOTION_CANCELLER_DEFAULT_CONFIG)
+ * @return true if the configuration is valid
+ */
+bool motion_canceller_init(motion_canceller_t* mc, const motion_canceller_config_t* config);
+
+/**
+ * @brief Clear weights and delay lines, keep configuration
+ */
+void motion_canceller_reset(motion_canceller_t* mc);
+
+/**
+ * @brief Cancel motion artifacts from one PPG block
+ * @param mc Canceller instance
+ * @param ppg Input PPG block
+ * @param accel_xyz Accelerometer reference in g, x/y/z interleaved, 3 * length values
+ * @param output Cleaned PPG block (may alias ppg)
+ * @param length Number of PPG samples
+ * @return true on success
+ */
+bool motion_canceller_process(motion_canceller_t* mc,
+                              const float* ppg,
+                              const float* accel_xyz,
+                              float* output,
+                              uint32_t length);
+
+/**
+ * @brief Resample IMU samples onto the PPG sample grid
+ *
+ * Linear interpolation on timestamps; PPG samples outside the IMU span
+ * hold the nearest IMU value.
+ *
+ * @param imu IMU samples ordered by timestamp (accel in mg)
+ * @param imu_count Number of IMU samples
+ * @param start_ms Timestamp of the first PPG sample
+ * @param sample_rate PPG sample rate in Hz
+ * @param length Number of PPG samples
+ * @param accel_xyz Output, 3 * length values in g
+ * @return true on success
+ */
+bool motion_canceller_align_accel(const imu_sample_t* imu,
+                                  uint32_t imu_count,
+                                  uint32_t start_ms,
+                                  uint32_t sample_rate,
+                                  uint32_t length,
+                                  float* accel_xyz);
+
+// =============================================================================
+// Pipeline Stage Binding
+// =============================================================================
+
+/**
+ * @brief Stage operations backing ppg_artifact_removal_stage_t
+ */
+extern pipeline_stage_ops_t motion_canceller_stage_ops;
+
+/**
+ * @brief Bind a canceller instance to an artifact removal stage
+ *
+ * Canceller settings are taken from config->parameters (see
+ * motion_canceller_param_t); unset entries keep their defaults. Row 0 of
+ * a multi-channel block is cancelled and the other rows pass through
+ * unchanged: the learned coupling belongs to one wavelength.
+ *
+ * @param stage Stage descriptor to fill
+ * @param mc Canceller state owned by the caller
+ * @param config Stage configuration
+ * @return true on success
+ */
+bool motion_canceller_stage_bind(ppg_artifact_removal_stage_t* stage,
+                                 motion_canceller_t* mc,
+                                 const pipeline_stage_config_t* config);
+
+#endif // MOTION_CANCELLER_H
@@ -0,0 +1,177 @@
+/*
+ * Pipeline Pool Implementation
+ *
+ * A slot is a pipeline descriptor followed by its arena. The arena is a
+ * bump allocator: topology changes only ever add buffers, and the whole
+ * arena is recycled with the slot, so there is no free list to fragment.
+ * The one stage scratch area sits at the top of the arena and grows
+ * downwards over itself, so a larger request reuses the old area.
+ */
+
+#include "pipeline_pool.h"
+#include "pipeline_port.h"
+#include <string.h>
+
+#define ARENA_ALIGN     8u
+
+typedef struct {
+    signal_pipeline_t pipeline;
+    uint32_t used;                    /* Arena bytes handed out from the bottom */
+    uint32_t scratch;                 /* Scratch bytes at the top */
+    bool in_use;
+    union {
+        uint64_t align;
+        uint8_t bytes[PIPELINE_POOL_ARENA_BYTES];
+    } arena;
+} pool_slot_t;
+
+static pool_slot_t slots[PIPELINE_POOL_SLOTS];
+static uint32_t slots_in_use;
+static uint32_t slots_peak;
+static uint32_t arena_peak;
+static uint32_t failures;
+
+#if !defined(__ZEPHYR__) && defined(PIPELINE_HOST_THREADS)
+pthread_mutex_t pipeline_host_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/* ==== PRIVATE FUNCTIONS ==== */
+
+static pool_slot_t* slot_of(const signal_pipeline_t* pipeline)
+{
+    for (uint32_t i = 0; i < PIPELINE_POOL_SLOTS; i++) {
+        if (&slots[i].pipeline == pipeline) {
+            return &slots[i];
+        }
+    }
+    return NULL;
+}
+
+static void note_peak(const pool_slot_t* slot)
+{
+    PIPELINE_CRITICAL_ENTER();
+    if (slot->used + slot->scratch > arena_peak) {
+        arena_peak = slot->used + slot->scratch;
+    }
+    PIPELINE_CRITICAL_EXIT();
+}
+
+/* ==== PUBLIC FUNCTIONS ==== */
+
+signal_pipeline_t* pipeline_pool_acquire(void)
+{
+    signal_pipeline_t* pipeline = NULL;
+
+    PIPELINE_CRITICAL_ENTER();
+    for (uint32_t i = 0; i < PIPELINE_POOL_SLOTS; i++) {
+        if (!slots[i].in_use) {
+            slots[i].in_use = true;
+            slots[i].used = 0;
+            slots[i].scratch = 0;
+            pipeline = &slots[i].pipeline;
+            if (++slots_in_use > slots_peak) {
+                slots_peak = slots_in_use;
+            }
+            break;
+        }
+    }
+    if (!pipeline) {
+        failures++;
+    }
+    PIPELINE_CRITICAL_EXIT();
+
+    return pipeline;
+}
+
+void pipeline_pool_release(signal_pipeline_t* pipeline)
+{
+    pool_slot_t* slot = slot_of(pipeline);
+
+    if (!slot || !slot->in_use) {
+        return;
+    }
+
+    PIPELINE_CRITICAL_ENTER();
+    slot->in_use = false;
+    slot->used = 0;
+    slot->scratch = 0;
+    slots_in_use--;
+    PIPELINE_CRITICAL_EXIT();
+}
+
+void* pipeline_pool_alloc(signal_pipeline_t* pipeline, uint32_t bytes)
+{
+    pool_slot_t* slot = slot_of(pipeline);
+
+    if (!slot || !slot->in_use || bytes == 0) {
+        return NULL;
+    }
+
+    uint32_t size = (bytes + ARENA_ALIGN - 1u) & ~(ARENA_ALIGN - 1u);
+    if (size > PIPELINE_POOL_ARENA_BYTES - slot->used - slot->scratch) {
+        PIPELINE_CRITICAL_ENTER();
+        failures++;
+        PIPELINE_CRITICAL_EXIT();
+        return NULL;
+    }
+
+    void* p = &slot->arena.bytes[slot->used];
+    slot->used += size;
+    note_peak(slot);
+
+    memset(p, 0, size);
+    return p;
+}
+
+void* pipeline_pool_scratch(signal_pipeline_t* pipeline, uint32_t bytes)
+{
+    pool_slot_t* slot = slot_of(pipeline);
+
+    if (!slot || !slot->in_use || bytes == 0) {
+        return NULL;
+    }
+
+    uint32_t size = (bytes + ARENA_ALIGN - 1u) & ~(ARENA_ALIGN - 1u);
+    if (size > PIPELINE_POOL_ARENA_BYTES - slot->used) {
+        PIPELINE_CRITICAL_ENTER();
+        failures++;
+        PIPELINE_CRITICAL_EXIT();
+        return NULL;
+    }
+
+    if (size > slot->scratch) {
+        slot->scratch = size;
+        note_peak(slot);
+    }
+    void* p = &slot->arena.bytes[PIPELINE_POOL_ARENA_BYTES - slot->scratch];
+    memset(p, 0, slot->scratch);
+    return p;
+}
+
+uint32_t pipeline_pool_used(const signal_pipeline_t* pipeline)
+{
+    const pool_slot_t* slot = slot_of(pipeline);
+    return slot ? slot->used + slot->scratch : 0;
+}
+
+signal_pipeline_t* pipeline_pool_at(uint32_t index)
+{
+    if (index >= PIPELINE_POOL_SLOTS || !slots[index].in_use) {
+        return NULL;
+    }
+    return &slots[index].pipeline;
+}
+
+void pipeline_pool_get_stats(pipeline_pool_stats_t* stats)
+{
+    if (!stats) {
+        return;
+    }
+
+    stats->slots_total = PIPELINE_POOL_SLOTS;
+    stats->slots_in_use = slots_in_use;
+    stats->slots_peak = slots_peak;
+    stats->arena_bytes = PIPELINE_POOL_ARENA_BYTES;
+    stats->arena_peak = arena_peak;
+    stats->failures = failures;
+}
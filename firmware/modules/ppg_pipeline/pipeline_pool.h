@@ -0,0 +1,104 @@
+#ifndef PIPELINE_POOL_H
+#define PIPELINE_POOL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "interfaces/signal_pipeline_interfaces.h"
+
+/**
+ * @file pipeline_pool.h
+ * @brief Static storage for pipelines, pool buffers and stage scratch
+ *
+ * Pipelines live in a fixed number of slots, each with its own arena.
+ * pipeline_create*() takes a slot; pool buffers (sized from the largest
+ * stage buffer_size) are bump-allocated from the bottom of the slot's
+ * arena and the shared stage scratch is kept at its top when the topology
+ * is set, and pipeline_destroy() hands
+ * the whole slot back. Nothing comes from the system heap, so create and
+ * destroy cycles over a week of uptime cannot fragment it, and a graph
+ * that does not fit fails at creation instead of mid-stream.
+ *
+ * Both limits can be overridden at build time (-DPIPELINE_POOL_SLOTS=...).
+ */
+
+// =============================================================================
+// Limits
+// =============================================================================
+
+#ifndef PIPELINE_POOL_SLOTS
+#define PIPELINE_POOL_SLOTS          4     ///< Pipelines alive at once
+#endif
+
+#ifndef PIPELINE_POOL_ARENA_BYTES
+#define PIPELINE_POOL_ARENA_BYTES    4096  ///< Buffers and scratch per pipeline
+#endif
+
+// =============================================================================
+// Data Structures
+// =============================================================================
+
+/**
+ * @brief Pool occupancy and high-water marks since boot
+ */
+typedef struct {
+    uint32_t slots_total;             ///< PIPELINE_POOL_SLOTS
+    uint32_t slots_in_use;            ///< Pipelines currently alive
+    uint32_t slots_peak;              ///< Most pipelines alive at once
+    uint32_t arena_bytes;             ///< Arena per slot
+    uint32_t arena_peak;              ///< Most arena bytes any pipeline reserved
+    uint32_t failures;                ///< Requests refused (no slot or arena full)
+} pipeline_pool_stats_t;
+
+// =============================================================================
+// Pool Functions
+// =============================================================================
+
+/**
+ * @brief Take a free pipeline slot
+ * @return Uninitialized pipeline, NULL if all slots are in use
+ */
+signal_pipeline_t* pipeline_pool_acquire(void);
+
+/**
+ * @brief Return a pipeline slot and everything allocated from its arena
+ */
+void pipeline_pool_release(signal_pipeline_t* pipeline);
+
+/**
+ * @brief Reserve memory from a pipeline's arena (8-byte aligned)
+ *
+ * Arena memory is only returned with the slot.
+ *
+ * @return Zeroed memory, NULL if the arena is full
+ */
+void* pipeline_pool_alloc(signal_pipeline_t* pipeline, uint32_t bytes);
+
+/**
+ * @brief Reserve or grow a pipeline's one stage scratch area (8-byte aligned)
+ *
+ * The area sits at the top of the arena; a larger request extends it
+ * over the old one, so growing scratch as stages are added does not
+ * leak arena space. Pointers from earlier calls are stale afterwards.
+ *
+ * @return Zeroed memory of at least bytes, NULL if the arena is full
+ */
+void* pipeline_pool_scratch(signal_pipeline_t* pipeline, uint32_t bytes);
+
+/**
+ * @brief Arena bytes reserved by one pipeline
+ */
+uint32_t pipeline_pool_used(const signal_pipeline_t* pipeline);
+
+/**
+ * @brief Live pipeline in a slot, for diagnostics that walk all pipelines
+ * @param index Slot index (0..PIPELINE_POOL_SLOTS-1)
+ * @return Pipeline, NULL if the slot is free
+ */
+signal_pipeline_t* pipeline_pool_at(uint32_t index);
+
+/**
+ * @brief Get pool occupancy and high-water marks
+ */
+void pipeline_pool_get_stats(pipeline_pool_stats_t* stats);
+
+#endif // PIPELINE_POOL_H
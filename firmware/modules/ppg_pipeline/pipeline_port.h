@@ -0,0 +1,49 @@
+#ifndef PIPELINE_PORT_H
+#define PIPELINE_PORT_H
+
+/**
+ * @file pipeline_port.h
+ * @brief Zephyr/host portability shims for the signal pipeline modules
+ *
+ * Pipeline modules are plain C99 and also build on the host for tests and
+ * tools; locking and logging go through these macros. There is no
+ * allocation shim: pipeline memory comes from pipeline_pool.h.
+ */
+
+#ifdef __ZEPHYR__
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+// Short copies shared with BLE/config threads (single core: IRQ lock)
+#define PIPELINE_CRITICAL_ENTER()   unsigned int pipeline_irq_key = irq_lock()
+#define PIPELINE_CRITICAL_EXIT()    irq_unlock(pipeline_irq_key)
+
+// Left untouched by startup code, so it survives System ON sleep and warm reset
+#define PIPELINE_RETAINED           __noinit
+
+#else
+
+#include <stdio.h>
+
+#ifdef PIPELINE_HOST_THREADS
+// Host tools running pipelines on several threads (pipeline_pool.c owns the lock)
+#include <pthread.h>
+extern pthread_mutex_t pipeline_host_lock;
+#define PIPELINE_CRITICAL_ENTER()   pthread_mutex_lock(&pipeline_host_lock)
+#define PIPELINE_CRITICAL_EXIT()    pthread_mutex_unlock(&pipeline_host_lock)
+#else
+#define PIPELINE_CRITICAL_ENTER()   do { } while (0)
+#define PIPELINE_CRITICAL_EXIT()    do { } while (0)
+#endif
+#define PIPELINE_RETAINED
+
+#define LOG_MODULE_REGISTER(...)
+#define LOG_ERR(...)            do { fprintf(stderr, __VA_ARGS__); fputc('\n', stderr); } while (0)
+#define LOG_WRN(...)            do { fprintf(stderr, __VA_ARGS__); fputc('\n', stderr); } while (0)
+#define LOG_INF(...)            do { } while (0)
+#define LOG_DBG(...)            do { } while (0)
+
+#endif
+
+#endif // PIPELINE_PORT_H
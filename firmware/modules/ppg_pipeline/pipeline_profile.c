@@ -0,0 +1,361 @@
+/*
+ * Pipeline Profiling Implementation
+ *
+ * Histogram buckets are log-linear: four buckets per power of two from 16
+ * ticks up, so any percentile is known to within 25% of its value with a
+ * fixed 288 bytes per stage. Exact min/max/sum are kept beside it.
+ */
+
+#ifdef CONFIG_PIPELINE_PROFILING
+
+#ifndef __ZEPHYR__
+#define _POSIX_C_SOURCE 199309L
+#endif
+
+#include "pipeline_profile.h"
+#include "pipeline_pool.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifndef __ZEPHYR__
+#include <time.h>
+#endif
+
+#define SUB_BUCKET_BITS     2u
+#define FIRST_OCTAVE        4u      /* Bucket 0 holds everything below 16 ticks */
+#define BLOCK_RECORD_NAME   "block"
+
+/* ==== TICK SOURCE ==== */
+
+#ifdef __ZEPHYR__
+
+void pipeline_profile_init(void)
+{
+    if (!(DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk)) {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CYCCNT = 0;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    }
+}
+
+#else
+
+void pipeline_profile_init(void)
+{
+}
+
+uint32_t pipeline_profile_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    // Wraps every 4.3 s; intervals are taken modulo 2^32 like CYCCNT
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+}
+
+#endif
+
+/* ==== PRIVATE FUNCTIONS ==== */
+
+static uint32_t bucket_of(uint32_t ticks)
+{
+    if (ticks < (1u << FIRST_OCTAVE)) {
+        return 0;
+    }
+
+    uint32_t octave = 31u - (uint32_t)__builtin_clz(ticks);
+    uint32_t sub = (ticks >> (octave - SUB_BUCKET_BITS)) & ((1u << SUB_BUCKET_BITS) - 1u);
+    uint32_t bucket = ((octave - FIRST_OCTAVE) << SUB_BUCKET_BITS) + sub;
+
+    return bucket < PIPELINE_PROFILE_BUCKETS ? bucket : PIPELINE_PROFILE_BUCKETS - 1;
+}
+
+/** Largest tick count that falls in a bucket */
+static uint32_t bucket_upper(uint32_t bucket)
+{
+    uint32_t octave = (bucket >> SUB_BUCKET_BITS) + FIRST_OCTAVE;
+    uint32_t sub = bucket & ((1u << SUB_BUCKET_BITS) - 1u);
+
+    return (((1u << SUB_BUCKET_BITS) + sub + 1u) << (octave - SUB_BUCKET_BITS)) - 1u;
+}
+
+static uint32_t ticks_to_ns(uint64_t ticks)
+{
+    uint64_t ns = ticks * 1000u / PIPELINE_PROFILE_TICKS_PER_US;
+    return ns > UINT32_MAX ? UINT32_MAX : (uint32_t)ns;
+}
+
+static void summarize(const pipeline_profile_entry_t* entry, pipeline_profile_summary_t* summary)
+{
+    memset(summary, 0, sizeof(pipeline_profile_summary_t));
+    if (entry->count == 0) {
+        return;
+    }
+
+    // Smallest bucket holding at least 99% of executions
+    uint32_t target = (uint32_t)(((uint64_t)entry->count * 99u + 99u) / 100u);
+    uint32_t seen = 0;
+    uint32_t p99 = entry->max;
+    for (uint32_t b = 0; b < PIPELINE_PROFILE_BUCKETS; b++) {
+        seen += entry->histogram[b];
+        if (seen >= target) {
+            p99 = bucket_upper(b);
+            break;
+        }
+    }
+    if (p99 > entry->max) {
+        p99 = entry->max;
+    }
+    if (p99 < entry->min) {
+        p99 = entry->min;
+    }
+
+    summary->count = entry->count;
+    summary->min_ns = ticks_to_ns(entry->min);
+    summary->avg_ns = ticks_to_ns(entry->total / entry->count);
+    summary->max_ns = ticks_to_ns(entry->max);
+    summary->p99_ns = ticks_to_ns(p99);
+    summary->last_ns = ticks_to_ns(entry->last);
+}
+
+static void put_u32(uint8_t* p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static void pack_record(uint8_t* p, const char* name, uint8_t signal_type,
+                        const pipeline_profile_entry_t* entry)
+{
+    pipeline_profile_summary_t s;
+    summarize(entry, &s);
+
+    memset(p, 0, PIPELINE_PROFILE_NAME_LEN);
+    strncpy((char*)p, name, PIPELINE_PROFILE_NAME_LEN);
+    p[PIPELINE_PROFILE_NAME_LEN] = signal_type;
+    put_u32(p + 12, s.count);
+    put_u32(p + 16, s.min_ns);
+    put_u32(p + 20, s.avg_ns);
+    put_u32(p + 24, s.p99_ns);
+    put_u32(p + 28, s.max_ns);
+}
+
+/** Append a pipeline's records after the header, return records written */
+static uint32_t pack_pipeline(const signal_pipeline_t* pipeline, uint8_t* data, uint32_t size, uint32_t* pos)
+{
+    uint32_t records = 0;
+    uint8_t type = (uint8_t)pipeline->signal_type;
+
+    if (*pos + PIPELINE_PROFILE_RECORD_SIZE > size) {
+        return 0;
+    }
+    pack_record(data + *pos, BLOCK_RECORD_NAME, type, &pipeline->block_profile);
+    *pos += PIPELINE_PROFILE_RECORD_SIZE;
+    records++;
+
+    for (uint32_t i = 0; i < pipeline->stage_count; i++) {
+        if (*pos + PIPELINE_PROFILE_RECORD_SIZE > size) {
+            break;
+        }
+        const pipeline_stage_t* stage = pipeline->stages[i];
+        pack_record(data + *pos, stage->name, type, &stage->profile);
+        *pos += PIPELINE_PROFILE_RECORD_SIZE;
+        records++;
+    }
+
+    return records;
+}
+
+static void write_header(uint8_t* data, uint32_t records)
+{
+    data[0] = PIPELINE_PROFILE_PACK_VERSION;
+    data[1] = (uint8_t)(records > 255u ? 255u : records);
+    data[2] = 0;
+    data[3] = 0;
+}
+
+/* ==== PUBLIC FUNCTIONS ==== */
+
+void pipeline_profile_record(pipeline_profile_entry_t* entry, uint32_t ticks)
+{
+    if (entry->count == 0 || ticks < entry->min) {
+        entry->min = ticks;
+    }
+    if (ticks > entry->max) {
+        entry->max = ticks;
+    }
+    entry->count++;
+    entry->total += ticks;
+    entry->last = ticks;
+    entry->histogram[bucket_of(ticks)]++;
+}
+
+uint32_t pipeline_profile_ticks_to_us(uint32_t ticks)
+{
+    uint32_t per_us = PIPELINE_PROFILE_TICKS_PER_US;
+    return per_us ? (uint32_t)(((uint64_t)ticks + per_us - 1u) / per_us) : 0;
+}
+
+bool pipeline_profile_get(const signal_pipeline_t* pipeline,
+                          const char* stage_name,
+                          pipeline_profile_summary_t* summary)
+{
+    if (!pipeline || !summary) {
+        return false;
+    }
+
+    if (!stage_name) {
+        summarize(&pipeline->block_profile, summary);
+        return true;
+    }
+
+    for (uint32_t i = 0; i < pipeline->stage_count; i++) {
+        if (strcmp(pipeline->stages[i]->name, stage_name) == 0) {
+            summarize(&pipeline->stages[i]->profile, summary);
+            return true;
+        }
+    }
+    return false;
+}
+
+void pipeline_profile_reset(signal_pipeline_t* pipeline)
+{
+    if (!pipeline) {
+        return;
+    }
+
+    memset(&pipeline->block_profile, 0, sizeof(pipeline_profile_entry_t));
+    for (uint32_t i = 0; i < pipeline->stage_count; i++) {
+        memset(&pipeline->stages[i]->profile, 0, sizeof(pipeline_profile_entry_t));
+    }
+}
+
+uint32_t pipeline_profile_format(const signal_pipeline_t* pipeline, char* text, uint32_t size)
+{
+    if (!pipeline || !text || size == 0) {
+        return 0;
+    }
+
+    int n = snprintf(text, size, "%-12s %8s %9s %9s %9s %9s (us)\n",
+                     "stage", "count", "min", "avg", "p99", "max");
+    if (n < 0 || (uint32_t)n >= size) {
+        text[0] = '\0';
+        return 0;
+    }
+    uint32_t pos = (uint32_t)n;
+
+    // Block row first, then stages in insertion order
+    for (int32_t i = -1; i < (int32_t)pipeline->stage_count; i++) {
+        const char* name = i < 0 ? BLOCK_RECORD_NAME : pipeline->stages[i]->name;
+        pipeline_profile_summary_t s;
+
+        summarize(i < 0 ? &pipeline->block_profile : &pipeline->stages[i]->profile, &s);
+
+        // Integer microseconds with one decimal; no float printf on target
+        n = snprintf(text + pos, size - pos, "%-12.12s %8u %7u.%u %7u.%u %7u.%u %7u.%u\n",
+                     name, (unsigned)s.count,
+                     (unsigned)(s.min_ns / 1000u), (unsigned)(s.min_ns % 1000u / 100u),
+                     (unsigned)(s.avg_ns / 1000u), (unsigned)(s.avg_ns % 1000u / 100u),
+                     (unsigned)(s.p99_ns / 1000u), (unsigned)(s.p99_ns % 1000u / 100u),
+                     (unsigned)(s.max_ns / 1000u), (unsigned)(s.max_ns % 1000u / 100u));
+        if (n < 0 || (uint32_t)n >= size - pos) {
+            text[pos] = '\0';
+            break;
+        }
+        pos += (uint32_t)n;
+    }
+
+    return pos;
+}
+
+uint32_t pipeline_profile_pack(const signal_pipeline_t* pipeline, uint8_t* data, uint32_t size)
+{
+    uint32_t pos = 4;
+
+    if (!pipeline || !data || size < pos) {
+        return 0;
+    }
+
+    write_header(data, pack_pipeline(pipeline, data, size, &pos));
+    return pos;
+}
+
+bool pipeline_profile_ble_read(ble_char_value_t* value, uint32_t* length)
+{
+    uint32_t pos = 4;
+    uint32_t records = 0;
+
+    if (!value || !value->data || value->max_length < pos) {
+        return false;
+    }
+
+    uint8_t* data = (uint8_t*)value->data;
+    for (uint32_t i = 0; i < PIPELINE_POOL_SLOTS; i++) {
+        const signal_pipeline_t* pipeline = pipeline_pool_at(i);
+        if (pipeline) {
+            records += pack_pipeline(pipeline, data, value->max_length, &pos);
+        }
+    }
+    write_header(data, records);
+
+    value->current_length = pos;
+    if (length) {
+        *length = pos;
+    }
+    return true;
+}
+
+/* ==== SHELL COMMANDS ==== */
+
+#if defined(__ZEPHYR__) && defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+
+static int cmd_profile_show(const struct shell* sh, size_t argc, char** argv)
+{
+    static char text[640];
+    bool any = false;
+
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    for (uint32_t i = 0; i < PIPELINE_POOL_SLOTS; i++) {
+        const signal_pipeline_t* pipeline = pipeline_pool_at(i);
+        if (!pipeline) {
+            continue;
+        }
+        pipeline_profile_format(pipeline, text, sizeof(text));
+        shell_print(sh, "pipeline %u (signal type %u)", (unsigned)i, (unsigned)pipeline->signal_type);
+        shell_fprintf(sh, SHELL_NORMAL, "%s", text);
+        any = true;
+    }
+
+    if (!any) {
+        shell_print(sh, "no pipelines");
+    }
+    return 0;
+}
+
+static int cmd_profile_reset(const struct shell* sh, size_t argc, char** argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    for (uint32_t i = 0; i < PIPELINE_POOL_SLOTS; i++) {
+        pipeline_profile_reset(pipeline_pool_at(i));
+    }
+    shell_print(sh, "profiles cleared");
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_pipeline_profile,
+    SHELL_CMD(show, NULL, "Per-stage min/avg/p99/max execution time", cmd_profile_show),
+    SHELL_CMD(reset, NULL, "Clear all profiles", cmd_profile_reset),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(pipeline_profile, &sub_pipeline_profile, "Signal pipeline profiling", NULL);
+
+#endif
+
+#endif // CONFIG_PIPELINE_PROFILING
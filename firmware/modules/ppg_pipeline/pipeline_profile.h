@@ -0,0 +1,149 @@
+#ifndef PIPELINE_PROFILE_H
+#define PIPELINE_PROFILE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "interfaces/signal_pipeline_interfaces.h"
+
+/**
+ * @file pipeline_profile.h
+ * @brief Per-stage execution time profiling
+ *
+ * With CONFIG_PIPELINE_PROFILING defined, every process() call and every
+ * block is timed with the DWT cycle counter on target (clock_gettime on
+ * host) into a log-scale histogram per stage, giving min/avg/max/p99
+ * without storing samples. The engine also fills stage processing_time_us
+ * and pipeline total_latency_us, which get_status() and
+ * pipeline_get_metrics() report.
+ *
+ * Results are readable with the `pipeline_profile` shell command and
+ * through pipeline_profile_ble_read(), the read callback for the BLE
+ * diagnostics characteristic.
+ *
+ * Without CONFIG_PIPELINE_PROFILING the timing hooks expand to nothing
+ * and the profile fields do not exist, so there is no cost in code, RAM
+ * or cycles.
+ */
+
+// =============================================================================
+// Engine Hooks
+// =============================================================================
+
+#ifdef CONFIG_PIPELINE_PROFILING
+
+#ifdef __ZEPHYR__
+#include <cmsis_core.h>
+
+/** Profiler ticks are CPU cycles */
+static inline uint32_t pipeline_profile_now(void)
+{
+    return DWT->CYCCNT;
+}
+#define PIPELINE_PROFILE_TICKS_PER_US   (SystemCoreClock / 1000000u)
+#else
+/** Profiler ticks are nanoseconds of CLOCK_MONOTONIC */
+uint32_t pipeline_profile_now(void);
+#define PIPELINE_PROFILE_TICKS_PER_US   1000u
+#endif
+
+/**
+ * @brief Start the tick source (enables the DWT counter; idempotent)
+ */
+void pipeline_profile_init(void);
+
+/**
+ * @brief Add one measurement to a profile entry
+ */
+void pipeline_profile_record(pipeline_profile_entry_t* entry, uint32_t ticks);
+
+/**
+ * @brief Convert ticks to whole microseconds, rounded up
+ */
+uint32_t pipeline_profile_ticks_to_us(uint32_t ticks);
+
+#define PIPELINE_PROFILE_INIT()             pipeline_profile_init()
+#define PIPELINE_PROFILE_BEGIN(start)       uint32_t start = pipeline_profile_now()
+#define PIPELINE_PROFILE_END(start, entry, us) \
+    do { \
+        uint32_t profile_ticks_ = pipeline_profile_now() - (start); \
+        pipeline_profile_record((entry), profile_ticks_); \
+        (us) = pipeline_profile_ticks_to_us(profile_ticks_); \
+    } while (0)
+
+#else
+
+#define PIPELINE_PROFILE_INIT()             do { } while (0)
+#define PIPELINE_PROFILE_BEGIN(start)
+#define PIPELINE_PROFILE_END(start, entry, us) do { } while (0)
+
+#endif // CONFIG_PIPELINE_PROFILING
+
+#ifdef CONFIG_PIPELINE_PROFILING
+
+#include "interfaces/ble_service_interfaces.h"
+
+// =============================================================================
+// Reporting
+// =============================================================================
+
+#define PIPELINE_PROFILE_NAME_LEN       11    ///< Stage name bytes in a packed record
+#define PIPELINE_PROFILE_RECORD_SIZE    32    ///< Packed record size
+#define PIPELINE_PROFILE_PACK_VERSION   1
+
+/**
+ * @brief Summary of one profile entry in nanoseconds
+ */
+typedef struct {
+    uint32_t count;                   ///< Executions measured
+    uint32_t min_ns;
+    uint32_t avg_ns;
+    uint32_t max_ns;
+    uint32_t p99_ns;                  ///< Upper edge of the p99 histogram bucket (<= max)
+    uint32_t last_ns;
+} pipeline_profile_summary_t;
+
+/**
+ * @brief Summarize a stage, or whole blocks
+ * @param pipeline Pipeline instance
+ * @param stage_name Stage name, NULL for the block profile
+ * @param summary Output summary
+ * @return false if the stage does not exist
+ */
+bool pipeline_profile_get(const signal_pipeline_t* pipeline,
+                          const char* stage_name,
+                          pipeline_profile_summary_t* summary);
+
+/**
+ * @brief Clear all profile entries of a pipeline
+ */
+void pipeline_profile_reset(signal_pipeline_t* pipeline);
+
+/**
+ * @brief Format a profile table (microseconds) for shell or log output
+ * @return Characters written, excluding the terminator
+ */
+uint32_t pipeline_profile_format(const signal_pipeline_t* pipeline, char* text, uint32_t size);
+
+/**
+ * @brief Pack profile records for BLE
+ *
+ * Layout (little endian): a 4-byte header {version, record_count, 0, 0},
+ * then per record: name[11] (NUL padded), signal_type, count, min_ns,
+ * avg_ns, p99_ns, max_ns. The block record is named "block" and comes
+ * first; records that do not fit are dropped.
+ *
+ * @return Bytes written (0 if not even the header fits)
+ */
+uint32_t pipeline_profile_pack(const signal_pipeline_t* pipeline, uint8_t* data, uint32_t size);
+
+/**
+ * @brief BLE diagnostics characteristic read callback
+ *
+ * Packs every live pipeline into value->data (up to value->max_length)
+ * under a single header.
+ */
+bool pipeline_profile_ble_read(ble_char_value_t* value, uint32_t* length);
+
+#endif // CONFIG_PIPELINE_PROFILING
+
+#endif // PIPELINE_PROFILE_H
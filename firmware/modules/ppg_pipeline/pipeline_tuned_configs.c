@@ -0,0 +1,509 @@
+/*
+ * Tuned PPG Stage Configurations
+ *
+ * GENERATED by tools/pipeline_tuner (make tune) - do not edit.
+ *
+ * 756 configurations per sensor scored on 10 simulated and 0 recorded
+ * recordings at 50 Hz. Error is mean |HR - reference| per 0.5 s block after
+ * 10 s warm-up, a block without HR counting 20 bpm; cost is host CPU
+ * time per sample and only ranks the candidates against each other.
+ */
+
+#include "pipeline_tuning.h"
+#include "ppg_stages.h"
+#include "motion_canceller.h"
+
+const pipeline_tuned_point_t pipeline_tuned_points[] = {
+    {
+        .sensor = "MAX30101",
+        .use_cases = 0,
+        .hr_error_bpm = 5.808f,
+        .coverage = 1.000f,
+        .cost_ns_per_sample = 29.1f,
+        .filter = {
+            .enabled = true,
+            .buffer_size = 32,
+            .parameters = {
+                [PPG_FILTER_PARAM_LOW_HZ] = 0.4f,
+                [PPG_FILTER_PARAM_HIGH_HZ] = 5.0f,
+                [PPG_FILTER_PARAM_ORDER] = 4.0f,
+                [PPG_FILTER_PARAM_DC_ALPHA] = 0.99f,
+            },
+            .parameter_count = PPG_FILTER_PARAM_COUNT,
+            .algorithm_name = "filter"
+        },
+        .artifact = {
+            .enabled = false,
+            .buffer_size = 32,
+            .parameters = {
+                [MOTION_CANCELLER_PARAM_TAPS] = 8.0f,
+                [MOTION_CANCELLER_PARAM_STEP_SIZE] = 0.01f,
+                [MOTION_CANCELLER_PARAM_MOTION_THRESHOLD] = 0.0025f,
+                [MOTION_CANCELLER_PARAM_CORRELATION] = 0.1f,
+                [MOTION_CANCELLER_PARAM_HANGOVER] = 2.0f,
+            },
+            .parameter_count = MOTION_CANCELLER_PARAM_COUNT,
+            .algorithm_name = "artifact"
+        },
+        .feature = {
+            .enabled = true,
+            .buffer_size = 32,
+            .parameters = {
+                [PPG_FEATURE_PARAM_HYSTERESIS] = 0.6f,
+                [PPG_FEATURE_PARAM_MIN_DISTANCE_MS] = 270.0f,
+                [PPG_FEATURE_PARAM_HR_WINDOW] = 4.0f,
+            },
+            .parameter_count = PPG_FEATURE_PARAM_COUNT,
+            .algorithm_name = "hr"
+        }
+    },
+    {
+        .sensor = "MAX30101",
+        .use_cases = 0,
+        .hr_error_bpm = 5.325f,
+        .coverage = 1.000f,
+        .cost_ns_per_sample = 32.6f,
+        .filter = {
+            .enabled = true,
+            .buffer_size = 32,
+            .parameters = {
+                [PPG_FILTER_PARAM_LOW_HZ] = 0.4f,
+                [PPG_FILTER_PARAM_HIGH_HZ] = 5.0f,
+                [PPG_FILTER_PARAM_ORDER] = 4.0f,
+                [PPG_FILTER_PARAM_DC_ALPHA] = 0.99f,
+            },
+            .parameter_count = PPG_FILTER_PARAM_COUNT,
+            .algorithm_name = "filter"
+        },
+        .artifact = {
+            .enabled = false,
+            .buffer_size = 32,
+            .parameters = {
+                [MOTION_CANCELLER_PARAM_TAPS] = 8.0f,
+                [MOTION_CANCELLER_PARAM_STEP_SIZE] = 0.01f,
+                [MOTION_CANCELLER_PARAM_MOTION_THRESHOLD] = 0.0025f,
+                [MOTION_CANCELLER_PARAM_CORRELATION] = 0.1f,
+                [MOTION_CANCELLER_PARAM_HANGOVER] = 2.0f,
+            },
+            .parameter_count = MOTION_CANCELLER_PARAM_COUNT,
+            .algorithm_name = "artifact"
+        },
+        .feature = {
+            .enabled = true,
+            .buffer_size = 32,
+            .parameters = {
+                [PPG_FEATURE_PARAM_HYSTERESIS] = 0.6f,
+                [PPG_FEATURE_PARAM_MIN_DISTANCE_MS] = 270.0f,
+                [PPG_FEATURE_PARAM_HR_WINDOW] = 8.0f,
+            },
+            .parameter_count = PPG_FEATURE_PARAM_COUNT,
+            .algorithm_name = "hr"
+        }
+    },
+    {
+        .sensor = "MAX30101",
+        .use_cases = PIPELINE_USE_BALANCED | PIPELINE_USE_LOW_POWER,
+        .hr_error_bpm = 1.383f,
+        .coverage = 1.000f,
+        .cost_ns_per_sample = 46.9f,
+        .filter = {
+            .enabled = true,
+            .buffer_size = 32,
+            .parameters = {
+                [PPG_FILTER_PARAM_LOW_HZ] = 0.4f,
+                [PPG_FILTER_PARAM_HIGH_HZ] = 5.0f,
+                [PPG_FILTER_PARAM_ORDER] = 2.0f,
+                [PPG_FILTER_PARAM_DC_ALPHA] = 0.99f,
+            },
+            .parameter_count = PPG_FILTER_PARAM_COUNT,
+            .algorithm_name = "filter"
+        },
+        .artifact = {
+            .enabled = true,
+            .buffer_size = 32,
+            .parameters = {
+                [MOTION_CANCELLER_PARAM_TAPS] = 4.0f,
+                [MOTION_CANCELLER_PARAM_STEP_SIZE] = 0.02f,
+                [MOTION_CANCELLER_PARAM_MOTION_THRESHOLD] = 0.0025f,
+                [MOTION_CANCELLER_PARAM_CORRELATION] = 0.1f,
+                [MOTION_CANCELLER_PARAM_HANGOVER] = 2.0f,
+            },
+            .parameter_count = MOTION_CANCELLER_PARAM_COUNT,
+            .algorithm_name = "artifact"
+        },
+        .feature = {
+            .enabled = true,
+            .buffer_size = 32,
+            .parameters = {
+                [PPG_FEATURE_PARAM_HYSTERESIS] = 0.6f,
+                [PPG_FEATURE_PARAM_MIN_DISTANCE_MS] = 270.0f,
+                [PPG_FEATURE_PARAM_HR_WINDOW] = 8.0f,
+            },
+            .parameter_count = PPG_FEATURE_PARAM_COUNT,
+            .algorithm_name = "hr"
+        }
+    },
+    {
+        .sensor = "MAX30101",
+        .use_cases = PIPELINE_USE_ACCURACY,
+        .hr_error_bpm = 1.379f,
+        .coverage = 1.000f,
+        .cost_ns_per_sample = 55.3f,
+        .filter = {
+            .enabled = true,
+            .buffer_size = 32,
+            .parameters = {
+                [PPG_FILTER_PARAM_LOW_HZ] = 0.4f,
+                [PPG_FILTER_PARAM_HIGH_HZ] = 5.0f,
+                [PPG_FILTER_PARAM_ORDER] = 2.0f,
+                [PPG_FILTER_PARAM_DC_ALPHA] = 0.99f,
+            },
+            .parameter_count = PPG_FILTER_PARAM_COUNT,
+            .algorithm_name = "filter"
+        },
+        .artifact = {
+            .enabled = true,
+            .buffer_size = 32,
+            .parameters = {
+                [MOTION_CANCELLER_PARAM_TAPS] = 8.0f,
+                [MOTION_CANCELLER_PARAM_STEP_SIZE] = 0.005f,
+                [MOTION_CANCELLER_PARAM_MOTION_THRESHOLD] = 0.0025f,
+                [MOTION_CANCELLER_PARAM_CORRELATION] = 0.1f,
+                [MOTION_CANCELLER_PARAM_HANGOVER] = 2.0f,
+            },
+            .parameter_count = MOTION_CANCELLER_PARAM_COUNT,
+            .algorithm_name = "artifact"
+        },
+        .feature = {
+            .enabled = true,
+            .buffer_size = 32,
+            .parameters = {
+                [PPG_FEATURE_PARAM_HYSTERESIS] = 0.6f,
+                [PPG_FEATURE_PARAM_MIN_DISTANCE_MS] = 270.0f,
+                [PPG_FEATURE_PARAM_HR_WINDOW] = 8.0f,
+            },
+            .parameter_count = PPG_FEATURE_PARAM_COUNT,
+            .algorithm_name = "hr"
+        }
+    },
+    {
+        .sensor = "MAX86141",
+        .use_cases = 0,
+        .hr_error_bpm = 5.830f,
+        .coverage = 1.000f,
+        .cost_ns_per_sample = 29.0f,
+        .filter = {
+            .enabled = true,
+            .buffer_size = 32,
+            .parameters = {
+                [PPG_FILTER_PARAM_LOW_HZ] = 0.25f,
+                [PPG_FILTER_PARAM_HIGH_HZ] = 4.0f,
+                [PPG_FILTER_PARAM_ORDER] = 2.0f,
+                [PPG_FILTER_PARAM_DC_ALPHA] = 0.99f,
+            },
+            .parameter_count = PPG_FILTER_PARAM_COUNT,
+            .algorithm_name = "filter"
+        },
+        .artifact = {
+            .enabled = false,
+            .buffer_size = 32,
+            .parameters = {
+                [MOTION_CANCELLER_PARAM_TAPS] = 8.0f,
+                [MOTION_CANCELLER_PARAM_STEP_SIZE] = 0.01f,
+                [MOTION_CANCELLER_PARAM_MOTION_THRESHOLD] = 0.0025f,
+                [MOTION_CANCELLER_PARAM_CORRELATION] = 0.1f,
+                [MOTION_CANCELLER_PARAM_HANGOVER] = 2.0f,
+            },
+            .parameter_count = MOTION_CANCELLER_PARAM_COUNT,
+            .algorithm_name = "artifact"
+        },
+        .feature = {
+            .enabled = true,
+            .buffer_size = 32,
+            .parameters = {
+                [PPG_FEATURE_PARAM_HYSTERESIS] = 0.6f,
+                [PPG_FEATURE_PARAM_MIN_DISTANCE_MS] = 270.0f,
+                [PPG_FEATURE_PARAM_HR_WINDOW] = 4.0f,
+            },
+            .parameter_count = PPG_FEATURE_PARAM_COUNT,
+            .algorithm_name = "hr"
+        }
+    },
+    {
+        .sensor = "MAX86141",
+        .use_cases = 0,
+        .hr_error_bpm = 5.513f,
+        .coverage = 1.000f,
+        .cost_ns_per_sample = 30.5f,
+        .filter = {
+            .enabled = true,
+            .buffer_size = 32,
+            .parameters = {
+                [PPG_FILTER_PARAM_LOW_HZ] = 0.25f,
+                [PPG_FILTER_PARAM_HIGH_HZ] = 5.0f,
+                [PPG_FILTER_PARAM_ORDER] = 4.0f,
+                [PPG_FILTER_PARAM_DC_ALPHA] = 0.99f,
+            },
+            .parameter_count = PPG_FILTER_PARAM_COUNT,
+            .algorithm_name = "filter"
+        },
+        .artifact = {
+            .enabled = false,
+            .buffer_size = 32,
+            .parameters = {
+                [MOTION_CANCELLER_PARAM_TAPS] = 8.0f,
+                [MOTION_CANCELLER_PARAM_STEP_SIZE] = 0.01f,
+                [MOTION_CANCELLER_PARAM_MOTION_THRESHOLD] = 0.0025f,
+                [MOTION_CANCELLER_PARAM_CORRELATION] = 0.1f,
+                [MOTION_CANCELLER_PARAM_HANGOVER] = 2.0f,
+            },
+            .parameter_count = MOTION_CANCELLER_PARAM_COUNT,
+            .algorithm_name = "artifact"
+        },
+        .feature = {
+            .enabled = true,
+            .buffer_size = 32,
+            .parameters = {
+                [PPG_FEATURE_PARAM_HYSTERESIS] = 0.6f,
+                [PPG_FEATURE_PARAM_MIN_DISTANCE_MS] = 270.0f,
+                [PPG_FEATURE_PARAM_HR_WINDOW] = 4.0f,
+            },
+            .parameter_count = PPG_FEATURE_PARAM_COUNT,
+            .algorithm_name = "hr"
+        }
+    },
+    {
+        .sensor = "MAX86141",
+        .use_cases = 0,
+        .hr_error_bpm = 5.407f,
+        .coverage = 1.000f,
+        .cost_ns_per_sample = 33.5f,
+        .filter = {
+            .enabled = true,
+            .buffer_size = 32,
+            .parameters = {
+                [PPG_FILTER_PARAM_LOW_HZ] = 0.4f,
+                [PPG_FILTER_PARAM_HIGH_HZ] = 5.0f,
+                [PPG_FILTER_PARAM_ORDER] = 4.0f,
+                [PPG_FILTER_PARAM_DC_ALPHA] = 0.99f,
+            },
+            .parameter_count = PPG_FILTER_PARAM_COUNT,
+            .algorithm_name = "filter"
+        },
+        .artifact = {
+            .enabled = false,
+            .buffer_size = 32,
+            .parameters = {
+                [MOTION_CANCELLER_PARAM_TAPS] = 8.0f,
+                [MOTION_CANCELLER_PARAM_STEP_SIZE] = 0.01f,
+                [MOTION_CANCELLER_PARAM_MOTION_THRESHOLD] = 0.0025f,
+                [MOTION_CANCELLER_PARAM_CORRELATION] = 0.1f,
+                [MOTION_CANCELLER_PARAM_HANGOVER] = 2.0f,
+            },
+            .parameter_count = MOTION_CANCELLER_PARAM_COUNT,
+            .algorithm_name = "artifact"
+        },
+        .feature = {
+            .enabled = true,
+            .buffer_size = 32,
+            .parameters = {
+                [PPG_FEATURE_PARAM_HYSTERESIS] = 0.6f,
+                [PPG_FEATURE_PARAM_MIN_DISTANCE_MS] = 270.0f,
+                [PPG_FEATURE_PARAM_HR_WINDOW] = 8.0f,
+            },
+            .parameter_count = PPG_FEATURE_PARAM_COUNT,
+            .algorithm_name = "hr"
+        }
+    },
+    {
+        .sensor = "MAX86141",
+        .use_cases = PIPELINE_USE_BALANCED | PIPELINE_USE_LOW_POWER,
+        .hr_error_bpm = 1.397f,
+        .coverage = 1.000f,
+        .cost_ns_per_sample = 45.5f,
+        .filter = {
+            .enabled = true,
+            .buffer_size = 32,
+            .parameters = {
+                [PPG_FILTER_PARAM_LOW_HZ] = 0.4f,
+                [PPG_FILTER_PARAM_HIGH_HZ] = 5.0f,
+                [PPG_FILTER_PARAM_ORDER] = 2.0f,
+                [PPG_FILTER_PARAM_DC_ALPHA] = 0.99f,
+            },
+            .parameter_count = PPG_FILTER_PARAM_COUNT,
+            .algorithm_name = "filter"
+        },
+        .artifact = {
+            .enabled = true,
+            .buffer_size = 32,
+            .parameters = {
+                [MOTION_CANCELLER_PARAM_TAPS] = 4.0f,
+                [MOTION_CANCELLER_PARAM_STEP_SIZE] = 0.02f,
+                [MOTION_CANCELLER_PARAM_MOTION_THRESHOLD] = 0.0025f,
+                [MOTION_CANCELLER_PARAM_CORRELATION] = 0.1f,
+                [MOTION_CANCELLER_PARAM_HANGOVER] = 2.0f,
+            },
+            .parameter_count = MOTION_CANCELLER_PARAM_COUNT,
+            .algorithm_name = "artifact"
+        },
+        .feature = {
+            .enabled = true,
+            .buffer_size = 32,
+            .parameters = {
+                [PPG_FEATURE_PARAM_HYSTERESIS] = 0.6f,
+                [PPG_FEATURE_PARAM_MIN_DISTANCE_MS] = 270.0f,
+                [PPG_FEATURE_PARAM_HR_WINDOW] = 8.0f,
+            },
+            .parameter_count = PPG_FEATURE_PARAM_COUNT,
+            .algorithm_name = "hr"
+        }
+    },
+    {
+        .sensor = "MAX86141",
+        .use_cases = PIPELINE_USE_ACCURACY,
+        .hr_error_bpm = 1.372f,
+        .coverage = 1.000f,
+        .cost_ns_per_sample = 54.4f,
+        .filter = {
+            .enabled = true,
+            .buffer_size = 32,
+            .parameters = {
+                [PPG_FILTER_PARAM_LOW_HZ] = 0.25f,
+                [PPG_FILTER_PARAM_HIGH_HZ] = 3.0f,
+                [PPG_FILTER_PARAM_ORDER] = 4.0f,
+                [PPG_FILTER_PARAM_DC_ALPHA] = 0.99f,
+            },
+            .parameter_count = PPG_FILTER_PARAM_COUNT,
+            .algorithm_name = "filter"
+        },
+        .artifact = {
+            .enabled = true,
+            .buffer_size = 32,
+            .parameters = {
+                [MOTION_CANCELLER_PARAM_TAPS] = 8.0f,
+                [MOTION_CANCELLER_PARAM_STEP_SIZE] = 0.02f,
+                [MOTION_CANCELLER_PARAM_MOTION_THRESHOLD] = 0.0025f,
+                [MOTION_CANCELLER_PARAM_CORRELATION] = 0.1f,
+                [MOTION_CANCELLER_PARAM_HANGOVER] = 2.0f,
+            },
+            .parameter_count = MOTION_CANCELLER_PARAM_COUNT,
+            .algorithm_name = "artifact"
+        },
+        .feature = {
+            .enabled = true,
+            .buffer_size = 32,
+            .parameters = {
+                [PPG_FEATURE_PARAM_HYSTERESIS] = 0.45f,
+                [PPG_FEATURE_PARAM_MIN_DISTANCE_MS] = 270.0f,
+                [PPG_FEATURE_PARAM_HR_WINDOW] = 8.0f,
+            },
+            .parameter_count = PPG_FEATURE_PARAM_COUNT,
+            .algorithm_name = "hr"
+        }
+    },
+};
+
+const uint32_t pipeline_tuned_point_count =
+    sizeof(pipeline_tuned_points) / sizeof(pipeline_tuned_points[0]);
+
+// MAX30101 balanced: 1.38 bpm, 100% coverage
+const pipeline_stage_config_t PPG_MAX30101_PREPROCESS_CONFIG = {
+    .enabled = true,
+    .buffer_size = 32,
+    .parameters = {
+        [PPG_PREPROCESS_PARAM_CHANNEL] = 0.0f,
+        [PPG_PREPROCESS_PARAM_SCALE] = 1.0f,
+    },
+    .parameter_count = PPG_PREPROCESS_PARAM_COUNT,
+    .algorithm_name = "pre"
+};
+
+const pipeline_stage_config_t PPG_MAX30101_FILTER_CONFIG = {
+    .enabled = true,
+    .buffer_size = 32,
+    .parameters = {
+        [PPG_FILTER_PARAM_LOW_HZ] = 0.4f,
+        [PPG_FILTER_PARAM_HIGH_HZ] = 5.0f,
+        [PPG_FILTER_PARAM_ORDER] = 2.0f,
+        [PPG_FILTER_PARAM_DC_ALPHA] = 0.99f,
+    },
+    .parameter_count = PPG_FILTER_PARAM_COUNT,
+    .algorithm_name = "filter"
+};
+
+const pipeline_stage_config_t PPG_MAX30101_ARTIFACT_CONFIG = {
+    .enabled = true,
+    .buffer_size = 32,
+    .parameters = {
+        [MOTION_CANCELLER_PARAM_TAPS] = 4.0f,
+        [MOTION_CANCELLER_PARAM_STEP_SIZE] = 0.02f,
+        [MOTION_CANCELLER_PARAM_MOTION_THRESHOLD] = 0.0025f,
+        [MOTION_CANCELLER_PARAM_CORRELATION] = 0.1f,
+        [MOTION_CANCELLER_PARAM_HANGOVER] = 2.0f,
+    },
+    .parameter_count = MOTION_CANCELLER_PARAM_COUNT,
+    .algorithm_name = "artifact"
+};
+
+const pipeline_stage_config_t PPG_MAX30101_FEATURE_CONFIG = {
+    .enabled = true,
+    .buffer_size = 32,
+    .parameters = {
+        [PPG_FEATURE_PARAM_HYSTERESIS] = 0.6f,
+        [PPG_FEATURE_PARAM_MIN_DISTANCE_MS] = 270.0f,
+        [PPG_FEATURE_PARAM_HR_WINDOW] = 8.0f,
+    },
+    .parameter_count = PPG_FEATURE_PARAM_COUNT,
+    .algorithm_name = "hr"
+};
+
+// MAX86141 balanced: 1.40 bpm, 100% coverage
+const pipeline_stage_config_t PPG_MAX86141_PREPROCESS_CONFIG = {
+    .enabled = true,
+    .buffer_size = 32,
+    .parameters = {
+        [PPG_PREPROCESS_PARAM_CHANNEL] = 0.0f,
+        [PPG_PREPROCESS_PARAM_SCALE] = 1.0f,
+    },
+    .parameter_count = PPG_PREPROCESS_PARAM_COUNT,
+    .algorithm_name = "pre"
+};
+
+const pipeline_stage_config_t PPG_MAX86141_FILTER_CONFIG = {
+    .enabled = true,
+    .buffer_size = 32,
+    .parameters = {
+        [PPG_FILTER_PARAM_LOW_HZ] = 0.4f,
+        [PPG_FILTER_PARAM_HIGH_HZ] = 5.0f,
+        [PPG_FILTER_PARAM_ORDER] = 2.0f,
+        [PPG_FILTER_PARAM_DC_ALPHA] = 0.99f,
+    },
+    .parameter_count = PPG_FILTER_PARAM_COUNT,
+    .algorithm_name = "filter"
+};
+
+const pipeline_stage_config_t PPG_MAX86141_ARTIFACT_CONFIG = {
+    .enabled = true,
+    .buffer_size = 32,
+    .parameters = {
+        [MOTION_CANCELLER_PARAM_TAPS] = 4.0f,
+        [MOTION_CANCELLER_PARAM_STEP_SIZE] = 0.02f,
+        [MOTION_CANCELLER_PARAM_MOTION_THRESHOLD] = 0.0025f,
+        [MOTION_CANCELLER_PARAM_CORRELATION] = 0.1f,
+        [MOTION_CANCELLER_PARAM_HANGOVER] = 2.0f,
+    },
+    .parameter_count = MOTION_CANCELLER_PARAM_COUNT,
+    .algorithm_name = "artifact"
+};
+
+const pipeline_stage_config_t PPG_MAX86141_FEATURE_CONFIG = {
+    .enabled = true,
+    .buffer_size = 32,
+    .parameters = {
+        [PPG_FEATURE_PARAM_HYSTERESIS] = 0.6f,
+        [PPG_FEATURE_PARAM_MIN_DISTANCE_MS] = 270.0f,
+        [PPG_FEATURE_PARAM_HR_WINDOW] = 8.0f,
+    },
+    .parameter_count = PPG_FEATURE_PARAM_COUNT,
+    .algorithm_name = "hr"
+};
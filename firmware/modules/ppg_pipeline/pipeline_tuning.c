@@ -0,0 +1,176 @@
+/*
+ * Pipeline Tuning Implementation
+ *
+ * Looks up the generated Pareto table and stages its configs on the
+ * matching nodes of a running pipeline. Migrating between sensors keeps
+ * the use case: the point the pipeline currently runs is recognised in
+ * the old sensor's front and the same use case is taken from the new one.
+ */
+
+#include "pipeline_tuning.h"
+#include "pipeline_port.h"
+#include "ppg_stages.h"
+#include "motion_canceller.h"
+#include <string.h>
+
+LOG_MODULE_REGISTER(pipeline_tuning, LOG_LEVEL_INF);
+
+static const struct {
+    const char* name;
+    uint32_t flag;
+} use_case_names[] = {
+    { "accuracy",  PIPELINE_USE_ACCURACY },
+    { "balanced",  PIPELINE_USE_BALANCED },
+    { "low_power", PIPELINE_USE_LOW_POWER },
+};
+
+/* ==== PRIVATE FUNCTIONS ==== */
+
+static uint32_t use_case_flag(const char* use_case)
+{
+    if (!use_case) {
+        return PIPELINE_USE_BALANCED;
+    }
+
+    for (uint32_t i = 0; i < sizeof(use_case_names) / sizeof(use_case_names[0]); i++) {
+        if (strcmp(use_case_names[i].name, use_case) == 0) {
+            return use_case_names[i].flag;
+        }
+    }
+    return 0;
+}
+
+static const pipeline_stage_config_t* point_config_for(const pipeline_tuned_point_t* point,
+                                                       const pipeline_stage_t* stage)
+{
+    if (stage->ops == &ppg_filter_stage_ops) {
+        return &point->filter;
+    }
+    if (stage->ops == &motion_canceller_stage_ops) {
+        return &point->artifact;
+    }
+    if (stage->ops == &ppg_feature_stage_ops) {
+        return &point->feature;
+    }
+    return NULL;
+}
+
+static bool same_parameters(const pipeline_stage_config_t* a, const pipeline_stage_config_t* b)
+{
+    if (a->enabled != b->enabled || a->parameter_count != b->parameter_count) {
+        return false;
+    }
+    for (uint32_t i = 0; i < a->parameter_count && i < PIPELINE_MAX_PARAMS; i++) {
+        if (a->parameters[i] != b->parameters[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** Use cases of the old sensor's point the pipeline is running (0: none) */
+static uint32_t current_use_cases(const signal_pipeline_t* pipeline, const char* sensor)
+{
+    for (uint32_t p = 0; p < pipeline_tuned_point_count; p++) {
+        const pipeline_tuned_point_t* point = &pipeline_tuned_points[p];
+        bool matched = false;
+        bool differs = false;
+
+        if (strcmp(point->sensor, sensor) != 0 || point->use_cases == 0) {
+            continue;
+        }
+
+        for (uint32_t i = 0; i < pipeline->stage_count && !differs; i++) {
+            const pipeline_stage_t* stage = pipeline->stages[i];
+            const pipeline_stage_config_t* tuned = point_config_for(point, stage);
+            if (tuned) {
+                matched = true;
+                differs = !same_parameters(tuned, &stage->config);
+            }
+        }
+
+        if (matched && !differs) {
+            return point->use_cases;
+        }
+    }
+    return 0;
+}
+
+/* ==== PUBLIC FUNCTIONS ==== */
+
+const pipeline_tuned_point_t* pipeline_tuned_lookup(const char* sensor, const char* use_case)
+{
+    uint32_t flag = use_case_flag(use_case);
+
+    if (!sensor || flag == 0) {
+        return NULL;
+    }
+
+    for (uint32_t p = 0; p < pipeline_tuned_point_count; p++) {
+        const pipeline_tuned_point_t* point = &pipeline_tuned_points[p];
+        if ((point->use_cases & flag) && strcmp(point->sensor, sensor) == 0) {
+            return point;
+        }
+    }
+    return NULL;
+}
+
+bool pipeline_apply_tuned_point(signal_pipeline_t* pipeline, const pipeline_tuned_point_t* point)
+{
+    bool applied = false;
+
+    if (!pipeline || !point) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < pipeline->stage_count; i++) {
+        pipeline_stage_t* stage = pipeline->stages[i];
+        const pipeline_stage_config_t* tuned = point_config_for(point, stage);
+        if (!tuned) {
+            continue;
+        }
+
+        pipeline_stage_config_t config = *tuned;
+        config.buffer_size = stage->config.buffer_size;
+        memcpy(config.algorithm_name, stage->config.algorithm_name, sizeof(config.algorithm_name));
+
+        if (pipeline_request_config(pipeline, stage->name, &config)) {
+            applied = true;
+        }
+    }
+
+    return applied;
+}
+
+bool pipeline_get_recommended_config(const char* use_case,
+                                     const char* sensor_name,
+                                     signal_pipeline_t* pipeline)
+{
+    const pipeline_tuned_point_t* point = pipeline_tuned_lookup(sensor_name, use_case);
+
+    if (!point) {
+        LOG_WRN("No tuned %s configuration for %s",
+                use_case ? use_case : "balanced", sensor_name ? sensor_name : "(null)");
+        return false;
+    }
+    return pipeline_apply_tuned_point(pipeline, point);
+}
+
+bool pipeline_auto_tune_for_sensor(signal_pipeline_t* pipeline,
+                                   const char* old_sensor,
+                                   const char* new_sensor)
+{
+    if (!pipeline || !new_sensor) {
+        return false;
+    }
+
+    // Keep the trade-off the old sensor was tuned for
+    uint32_t use_cases = old_sensor ? current_use_cases(pipeline, old_sensor) : 0;
+    const char* use_case = "balanced";
+    if (use_cases && !(use_cases & PIPELINE_USE_BALANCED)) {
+        use_case = (use_cases & PIPELINE_USE_ACCURACY) ? "accuracy" : "low_power";
+    }
+
+    LOG_INF("Retuning for %s -> %s (%s)", old_sensor ? old_sensor : "?", new_sensor, use_case);
+    return pipeline_get_recommended_config(use_case, new_sensor, pipeline);
+}
@@ -0,0 +1,79 @@
+#ifndef PIPELINE_TUNING_H
+#define PIPELINE_TUNING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "interfaces/signal_pipeline_interfaces.h"
+
+/**
+ * @file pipeline_tuning.h
+ * @brief Offline-tuned PPG stage configurations per sensor
+ *
+ * tools/pipeline_tuner sweeps filter cutoffs and order, NLMS taps and step
+ * size, and beat detector threshold and window over a simulated (or
+ * recorded) corpus per sensor. It runs the real stages, scores HR error
+ * against compute time, and writes the Pareto-optimal configurations to
+ * pipeline_tuned_configs.c, which also defines the PPG_<sensor>_*_CONFIG
+ * constants from the balanced point.
+ *
+ * pipeline_get_recommended_config() and pipeline_auto_tune_for_sensor()
+ * pick a point from that table and stage it on a running pipeline; the
+ * change is applied at the next block boundary like any live update.
+ * Stages are matched by their ops, so any graph with a PPG filter, motion
+ * canceller or HR feature node can be tuned.
+ */
+
+// =============================================================================
+// Data Structures
+// =============================================================================
+
+/**
+ * @brief Use cases a tuned point can be recommended for (bit flags)
+ */
+typedef enum {
+    PIPELINE_USE_ACCURACY  = 0x01,    ///< Lowest HR error on the corpus
+    PIPELINE_USE_BALANCED  = 0x02,    ///< Cheapest within 1 bpm of the best
+    PIPELINE_USE_LOW_POWER = 0x04,    ///< Cheapest within the low-power error budget
+} pipeline_use_case_t;
+
+/**
+ * @brief One Pareto-optimal configuration for a sensor
+ */
+typedef struct {
+    const char* sensor;               ///< Part name, e.g. "MAX86141"
+    uint32_t use_cases;               ///< pipeline_use_case_t flags (0: front only)
+    float hr_error_bpm;               ///< Mean HR error, blocks without HR count as a miss
+    float coverage;                   ///< Fraction of scored blocks with a valid HR
+    float cost_ns_per_sample;         ///< Host time per sample (relative cost)
+    pipeline_stage_config_t filter;   ///< ppg_filter_stage parameters
+    pipeline_stage_config_t artifact; ///< motion_canceller_stage parameters
+    pipeline_stage_config_t feature;  ///< ppg_feature_stage parameters
+} pipeline_tuned_point_t;
+
+/** Pareto fronts of all sensors, each sorted by increasing cost (generated) */
+extern const pipeline_tuned_point_t pipeline_tuned_points[];
+extern const uint32_t pipeline_tuned_point_count;
+
+// =============================================================================
+// Tuning Functions
+// =============================================================================
+
+/**
+ * @brief Find the recommended point for a sensor
+ * @param sensor Part name
+ * @param use_case "accuracy", "balanced" or "low_power" (NULL: balanced)
+ * @return Point, NULL if the sensor or use case is unknown
+ */
+const pipeline_tuned_point_t* pipeline_tuned_lookup(const char* sensor, const char* use_case);
+
+/**
+ * @brief Stage a tuned point on every matching stage of a pipeline
+ *
+ * Stage names, buffer sizes and algorithm names are kept. The configs are
+ * swapped in at the next block boundary (pipeline_request_config()).
+ *
+ * @return false if no stage of the pipeline is tunable
+ */
+bool pipeline_apply_tuned_point(signal_pipeline_t* pipeline, const pipeline_tuned_point_t* point);
+
+#endif // PIPELINE_TUNING_H
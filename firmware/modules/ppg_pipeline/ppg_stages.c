@@ -0,0 +1,742 @@
+/*
+ * Standard PPG Pipeline Stages
+ *
+ * Preprocessing, band-pass filtering and HR feature extraction as
+ * pipeline_stage_ops_t implementations.
+ */
+
+#include "ppg_stages.h"
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+
+#define BUTTERWORTH_Q_ORDER2    0.70710678f
+#define BUTTERWORTH_Q_ORDER4_A  0.54119610f
+#define BUTTERWORTH_Q_ORDER4_B  1.30656296f
+#define NOTCH_Q                 30.0f
+#define MAX_CUTOFF_FRACTION     0.45f       /* of the sample rate */
+
+/* ==== SHARED HELPERS ==== */
+
+static float config_param(const pipeline_stage_config_t* config, uint32_t index, float fallback)
+{
+    if (config->parameter_count > index && config->parameters[index] > 0.0f) {
+        return config->parameters[index];
+    }
+    return fallback;
+}
+
+static void copy_buffer_header(const signal_buffer_t* input, signal_buffer_t* output)
+{
+    output->length = input->length;
+    output->sample_rate = input->sample_rate;
+    output->timestamp_start = input->timestamp_start;
+    output->quality_score = input->quality_score;
+}
+
+static bool stage_get_latency(pipeline_stage_t* stage, float* quality, uint32_t* latency_us)
+{
+    if (quality) {
+        *quality = 1.0f;
+    }
+    if (latency_us) {
+        *latency_us = stage->processing_time_us;
+    }
+    return true;
+}
+
+/* ==== PREPROCESS STAGE ==== */
+
+static bool preprocess_init(pipeline_stage_t* stage, const pipeline_stage_config_t* config)
+{
+    ppg_preprocess_stage_t* pre = (ppg_preprocess_stage_t*)stage;
+
+    if (!config) {
+        return false;
+    }
+
+    stage->config = *config;
+    pre->params.adc_scale_factor = config_param(config, PPG_PREPROCESS_PARAM_SCALE, 1.0f);
+    for (int ch = 0; ch < 4; ch++) {
+        pre->params.dc_offset[ch] = 0.0f;
+        pre->params.gain_correction[ch] = 1.0f;
+    }
+    pre->params.enable_calibration = false;
+
+    return config_param(config, PPG_PREPROCESS_PARAM_CHANNEL, 0.0f) < 4.0f;
+}
+
+static bool preprocess_process(pipeline_stage_t* stage, const signal_buffer_t* input, signal_buffer_t* output)
+{
+    const ppg_preprocess_stage_t* pre = (const ppg_preprocess_stage_t*)stage;
+
+    if (!input || !output || !input->data || !output->data) {
+        return false;
+    }
+
+    uint32_t ch = (uint32_t)config_param(&stage->config, PPG_PREPROCESS_PARAM_CHANNEL, 0.0f);
+    uint32_t rows = SIGNAL_CHANNEL_COUNT(input);
+
+    if (ch + rows > 4) {
+        return false;
+    }
+
+    for (uint32_t r = 0; r < rows; r++) {
+        float offset = 0.0f;
+        float gain = pre->params.adc_scale_factor;
+
+        if (pre->params.enable_calibration) {
+            offset = pre->params.dc_offset[ch + r];
+            gain *= pre->params.gain_correction[ch + r];
+        }
+
+        const float* restrict x = SIGNAL_CHANNEL(input, r);
+        float* restrict y = SIGNAL_CHANNEL(output, r);
+        for (uint32_t n = 0; n < input->length; n++) {
+            y[n] = (x[n] - offset) * gain;
+        }
+    }
+
+    copy_buffer_header(input, output);
+    output->channels = input->channels;
+    return true;
+}
+
+static bool preprocess_reset(pipeline_stage_t* stage)
+{
+    (void)stage;
+    return true;
+}
+
+static bool preprocess_update_config(pipeline_stage_t* stage, const pipeline_stage_config_t* config)
+{
+    ppg_preprocess_stage_t* pre = (ppg_preprocess_stage_t*)stage;
+
+    if (!config || config_param(config, PPG_PREPROCESS_PARAM_CHANNEL, 0.0f) >= 4.0f) {
+        return false;
+    }
+
+    // Keep calibration tables, only the scaling/channel come from the config
+    stage->config = *config;
+    pre->params.adc_scale_factor = config_param(config, PPG_PREPROCESS_PARAM_SCALE, 1.0f);
+    return true;
+}
+
+static void preprocess_cleanup(pipeline_stage_t* stage)
+{
+    (void)stage;
+}
+
+pipeline_stage_ops_t ppg_preprocess_stage_ops = {
+    .init = preprocess_init,
+    .process = preprocess_process,
+    .reset = preprocess_reset,
+    .update_config = preprocess_update_config,
+    .get_status = stage_get_latency,
+    .cleanup = preprocess_cleanup,
+};
+
+bool ppg_preprocess_stage_bind(ppg_preprocess_stage_t* stage,
+                               const pipeline_stage_config_t* config)
+{
+    if (!stage || !config) {
+        return false;
+    }
+
+    memset(stage, 0, sizeof(ppg_preprocess_stage_t));
+    stage->base.type = PIPELINE_STAGE_PREPROCESS;
+    stage->base.ops = &ppg_preprocess_stage_ops;
+    stage->base.multichannel = true;
+
+    if (!preprocess_init(&stage->base, config)) {
+        return false;
+    }
+    pipeline_stage_set_name(&stage->base, "ppg_preprocess");
+    return true;
+}
+
+/* ==== FILTER STAGE ==== */
+
+static void biquad_design(ppg_biquad_t* bq, bool highpass, float cutoff_hz, float q, float sample_rate)
+{
+    float w0 = 2.0f * 3.14159265f * cutoff_hz / sample_rate;
+    float cos_w0 = cosf(w0);
+    float alpha = sinf(w0) / (2.0f * q);
+    float a0 = 1.0f + alpha;
+
+    if (highpass) {
+        bq->b0 = (1.0f + cos_w0) * 0.5f / a0;
+        bq->b1 = -(1.0f + cos_w0) / a0;
+    } else {
+        bq->b0 = (1.0f - cos_w0) * 0.5f / a0;
+        bq->b1 = (1.0f - cos_w0) / a0;
+    }
+    bq->b2 = bq->b0;
+    bq->a1 = -2.0f * cos_w0 / a0;
+    bq->a2 = (1.0f - alpha) / a0;
+    bq->z1 = 0.0f;
+    bq->z2 = 0.0f;
+}
+
+static void notch_design(ppg_biquad_t* bq, float notch_hz, float sample_rate)
+{
+    float w0 = 2.0f * 3.14159265f * notch_hz / sample_rate;
+    float cos_w0 = cosf(w0);
+    float alpha = sinf(w0) / (2.0f * NOTCH_Q);
+    float a0 = 1.0f + alpha;
+
+    bq->b0 = 1.0f / a0;
+    bq->b1 = -2.0f * cos_w0 / a0;
+    bq->b2 = bq->b0;
+    bq->a1 = bq->b1;
+    bq->a2 = (1.0f - alpha) / a0;
+    bq->z1 = 0.0f;
+    bq->z2 = 0.0f;
+}
+
+uint32_t ppg_filter_design_bandpass(ppg_biquad_t* sections, uint32_t order,
+                                    float low_hz, float high_hz, uint32_t sample_rate)
+{
+    float fs = (float)sample_rate;
+    uint32_t count = 0;
+
+    if (high_hz > MAX_CUTOFF_FRACTION * fs) {
+        high_hz = MAX_CUTOFF_FRACTION * fs;
+    }
+
+    if (order >= 4) {
+        biquad_design(&sections[count++], true, low_hz, BUTTERWORTH_Q_ORDER4_A, fs);
+        biquad_design(&sections[count++], true, low_hz, BUTTERWORTH_Q_ORDER4_B, fs);
+        biquad_design(&sections[count++], false, high_hz, BUTTERWORTH_Q_ORDER4_A, fs);
+        biquad_design(&sections[count++], false, high_hz, BUTTERWORTH_Q_ORDER4_B, fs);
+    } else {
+        biquad_design(&sections[count++], true, low_hz, BUTTERWORTH_Q_ORDER2, fs);
+        biquad_design(&sections[count++], false, high_hz, BUTTERWORTH_Q_ORDER2, fs);
+    }
+    return count;
+}
+
+static void filter_design(const ppg_filter_stage_t* filter, ppg_filter_state_t* state, uint32_t sample_rate)
+{
+    float fs = (float)sample_rate;
+    uint32_t count = ppg_filter_design_bandpass(state->sections, filter->params.filter_order,
+                                                filter->params.bandpass_low_hz,
+                                                filter->params.bandpass_high_hz, sample_rate);
+
+    // Mains notches only where they fall below Nyquist
+    if (filter->params.enable_notch_50hz && 50.0f < MAX_CUTOFF_FRACTION * fs) {
+        notch_design(&state->sections[count++], 50.0f, fs);
+    }
+    if (filter->params.enable_notch_60hz && 60.0f < MAX_CUTOFF_FRACTION * fs) {
+        notch_design(&state->sections[count++], 60.0f, fs);
+    }
+
+    state->section_count = count;
+    state->sample_rate = sample_rate;
+}
+
+#if defined(__GNUC__)
+#define FILTER_INLINE static inline __attribute__((always_inline))
+#else
+#define FILTER_INLINE static inline
+#endif
+
+/** Runs one sample of every row through the cascade, v[] in place */
+FILTER_INLINE void biquad_cascade(const ppg_biquad_t* sections, uint32_t count,
+                                  ppg_filter_delay_t* delay, float* v, const uint32_t rows)
+{
+    for (uint32_t s = 0; s < count; s++) {
+        const ppg_biquad_t* bq = &sections[s];
+        float* z1 = delay->z1[s];
+        float* z2 = delay->z2[s];
+
+        for (uint32_t r = 0; r < rows; r++) {
+            float out = bq->b0 * v[r] + z1[r];
+            z1[r] = bq->b1 * v[r] - bq->a1 * out + z2[r];
+            z2[r] = bq->b2 * v[r] - bq->a2 * out;
+            v[r] = out;
+        }
+    }
+}
+
+/**
+ * Filters all rows of a block in lockstep. rows is a constant after
+ * inlining, so each row count gets its own loop with the row steps
+ * unrolled; the coefficients are loaded once per section for all rows.
+ */
+FILTER_INLINE void filter_rows(ppg_filter_state_t* state, float alpha,
+                               const signal_buffer_t* input, signal_buffer_t* output,
+                               const uint32_t rows)
+{
+    const float* x = input->data;
+    float* y = output->data;
+    const uint32_t x_stride = input->stride;
+    const uint32_t y_stride = output->stride;
+    float last_in[PIPELINE_MAX_CHANNELS];
+    float last_out[PIPELINE_MAX_CHANNELS];
+
+    for (uint32_t r = 0; r < rows; r++) {
+        last_in[r] = state->dc_last_in[r];
+        last_out[r] = state->dc_last_out[r];
+    }
+
+    for (uint32_t n = 0; n < input->length; n++) {
+        float v[PIPELINE_MAX_CHANNELS];
+        float old[PIPELINE_MAX_CHANNELS];
+
+        for (uint32_t r = 0; r < rows; r++) {
+            float in = x[r * x_stride + n];
+            v[r] = in - last_in[r] + alpha * last_out[r];
+            last_in[r] = in;
+            last_out[r] = v[r];
+            old[r] = v[r];
+        }
+
+        biquad_cascade(state->sections, state->section_count, &state->delay, v, rows);
+        if (state->fade_remaining > 0) {
+            biquad_cascade(state->fade_sections, state->fade_section_count, &state->fade_delay, old, rows);
+            float w = (float)state->fade_remaining-- / (float)state->fade_length;
+            for (uint32_t r = 0; r < rows; r++) {
+                v[r] += w * (old[r] - v[r]);
+            }
+        }
+
+        for (uint32_t r = 0; r < rows; r++) {
+            y[r * y_stride + n] = v[r];
+        }
+    }
+
+    for (uint32_t r = 0; r < rows; r++) {
+        state->dc_last_in[r] = last_in[r];
+        state->dc_last_out[r] = last_out[r];
+    }
+}
+
+static void filter_params_from_config(ppg_filter_stage_t* filter, const pipeline_stage_config_t* config)
+{
+    filter->base.config = *config;
+    filter->params.bandpass_low_hz = config_param(config, PPG_FILTER_PARAM_LOW_HZ, 0.5f);
+    filter->params.bandpass_high_hz = config_param(config, PPG_FILTER_PARAM_HIGH_HZ, 4.0f);
+    filter->params.filter_order = (uint32_t)config_param(config, PPG_FILTER_PARAM_ORDER, 2.0f);
+    filter->params.dc_alpha = config_param(config, PPG_FILTER_PARAM_DC_ALPHA, 0.99f);
+}
+
+static bool filter_params_valid(const ppg_filter_stage_t* filter)
+{
+    return filter->params.bandpass_low_hz > 0.0f &&
+           filter->params.bandpass_high_hz > filter->params.bandpass_low_hz &&
+           filter->params.dc_alpha < 1.0f;
+}
+
+static bool filter_init(pipeline_stage_t* stage, const pipeline_stage_config_t* config)
+{
+    ppg_filter_stage_t* filter = (ppg_filter_stage_t*)stage;
+    ppg_filter_state_t* state = (ppg_filter_state_t*)stage->context;
+
+    if (!config) {
+        return false;
+    }
+
+    filter_params_from_config(filter, config);
+    memset(state, 0, sizeof(ppg_filter_state_t));
+
+    return filter_params_valid(filter);
+}
+
+static bool filter_process(pipeline_stage_t* stage, const signal_buffer_t* input, signal_buffer_t* output)
+{
+    const ppg_filter_stage_t* filter = (const ppg_filter_stage_t*)stage;
+    ppg_filter_state_t* state = (ppg_filter_state_t*)stage->context;
+
+    if (!input || !output || !input->data || !output->data || input->sample_rate == 0) {
+        return false;
+    }
+
+    uint32_t rows = SIGNAL_CHANNEL_COUNT(input);
+
+    if (state->sample_rate != input->sample_rate || state->channels != rows) {
+        if (state->sample_rate != input->sample_rate) {
+            filter_design(filter, state, input->sample_rate);
+        }
+        memset(&state->delay, 0, sizeof(state->delay));
+        state->channels = rows;
+        state->primed = false;
+        state->fade_remaining = 0;
+    }
+
+    if (!state->primed && input->length > 0) {
+        for (uint32_t r = 0; r < rows; r++) {
+            state->dc_last_in[r] = SIGNAL_CHANNEL(input, r)[0];
+            state->dc_last_out[r] = 0.0f;
+        }
+        state->primed = true;
+    }
+
+    const float alpha = filter->params.dc_alpha;
+    switch (rows) {
+    case 1:
+        filter_rows(state, alpha, input, output, 1);
+        break;
+    case 2:
+        filter_rows(state, alpha, input, output, 2);
+        break;
+    case 3:
+        filter_rows(state, alpha, input, output, 3);
+        break;
+    default:
+        filter_rows(state, alpha, input, output, PIPELINE_MAX_CHANNELS);
+        break;
+    }
+
+    copy_buffer_header(input, output);
+    output->channels = input->channels;
+    return true;
+}
+
+static bool filter_reset(pipeline_stage_t* stage)
+{
+    ppg_filter_state_t* state = (ppg_filter_state_t*)stage->context;
+
+    memset(&state->delay, 0, sizeof(state->delay));
+    state->primed = false;
+    state->fade_remaining = 0;
+    return true;
+}
+
+static bool filter_update_config(pipeline_stage_t* stage, const pipeline_stage_config_t* config)
+{
+    ppg_filter_stage_t* filter = (ppg_filter_stage_t*)stage;
+    ppg_filter_state_t* state = (ppg_filter_state_t*)stage->context;
+
+    if (!config) {
+        return false;
+    }
+
+    ppg_filter_stage_t next = *filter;
+    filter_params_from_config(&next, config);
+    if (!filter_params_valid(&next)) {
+        return false;
+    }
+
+    filter->base.config = next.base.config;
+    filter->params = next.params;
+    if (state->sample_rate == 0) {
+        return true;
+    }
+
+    // Running: keep the old design for the fade, seed the new one with its state
+    memcpy(state->fade_sections, state->sections, sizeof(state->sections));
+    state->fade_delay = state->delay;
+    state->fade_section_count = state->section_count;
+    filter_design(filter, state, state->sample_rate);
+    if (state->section_count != state->fade_section_count) {
+        memset(&state->delay, 0, sizeof(state->delay));
+    }
+    state->fade_length = PPG_FILTER_FADE_MS * state->sample_rate / 1000;
+    state->fade_remaining = state->fade_length;
+    return true;
+}
+
+/** Warm filter state; coefficients are redesigned from the configuration */
+typedef struct {
+    uint32_t sample_rate;
+    uint32_t section_count;
+    uint32_t channels;
+    ppg_filter_delay_t delay;
+} filter_checkpoint_t;
+
+static uint32_t filter_save_state(pipeline_stage_t* stage, void* buffer, uint32_t capacity)
+{
+    const ppg_filter_state_t* state = (const ppg_filter_state_t*)stage->context;
+    filter_checkpoint_t cp = {
+        .sample_rate = state->sample_rate,
+        .section_count = state->section_count,
+        .channels = state->channels,
+        .delay = state->delay
+    };
+
+    if (capacity < sizeof(cp)) {
+        return 0;
+    }
+    memcpy(buffer, &cp, sizeof(cp));
+    return sizeof(cp);
+}
+
+static bool filter_restore_state(pipeline_stage_t* stage, const void* buffer, uint32_t length)
+{
+    const ppg_filter_stage_t* filter = (const ppg_filter_stage_t*)stage;
+    ppg_filter_state_t* state = (ppg_filter_state_t*)stage->context;
+    filter_checkpoint_t cp;
+
+    if (length != sizeof(cp)) {
+        return false;
+    }
+    memcpy(&cp, buffer, sizeof(cp));
+    if (cp.sample_rate == 0) {
+        return true;
+    }
+
+    filter_design(filter, state, cp.sample_rate);
+    if (state->section_count != cp.section_count) {
+        return false;
+    }
+    state->delay = cp.delay;
+    state->channels = cp.channels;
+
+    // The DC level may have moved while asleep: re-seed the blocker from the first sample
+    state->primed = false;
+    state->fade_remaining = 0;
+    return true;
+}
+
+static void filter_cleanup(pipeline_stage_t* stage)
+{
+    memset(stage->context, 0, sizeof(ppg_filter_state_t));
+}
+
+pipeline_stage_ops_t ppg_filter_stage_ops = {
+    .init = filter_init,
+    .process = filter_process,
+    .reset = filter_reset,
+    .update_config = filter_update_config,
+    .get_status = stage_get_latency,
+    .cleanup = filter_cleanup,
+    .save_state = filter_save_state,
+    .restore_state = filter_restore_state,
+};
+
+bool ppg_filter_stage_bind(ppg_filter_stage_t* stage,
+                           ppg_filter_state_t* state,
+                           const pipeline_stage_config_t* config)
+{
+    if (!stage || !state || !config) {
+        return false;
+    }
+
+    memset(stage, 0, sizeof(ppg_filter_stage_t));
+    stage->base.type = PIPELINE_STAGE_FILTER;
+    stage->base.ops = &ppg_filter_stage_ops;
+    stage->base.multichannel = true;
+    stage->base.context = state;
+
+    if (!filter_init(&stage->base, config)) {
+        return false;
+    }
+    pipeline_stage_set_name(&stage->base, "ppg_filter");
+    return true;
+}
+
+/* ==== HR FEATURE STAGE ==== */
+
+static void feature_detector_config(const ppg_feature_stage_t* feature, beat_detector_config_t* config)
+{
+    *config = BEAT_DETECTOR_DEFAULT_CONFIG;
+    config->hysteresis = feature->params.peak_threshold;
+    config->min_interval_ms = (float)feature->params.min_peak_distance;
+    config->hr_window = feature->params.hr_window_size;
+}
+
+static void feature_params_from_config(ppg_feature_stage_t* feature, const pipeline_stage_config_t* config)
+{
+    feature->base.config = *config;
+    feature->params.peak_threshold = config_param(config, PPG_FEATURE_PARAM_HYSTERESIS,
+                                                  BEAT_DETECTOR_DEFAULT_CONFIG.hysteresis);
+    feature->params.min_peak_distance = (uint32_t)config_param(config, PPG_FEATURE_PARAM_MIN_DISTANCE_MS,
+                                                               BEAT_DETECTOR_DEFAULT_CONFIG.min_interval_ms);
+    feature->params.hr_window_size = (uint32_t)config_param(config, PPG_FEATURE_PARAM_HR_WINDOW,
+                                                            (float)BEAT_DETECTOR_DEFAULT_CONFIG.hr_window);
+}
+
+static bool feature_init(pipeline_stage_t* stage, const pipeline_stage_config_t* config)
+{
+    ppg_feature_stage_t* feature = (ppg_feature_stage_t*)stage;
+    ppg_feature_state_t* state = (ppg_feature_state_t*)stage->context;
+    beat_detector_config_t bd_config;
+
+    if (!config) {
+        return false;
+    }
+
+    feature_params_from_config(feature, config);
+    feature->params.enable_hrv = true;
+    memset(state, 0, sizeof(ppg_feature_state_t));
+    state->block.beats = state->beats;
+
+    // Validate now, the detector itself starts with the first block's rate
+    feature_detector_config(feature, &bd_config);
+    return beat_detector_init(&state->detector, &bd_config, 1);
+}
+
+static bool feature_process(pipeline_stage_t* stage, const signal_buffer_t* input, signal_buffer_t* output)
+{
+    ppg_feature_stage_t* feature = (ppg_feature_stage_t*)stage;
+    ppg_feature_state_t* state = (ppg_feature_state_t*)stage->context;
+
+    if (!input || !output || !input->data || input->sample_rate == 0) {
+        return false;
+    }
+
+    if (state->sample_rate != input->sample_rate) {
+        beat_detector_config_t bd_config;
+        feature_detector_config(feature, &bd_config);
+        if (!beat_detector_init(&state->detector, &bd_config, input->sample_rate)) {
+            return false;
+        }
+        state->sample_rate = input->sample_rate;
+    }
+
+    state->block.block_start_index = state->detector.sample_index;
+    state->block.count = beat_detector_process(&state->detector, input->data, input->length,
+                                               state->beats, PPG_FEATURE_MAX_BEATS);
+    state->block.hr_bpm = beat_detector_get_hr(&state->detector);
+
+    feature->last_hr_bpm = state->block.hr_bpm;
+    if (feature->params.enable_hrv) {
+        feature->last_hrv_rmssd = beat_detector_get_rmssd(&state->detector);
+    }
+
+    copy_buffer_header(input, output);
+    output->length = 0;
+    output->metadata = &state->block;
+    return true;
+}
+
+static bool feature_reset(pipeline_stage_t* stage)
+{
+    ppg_feature_stage_t* feature = (ppg_feature_stage_t*)stage;
+    ppg_feature_state_t* state = (ppg_feature_state_t*)stage->context;
+
+    beat_detector_reset(&state->detector);
+    state->block.count = 0;
+    state->block.hr_bpm = 0.0f;
+    feature->last_hr_bpm = 0.0f;
+    feature->last_hrv_rmssd = 0.0f;
+    return true;
+}
+
+static bool feature_update_config(pipeline_stage_t* stage, const pipeline_stage_config_t* config)
+{
+    ppg_feature_stage_t* feature = (ppg_feature_stage_t*)stage;
+    ppg_feature_state_t* state = (ppg_feature_state_t*)stage->context;
+    beat_detector_config_t bd_config;
+
+    if (!config) {
+        return false;
+    }
+
+    ppg_feature_stage_t next = *feature;
+    feature_params_from_config(&next, config);
+    feature_detector_config(&next, &bd_config);
+
+    // Keep the detector running: thresholds change, the interval history stays
+    beat_detector_t check;
+    if (!beat_detector_init(&check, &bd_config, 1)) {
+        return false;
+    }
+    if (state->sample_rate) {
+        beat_detector_set_config(&state->detector, &bd_config);
+    }
+
+    feature->base.config = next.base.config;
+    feature->params = next.params;
+    return true;
+}
+
+static bool feature_get_status(pipeline_stage_t* stage, float* quality, uint32_t* latency_us)
+{
+    const ppg_feature_stage_t* feature = (const ppg_feature_stage_t*)stage;
+
+    if (quality) {
+        *quality = feature->last_hr_bpm > 0.0f ? 1.0f : 0.0f;
+    }
+    if (latency_us) {
+        *latency_us = stage->processing_time_us;
+    }
+    return true;
+}
+
+/** Warm detector state; the snapshot's unused intervals are not stored */
+typedef struct {
+    uint32_t sample_rate;
+    beat_detector_snapshot_t detector;
+} feature_checkpoint_t;
+
+static uint32_t feature_save_state(pipeline_stage_t* stage, void* buffer, uint32_t capacity)
+{
+    const ppg_feature_state_t* state = (const ppg_feature_state_t*)stage->context;
+    feature_checkpoint_t cp = { .sample_rate = state->sample_rate };
+
+    uint32_t length = offsetof(feature_checkpoint_t, detector) +
+                      beat_detector_snapshot(&state->detector, &cp.detector);
+    if (capacity < length) {
+        return 0;
+    }
+    memcpy(buffer, &cp, length);
+    return length;
+}
+
+static bool feature_restore_state(pipeline_stage_t* stage, const void* buffer, uint32_t length)
+{
+    ppg_feature_stage_t* feature = (ppg_feature_stage_t*)stage;
+    ppg_feature_state_t* state = (ppg_feature_state_t*)stage->context;
+    const uint32_t fixed = offsetof(feature_checkpoint_t, detector.intervals);
+    feature_checkpoint_t cp;
+    beat_detector_config_t bd_config;
+
+    if (length < fixed || length > sizeof(cp)) {
+        return false;
+    }
+    memcpy(&cp, buffer, length);
+    if (cp.sample_rate == 0) {
+        return true;
+    }
+    if (cp.detector.interval_count > BEAT_DETECTOR_MAX_WINDOW ||
+        length != fixed + cp.detector.interval_count * sizeof(float)) {
+        return false;
+    }
+
+    feature_detector_config(feature, &bd_config);
+    if (!beat_detector_init(&state->detector, &bd_config, cp.sample_rate) ||
+        !beat_detector_resume(&state->detector, &cp.detector)) {
+        return false;
+    }
+    state->sample_rate = cp.sample_rate;
+    return true;
+}
+
+static void feature_cleanup(pipeline_stage_t* stage)
+{
+    feature_reset(stage);
+}
+
+pipeline_stage_ops_t ppg_feature_stage_ops = {
+    .init = feature_init,
+    .process = feature_process,
+    .reset = feature_reset,
+    .update_config = feature_update_config,
+    .get_status = feature_get_status,
+    .cleanup = feature_cleanup,
+    .save_state = feature_save_state,
+    .restore_state = feature_restore_state,
+};
+
+bool ppg_feature_stage_bind(ppg_feature_stage_t* stage,
+                            ppg_feature_state_t* state,
+                            const pipeline_stage_config_t* config)
+{
+    if (!stage || !state || !config) {
+        return false;
+    }
+
+    memset(stage, 0, sizeof(ppg_feature_stage_t));
+    stage->base.type = PIPELINE_STAGE_FEATURE_EXTRACT;
+    stage->base.ops = &ppg_feature_stage_ops;
+    stage->base.multichannel = true;
+    stage->base.context = state;
+
+    if (!feature_init(&stage->base, config)) {
+        return false;
+    }
+    pipeline_stage_set_name(&stage->base, "ppg_hr");
+    return true;
+}
@@ -0,0 +1,168 @@
+#ifndef PPG_STAGES_H
+#define PPG_STAGES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "interfaces/signal_pipeline_interfaces.h"
+#include "beat_detector.h"
+
+/**
+ * @file ppg_stages.h
+ * @brief Standard PPG pipeline stages
+ *
+ * Preprocessing (calibration/scaling), band-pass filtering and HR feature
+ * extraction. In the fan-out graph one preprocess and one filter node are
+ * shared by all feature nodes (HR, SpO2, respiration).
+ */
+
+// =============================================================================
+// Limits
+// =============================================================================
+
+#define PPG_FILTER_MAX_SECTIONS      6     ///< Biquad sections (band-pass + notches)
+#define PPG_FEATURE_MAX_BEATS        8     ///< Beats reported per block
+#define PPG_FILTER_FADE_MS           500   ///< Cross-fade after a live filter change
+
+// =============================================================================
+// Stage Parameters (pipeline_stage_config_t.parameters indices)
+// =============================================================================
+
+typedef enum {
+    PPG_PREPROCESS_PARAM_CHANNEL = 0,     ///< Calibration channel (0..3)
+    PPG_PREPROCESS_PARAM_SCALE,           ///< ADC to physical units
+    PPG_PREPROCESS_PARAM_COUNT
+} ppg_preprocess_param_t;
+
+typedef enum {
+    PPG_FILTER_PARAM_LOW_HZ = 0,          ///< Band-pass low cutoff
+    PPG_FILTER_PARAM_HIGH_HZ,             ///< Band-pass high cutoff
+    PPG_FILTER_PARAM_ORDER,               ///< Band-pass order (2 or 4)
+    PPG_FILTER_PARAM_DC_ALPHA,            ///< DC blocker pole
+    PPG_FILTER_PARAM_COUNT
+} ppg_filter_param_t;
+
+typedef enum {
+    PPG_FEATURE_PARAM_HYSTERESIS = 0,     ///< Peak threshold (fraction of p-p level)
+    PPG_FEATURE_PARAM_MIN_DISTANCE_MS,    ///< Refractory period
+    PPG_FEATURE_PARAM_HR_WINDOW,          ///< Intervals in HR median
+    PPG_FEATURE_PARAM_COUNT
+} ppg_feature_param_t;
+
+// =============================================================================
+// Stage State
+// =============================================================================
+
+/**
+ * @brief Biquad section, transposed direct form II
+ */
+typedef struct {
+    float b0, b1, b2, a1, a2;
+    float z1, z2;
+} ppg_biquad_t;
+
+/**
+ * @brief Delay state of a section cascade for every channel row
+ *
+ * Channel index innermost: each sample step updates one section for all
+ * rows from contiguous state.
+ */
+typedef struct {
+    float z1[PPG_FILTER_MAX_SECTIONS][PIPELINE_MAX_CHANNELS];
+    float z2[PPG_FILTER_MAX_SECTIONS][PIPELINE_MAX_CHANNELS];
+} ppg_filter_delay_t;
+
+/**
+ * @brief Filter stage state (owned by caller, bound via context)
+ *
+ * One design is shared by all channel rows; delay and DC blocker state
+ * are kept per row.
+ */
+typedef struct {
+    ppg_biquad_t sections[PPG_FILTER_MAX_SECTIONS]; ///< Coefficients (z1/z2 unused)
+    uint32_t section_count;
+    uint32_t sample_rate;             ///< Rate the coefficients were designed for
+    uint32_t channels;                ///< Rows the delay state belongs to
+    ppg_filter_delay_t delay;
+    float dc_last_in[PIPELINE_MAX_CHANNELS];  ///< DC blocker x[n-1]
+    float dc_last_out[PIPELINE_MAX_CHANNELS]; ///< DC blocker y[n-1]
+    bool primed;                      ///< DC blocker seeded from first sample
+
+    // Live reconfiguration: the previous design runs alongside and is faded out
+    ppg_biquad_t fade_sections[PPG_FILTER_MAX_SECTIONS];
+    ppg_filter_delay_t fade_delay;
+    uint32_t fade_section_count;
+    uint32_t fade_remaining;          ///< Samples left in the cross-fade (0: none)
+    uint32_t fade_length;             ///< Cross-fade length in samples
+} ppg_filter_state_t;
+
+/**
+ * @brief HR feature stage state (owned by caller, bound via context)
+ */
+typedef struct {
+    beat_detector_t detector;
+    ppg_beat_t beats[PPG_FEATURE_MAX_BEATS];  ///< Beats of the last block
+    ppg_beat_block_t block;           ///< Published through output metadata
+    uint32_t sample_rate;             ///< Rate the detector runs at
+} ppg_feature_state_t;
+
+// =============================================================================
+// Filter Design
+// =============================================================================
+
+/**
+ * @brief Design the Butterworth band-pass of the filter stage
+ *
+ * Order 2 gives one high-pass and one low-pass section, order 4 two of
+ * each. The high cutoff is clamped below Nyquist. Delay state is cleared.
+ *
+ * @param sections Output, room for 4 sections
+ * @return Number of sections written (2 or 4)
+ */
+uint32_t ppg_filter_design_bandpass(ppg_biquad_t* sections, uint32_t order,
+                                    float low_hz, float high_hz, uint32_t sample_rate);
+
+// =============================================================================
+// Stage Binding
+// =============================================================================
+
+extern pipeline_stage_ops_t ppg_preprocess_stage_ops;
+extern pipeline_stage_ops_t ppg_filter_stage_ops;
+extern pipeline_stage_ops_t ppg_feature_stage_ops;
+
+/**
+ * @brief Bind a preprocessing stage
+ *
+ * Output = (x - dc_offset[ch]) * gain_correction[ch] * adc_scale_factor.
+ * Without calibration only the scale factor is applied. Row r of a
+ * multi-channel block is calibrated as channel ch + r.
+ */
+bool ppg_preprocess_stage_bind(ppg_preprocess_stage_t* stage,
+                               const pipeline_stage_config_t* config);
+
+/**
+ * @brief Bind a filter stage (DC blocker + Butterworth band-pass + notches)
+ *
+ * Coefficients are designed from the sample rate of the first block and
+ * redesigned whenever the input rate changes. All channel rows of a block
+ * are filtered in one pass; a change in row count restarts the filter.
+ * update_config() on a running filter redesigns in place: the new
+ * sections start from the old delay state and the old design is
+ * cross-faded out over PPG_FILTER_FADE_MS, so the output has no gap or
+ * step.
+ */
+bool ppg_filter_stage_bind(ppg_filter_stage_t* stage,
+                           ppg_filter_state_t* state,
+                           const pipeline_stage_config_t* config);
+
+/**
+ * @brief Bind an HR feature stage
+ *
+ * Produces no samples; the output metadata points to a ppg_beat_block_t
+ * with the beats confirmed during the block, so downstream nodes can align
+ * to heartbeats. Beats are detected on row 0 of a multi-channel block.
+ */
+bool ppg_feature_stage_bind(ppg_feature_stage_t* stage,
+                            ppg_feature_state_t* state,
+                            const pipeline_stage_config_t* config);
+
+#endif // PPG_STAGES_H
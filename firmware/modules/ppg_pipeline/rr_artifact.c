@@ -0,0 +1,399 @@
+/*
+ * Streaming RR Artifact Correction Implementation
+ *
+ * Every interval updates the running |dRR| and |mRR| quartiles and the RR
+ * median once, is normalized with the thresholds of that moment and
+ * enters a four-slot lookahead. The slot two behind the newest is then
+ * classified with its predecessor and both successors, exactly the
+ * neighbourhood the decision rules read, so each beat costs a fixed
+ * number of heap sifts and comparisons.
+ */
+
+#include "rr_artifact.h"
+#include <string.h>
+#include <math.h>
+
+/* ==== PRIVATE FUNCTIONS ==== */
+
+static bool config_is_valid(const rr_artifact_config_t* config)
+{
+    return config->mode <= RR_ARTIFACT_DROP &&
+           config->alpha > 0.0f && config->c1 >= 0.0f && config->c2 >= 0.0f &&
+           config->min_threshold_ms > 0.0f &&
+           config->quantile_window >= 4 && config->quantile_window <= RR_ARTIFACT_MAX_QUANTILE_WINDOW &&
+           config->median_window >= 1 && config->median_window <= RR_ARTIFACT_MAX_MEDIAN_WINDOW &&
+           config->report_beats >= 2 &&
+           config->max_artifact_percent > 0.0f;
+}
+
+static float quartile_threshold(const rr_artifact_t* rr, const running_quantile_t* q1, const running_quantile_t* q3)
+{
+    float th = rr->config.alpha * 0.5f * (running_quantile_get(q3) - running_quantile_get(q1));
+    return th > rr->config.min_threshold_ms ? th : rr->config.min_threshold_ms;
+}
+
+static rr_artifact_type_t classify(const rr_artifact_t* rr)
+{
+    const rr_pending_t* prev = &rr->pending[0];
+    const rr_pending_t* e = &rr->pending[1];
+    const rr_pending_t* next = &rr->pending[2];
+    const rr_pending_t* next2 = &rr->pending[3];
+    const float d = e->drrs;
+
+    if (fabsf(d) <= 1.0f && fabsf(e->mrrs) <= 3.0f) {
+        return RR_NORMAL;
+    }
+
+    // Premature beat: the jump is flanked by jumps the other way
+    float s12 = d > 0.0f ? fmaxf(prev->drrs, next->drrs) : fminf(prev->drrs, next->drrs);
+    if ((d > 1.0f && s12 < -rr->config.c1 * d - rr->config.c2) ||
+        (d < -1.0f && s12 > -rr->config.c1 * d + rr->config.c2)) {
+        return RR_ECTOPIC;
+    }
+
+    float s22 = d >= 0.0f ? fminf(next->drrs, next2->drrs) : fmaxf(next->drrs, next2->drrs);
+    bool is_long = d > 1.0f && s22 < -1.0f;
+    bool is_short = d < -1.0f && s22 > 1.0f;
+    if (!is_long && !is_short && fabsf(e->mrrs) <= 3.0f) {
+        return RR_NORMAL;
+    }
+
+    if (is_short && next->valid && fabsf(e->rr + next->rr - e->median) < e->th2) {
+        return RR_EXTRA;
+    }
+    if (is_long && fabsf(0.5f * e->rr - e->median) < e->th2) {
+        return RR_MISSED;
+    }
+    return e->rr > e->median ? RR_LONG : RR_SHORT;
+}
+
+static void close_report(rr_artifact_t* rr)
+{
+    rr_artifact_report_t* r = &rr->current;
+    uint32_t n = r->clean_intervals;
+
+    r->artifact_percent = r->intervals ? 100.0f * (float)r->artifacts / (float)r->intervals : 0.0f;
+    r->rmssd_ms = rr->diff_count ? sqrtf(rr->diff_sq / (float)rr->diff_count) : 0.0f;
+    if (n >= 2) {
+        float mean = rr->sum / (float)n;
+        float var = (rr->sum_sq - (float)n * mean * mean) / (float)(n - 1);
+        r->sdnn_ms = var > 0.0f ? sqrtf(var) : 0.0f;
+    }
+    r->valid = rr->diff_count >= 1 && 2 * n >= r->intervals &&
+               r->artifact_percent <= rr->config.max_artifact_percent;
+
+    rr->report = *r;
+    rr->reports++;
+    memset(&rr->current, 0, sizeof(rr->current));
+    rr->sum = 0.0f;
+    rr->sum_sq = 0.0f;
+    rr->diff_sq = 0.0f;
+    rr->diff_count = 0;
+}
+
+/** Append to the output; clean intervals also feed the HRV sums */
+static uint32_t emit(rr_artifact_t* rr, rr_clean_interval_t* out, uint32_t n, uint32_t max_out,
+                     float interval, float raw, rr_artifact_type_t type, bool corrected, bool clean)
+{
+    if (clean) {
+        if (rr->current.clean_intervals == 0) {
+            rr->shift = interval;
+        }
+        float v = interval - rr->shift;
+        rr->sum += v;
+        rr->sum_sq += v * v;
+        rr->current.clean_intervals++;
+        if (rr->last_clean > 0.0f) {
+            float diff = interval - rr->last_clean;
+            rr->diff_sq += diff * diff;
+            rr->diff_count++;
+        }
+        rr->last_clean = interval;
+    } else {
+        rr->last_clean = 0.0f;
+    }
+
+    if (out && n < max_out) {
+        out[n].interval_ms = interval;
+        out[n].raw_ms = raw;
+        out[n].type = (uint8_t)type;
+        out[n].corrected = corrected;
+        n++;
+    }
+    return n;
+}
+
+/** Classify pending[1] and release what it becomes */
+static uint32_t release(rr_artifact_t* rr, rr_clean_interval_t* out, uint32_t n, uint32_t max_out)
+{
+    rr_pending_t* e = &rr->pending[1];
+
+    if (!e->valid || e->merged) {
+        return n;
+    }
+
+    rr_artifact_type_t type = classify(rr);
+    rr->current.intervals++;
+    rr->current.by_type[type]++;
+    if (type != RR_NORMAL) {
+        rr->current.artifacts++;
+    }
+
+    if (type == RR_NORMAL) {
+        n = emit(rr, out, n, max_out, e->rr, e->rr, type, false, true);
+    } else if (rr->config.mode == RR_ARTIFACT_FLAG) {
+        n = emit(rr, out, n, max_out, e->rr, e->rr, type, false, false);
+    } else if (rr->config.mode == RR_ARTIFACT_DROP) {
+        rr->last_clean = 0.0f;
+    } else if (type == RR_MISSED) {
+        n = emit(rr, out, n, max_out, 0.5f * e->rr, e->rr, type, true, true);
+        n = emit(rr, out, n, max_out, 0.5f * e->rr, e->rr, type, true, true);
+    } else if (type == RR_EXTRA) {
+        float sum = e->rr + rr->pending[2].rr;
+        rr->pending[2].merged = true;
+        n = emit(rr, out, n, max_out, sum, sum, type, true, true);
+    } else {
+        n = emit(rr, out, n, max_out, e->median, e->rr, type, true, true);
+    }
+
+    if (rr->current.intervals >= rr->config.report_beats) {
+        close_report(rr);
+    }
+    return n;
+}
+
+static void shift_in(rr_artifact_t* rr, const rr_pending_t* entry)
+{
+    memmove(&rr->pending[0], &rr->pending[1], 3 * sizeof(rr_pending_t));
+    rr->pending[3] = *entry;
+}
+
+/* ==== PUBLIC FUNCTIONS ==== */
+
+bool rr_artifact_init(rr_artifact_t* rr, const rr_artifact_config_t* config)
+{
+    if (!rr) {
+        return false;
+    }
+
+    rr_artifact_config_t cfg = config ? *config : RR_ARTIFACT_DEFAULT_CONFIG;
+    if (!config_is_valid(&cfg)) {
+        return false;
+    }
+
+    memset(rr, 0, sizeof(rr_artifact_t));
+    rr->config = cfg;
+    running_quantile_init(&rr->drr_q1, cfg.quantile_window, 0.25f, rr->drr_values[0], rr->drr_index[0]);
+    running_quantile_init(&rr->drr_q3, cfg.quantile_window, 0.75f, rr->drr_values[1], rr->drr_index[1]);
+    running_quantile_init(&rr->mrr_q1, cfg.quantile_window, 0.25f, rr->mrr_values[0], rr->mrr_index[0]);
+    running_quantile_init(&rr->mrr_q3, cfg.quantile_window, 0.75f, rr->mrr_values[1], rr->mrr_index[1]);
+    running_median_init(&rr->median, cfg.median_window, rr->median_values, rr->median_index);
+    return true;
+}
+
+void rr_artifact_reset(rr_artifact_t* rr)
+{
+    rr_artifact_config_t config = rr->config;
+    rr_artifact_init(rr, &config);
+}
+
+uint32_t rr_artifact_push(rr_artifact_t* rr, float interval_ms, rr_clean_interval_t* out, uint32_t max_out)
+{
+    if (!rr) {
+        return 0;
+    }
+    if (!(interval_ms > 0.0f)) {
+        return rr_artifact_flush(rr, out, max_out);
+    }
+
+    rr_pending_t entry = { .valid = true, .rr = interval_ms };
+
+    // No difference across a gap: the first interval after one is judged by mRR only
+    if (rr->last_rr > 0.0f) {
+        float drr = fabsf(interval_ms - rr->last_rr);
+        running_quantile_push(&rr->drr_q1, drr);
+        running_quantile_push(&rr->drr_q3, drr);
+        entry.drrs = (interval_ms - rr->last_rr) / quartile_threshold(rr, &rr->drr_q1, &rr->drr_q3);
+    }
+    rr->last_rr = interval_ms;
+
+    running_quantile_push(&rr->median, interval_ms);
+    entry.median = running_quantile_get(&rr->median);
+    float mrr = interval_ms - entry.median;
+    if (mrr < 0.0f) {
+        mrr *= 2.0f;
+    }
+    running_quantile_push(&rr->mrr_q1, fabsf(mrr));
+    running_quantile_push(&rr->mrr_q3, fabsf(mrr));
+    entry.th2 = quartile_threshold(rr, &rr->mrr_q1, &rr->mrr_q3);
+    entry.mrrs = mrr / entry.th2;
+
+    shift_in(rr, &entry);
+    return release(rr, out, 0, max_out);
+}
+
+uint32_t rr_artifact_flush(rr_artifact_t* rr, rr_clean_interval_t* out, uint32_t max_out)
+{
+    const rr_pending_t none = { .valid = false };
+    uint32_t n = 0;
+
+    if (!rr) {
+        return 0;
+    }
+
+    // Missing successors read as no change
+    for (int i = 0; i < 2; i++) {
+        shift_in(rr, &none);
+        n = release(rr, out, n, max_out);
+    }
+    memset(rr->pending, 0, sizeof(rr->pending));
+    rr->last_rr = 0.0f;
+    rr->last_clean = 0.0f;
+    return n;
+}
+
+const rr_artifact_report_t* rr_artifact_get_report(const rr_artifact_t* rr)
+{
+    return rr && rr->reports > 0 ? &rr->report : NULL;
+}
+
+/* ==== PIPELINE STAGE ==== */
+
+static float config_param(const pipeline_stage_config_t* config, uint32_t index, float fallback)
+{
+    if (config->parameter_count > index && config->parameters[index] > 0.0f) {
+        return config->parameters[index];
+    }
+    return fallback;
+}
+
+static void stage_apply_config(rr_artifact_config_t* cfg, const pipeline_stage_config_t* config)
+{
+    float mode = config_param(config, RR_ARTIFACT_PARAM_MODE, 0.0f);
+
+    if (mode > 0.0f) {
+        cfg->mode = (rr_artifact_mode_t)((uint32_t)mode - 1);
+    }
+    cfg->alpha = config_param(config, RR_ARTIFACT_PARAM_ALPHA, cfg->alpha);
+    cfg->report_beats = (uint32_t)config_param(config, RR_ARTIFACT_PARAM_REPORT_BEATS, (float)cfg->report_beats);
+    cfg->max_artifact_percent = config_param(config, RR_ARTIFACT_PARAM_MAX_PERCENT, cfg->max_artifact_percent);
+}
+
+static bool stage_init(pipeline_stage_t* stage, const pipeline_stage_config_t* config)
+{
+    rr_artifact_stage_state_t* state = (rr_artifact_stage_state_t*)stage->context;
+    rr_artifact_config_t cfg = RR_ARTIFACT_DEFAULT_CONFIG;
+
+    if (!config) {
+        return false;
+    }
+
+    stage->config = *config;
+    stage_apply_config(&cfg, config);
+    memset(&state->block, 0, sizeof(state->block));
+    return rr_artifact_init(&state->detector, &cfg);
+}
+
+static bool stage_process(pipeline_stage_t* stage, const signal_buffer_t* input, signal_buffer_t* output)
+{
+    rr_artifact_stage_state_t* state = (rr_artifact_stage_state_t*)stage->context;
+    const ppg_beat_block_t* beats = input ? (const ppg_beat_block_t*)input[0].metadata : NULL;
+
+    if (!beats || !output) {
+        return false;
+    }
+
+    state->block.count = 0;
+    for (uint32_t i = 0; i < beats->count; i++) {
+        state->block.count += rr_artifact_push(&state->detector, beats->beats[i].interval_ms,
+                                               state->block.intervals + state->block.count,
+                                               RR_ARTIFACT_MAX_BLOCK_OUTPUT - state->block.count);
+    }
+    state->block.report = rr_artifact_get_report(&state->detector);
+
+    output->length = 0;
+    output->sample_rate = input[0].sample_rate;
+    output->timestamp_start = input[0].timestamp_start;
+    output->quality_score = state->block.report && state->block.report->valid ?
+                            1.0f - 0.01f * state->block.report->artifact_percent : 0.0f;
+    output->metadata = &state->block;
+    return true;
+}
+
+static bool stage_reset(pipeline_stage_t* stage)
+{
+    rr_artifact_stage_state_t* state = (rr_artifact_stage_state_t*)stage->context;
+
+    rr_artifact_reset(&state->detector);
+    memset(&state->block, 0, sizeof(state->block));
+    return true;
+}
+
+static bool stage_update_config(pipeline_stage_t* stage, const pipeline_stage_config_t* config)
+{
+    rr_artifact_stage_state_t* state = (rr_artifact_stage_state_t*)stage->context;
+
+    if (!config) {
+        return false;
+    }
+
+    // Decision settings only; the running statistics stay valid
+    rr_artifact_config_t cfg = state->detector.config;
+    stage_apply_config(&cfg, config);
+    if (!config_is_valid(&cfg)) {
+        return false;
+    }
+
+    state->detector.config = cfg;
+    stage->config = *config;
+    return true;
+}
+
+static bool stage_get_status(pipeline_stage_t* stage, float* quality, uint32_t* latency_us)
+{
+    const rr_artifact_stage_state_t* state = (const rr_artifact_stage_state_t*)stage->context;
+    const rr_artifact_report_t* report = rr_artifact_get_report(&state->detector);
+
+    if (quality) {
+        *quality = report && report->valid ? 1.0f - 0.01f * report->artifact_percent : 0.0f;
+    }
+    if (latency_us) {
+        *latency_us = stage->processing_time_us;
+    }
+    return true;
+}
+
+static void stage_cleanup(pipeline_stage_t* stage)
+{
+    stage_reset(stage);
+}
+
+pipeline_stage_ops_t rr_artifact_stage_ops = {
+    .init = stage_init,
+    .process = stage_process,
+    .reset = stage_reset,
+    .update_config = stage_update_config,
+    .get_status = stage_get_status,
+    .cleanup = stage_cleanup,
+};
+
+bool rr_artifact_stage_bind(pipeline_stage_t* stage,
+                            rr_artifact_stage_state_t* state,
+                            const pipeline_stage_config_t* config)
+{
+    if (!stage || !state || !config) {
+        return false;
+    }
+
+    memset(stage, 0, sizeof(pipeline_stage_t));
+    stage->type = PIPELINE_STAGE_ALGORITHM;
+    stage->ops = &rr_artifact_stage_ops;
+    stage->multichannel = true;
+    stage->context = state;
+
+    if (!stage_init(stage, config)) {
+        return false;
+    }
+    pipeline_stage_set_name(stage, "rr_artifact");
+    return true;
+}
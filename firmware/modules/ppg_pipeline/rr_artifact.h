@@ -0,0 +1,263 @@
+#ifndef RR_ARTIFACT_H
+#define RR_ARTIFACT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "interfaces/signal_pipeline_interfaces.h"
+#include "ppg_stages.h"
+#include "running_filters.h"
+
+/**
+ * @file rr_artifact.h
+ * @brief Streaming RR-interval artifact detection and correction
+ *
+ * Incremental form of the Lipponen & Tarvainen (2019) dRR classifier.
+ * Each interval is normalized twice:
+ *
+ * - dRRs: successive difference over alpha * QD(|dRR|), the quartile
+ *   deviation of the last quantile_window differences
+ * - mRRs: difference to the median of the last median_window intervals
+ *   (shorter ones doubled) over alpha * QD(|mRR|)
+ *
+ * An interval is ectopic if its dRRs and the larger (or smaller) of its
+ * neighbours' dRRs form the negative-positive-negative pattern of a
+ * premature beat; long or short if it crosses the dRRs/mRRs thresholds
+ * without that pattern; missed if half of it, extra if the sum with the
+ * next one, is within the threshold of the median.
+ *
+ * The quartiles and median are running filters over trailing windows
+ * (the reference uses centered ones), updated in O(log window) per beat;
+ * classification needs the next two intervals, so output lags input by
+ * two beats. Ectopic, long and short intervals are replaced with the
+ * running median, missed beats split in two and extra beats merged, or,
+ * by mode, passed through flagged or dropped.
+ *
+ * Every report_beats classified intervals close a window with the
+ * artifact percentage and RMSSD/SDNN over the clean output only: flagged
+ * and dropped intervals break the successive-difference chain.
+ */
+
+// =============================================================================
+// Limits
+// =============================================================================
+
+#define RR_ARTIFACT_MAX_QUANTILE_WINDOW  91    ///< Beats in the dRR/mRR quartiles
+#define RR_ARTIFACT_MAX_MEDIAN_WINDOW    11    ///< Beats in the RR median
+#define RR_ARTIFACT_MAX_OUTPUT           2     ///< Intervals emitted per classified interval
+
+/** Stage output per block: every beat, plus the two intervals a gap flushes */
+#define RR_ARTIFACT_MAX_BLOCK_OUTPUT     (RR_ARTIFACT_MAX_OUTPUT * (PPG_FEATURE_MAX_BEATS + 2))
+
+/**
+ * @brief Index of artifact stage parameters in pipeline_stage_config_t.parameters
+ */
+typedef enum {
+    RR_ARTIFACT_PARAM_MODE = 0,           ///< rr_artifact_mode_t + 1 (0: default)
+    RR_ARTIFACT_PARAM_ALPHA,              ///< Threshold in quartile deviations
+    RR_ARTIFACT_PARAM_REPORT_BEATS,       ///< Intervals per artifact report
+    RR_ARTIFACT_PARAM_MAX_PERCENT,        ///< Report artifact percentage limit for valid HRV
+    RR_ARTIFACT_PARAM_COUNT
+} rr_artifact_param_t;
+
+// =============================================================================
+// Data Structures
+// =============================================================================
+
+/**
+ * @brief Classification of one interval
+ */
+typedef enum {
+    RR_NORMAL = 0,
+    RR_ECTOPIC,                       ///< Premature beat with compensatory pause
+    RR_LONG,                          ///< Too long, not a whole missed beat
+    RR_SHORT,                         ///< Too short, not a split beat
+    RR_MISSED,                        ///< Undetected beat: about twice the median
+    RR_EXTRA,                         ///< False beat: sums with the next to the median
+    RR_ARTIFACT_TYPE_COUNT
+} rr_artifact_type_t;
+
+/**
+ * @brief What is done with artifacts
+ */
+typedef enum {
+    RR_ARTIFACT_CORRECT = 0,          ///< Interpolate, split missed, merge extra
+    RR_ARTIFACT_FLAG,                 ///< Pass through unchanged, flagged
+    RR_ARTIFACT_DROP,                 ///< Emit nothing
+} rr_artifact_mode_t;
+
+/**
+ * @brief Detector configuration
+ */
+typedef struct {
+    rr_artifact_mode_t mode;
+    float alpha;                      ///< Threshold in quartile deviations (5.2)
+    float c1;                         ///< Ectopic decision boundary slope
+    float c2;                         ///< Ectopic decision boundary offset
+    float min_threshold_ms;           ///< Floor for both thresholds (steady rhythm)
+    uint32_t quantile_window;         ///< Beats in the quartiles (<= RR_ARTIFACT_MAX_QUANTILE_WINDOW)
+    uint32_t median_window;           ///< Beats in the median (<= RR_ARTIFACT_MAX_MEDIAN_WINDOW)
+    uint32_t report_beats;            ///< Classified intervals per report
+    float max_artifact_percent;       ///< Reports above this are not valid for HRV
+} rr_artifact_config_t;
+
+/**
+ * @brief One interval of the cleaned series
+ */
+typedef struct {
+    float interval_ms;                ///< Emitted interval
+    float raw_ms;                     ///< Interval as detected (sum for merged extra beats)
+    uint8_t type;                     ///< rr_artifact_type_t of the source interval
+    bool corrected;                   ///< interval_ms was interpolated, split or merged
+} rr_clean_interval_t;
+
+/**
+ * @brief Artifact statistics and clean HRV over one report window
+ */
+typedef struct {
+    uint32_t intervals;               ///< Classified input intervals
+    uint32_t artifacts;               ///< Of which not normal
+    uint32_t by_type[RR_ARTIFACT_TYPE_COUNT];
+    float artifact_percent;
+    uint32_t clean_intervals;         ///< Emitted intervals used for HRV (not flagged)
+    float rmssd_ms;                   ///< From successive clean intervals
+    float sdnn_ms;
+    bool valid;                       ///< Half the window clean, artifacts within limit
+} rr_artifact_report_t;
+
+/**
+ * @brief Interval in the classification lookahead
+ */
+typedef struct {
+    bool valid;                       ///< Slot holds an interval
+    float rr;                         ///< Interval in ms
+    float drrs;                       ///< Normalized successive difference
+    float mrrs;                       ///< Normalized difference to the median
+    float median;                     ///< RR median when it arrived
+    float th2;                        ///< mRR threshold when it arrived
+    bool merged;                      ///< Consumed by the previous extra beat
+} rr_pending_t;
+
+/**
+ * @brief Detector state
+ */
+typedef struct {
+    rr_artifact_config_t config;
+
+    // Running statistics over the raw series
+    running_quantile_t drr_q1, drr_q3, mrr_q1, mrr_q3, median;
+    float drr_values[2][RR_ARTIFACT_MAX_QUANTILE_WINDOW];
+    float mrr_values[2][RR_ARTIFACT_MAX_QUANTILE_WINDOW];
+    float median_values[RR_ARTIFACT_MAX_MEDIAN_WINDOW];
+    uint16_t drr_index[2][2 * RR_ARTIFACT_MAX_QUANTILE_WINDOW];
+    uint16_t mrr_index[2][2 * RR_ARTIFACT_MAX_QUANTILE_WINDOW];
+    uint16_t median_index[2 * RR_ARTIFACT_MAX_MEDIAN_WINDOW];
+
+    // Classification lookahead: pending[0] is the previous interval,
+    // pending[1] the one to classify, pending[2..3] its successors
+    rr_pending_t pending[4];
+    float last_rr;                    ///< Previous raw interval (0: none)
+
+    // Clean-series HRV of the current report window, sums taken about
+    // the window's first clean interval to keep float precision
+    float last_clean;                 ///< Previous clean interval (0: chain broken)
+    float shift;
+    float sum, sum_sq, diff_sq;
+    uint32_t diff_count;
+    rr_artifact_report_t current;
+    rr_artifact_report_t report;      ///< Last completed window
+    uint32_t reports;                 ///< Windows completed
+} rr_artifact_t;
+
+// Lipponen & Tarvainen 2019 constants; 60-beat reports, the HRV artifact
+// limit the application uses (HRV_MAX_ARTIFACT_PERCENT).
+static const rr_artifact_config_t RR_ARTIFACT_DEFAULT_CONFIG = {
+    .mode = RR_ARTIFACT_CORRECT,
+    .alpha = 5.2f,
+    .c1 = 0.13f,
+    .c2 = 0.17f,
+    .min_threshold_ms = 40.0f,
+    .quantile_window = 91,
+    .median_window = 11,
+    .report_beats = 60,
+    .max_artifact_percent = 20.0f
+};
+
+// =============================================================================
+// Detector Functions
+// =============================================================================
+
+/**
+ * @brief Initialize detector
+ * @param rr Detector instance
+ * @param config Configuration (NULL for RR_ARTIFACT_DEFAULT_CONFIG)
+ * @return true if the configuration is valid
+ */
+bool rr_artifact_init(rr_artifact_t* rr, const rr_artifact_config_t* config);
+
+/**
+ * @brief Clear history and reports, keep configuration
+ */
+void rr_artifact_reset(rr_artifact_t* rr);
+
+/**
+ * @brief Add one detected interval
+ * @param rr Detector instance
+ * @param interval_ms Interval; 0 marks a gap (pending intervals are flushed)
+ * @param out Cleaned intervals released by this call
+ * @param max_out Capacity of out (RR_ARTIFACT_MAX_OUTPUT per pending interval)
+ * @return Number of intervals written
+ */
+uint32_t rr_artifact_push(rr_artifact_t* rr, float interval_ms, rr_clean_interval_t* out, uint32_t max_out);
+
+/**
+ * @brief Classify the pending intervals without their successors
+ * @return Number of intervals written
+ */
+uint32_t rr_artifact_flush(rr_artifact_t* rr, rr_clean_interval_t* out, uint32_t max_out);
+
+/**
+ * @brief Last completed report, NULL before the first
+ */
+const rr_artifact_report_t* rr_artifact_get_report(const rr_artifact_t* rr);
+
+// =============================================================================
+// Pipeline Stage Binding
+// =============================================================================
+
+/**
+ * @brief Output of the artifact stage (signal_buffer_t.metadata)
+ */
+typedef struct {
+    rr_clean_interval_t intervals[RR_ARTIFACT_MAX_BLOCK_OUTPUT]; ///< Released this block
+    uint32_t count;
+    const rr_artifact_report_t* report; ///< Last completed report (NULL before the first)
+} rr_artifact_block_t;
+
+/**
+ * @brief Stage state (owned by caller, bound via context)
+ */
+typedef struct {
+    rr_artifact_t detector;
+    rr_artifact_block_t block;
+} rr_artifact_stage_state_t;
+
+/**
+ * @brief Stage operations for an RR artifact node
+ *
+ * Input 0 is an HR feature node; the beats in its ppg_beat_block_t
+ * metadata are fed in order and the cleaned intervals published in an
+ * rr_artifact_block_t.
+ */
+extern pipeline_stage_ops_t rr_artifact_stage_ops;
+
+/**
+ * @brief Bind an RR artifact detector to an algorithm stage
+ *
+ * Settings come from config->parameters (rr_artifact_param_t); unset
+ * entries keep RR_ARTIFACT_DEFAULT_CONFIG.
+ */
+bool rr_artifact_stage_bind(pipeline_stage_t* stage,
+                            rr_artifact_stage_state_t* state,
+                            const pipeline_stage_config_t* config);
+
+#endif // RR_ARTIFACT_H
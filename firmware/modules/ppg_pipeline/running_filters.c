@@ -0,0 +1,401 @@
+/*
+ * Sliding-Window Order Statistics Implementation
+ *
+ * Running quantile: the heap array holds the lower max-heap in
+ * [0, lower_cap) and the upper min-heap from lower_cap on; heap_pos maps
+ * every ring entry to its slot, so the sample leaving the window is found
+ * without a search and overwritten in place by the arriving one. Heap
+ * sizes only change while the window fills; after that a replacement
+ * keeps both sizes, and a single exchange of the tops restores
+ * max(lower) <= min(upper).
+ *
+ * Running min/max: each deque holds ring positions in arrival order with
+ * monotonic values, so its front is the extreme of the window and is
+ * dropped when its sample leaves.
+ *
+ * Running MAD: deviations of the samples at or below the median, read
+ * outwards from it, and of those above it are two ascending runs of the
+ * sorted window; the MAD is their merged middle rank, found by bisecting
+ * how many of the smallest deviations come from each run.
+ */
+
+#include "running_filters.h"
+#include <string.h>
+#include <math.h>
+
+/* ==== RUNNING QUANTILE ==== */
+
+static inline float slot_value(const running_quantile_t* rq, uint32_t slot)
+{
+    return rq->values[rq->heap[slot]];
+}
+
+static inline void place(running_quantile_t* rq, uint32_t slot, uint16_t ring)
+{
+    rq->heap[slot] = ring;
+    rq->heap_pos[ring] = (uint16_t)slot;
+}
+
+/** a belongs nearer the top than b */
+static inline bool above(float a, float b, bool max_heap)
+{
+    return max_heap ? a > b : a < b;
+}
+
+static uint32_t sift_up(running_quantile_t* rq, uint32_t base, uint32_t i, bool max_heap)
+{
+    uint16_t item = rq->heap[base + i];
+    float v = rq->values[item];
+
+    while (i > 0) {
+        uint32_t parent = (i - 1) / 2;
+        if (!above(v, slot_value(rq, base + parent), max_heap)) {
+            break;
+        }
+        place(rq, base + i, rq->heap[base + parent]);
+        i = parent;
+    }
+    place(rq, base + i, item);
+    return i;
+}
+
+static void sift_down(running_quantile_t* rq, uint32_t base, uint32_t size, uint32_t i, bool max_heap)
+{
+    uint16_t item = rq->heap[base + i];
+    float v = rq->values[item];
+
+    for (;;) {
+        uint32_t child = 2 * i + 1;
+        if (child >= size) {
+            break;
+        }
+        if (child + 1 < size && above(slot_value(rq, base + child + 1), slot_value(rq, base + child), max_heap)) {
+            child++;
+        }
+        if (!above(slot_value(rq, base + child), v, max_heap)) {
+            break;
+        }
+        place(rq, base + i, rq->heap[base + child]);
+        i = child;
+    }
+    place(rq, base + i, item);
+}
+
+/** Restore the heap holding slot after its value changed */
+static void fix_slot(running_quantile_t* rq, uint32_t slot)
+{
+    if (slot < rq->lower_cap) {
+        uint32_t i = sift_up(rq, 0, slot, true);
+        sift_down(rq, 0, rq->lower_size, i, true);
+    } else {
+        uint32_t i = sift_up(rq, rq->lower_cap, slot - rq->lower_cap, false);
+        sift_down(rq, rq->lower_cap, rq->upper_size, i, false);
+    }
+}
+
+/** Lower heap size for count samples: ranks 0..floor(q * (count - 1)) */
+static inline uint32_t lower_target(const running_quantile_t* rq, uint32_t count)
+{
+    return (uint32_t)floorf(rq->quantile * (float)(count - 1)) + 1;
+}
+
+static void fill(running_quantile_t* rq, uint16_t ring, float x)
+{
+    rq->count++;
+
+    if (rq->lower_size < lower_target(rq, rq->count)) {
+        // Lower heap grows: x, or the upper top if x belongs above it
+        if (rq->upper_size > 0 && x > slot_value(rq, rq->lower_cap)) {
+            uint16_t top = rq->heap[rq->lower_cap];
+            place(rq, rq->lower_cap, ring);
+            sift_down(rq, rq->lower_cap, rq->upper_size, 0, false);
+            ring = top;
+        }
+        place(rq, rq->lower_size, ring);
+        sift_up(rq, 0, rq->lower_size++, true);
+    } else {
+        if (rq->lower_size > 0 && x < slot_value(rq, 0)) {
+            uint16_t top = rq->heap[0];
+            place(rq, 0, ring);
+            sift_down(rq, 0, rq->lower_size, 0, true);
+            ring = top;
+        }
+        place(rq, rq->lower_cap + rq->upper_size, ring);
+        sift_up(rq, rq->lower_cap, rq->upper_size++, false);
+    }
+}
+
+bool running_quantile_init(running_quantile_t* rq, uint32_t window, float quantile,
+                           float* values, uint16_t* index)
+{
+    if (!rq || !values || !index || window == 0 || window > RUNNING_FILTER_MAX_WINDOW ||
+        !(quantile >= 0.0f && quantile <= 1.0f)) {
+        return false;
+    }
+
+    memset(rq, 0, sizeof(running_quantile_t));
+    rq->values = values;
+    rq->heap_pos = index;
+    rq->heap = index + window;
+    rq->window = window;
+    rq->quantile = quantile;
+    rq->lower_cap = lower_target(rq, window);
+    return true;
+}
+
+bool running_median_init(running_quantile_t* rq, uint32_t window, float* values, uint16_t* index)
+{
+    return running_quantile_init(rq, window, 0.5f, values, index);
+}
+
+void running_quantile_reset(running_quantile_t* rq)
+{
+    rq->count = 0;
+    rq->head = 0;
+    rq->lower_size = 0;
+    rq->upper_size = 0;
+}
+
+void running_quantile_push(running_quantile_t* rq, float x)
+{
+    uint16_t ring = (uint16_t)rq->head;
+
+    rq->head = rq->head + 1 == rq->window ? 0 : rq->head + 1;
+    rq->values[ring] = x;
+
+    if (rq->count < rq->window) {
+        fill(rq, ring, x);
+        return;
+    }
+
+    // Oldest sample overwritten in place: one sift, then at most one exchange
+    fix_slot(rq, rq->heap_pos[ring]);
+    if (rq->upper_size > 0 && slot_value(rq, 0) > slot_value(rq, rq->lower_cap)) {
+        uint16_t lower_top = rq->heap[0];
+        place(rq, 0, rq->heap[rq->lower_cap]);
+        place(rq, rq->lower_cap, lower_top);
+        sift_down(rq, 0, rq->lower_size, 0, true);
+        sift_down(rq, rq->lower_cap, rq->upper_size, 0, false);
+    }
+}
+
+float running_quantile_get(const running_quantile_t* rq)
+{
+    if (rq->count == 0) {
+        return 0.0f;
+    }
+
+    float low = slot_value(rq, 0);
+    float rank = rq->quantile * (float)(rq->count - 1);
+    float frac = rank - floorf(rank);
+
+    if (frac > 0.0f && rq->upper_size > 0) {
+        return low + frac * (slot_value(rq, rq->lower_cap) - low);
+    }
+    return low;
+}
+
+/* ==== RUNNING MIN / MAX ==== */
+
+static inline uint32_t wrap(const running_minmax_t* rm, uint32_t i)
+{
+    return i >= rm->window ? i - rm->window : i;
+}
+
+bool running_minmax_init(running_minmax_t* rm, uint32_t window, float* values, uint16_t* deque)
+{
+    if (!rm || !values || !deque || window == 0 || window > RUNNING_FILTER_MAX_WINDOW) {
+        return false;
+    }
+
+    memset(rm, 0, sizeof(running_minmax_t));
+    rm->values = values;
+    rm->deque = deque;
+    rm->window = window;
+    return true;
+}
+
+void running_minmax_reset(running_minmax_t* rm)
+{
+    rm->count = 0;
+    rm->head = 0;
+    rm->min_first = 0;
+    rm->min_size = 0;
+    rm->max_first = 0;
+    rm->max_size = 0;
+}
+
+void running_minmax_push(running_minmax_t* rm, float x)
+{
+    uint16_t ring = (uint16_t)rm->head;
+    uint16_t* min_q = rm->deque;
+    uint16_t* max_q = rm->deque + rm->window;
+
+    rm->head = wrap(rm, rm->head + 1);
+
+    if (rm->count == rm->window) {
+        // The leaving sample can only be at a front
+        if (rm->min_size > 0 && min_q[rm->min_first] == ring) {
+            rm->min_first = wrap(rm, rm->min_first + 1);
+            rm->min_size--;
+        }
+        if (rm->max_size > 0 && max_q[rm->max_first] == ring) {
+            rm->max_first = wrap(rm, rm->max_first + 1);
+            rm->max_size--;
+        }
+    } else {
+        rm->count++;
+    }
+    rm->values[ring] = x;
+
+    while (rm->min_size > 0 && rm->values[min_q[wrap(rm, rm->min_first + rm->min_size - 1)]] >= x) {
+        rm->min_size--;
+    }
+    min_q[wrap(rm, rm->min_first + rm->min_size++)] = ring;
+
+    while (rm->max_size > 0 && rm->values[max_q[wrap(rm, rm->max_first + rm->max_size - 1)]] <= x) {
+        rm->max_size--;
+    }
+    max_q[wrap(rm, rm->max_first + rm->max_size++)] = ring;
+}
+
+float running_minmax_min(const running_minmax_t* rm)
+{
+    return rm->min_size > 0 ? rm->values[rm->deque[rm->min_first]] : 0.0f;
+}
+
+float running_minmax_max(const running_minmax_t* rm)
+{
+    return rm->max_size > 0 ? rm->values[rm->deque[rm->window + rm->max_first]] : 0.0f;
+}
+
+/* ==== RUNNING MAD ==== */
+
+/** First position in sorted[0, n) whose value is not below x */
+static uint32_t lower_bound(const float* sorted, uint32_t n, float x)
+{
+    uint32_t lo = 0;
+
+    while (n > 0) {
+        uint32_t half = n / 2;
+        if (sorted[lo + half] < x) {
+            lo += half + 1;
+            n -= half + 1;
+        } else {
+            n = half;
+        }
+    }
+    return lo;
+}
+
+/** Deviation of the i-th sample at or below the median, nearest first */
+static inline float below_dev(const running_mad_t* mad, uint32_t split, float median, uint32_t i)
+{
+    return median - mad->sorted[split - 1 - i];
+}
+
+/** Deviation of the i-th sample above the median, nearest first */
+static inline float above_dev(const running_mad_t* mad, uint32_t split, float median, uint32_t i)
+{
+    return mad->sorted[split + i] - median;
+}
+
+/** Deviation of rank k (0-based) among all samples: bisect how many come from below */
+static float deviation_rank(const running_mad_t* mad, uint32_t split, float median, uint32_t k)
+{
+    uint32_t below = split;
+    uint32_t above = mad->count - split;
+    uint32_t lo = k + 1 > above ? k + 1 - above : 0;
+    uint32_t hi = k + 1 < below ? k + 1 : below;
+
+    // i deviations from below and k + 1 - i from above are the k + 1 smallest
+    while (lo < hi) {
+        uint32_t i = (lo + hi) / 2;
+        uint32_t j = k + 1 - i;
+        if (j > 0 && i < below && above_dev(mad, split, median, j - 1) > below_dev(mad, split, median, i)) {
+            lo = i + 1;
+        } else {
+            hi = i;
+        }
+    }
+
+    uint32_t i = lo;
+    uint32_t j = k + 1 - i;
+    float a = i > 0 ? below_dev(mad, split, median, i - 1) : 0.0f;
+    float b = j > 0 ? above_dev(mad, split, median, j - 1) : 0.0f;
+    return a > b ? a : b;
+}
+
+bool running_mad_init(running_mad_t* mad, uint32_t window, float* values, float* sorted)
+{
+    if (!mad || !values || !sorted || window == 0 || window > RUNNING_FILTER_MAX_WINDOW) {
+        return false;
+    }
+
+    memset(mad, 0, sizeof(running_mad_t));
+    mad->values = values;
+    mad->sorted = sorted;
+    mad->window = window;
+    return true;
+}
+
+void running_mad_reset(running_mad_t* mad)
+{
+    mad->count = 0;
+    mad->head = 0;
+}
+
+void running_mad_push(running_mad_t* mad, float x)
+{
+    uint32_t ring = mad->head;
+    float* sorted = mad->sorted;
+
+    mad->head = mad->head + 1 == mad->window ? 0 : mad->head + 1;
+
+    if (mad->count < mad->window) {
+        uint32_t at = lower_bound(sorted, mad->count, x);
+        memmove(&sorted[at + 1], &sorted[at], (mad->count - at) * sizeof(float));
+        sorted[at] = x;
+        mad->count++;
+    } else {
+        // Shift only the span between the leaving and the arriving sample
+        uint32_t out = lower_bound(sorted, mad->count, mad->values[ring]);
+        uint32_t at = lower_bound(sorted, mad->count, x);
+        if (at > out) {
+            at--;
+            memmove(&sorted[out], &sorted[out + 1], (at - out) * sizeof(float));
+        } else {
+            memmove(&sorted[at + 1], &sorted[at], (out - at) * sizeof(float));
+        }
+        sorted[at] = x;
+    }
+    mad->values[ring] = x;
+}
+
+float running_mad_median(const running_mad_t* mad)
+{
+    uint32_t n = mad->count;
+
+    if (n == 0) {
+        return 0.0f;
+    }
+    return n % 2 ? mad->sorted[n / 2] : 0.5f * (mad->sorted[n / 2 - 1] + mad->sorted[n / 2]);
+}
+
+float running_mad_get(const running_mad_t* mad)
+{
+    uint32_t n = mad->count;
+
+    if (n == 0) {
+        return 0.0f;
+    }
+
+    float median = running_mad_median(mad);
+    uint32_t split = lower_bound(mad->sorted, n, median);
+    while (split < n && mad->sorted[split] <= median) {
+        split++;
+    }
+
+    float mid = deviation_rank(mad, split, median, (n - 1) / 2);
+    return n % 2 ? mid : 0.5f * (mid + deviation_rank(mad, split, median, n / 2));
+}
@@ -0,0 +1,169 @@
+#ifndef RUNNING_FILTERS_H
+#define RUNNING_FILTERS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @file running_filters.h
+ * @brief Sliding-window order statistics: quantile/median, min/max, MAD
+ *
+ * Robust baselines and outlier gates without sorting the window:
+ *
+ * - running_quantile_t keeps the window split around the requested rank
+ *   in a max-heap (lower part) and a min-heap (upper part) indexed from a
+ *   ring of samples. Replacing the oldest sample is one sift in its heap
+ *   plus at most one exchange of the two tops: O(log n) per sample, O(1)
+ *   to read. The median is the 0.5 quantile.
+ * - running_minmax_t keeps monotonic deques of ring positions, so each
+ *   sample is pushed and popped at most once: O(1) amortized.
+ * - running_mad_t keeps the window sorted (binary search plus one
+ *   memmove of the span between the leaving and the arriving sample) and
+ *   finds the exact median absolute deviation by bisecting the two sorted
+ *   deviation runs either side of the median: O(log n) compares, O(n)
+ *   word moves. Meant for per-beat series such as RR intervals, where
+ *   windows are tens of samples; deviations taken against a lagging
+ *   median instead would inflate the MAD on a trending series.
+ *
+ * Typical uses: RR outlier rejection (median +- k * MAD of recent
+ * intervals), baseline wander removal (subtract a ~1.5 s running median)
+ * and perfusion index ((max - min) / mean over one beat).
+ *
+ * Storage is owned by the caller so the window can be sized per use
+ * without a compile-time maximum in every instance.
+ */
+
+// =============================================================================
+// Limits
+// =============================================================================
+
+#define RUNNING_FILTER_MAX_WINDOW    4096  ///< Ring positions are stored as uint16_t
+
+/** MAD to standard deviation for normally distributed data */
+#define RUNNING_MAD_TO_SIGMA         1.4826f
+
+// =============================================================================
+// Data Structures
+// =============================================================================
+
+/**
+ * @brief Running quantile over the last window samples
+ */
+typedef struct {
+    float* values;                    ///< Ring of samples [window]
+    uint16_t* heap_pos;               ///< Heap slot of each ring entry [window]
+    uint16_t* heap;                   ///< Lower max-heap [0, lower_cap), upper min-heap after it [window]
+    uint32_t window;                  ///< Window length in samples
+    uint32_t lower_cap;               ///< Lower heap size once the window is full
+    float quantile;                   ///< Requested quantile (0..1)
+    uint32_t count;                   ///< Samples in the window
+    uint32_t head;                    ///< Ring position of the next sample
+    uint32_t lower_size;              ///< Entries in the lower heap
+    uint32_t upper_size;              ///< Entries in the upper heap
+} running_quantile_t;
+
+/**
+ * @brief Running minimum and maximum over the last window samples
+ */
+typedef struct {
+    float* values;                    ///< Ring of samples [window]
+    uint16_t* deque;                  ///< Min deque [0, window), max deque [window, 2 * window)
+    uint32_t window;                  ///< Window length in samples
+    uint32_t count;                   ///< Samples in the window
+    uint32_t head;                    ///< Ring position of the next sample
+    uint32_t min_first;               ///< Min deque front (increasing values)
+    uint32_t min_size;
+    uint32_t max_first;               ///< Max deque front (decreasing values)
+    uint32_t max_size;
+} running_minmax_t;
+
+/**
+ * @brief Running median and median absolute deviation
+ */
+typedef struct {
+    float* values;                    ///< Ring of samples [window]
+    float* sorted;                    ///< Window in ascending order [window]
+    uint32_t window;                  ///< Window length in samples
+    uint32_t count;                   ///< Samples in the window
+    uint32_t head;                    ///< Ring position of the next sample
+} running_mad_t;
+
+// =============================================================================
+// Running Quantile / Median
+// =============================================================================
+
+/**
+ * @brief Initialize a running quantile
+ * @param rq Instance
+ * @param window Window length (1..RUNNING_FILTER_MAX_WINDOW)
+ * @param quantile 0 (minimum) .. 1 (maximum), linearly interpolated between ranks
+ * @param values Sample ring, window entries
+ * @param index Heap bookkeeping, 2 * window entries
+ * @return false on invalid arguments
+ */
+bool running_quantile_init(running_quantile_t* rq, uint32_t window, float quantile,
+                           float* values, uint16_t* index);
+
+/**
+ * @brief Running median (0.5 quantile; mean of the middle pair for even counts)
+ */
+bool running_median_init(running_quantile_t* rq, uint32_t window, float* values, uint16_t* index);
+
+/**
+ * @brief Empty the window, keep window length, quantile and storage
+ */
+void running_quantile_reset(running_quantile_t* rq);
+
+/**
+ * @brief Add a sample, dropping the oldest once the window is full
+ */
+void running_quantile_push(running_quantile_t* rq, float x);
+
+/**
+ * @brief Quantile of the samples currently in the window (0 if empty)
+ */
+float running_quantile_get(const running_quantile_t* rq);
+
+// =============================================================================
+// Running Min / Max
+// =============================================================================
+
+/**
+ * @brief Initialize a running min/max
+ * @param values Sample ring, window entries
+ * @param deque Deque storage, 2 * window entries
+ */
+bool running_minmax_init(running_minmax_t* rm, uint32_t window, float* values, uint16_t* deque);
+
+void running_minmax_reset(running_minmax_t* rm);
+
+void running_minmax_push(running_minmax_t* rm, float x);
+
+/** Minimum of the window (0 if empty) */
+float running_minmax_min(const running_minmax_t* rm);
+
+/** Maximum of the window (0 if empty) */
+float running_minmax_max(const running_minmax_t* rm);
+
+// =============================================================================
+// Running MAD
+// =============================================================================
+
+/**
+ * @brief Initialize a running MAD
+ * @param values Sample ring, window entries
+ * @param sorted Sorted copy, window entries
+ */
+bool running_mad_init(running_mad_t* mad, uint32_t window, float* values, float* sorted);
+
+void running_mad_reset(running_mad_t* mad);
+
+void running_mad_push(running_mad_t* mad, float x);
+
+/** Median of the window (0 if empty) */
+float running_mad_median(const running_mad_t* mad);
+
+/** Median absolute deviation (multiply by RUNNING_MAD_TO_SIGMA for a sigma estimate) */
+float running_mad_get(const running_mad_t* mad);
+
+#endif // RUNNING_FILTERS_H
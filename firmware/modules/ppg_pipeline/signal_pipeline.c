@@ -0,0 +1,1196 @@
+/*
+ * Signal Pipeline Implementation
+ *
+ * Runs pipeline stages as a directed acyclic graph. Shared preprocessing
+ * and filter nodes fan out to several feature nodes (HR, SpO2,
+ * respiration), each node runs exactly once per block in topological
+ * order, and intermediate buffers come from a reference-counted pool that
+ * is sized for the peak number of live results when the topology is set.
+ */
+
+#include "interfaces/signal_pipeline_interfaces.h"
+#include "pipeline_port.h"
+#include "pipeline_pool.h"
+#include "pipeline_profile.h"
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+LOG_MODULE_REGISTER(signal_pipeline, LOG_LEVEL_INF);
+
+#define NODE_INVALID    INT8_MAX
+
+#define CHECKPOINT_MAGIC    0x50434B50u     /* "PCKP" */
+#define CHECKPOINT_VERSION  2u
+#define FNV_OFFSET          2166136261u
+#define FNV_PRIME           16777619u
+
+/** Checkpoint layout: header, then one record header + payload per stage */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t length;                  /* Header and records */
+    uint32_t checksum;                /* FNV-1a over the rest of the header, then the records */
+    uint32_t record_count;
+    uint32_t gate_open;
+} checkpoint_header_t;
+
+typedef struct {
+    uint32_t name_hash;               /* FNV-1a of the stage name */
+    uint32_t length;                  /* Payload bytes (records are 4-byte aligned) */
+} checkpoint_record_t;
+
+/* ==== PRIVATE FUNCTIONS ==== */
+
+static uint32_t fnv1a(uint32_t hash, const void* data, uint32_t length)
+{
+    const uint8_t* p = (const uint8_t*)data;
+    for (uint32_t i = 0; i < length; i++) {
+        hash = (hash ^ p[i]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+/** Covers every header field but the checksum itself, then the records */
+static uint32_t checkpoint_checksum(const uint8_t* base, uint32_t length)
+{
+    const uint32_t skip = offsetof(checkpoint_header_t, checksum);
+    const uint32_t rest = skip + sizeof(uint32_t);
+
+    uint32_t hash = fnv1a(FNV_OFFSET, base, skip);
+    hash = fnv1a(hash, base + rest, sizeof(checkpoint_header_t) - rest);
+    return fnv1a(hash, base + sizeof(checkpoint_header_t), length - sizeof(checkpoint_header_t));
+}
+
+static int find_stage(const signal_pipeline_t* pipeline, const char* name)
+{
+    for (uint32_t i = 0; i < pipeline->stage_count; i++) {
+        if (pipeline->stages[i]->name && strcmp(pipeline->stages[i]->name, name) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+static uint32_t stage_inputs(const pipeline_stage_t* stage)
+{
+    return stage->input_count ? stage->input_count : 1u;
+}
+
+static int8_t resolve_input(const pipeline_node_desc_t* nodes, uint32_t node_count, const char* name)
+{
+    if (strcmp(name, PIPELINE_SOURCE_NAME_0) == 0) {
+        return PIPELINE_SOURCE(0);
+    }
+    if (strcmp(name, PIPELINE_SOURCE_NAME_1) == 0) {
+        return PIPELINE_SOURCE(1);
+    }
+
+    for (uint32_t i = 0; i < node_count; i++) {
+        if (nodes[i].stage->name && strcmp(nodes[i].stage->name, name) == 0) {
+            return (int8_t)i;
+        }
+    }
+    return NODE_INVALID;
+}
+
+/**
+ * Kahn's algorithm over the node table; fills exec_order and consumer
+ * counts. Ties keep declaration order so linear pipelines run as added.
+ */
+static bool build_schedule(signal_pipeline_t* pipeline)
+{
+    uint8_t pending[PIPELINE_MAX_STAGES] = {0};
+    uint32_t count = pipeline->stage_count;
+    uint32_t scheduled = 0;
+
+    for (uint32_t i = 0; i < count; i++) {
+        pipeline->nodes[i].consumer_count = 0;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        const pipeline_node_t* node = &pipeline->nodes[i];
+        for (uint32_t j = 0; j < node->input_count; j++) {
+            if (!PIPELINE_IS_SOURCE(node->inputs[j])) {
+                pipeline->nodes[node->inputs[j]].consumer_count++;
+                pending[i]++;
+            }
+        }
+    }
+
+    while (scheduled < count) {
+        int ready = -1;
+
+        for (uint32_t i = 0; i < count; i++) {
+            if (pending[i] == 0) {
+                ready = (int)i;
+                break;
+            }
+        }
+        if (ready < 0) {
+            LOG_ERR("Pipeline graph contains a cycle");
+            return false;
+        }
+
+        pending[ready] = UINT8_MAX;
+        pipeline->exec_order[scheduled++] = (uint8_t)ready;
+
+        for (uint32_t i = 0; i < count; i++) {
+            const pipeline_node_t* node = &pipeline->nodes[i];
+            for (uint32_t j = 0; j < node->input_count; j++) {
+                if (node->inputs[j] == ready && pending[i] != UINT8_MAX) {
+                    pending[i]--;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Replays one block of the schedule with reference counts only and
+ * returns the peak number of simultaneously live buffers.
+ */
+static uint32_t plan_buffer_count(const signal_pipeline_t* pipeline)
+{
+    uint8_t refs[PIPELINE_MAX_STAGES] = {0};
+    uint32_t live = 0;
+    uint32_t peak = 0;
+
+    for (uint32_t k = 0; k < pipeline->stage_count; k++) {
+        uint8_t i = pipeline->exec_order[k];
+        const pipeline_node_t* node = &pipeline->nodes[i];
+
+        // Output is acquired before the inputs are released
+        live++;
+        if (live > peak) {
+            peak = live;
+        }
+        refs[i] = node->consumer_count + (node->is_output ? 1 : 0);
+
+        for (uint32_t j = 0; j < node->input_count; j++) {
+            int8_t ref = node->inputs[j];
+            if (!PIPELINE_IS_SOURCE(ref) && --refs[ref] == 0) {
+                live--;
+            }
+        }
+        if (refs[i] == 0) {
+            live--;
+        }
+    }
+
+    return peak;
+}
+
+/** Grows the buffer pool from the pipeline's arena; buffers are never shrunk */
+static bool ensure_buffers(signal_pipeline_t* pipeline, uint32_t count)
+{
+    for (uint32_t s = pipeline->buffer_count; s < count; s++) {
+        float* data = pipeline_pool_alloc(pipeline, pipeline->channel_count *
+                                                    pipeline->buffer_samples * sizeof(float));
+        if (!data) {
+            LOG_ERR("No pool memory for pipeline buffer %u", s);
+            return false;
+        }
+        memset(&pipeline->stage_buffers[s], 0, sizeof(signal_buffer_t));
+        pipeline->stage_buffers[s].data = data;
+        pipeline->stage_buffers[s].stride = pipeline->buffer_samples;
+        pipeline->buffer_refs[s] = 0;
+        pipeline->buffer_count = s + 1;
+    }
+    return true;
+}
+
+/** Grows the one scratch area to the largest stage request (in place) and hands it to every stage */
+static bool ensure_scratch(signal_pipeline_t* pipeline)
+{
+    uint32_t needed = 0;
+
+    for (uint32_t i = 0; i < pipeline->stage_count; i++) {
+        if (pipeline->stages[i]->scratch_bytes > needed) {
+            needed = pipeline->stages[i]->scratch_bytes;
+        }
+    }
+
+    if (needed > pipeline->scratch_bytes) {
+        void* scratch = pipeline_pool_scratch(pipeline, needed);
+        if (!scratch) {
+            LOG_ERR("No pool memory for %u bytes of stage scratch", needed);
+            return false;
+        }
+        pipeline->scratch = scratch;
+        pipeline->scratch_bytes = needed;
+    }
+
+    for (uint32_t i = 0; i < pipeline->stage_count; i++) {
+        pipeline_stage_t* stage = pipeline->stages[i];
+        stage->scratch = stage->scratch_bytes ? pipeline->scratch : NULL;
+    }
+    return true;
+}
+
+/**
+ * Marks feature and algorithm nodes reachable from the gate stage, and
+ * everything downstream of them, as skippable. Clears the gate if its
+ * stage is no longer in the pipeline.
+ */
+static void plan_gating(signal_pipeline_t* pipeline)
+{
+    uint32_t reached = 0;
+    int gate = -1;
+
+    pipeline->gated_mask = 0;
+    for (uint32_t i = 0; i < pipeline->stage_count; i++) {
+        if (pipeline->stages[i] == pipeline->gate_stage) {
+            gate = (int)i;
+        }
+    }
+    if (gate < 0) {
+        pipeline->gate_stage = NULL;
+        return;
+    }
+
+    reached = 1u << gate;
+    for (uint32_t k = 0; k < pipeline->stage_count; k++) {
+        uint8_t i = pipeline->exec_order[k];
+        const pipeline_node_t* node = &pipeline->nodes[i];
+        pipeline_stage_type_t type = pipeline->stages[i]->type;
+
+        for (uint32_t j = 0; j < node->input_count; j++) {
+            int8_t ref = node->inputs[j];
+            if (PIPELINE_IS_SOURCE(ref)) {
+                continue;
+            }
+            if (pipeline->gated_mask & (1u << ref)) {
+                pipeline->gated_mask |= 1u << i;
+            }
+            if (reached & (1u << ref)) {
+                reached |= 1u << i;
+                if (type == PIPELINE_STAGE_FEATURE_EXTRACT || type == PIPELINE_STAGE_ALGORITHM) {
+                    pipeline->gated_mask |= 1u << i;
+                }
+            }
+        }
+    }
+}
+
+static bool apply_topology(signal_pipeline_t* pipeline)
+{
+    if (!build_schedule(pipeline)) {
+        return false;
+    }
+    plan_gating(pipeline);
+    return ensure_buffers(pipeline, plan_buffer_count(pipeline)) && ensure_scratch(pipeline);
+}
+
+static int acquire_buffer(signal_pipeline_t* pipeline)
+{
+    for (uint32_t s = 0; s < pipeline->buffer_count; s++) {
+        if (pipeline->buffer_refs[s] == 0) {
+            pipeline->buffer_refs[s] = 1;
+            return (int)s;
+        }
+    }
+    return -1;
+}
+
+static void release_buffer(signal_pipeline_t* pipeline, int8_t slot)
+{
+    if (slot >= 0 && pipeline->buffer_refs[slot] > 0) {
+        pipeline->buffer_refs[slot]--;
+    }
+}
+
+/** Drop outputs held from the previous block */
+static void release_held_outputs(signal_pipeline_t* pipeline)
+{
+    for (uint32_t i = 0; i < pipeline->stage_count; i++) {
+        pipeline_node_t* node = &pipeline->nodes[i];
+        if (node->is_output && node->output) {
+            release_buffer(pipeline, node->buffer_slot);
+        }
+        node->output = NULL;
+        node->buffer_slot = -1;
+    }
+}
+
+/** Most samples per row a stage may write: its declared buffer_size, else its longest input */
+static uint32_t output_bound(const pipeline_stage_t* stage, const signal_buffer_t* inputs, uint32_t count)
+{
+    uint32_t bound = stage->config.buffer_size;
+
+    for (uint32_t j = 0; j < count; j++) {
+        if (inputs[j].length > bound) {
+            bound = inputs[j].length;
+        }
+    }
+    return bound;
+}
+
+static void run_node(signal_pipeline_t* pipeline, uint8_t index,
+                     const signal_buffer_t* sources, uint32_t source_count)
+{
+    pipeline_node_t* node = &pipeline->nodes[index];
+    pipeline_stage_t* stage = pipeline->stages[index];
+    signal_buffer_t inputs[PIPELINE_MAX_NODE_INPUTS];
+    int8_t input_slots[PIPELINE_MAX_NODE_INPUTS];
+    uint8_t holders = node->consumer_count + (node->is_output ? 1 : 0);
+    bool inputs_ok = true;
+
+    for (uint32_t j = 0; j < node->input_count; j++) {
+        int8_t ref = node->inputs[j];
+
+        if (PIPELINE_IS_SOURCE(ref)) {
+            uint8_t src = PIPELINE_SOURCE_INDEX(ref);
+            if (src < source_count) {
+                inputs[j] = sources[src];
+            } else {
+                memset(&inputs[j], 0, sizeof(signal_buffer_t));
+                inputs_ok = false;
+            }
+            input_slots[j] = -1;
+        } else if (pipeline->nodes[ref].output) {
+            inputs[j] = *pipeline->nodes[ref].output;
+            input_slots[j] = pipeline->nodes[ref].buffer_slot;
+        } else {
+            memset(&inputs[j], 0, sizeof(signal_buffer_t));
+            input_slots[j] = -1;
+            inputs_ok = false;
+        }
+    }
+
+    int slot = -1;
+
+    // Disabled stage on a pooled input: share the upstream buffer
+    if (!stage->config.enabled && inputs_ok && input_slots[0] >= 0) {
+        node->buffer_slot = input_slots[0];
+        node->output = &pipeline->stage_buffers[node->buffer_slot];
+        pipeline->buffer_refs[node->buffer_slot] += holders;
+    } else if ((slot = acquire_buffer(pipeline)) < 0) {
+        // Pool is sized from the schedule; running dry means corrupt refcounts
+        LOG_ERR("Pipeline buffer pool exhausted at %s", stage->name);
+        pipeline->errors++;
+    } else {
+        signal_buffer_t* out = &pipeline->stage_buffers[slot];
+        out->length = 0;
+        out->sample_rate = inputs[0].sample_rate;
+        out->timestamp_start = inputs[0].timestamp_start;
+        out->quality_score = inputs[0].quality_score;
+        out->metadata = NULL;
+        out->channels = 0;
+
+        if (!stage->config.enabled && inputs_ok) {
+            for (uint32_t c = 0; c < SIGNAL_CHANNEL_COUNT(&inputs[0]); c++) {
+                memcpy(SIGNAL_CHANNEL(out, c), SIGNAL_CHANNEL(&inputs[0], c),
+                       inputs[0].length * sizeof(float));
+            }
+            out->length = inputs[0].length;
+            out->channels = inputs[0].channels;
+        } else {
+            // Checked before the call: an overrun would already have hit the neighbouring buffer
+            bool ok = inputs_ok && output_bound(stage, inputs, node->input_count) <= pipeline->buffer_samples;
+            if (ok) {
+                PIPELINE_PROFILE_BEGIN(start);
+                ok = stage->ops->process(stage, inputs, out);
+                PIPELINE_PROFILE_END(start, &stage->profile, stage->processing_time_us);
+            } else if (inputs_ok) {
+                LOG_ERR("Stage %s output exceeds %u-sample buffers", stage->name, pipeline->buffer_samples);
+            }
+            if (!ok) {
+                out->length = 0;
+                pipeline->errors++;
+            }
+        }
+
+        node->buffer_slot = (int8_t)slot;
+        node->output = out;
+        pipeline->buffer_refs[slot] = holders + 1;
+        release_buffer(pipeline, (int8_t)slot);
+    }
+
+    for (uint32_t j = 0; j < node->input_count; j++) {
+        release_buffer(pipeline, input_slots[j]);
+    }
+
+    node->last_block = pipeline->block_sequence;
+}
+
+/** Gated node on a closed gate: publish nothing, hand back the inputs */
+static void skip_node(signal_pipeline_t* pipeline, uint8_t index)
+{
+    pipeline_node_t* node = &pipeline->nodes[index];
+
+    for (uint32_t j = 0; j < node->input_count; j++) {
+        int8_t ref = node->inputs[j];
+        if (!PIPELINE_IS_SOURCE(ref)) {
+            release_buffer(pipeline, pipeline->nodes[ref].buffer_slot);
+        }
+    }
+
+    node->output = NULL;
+    node->buffer_slot = -1;
+    node->last_block = pipeline->block_sequence;
+    pipeline->gated_skips++;
+}
+
+static void update_gate(signal_pipeline_t* pipeline, uint8_t gate)
+{
+    const signal_buffer_t* out = pipeline->nodes[gate].output;
+    bool open = out && out->quality_score >= pipeline->gate_threshold;
+
+    // Gated stages missed blocks; restart them rather than bridge the gap
+    if (open && !pipeline->gate_open) {
+        for (uint32_t i = 0; i < pipeline->stage_count; i++) {
+            pipeline_stage_t* stage = pipeline->stages[i];
+            if ((pipeline->gated_mask & (1u << i)) && stage->ops->reset) {
+                stage->ops->reset(stage);
+            }
+        }
+    }
+    pipeline->gate_open = open;
+}
+
+/** Swap staged configurations in before any node of the block runs */
+static void apply_pending_configs(signal_pipeline_t* pipeline)
+{
+    for (uint32_t i = 0; i < pipeline->stage_count; i++) {
+        pipeline_stage_t* stage = pipeline->stages[i];
+        pipeline_stage_config_t config;
+
+        if (stage->pending_sequence == stage->applied_sequence) {
+            continue;
+        }
+
+        PIPELINE_CRITICAL_ENTER();
+        config = stage->pending_config;
+        stage->applied_sequence = stage->pending_sequence;
+        PIPELINE_CRITICAL_EXIT();
+
+        if (!stage->ops->update_config) {
+            stage->config = config;
+        } else if (!stage->ops->update_config(stage, &config)) {
+            LOG_WRN("Stage %s rejected new configuration", stage->name);
+            pipeline->errors++;
+        }
+    }
+}
+
+/**
+ * Parses "stage:index=value,...;stage:..." on top of each stage's pending
+ * (or active) configuration. With apply false the string is only checked.
+ */
+static bool parse_config_string(signal_pipeline_t* pipeline, const char* text, bool apply)
+{
+    const char* p = text;
+
+    while (*p) {
+        const char* end = strchr(p, ';');
+        const char* colon = strchr(p, ':');
+        char name[sizeof(((pipeline_stage_config_t*)0)->algorithm_name)];
+
+        if (!end) {
+            end = p + strlen(p);
+        }
+        if (!colon || colon > end || colon == p || (size_t)(colon - p) >= sizeof(name)) {
+            return false;
+        }
+        memcpy(name, p, (size_t)(colon - p));
+        name[colon - p] = '\0';
+
+        int index = find_stage(pipeline, name);
+        if (index < 0) {
+            return false;
+        }
+
+        pipeline_stage_t* stage = pipeline->stages[index];
+        pipeline_stage_config_t config = (stage->pending_sequence != stage->applied_sequence) ?
+                                         stage->pending_config : stage->config;
+
+        for (const char* q = colon + 1; q < end; ) {
+            char* next;
+
+            if (strncmp(q, "enabled=", 8) == 0) {
+                config.enabled = strtoul(q + 8, &next, 10) != 0;
+                if (next == q + 8) {
+                    return false;
+                }
+            } else {
+                unsigned long param = strtoul(q, &next, 10);
+                if (next == q || *next != '=' || param >= PIPELINE_MAX_PARAMS) {
+                    return false;
+                }
+                q = next + 1;
+                config.parameters[param] = strtof(q, &next);
+                if (next == q) {
+                    return false;
+                }
+                if (config.parameter_count <= param) {
+                    config.parameter_count = (uint32_t)param + 1;
+                }
+            }
+
+            if (next > end || (next < end && *next != ',')) {
+                return false;
+            }
+            q = (next < end) ? next + 1 : end;
+        }
+
+        if (apply && !pipeline_request_config(pipeline, name, &config)) {
+            return false;
+        }
+        p = (*end == ';') ? end + 1 : end;
+    }
+
+    return true;
+}
+
+static bool run_block(signal_pipeline_t* pipeline, const signal_buffer_t* sources, uint32_t source_count)
+{
+    const signal_buffer_t* primary = NULL;
+
+    release_held_outputs(pipeline);
+    pipeline->block_sequence++;
+    apply_pending_configs(pipeline);
+
+    for (uint32_t k = 0; k < pipeline->stage_count; k++) {
+        uint8_t index = pipeline->exec_order[k];
+
+        if (pipeline->gated_mask & (1u << index)) {
+            if (!pipeline->gate_open) {
+                skip_node(pipeline, index);
+                continue;
+            }
+            pipeline->gated_runs++;
+        }
+
+        run_node(pipeline, index, sources, source_count);
+
+        if (pipeline->stages[index] == pipeline->gate_stage) {
+            update_gate(pipeline, index);
+        }
+    }
+
+    // Primary output: last output node in execution order
+    for (uint32_t k = 0; k < pipeline->stage_count; k++) {
+        const pipeline_node_t* node = &pipeline->nodes[pipeline->exec_order[k]];
+        if (node->is_output && node->output) {
+            primary = node->output;
+        }
+    }
+
+    if (primary) {
+        pipeline->output_buffer = *primary;
+        pipeline->overall_quality = primary->quality_score;
+    }
+    pipeline->input_buffer = sources[0];
+    pipeline->samples_processed += sources[0].length;
+    return true;
+}
+
+static void init_pipeline(signal_pipeline_t* pipeline, pipeline_signal_type_t signal_type, uint32_t block_size)
+{
+    memset(pipeline, 0, sizeof(signal_pipeline_t));
+    pipeline->signal_type = signal_type;
+    pipeline->block_capacity = block_size ? block_size : PIPELINE_DEFAULT_BLOCK_SIZE;
+    pipeline->buffer_samples = pipeline->block_capacity;
+    pipeline->channel_count = 1;
+    pipeline->target_quality = 0.8f;
+    PIPELINE_PROFILE_INIT();
+
+    for (uint32_t i = 0; i < PIPELINE_MAX_STAGES; i++) {
+        pipeline->nodes[i].buffer_slot = -1;
+    }
+}
+
+/* ==== PUBLIC FUNCTIONS ==== */
+
+signal_pipeline_t* pipeline_create(pipeline_signal_type_t signal_type)
+{
+    if (signal_type >= PIPELINE_SIGNAL_COUNT) {
+        return NULL;
+    }
+
+    signal_pipeline_t* pipeline = pipeline_pool_acquire();
+    if (!pipeline) {
+        LOG_ERR("No free pipeline slot");
+        return NULL;
+    }
+
+    init_pipeline(pipeline, signal_type, 0);
+    return pipeline;
+}
+
+signal_pipeline_t* pipeline_create_graph(pipeline_signal_type_t signal_type,
+                                         const pipeline_node_desc_t* nodes,
+                                         uint32_t node_count,
+                                         uint32_t block_size)
+{
+    return pipeline_create_multichannel(signal_type, nodes, node_count, block_size, 0);
+}
+
+signal_pipeline_t* pipeline_create_multichannel(pipeline_signal_type_t signal_type,
+                                                const pipeline_node_desc_t* nodes,
+                                                uint32_t node_count,
+                                                uint32_t block_size,
+                                                uint8_t led_slots)
+{
+    if (signal_type >= PIPELINE_SIGNAL_COUNT || !nodes ||
+        node_count == 0 || node_count > PIPELINE_MAX_STAGES) {
+        LOG_ERR("Invalid pipeline graph (%u nodes)", node_count);
+        return NULL;
+    }
+    if (led_slots >> PIPELINE_MAX_CHANNELS) {
+        LOG_ERR("LED slots 0x%02x beyond the %u sample channels", led_slots, PIPELINE_MAX_CHANNELS);
+        return NULL;
+    }
+    uint32_t channels = pipeline_channels_from_slots(led_slots);
+
+    for (uint32_t i = 0; i < node_count; i++) {
+        const pipeline_stage_t* stage = nodes[i].stage;
+
+        if (!stage || !stage->ops || !stage->ops->process || !stage->name) {
+            LOG_ERR("Pipeline node %u has no stage", i);
+            return NULL;
+        }
+        if (channels > 1 && !stage->multichannel) {
+            LOG_ERR("Stage %s handles one channel row, pipeline has %u", stage->name, channels);
+            return NULL;
+        }
+        uint32_t wired = 0;
+        while (wired < PIPELINE_MAX_NODE_INPUTS && nodes[i].inputs[wired]) {
+            wired++;
+        }
+        if (wired != stage_inputs(stage)) {
+            LOG_ERR("Stage %s reads %u inputs, node has %u", stage->name, stage_inputs(stage), wired);
+            return NULL;
+        }
+        if (resolve_input(nodes, i, stage->name) != NODE_INVALID) {
+            LOG_ERR("Duplicate stage name %s", stage->name);
+            return NULL;
+        }
+    }
+
+    signal_pipeline_t* pipeline = pipeline_pool_acquire();
+    if (!pipeline) {
+        LOG_ERR("No free pipeline slot");
+        return NULL;
+    }
+    init_pipeline(pipeline, signal_type, block_size);
+    pipeline->led_slots = led_slots;
+    if (led_slots) {
+        pipeline->channel_count = channels;
+    }
+
+    // Every pool buffer must hold the largest output any stage declares
+    for (uint32_t i = 0; i < node_count; i++) {
+        if (nodes[i].stage->config.buffer_size > pipeline->buffer_samples) {
+            pipeline->buffer_samples = nodes[i].stage->config.buffer_size;
+        }
+    }
+
+    for (uint32_t i = 0; i < node_count; i++) {
+        pipeline_node_t* node = &pipeline->nodes[i];
+
+        pipeline->stages[i] = nodes[i].stage;
+        node->is_output = nodes[i].is_output;
+
+        for (uint32_t j = 0; j < PIPELINE_MAX_NODE_INPUTS && nodes[i].inputs[j]; j++) {
+            int8_t ref = resolve_input(nodes, node_count, nodes[i].inputs[j]);
+            if (ref == NODE_INVALID || ref == (int8_t)i) {
+                LOG_ERR("Stage %s: unknown input %s", nodes[i].stage->name, nodes[i].inputs[j]);
+                pipeline_pool_release(pipeline);
+                return NULL;
+            }
+            node->inputs[node->input_count++] = ref;
+        }
+
+        if (node->input_count == 0) {
+            LOG_ERR("Stage %s has no inputs", nodes[i].stage->name);
+            pipeline_pool_release(pipeline);
+            return NULL;
+        }
+    }
+    pipeline->stage_count = node_count;
+
+    // Sinks nobody reads would be computed for nothing: keep them as outputs
+    if (!build_schedule(pipeline)) {
+        pipeline_pool_release(pipeline);
+        return NULL;
+    }
+    for (uint32_t i = 0; i < node_count; i++) {
+        if (pipeline->nodes[i].consumer_count == 0) {
+            pipeline->nodes[i].is_output = true;
+        }
+    }
+
+    if (!apply_topology(pipeline)) {
+        pipeline_pool_release(pipeline);
+        return NULL;
+    }
+
+    LOG_INF("Pipeline graph: %u nodes, %u buffers of %u x %u samples, %u pool bytes",
+            node_count, pipeline->buffer_count, pipeline->channel_count,
+            pipeline->buffer_samples, pipeline_pool_used(pipeline));
+    return pipeline;
+}
+
+uint32_t pipeline_channels_from_slots(uint8_t led_slots)
+{
+    uint32_t channels = 0;
+
+    for (; led_slots; led_slots &= (uint8_t)(led_slots - 1)) {
+        channels++;
+    }
+    return channels;
+}
+
+uint32_t pipeline_deinterleave_samples(const ppg_sample_t* samples, uint32_t count,
+                                       uint8_t led_slots, float* data, uint32_t stride)
+{
+    uint32_t rows = 0;
+
+    if (!samples || !data || count > stride) {
+        return 0;
+    }
+
+    for (uint32_t slot = 0; slot < PIPELINE_MAX_CHANNELS; slot++) {
+        if (!(led_slots & (1u << slot))) {
+            continue;
+        }
+        float* row = data + rows * stride;
+        for (uint32_t n = 0; n < count; n++) {
+            row[n] = (float)samples[n].channels[slot];
+        }
+        rows++;
+    }
+    return rows;
+}
+
+bool pipeline_add_stage(signal_pipeline_t* pipeline, pipeline_stage_t* stage)
+{
+    if (!pipeline || !stage || !stage->ops || !stage->ops->process || !stage->name) {
+        return false;
+    }
+    if (pipeline->stage_count >= PIPELINE_MAX_STAGES || find_stage(pipeline, stage->name) >= 0) {
+        return false;
+    }
+    if (stage->config.buffer_size > pipeline->buffer_samples) {
+        LOG_ERR("Stage %s needs %u-sample buffers, pipeline has %u",
+                stage->name, stage->config.buffer_size, pipeline->buffer_samples);
+        return false;
+    }
+    if (pipeline->channel_count > 1 && !stage->multichannel) {
+        LOG_ERR("Stage %s handles one channel row, pipeline has %u", stage->name, pipeline->channel_count);
+        return false;
+    }
+    if (stage_inputs(stage) != 1) {
+        LOG_ERR("Stage %s reads %u inputs, a chain stage has one", stage->name, stage_inputs(stage));
+        return false;
+    }
+
+    // Appends to the chain: fed by the most recently added stage
+    uint32_t index = pipeline->stage_count;
+    pipeline_node_t* node = &pipeline->nodes[index];
+
+    release_held_outputs(pipeline);
+
+    memset(node, 0, sizeof(pipeline_node_t));
+    node->buffer_slot = -1;
+    node->input_count = 1;
+    node->is_output = true;
+    if (index == 0) {
+        node->inputs[0] = PIPELINE_SOURCE(0);
+    } else {
+        node->inputs[0] = (int8_t)(index - 1);
+        pipeline->nodes[index - 1].is_output = false;
+    }
+
+    pipeline->stages[index] = stage;
+    pipeline->stage_count++;
+
+    if (!apply_topology(pipeline)) {
+        pipeline->stage_count--;
+        if (index > 0) {
+            pipeline->nodes[index - 1].is_output = true;
+        }
+        apply_topology(pipeline);
+        return false;
+    }
+    return true;
+}
+
+void pipeline_stage_set_name(pipeline_stage_t* stage, const char* fallback)
+{
+    const char* name = stage->config.algorithm_name[0] ? stage->config.algorithm_name : fallback;
+
+    strncpy(stage->name_buffer, name, sizeof(stage->name_buffer) - 1u);
+    stage->name_buffer[sizeof(stage->name_buffer) - 1u] = '\0';
+    stage->name = stage->name_buffer;
+}
+
+bool pipeline_remove_stage(signal_pipeline_t* pipeline, const char* stage_name)
+{
+    if (!pipeline || !stage_name) {
+        return false;
+    }
+
+    int index = find_stage(pipeline, stage_name);
+    if (index < 0) {
+        return false;
+    }
+
+    release_held_outputs(pipeline);
+
+    // Consumers of the removed node are re-wired to its first input
+    int8_t bypass = pipeline->nodes[index].inputs[0];
+    bool was_output = pipeline->nodes[index].is_output;
+
+    for (uint32_t i = 0; i < pipeline->stage_count; i++) {
+        pipeline_node_t* node = &pipeline->nodes[i];
+        for (uint32_t j = 0; j < node->input_count; j++) {
+            if (node->inputs[j] == index) {
+                node->inputs[j] = bypass;
+            }
+        }
+    }
+
+    for (uint32_t i = (uint32_t)index; i + 1 < pipeline->stage_count; i++) {
+        pipeline->stages[i] = pipeline->stages[i + 1];
+        pipeline->nodes[i] = pipeline->nodes[i + 1];
+    }
+    pipeline->stage_count--;
+
+    for (uint32_t i = 0; i < pipeline->stage_count; i++) {
+        pipeline_node_t* node = &pipeline->nodes[i];
+        for (uint32_t j = 0; j < node->input_count; j++) {
+            if (!PIPELINE_IS_SOURCE(node->inputs[j]) && node->inputs[j] > index) {
+                node->inputs[j]--;
+            }
+        }
+    }
+
+    // Removing the tail of a chain makes its predecessor the output again
+    if (was_output && !PIPELINE_IS_SOURCE(bypass)) {
+        pipeline->nodes[bypass > index ? bypass - 1 : bypass].is_output = true;
+    }
+
+    return apply_topology(pipeline);
+}
+
+bool pipeline_process(signal_pipeline_t* pipeline, const signal_buffer_t* input)
+{
+    return pipeline_process_sources(pipeline, input, 1);
+}
+
+bool pipeline_process_sources(signal_pipeline_t* pipeline,
+                              const signal_buffer_t* sources,
+                              uint32_t source_count)
+{
+    signal_buffer_t blocks[PIPELINE_MAX_SOURCES];
+
+    if (!pipeline || !sources || source_count == 0 ||
+        source_count > PIPELINE_MAX_SOURCES || pipeline->stage_count == 0) {
+        return false;
+    }
+
+    uint32_t length = sources[0].length;
+    for (uint32_t s = 0; s < source_count; s++) {
+        uint32_t channels = SIGNAL_CHANNEL_COUNT(&sources[s]);
+        if (!sources[s].data || sources[s].length != length ||
+            channels > pipeline->channel_count ||
+            (channels > 1 && sources[s].stride < length)) {
+            pipeline->errors++;
+            return false;
+        }
+    }
+
+    // Longer inputs are split into pool-sized blocks
+    for (uint32_t offset = 0; offset < length; offset += pipeline->block_capacity) {
+        uint32_t chunk = length - offset;
+        if (chunk > pipeline->block_capacity) {
+            chunk = pipeline->block_capacity;
+        }
+
+        for (uint32_t s = 0; s < source_count; s++) {
+            blocks[s] = sources[s];
+            blocks[s].data = sources[s].data + offset;
+            blocks[s].length = chunk;
+            if (sources[s].sample_rate) {
+                blocks[s].timestamp_start = sources[s].timestamp_start +
+                                            (offset * 1000) / sources[s].sample_rate;
+            }
+        }
+
+        PIPELINE_PROFILE_BEGIN(start);
+        run_block(pipeline, blocks, source_count);
+        PIPELINE_PROFILE_END(start, &pipeline->block_profile, pipeline->total_latency_us);
+    }
+
+    return true;
+}
+
+bool pipeline_request_config(signal_pipeline_t* pipeline,
+                             const char* stage_name,
+                             const pipeline_stage_config_t* config)
+{
+    if (!pipeline || !stage_name || !config) {
+        return false;
+    }
+
+    int index = find_stage(pipeline, stage_name);
+    if (index < 0) {
+        return false;
+    }
+
+    pipeline_stage_t* stage = pipeline->stages[index];
+    PIPELINE_CRITICAL_ENTER();
+    stage->pending_config = *config;
+    stage->pending_sequence++;
+    PIPELINE_CRITICAL_EXIT();
+    return true;
+}
+
+bool pipeline_update_config(signal_pipeline_t* pipeline, const char* config_string)
+{
+    if (!pipeline || !config_string) {
+        return false;
+    }
+
+    if (!parse_config_string(pipeline, config_string, false)) {
+        LOG_ERR("Invalid pipeline configuration: %s", config_string);
+        return false;
+    }
+    return parse_config_string(pipeline, config_string, true);
+}
+
+const signal_buffer_t* pipeline_get_output(signal_pipeline_t* pipeline)
+{
+    if (!pipeline || pipeline->block_sequence == 0) {
+        return NULL;
+    }
+    return &pipeline->output_buffer;
+}
+
+const signal_buffer_t* pipeline_get_node_output(signal_pipeline_t* pipeline, const char* stage_name)
+{
+    if (!pipeline || !stage_name) {
+        return NULL;
+    }
+
+    int index = find_stage(pipeline, stage_name);
+    if (index < 0 || !pipeline->nodes[index].is_output) {
+        return NULL;
+    }
+    return pipeline->nodes[index].output;
+}
+
+bool pipeline_reset(signal_pipeline_t* pipeline)
+{
+    if (!pipeline) {
+        return false;
+    }
+
+    bool ok = true;
+    for (uint32_t i = 0; i < pipeline->stage_count; i++) {
+        pipeline_stage_t* stage = pipeline->stages[i];
+        if (stage->ops->reset && !stage->ops->reset(stage)) {
+            ok = false;
+        }
+    }
+
+    release_held_outputs(pipeline);
+    memset(pipeline->buffer_refs, 0, sizeof(pipeline->buffer_refs));
+    pipeline->samples_processed = 0;
+    pipeline->errors = 0;
+    pipeline->overall_quality = 0.0f;
+    pipeline->gate_open = false;
+    pipeline->gated_runs = 0;
+    pipeline->gated_skips = 0;
+
+    return ok;
+}
+
+uint32_t pipeline_checkpoint(signal_pipeline_t* pipeline, void* buffer, uint32_t capacity)
+{
+    if (!pipeline || !buffer || capacity < sizeof(checkpoint_header_t)) {
+        return 0;
+    }
+
+    uint8_t* base = (uint8_t*)buffer;
+    checkpoint_header_t header = {
+        .magic = CHECKPOINT_MAGIC,
+        .version = CHECKPOINT_VERSION,
+        .gate_open = pipeline->gate_open
+    };
+    uint32_t used = sizeof(header);
+
+    for (uint32_t i = 0; i < pipeline->stage_count; i++) {
+        pipeline_stage_t* stage = pipeline->stages[i];
+        checkpoint_record_t record;
+
+        if (!stage->ops->save_state || capacity - used < sizeof(record)) {
+            continue;
+        }
+
+        record.length = stage->ops->save_state(stage, base + used + sizeof(record),
+                                               capacity - used - sizeof(record));
+        if (record.length == 0) {
+            LOG_WRN("No room to checkpoint stage %s", stage->name);
+            continue;
+        }
+
+        record.name_hash = fnv1a(FNV_OFFSET, stage->name, (uint32_t)strlen(stage->name));
+        memcpy(base + used, &record, sizeof(record));
+        used += sizeof(record) + ((record.length + 3u) & ~3u);
+        if (used > capacity) {
+            return 0;
+        }
+        header.record_count++;
+    }
+
+    header.length = used;
+    memcpy(base, &header, sizeof(header));
+    header.checksum = checkpoint_checksum(base, used);
+    memcpy(base, &header, sizeof(header));
+    return used;
+}
+
+bool pipeline_restore(signal_pipeline_t* pipeline, const void* buffer, uint32_t length)
+{
+    checkpoint_header_t header;
+
+    if (!pipeline || !buffer || length < sizeof(header)) {
+        return false;
+    }
+
+    const uint8_t* base = (const uint8_t*)buffer;
+    memcpy(&header, base, sizeof(header));
+    if (header.magic != CHECKPOINT_MAGIC || header.version != CHECKPOINT_VERSION ||
+        header.length < sizeof(header) || header.length > length ||
+        header.checksum != checkpoint_checksum(base, header.length)) {
+        return false;
+    }
+
+    pipeline_reset(pipeline);
+
+    uint32_t pos = sizeof(header);
+    for (uint32_t r = 0; r < header.record_count; r++) {
+        checkpoint_record_t record;
+
+        if (pos > header.length || header.length - pos < sizeof(record)) {
+            break;
+        }
+        memcpy(&record, base + pos, sizeof(record));
+        pos += sizeof(record);
+        if (header.length - pos < record.length) {
+            break;
+        }
+
+        for (uint32_t i = 0; i < pipeline->stage_count; i++) {
+            pipeline_stage_t* stage = pipeline->stages[i];
+            if (!stage->ops->restore_state ||
+                fnv1a(FNV_OFFSET, stage->name, (uint32_t)strlen(stage->name)) != record.name_hash) {
+                continue;
+            }
+            if (!stage->ops->restore_state(stage, base + pos, record.length)) {
+                LOG_WRN("Stage %s starts cold", stage->name);
+                if (stage->ops->reset) {
+                    stage->ops->reset(stage);
+                }
+            }
+            break;
+        }
+        pos += (record.length + 3u) & ~3u;
+    }
+
+    pipeline->gate_open = header.gate_open != 0;
+    return true;
+}
+
+bool pipeline_get_metrics(signal_pipeline_t* pipeline,
+                         uint32_t* latency_us,
+                         float* quality,
+                         uint32_t* throughput)
+{
+    if (!pipeline) {
+        return false;
+    }
+
+    if (latency_us) {
+        *latency_us = pipeline->total_latency_us;
+    }
+    if (quality) {
+        *quality = pipeline->overall_quality;
+    }
+    if (throughput) {
+        *throughput = pipeline->samples_processed;
+    }
+    return true;
+}
+
+bool pipeline_set_quality_gate(signal_pipeline_t* pipeline, const char* stage_name, float threshold)
+{
+    if (!pipeline || threshold < 0.0f || threshold > 1.0f) {
+        return false;
+    }
+
+    pipeline->gate_stage = NULL;
+    pipeline->gated_mask = 0;
+    if (stage_name) {
+        int index = find_stage(pipeline, stage_name);
+        if (index < 0) {
+            return false;
+        }
+        pipeline->gate_stage = pipeline->stages[index];
+        plan_gating(pipeline);
+    }
+
+    // Closed until the gating stage has scored a block
+    pipeline->gate_threshold = threshold;
+    pipeline->gate_open = false;
+    pipeline->gated_runs = 0;
+    pipeline->gated_skips = 0;
+    return true;
+}
+
+bool pipeline_get_gate_stats(const signal_pipeline_t* pipeline, uint32_t* runs, uint32_t* skipped)
+{
+    if (!pipeline) {
+        return false;
+    }
+
+    if (runs) {
+        *runs = pipeline->gated_runs;
+    }
+    if (skipped) {
+        *skipped = pipeline->gated_skips;
+    }
+    return true;
+}
+
+bool pipeline_set_adaptive(signal_pipeline_t* pipeline, bool enable, float target_quality)
+{
+    if (!pipeline || target_quality < 0.0f || target_quality > 1.0f) {
+        return false;
+    }
+
+    pipeline->adaptive_tuning = enable;
+    pipeline->target_quality = target_quality;
+    return true;
+}
+
+void pipeline_destroy(signal_pipeline_t* pipeline)
+{
+    if (!pipeline) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < pipeline->stage_count; i++) {
+        pipeline_stage_t* stage = pipeline->stages[i];
+        if (stage->ops->cleanup) {
+            stage->ops->cleanup(stage);
+        }
+    }
+
+    pipeline_pool_release(pipeline);
+}
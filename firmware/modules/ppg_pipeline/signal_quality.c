@@ -0,0 +1,444 @@
+/*
+ * Signal Quality Index Implementation
+ *
+ * Moments, DC and motion energy are block sums folded into exponential
+ * averages; beat templates are cut from a short history ring at the peaks
+ * the embedded detector confirms. Per-sample cost is a few adds and the
+ * turning-point detector, far below the feature and algorithm nodes the
+ * score gates.
+ */
+
+#include "signal_quality.h"
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+
+#define SQI_HISTORY_MASK        (SQI_HISTORY_SAMPLES - 1)
+#define SQI_TEMPLATE_SPAN_S     0.5f   // Diastole and upstroke before the peak
+#define SQI_CORRELATION_ALPHA   0.25f  // Per-beat smoothing of template correlation
+#define SQI_SQRT8               2.8284271f // Peak-to-peak of a sinusoid over its RMS
+
+/* ==== PRIVATE FUNCTIONS ==== */
+
+static bool config_is_valid(const sqi_config_t* config)
+{
+    return config->good_perfusion > config->min_perfusion &&
+           config->max_perfusion > config->good_perfusion &&
+           config->good_correlation > config->min_correlation &&
+           config->max_skewness > config->good_skewness &&
+           config->motion_ref_g2 > 0.0f &&
+           config->time_constant_s > 0.0f;
+}
+
+static float config_param(const pipeline_stage_config_t* config, uint32_t index, float fallback)
+{
+    if (config->parameter_count > index && config->parameters[index] > 0.0f) {
+        return config->parameters[index];
+    }
+    return fallback;
+}
+
+static void apply_config(sqi_state_t* sqi, const pipeline_stage_config_t* config)
+{
+    sqi_config_t cfg = SQI_DEFAULT_CONFIG;
+
+    cfg.min_perfusion = config_param(config, SQI_PARAM_MIN_PERFUSION, cfg.min_perfusion);
+    cfg.min_correlation = config_param(config, SQI_PARAM_MIN_CORRELATION, cfg.min_correlation);
+    cfg.max_skewness = config_param(config, SQI_PARAM_MAX_SKEWNESS, cfg.max_skewness);
+    cfg.motion_ref_g2 = config_param(config, SQI_PARAM_MOTION_REF, cfg.motion_ref_g2);
+    cfg.time_constant_s = config_param(config, SQI_PARAM_TIME_CONSTANT_S, cfg.time_constant_s);
+
+    // Keep the ramps ordered when only the lower bound is configured
+    if (cfg.good_perfusion <= cfg.min_perfusion) {
+        cfg.good_perfusion = 4.0f * cfg.min_perfusion;
+    }
+    if (cfg.good_skewness >= cfg.max_skewness) {
+        cfg.good_skewness = 0.5f * cfg.max_skewness;
+    }
+
+    sqi->config = cfg;
+}
+
+/** Clear features and templates, keep configuration and sample rate */
+static void reset_features(sqi_state_t* sqi)
+{
+    if (sqi->sample_rate) {
+        beat_detector_reset(&sqi->detector);
+    }
+    memset(sqi->history, 0, sizeof(sqi->history));
+    sqi->have_template = false;
+    sqi->last_beat_index = 0;
+    sqi->primed = false;
+    sqi->m1 = sqi->m2 = sqi->m3 = 0.0f;
+    sqi->dc = 0.0f;
+    sqi->correlation = 0.0f;
+    sqi->motion = 0.0f;
+    memset(&sqi->result, 0, sizeof(sqi->result));
+}
+
+static bool start_rate(sqi_state_t* sqi, uint32_t sample_rate)
+{
+    if (!beat_detector_init(&sqi->detector, NULL, sample_rate)) {
+        return false;
+    }
+
+    uint32_t span = (uint32_t)(SQI_TEMPLATE_SPAN_S * (float)sample_rate + 0.5f);
+    sqi->template_stride = (span + SQI_TEMPLATE_POINTS / 2) / SQI_TEMPLATE_POINTS;
+    if (sqi->template_stride == 0) {
+        sqi->template_stride = 1;
+    }
+
+    sqi->sample_rate = sample_rate;
+    reset_features(sqi);
+    return true;
+}
+
+static float ramp(float x, float zero, float one)
+{
+    float s = (x - zero) / (one - zero);
+    return s < 0.0f ? 0.0f : (s > 1.0f ? 1.0f : s);
+}
+
+static float pearson(const float* a, const float* b, uint32_t n)
+{
+    float ma = 0.0f, mb = 0.0f;
+    for (uint32_t i = 0; i < n; i++) {
+        ma += a[i];
+        mb += b[i];
+    }
+    ma /= (float)n;
+    mb /= (float)n;
+
+    float sab = 0.0f, saa = 0.0f, sbb = 0.0f;
+    for (uint32_t i = 0; i < n; i++) {
+        float da = a[i] - ma;
+        float db = b[i] - mb;
+        sab += da * db;
+        saa += da * da;
+        sbb += db * db;
+    }
+
+    if (saa <= 0.0f || sbb <= 0.0f) {
+        return 0.0f;
+    }
+    return sab / sqrtf(saa * sbb);
+}
+
+/** Correlate the template ending at each new peak with the previous beat's */
+static void score_beats(sqi_state_t* sqi, uint32_t count)
+{
+    uint32_t now = sqi->detector.sample_index;
+    uint32_t span = (SQI_TEMPLATE_POINTS - 1) * sqi->template_stride;
+    float current[SQI_TEMPLATE_POINTS];
+
+    for (uint32_t b = 0; b < count; b++) {
+        uint32_t peak = sqi->beats[b].sample_index;
+
+        sqi->last_beat_index = peak;
+        if (peak < span || now - (peak - span) > SQI_HISTORY_SAMPLES) {
+            sqi->have_template = false;
+            continue;
+        }
+
+        for (uint32_t k = 0; k < SQI_TEMPLATE_POINTS; k++) {
+            uint32_t index = peak - span + k * sqi->template_stride;
+            current[k] = sqi->history[index & SQI_HISTORY_MASK];
+        }
+
+        if (sqi->have_template) {
+            float r = pearson(current, sqi->template_prev, SQI_TEMPLATE_POINTS);
+            if (sqi->correlation <= 0.0f) {
+                sqi->correlation = r;
+            } else {
+                sqi->correlation += SQI_CORRELATION_ALPHA * (r - sqi->correlation);
+            }
+        }
+
+        memcpy(sqi->template_prev, current, sizeof(current));
+        sqi->have_template = true;
+    }
+
+    // No pulse for longer than any valid beat interval: nothing to correlate
+    uint32_t max_gap = (uint32_t)(sqi->detector.config.max_interval_ms * (float)sqi->sample_rate / 1000.0f);
+    if (now - sqi->last_beat_index > max_gap) {
+        sqi->have_template = false;
+        sqi->correlation = 0.0f;
+    }
+}
+
+static float block_motion(const signal_buffer_t* imu, uint32_t length)
+{
+    float sum = 0.0f, sum_sq = 0.0f;
+
+    for (uint32_t n = 0; n < length; n++) {
+        const float* a = &imu->data[3 * n];
+        float mag = sqrtf(a[0] * a[0] + a[1] * a[1] + a[2] * a[2]);
+        sum += mag;
+        sum_sq += mag * mag;
+    }
+
+    float mean = sum / (float)length;
+    float var = sum_sq / (float)length - mean * mean;
+    return var > 0.0f ? var : 0.0f;
+}
+
+static void update_features(sqi_state_t* sqi, const signal_buffer_t* filtered, const signal_buffer_t* raw)
+{
+    uint32_t length = filtered->length;
+    float s1 = 0.0f, s2 = 0.0f, s3 = 0.0f, dc = 0.0f;
+
+    for (uint32_t n = 0; n < length; n++) {
+        float x = filtered->data[n];
+        float x2 = x * x;
+        s1 += x;
+        s2 += x2;
+        s3 += x2 * x;
+        dc += raw->data[n];
+    }
+
+    float inv = 1.0f / (float)length;
+    float motion = 0.0f;
+    if (sqi->imu_buffer && sqi->imu_buffer->data && sqi->imu_buffer->length >= 3 * length) {
+        motion = block_motion(sqi->imu_buffer, length);
+    }
+
+    if (!sqi->primed) {
+        sqi->m1 = s1 * inv;
+        sqi->m2 = s2 * inv;
+        sqi->m3 = s3 * inv;
+        sqi->dc = dc * inv;
+        sqi->motion = motion;
+        sqi->primed = true;
+        return;
+    }
+
+    float alpha = (float)length / (sqi->config.time_constant_s * (float)sqi->sample_rate);
+    if (alpha > 1.0f) {
+        alpha = 1.0f;
+    }
+    sqi->m1 += alpha * (s1 * inv - sqi->m1);
+    sqi->m2 += alpha * (s2 * inv - sqi->m2);
+    sqi->m3 += alpha * (s3 * inv - sqi->m3);
+    sqi->dc += alpha * (dc * inv - sqi->dc);
+    sqi->motion += alpha * (motion - sqi->motion);
+}
+
+static void update_result(sqi_state_t* sqi)
+{
+    const sqi_config_t* cfg = &sqi->config;
+    sqi_result_t* r = &sqi->result;
+
+    float var = sqi->m2 - sqi->m1 * sqi->m1;
+    float sd = var > 0.0f ? sqrtf(var) : 0.0f;
+
+    r->perfusion_index = sqi->dc > 0.0f ? SQI_SQRT8 * sd / sqi->dc : 0.0f;
+    r->skewness = sd > 0.0f ?
+        (sqi->m3 - 3.0f * sqi->m1 * var - sqi->m1 * sqi->m1 * sqi->m1) / (var * sd) : 0.0f;
+    r->template_correlation = sqi->correlation;
+    r->motion_energy = sqi->motion;
+
+    r->scores[0] = r->perfusion_index > cfg->max_perfusion ? 0.0f :
+                   ramp(r->perfusion_index, cfg->min_perfusion, cfg->good_perfusion);
+    r->scores[1] = ramp(r->template_correlation, cfg->min_correlation, cfg->good_correlation);
+    r->scores[2] = ramp(fabsf(r->skewness), cfg->max_skewness, cfg->good_skewness);
+    r->scores[3] = cfg->motion_ref_g2 / (cfg->motion_ref_g2 + r->motion_energy);
+
+    r->quality = r->scores[0] * r->scores[1] * r->scores[2] * r->scores[3];
+}
+
+/* ==== PIPELINE STAGE BINDING ==== */
+
+static bool stage_init(pipeline_stage_t* stage, const pipeline_stage_config_t* config)
+{
+    sqi_state_t* sqi = (sqi_state_t*)stage->context;
+
+    if (!config) {
+        return false;
+    }
+
+    memset(sqi, 0, sizeof(sqi_state_t));
+    stage->config = *config;
+    apply_config(sqi, config);
+    return config_is_valid(&sqi->config);
+}
+
+static bool stage_process(pipeline_stage_t* stage, const signal_buffer_t* input, signal_buffer_t* output)
+{
+    sqi_state_t* sqi = (sqi_state_t*)stage->context;
+    const signal_buffer_t* filtered = &input[0];
+    const signal_buffer_t* raw = &input[1];
+
+    if (!filtered->data || !raw->data || filtered->length != raw->length ||
+        filtered->length == 0 || filtered->sample_rate == 0) {
+        return false;
+    }
+
+    if (sqi->sample_rate != filtered->sample_rate && !start_rate(sqi, filtered->sample_rate)) {
+        return false;
+    }
+
+    uint32_t base = sqi->detector.sample_index;
+    for (uint32_t n = 0; n < filtered->length; n++) {
+        sqi->history[(base + n) & SQI_HISTORY_MASK] = filtered->data[n];
+    }
+
+    uint32_t count = beat_detector_process(&sqi->detector, filtered->data, filtered->length,
+                                           sqi->beats, SQI_MAX_BEATS_PER_BLOCK);
+    score_beats(sqi, count);
+    update_features(sqi, filtered, raw);
+    update_result(sqi);
+
+    for (uint32_t r = 0; r < SIGNAL_CHANNEL_COUNT(filtered); r++) {
+        memcpy(SIGNAL_CHANNEL(output, r), SIGNAL_CHANNEL(filtered, r), filtered->length * sizeof(float));
+    }
+    output->length = filtered->length;
+    output->channels = filtered->channels;
+    output->sample_rate = filtered->sample_rate;
+    output->timestamp_start = filtered->timestamp_start;
+    output->quality_score = sqi->result.quality;
+    output->metadata = &sqi->result;
+    return true;
+}
+
+static bool stage_reset(pipeline_stage_t* stage)
+{
+    reset_features((sqi_state_t*)stage->context);
+    return true;
+}
+
+static bool stage_update_config(pipeline_stage_t* stage, const pipeline_stage_config_t* config)
+{
+    sqi_state_t* sqi = (sqi_state_t*)stage->context;
+    sqi_config_t previous = sqi->config;
+
+    if (!config) {
+        return false;
+    }
+
+    apply_config(sqi, config);
+    if (!config_is_valid(&sqi->config)) {
+        sqi->config = previous;
+        return false;
+    }
+
+    stage->config = *config;
+    return true;
+}
+
+static bool stage_get_status(pipeline_stage_t* stage, float* quality, uint32_t* latency_us)
+{
+    const sqi_state_t* sqi = (const sqi_state_t*)stage->context;
+
+    if (quality) {
+        *quality = sqi->result.quality;
+    }
+    if (latency_us) {
+        *latency_us = stage->processing_time_us;
+    }
+    return true;
+}
+
+/** Smoothed features; detector snapshot last so unused intervals can be cut */
+typedef struct {
+    uint32_t sample_rate;
+    float m1, m2, m3;
+    float dc;
+    float correlation;
+    float motion;
+    beat_detector_snapshot_t detector;
+} sqi_checkpoint_t;
+
+static uint32_t stage_save_state(pipeline_stage_t* stage, void* buffer, uint32_t capacity)
+{
+    const sqi_state_t* sqi = (const sqi_state_t*)stage->context;
+    sqi_checkpoint_t cp = {
+        .sample_rate = sqi->primed ? sqi->sample_rate : 0,
+        .m1 = sqi->m1, .m2 = sqi->m2, .m3 = sqi->m3,
+        .dc = sqi->dc,
+        .correlation = sqi->correlation,
+        .motion = sqi->motion
+    };
+
+    uint32_t length = offsetof(sqi_checkpoint_t, detector) +
+                      beat_detector_snapshot(&sqi->detector, &cp.detector);
+    if (capacity < length) {
+        return 0;
+    }
+    memcpy(buffer, &cp, length);
+    return length;
+}
+
+static bool stage_restore_state(pipeline_stage_t* stage, const void* buffer, uint32_t length)
+{
+    sqi_state_t* sqi = (sqi_state_t*)stage->context;
+    const uint32_t fixed = offsetof(sqi_checkpoint_t, detector.intervals);
+    sqi_checkpoint_t cp;
+
+    if (length < fixed || length > sizeof(cp)) {
+        return false;
+    }
+    memcpy(&cp, buffer, length);
+    if (cp.sample_rate == 0) {
+        return true;
+    }
+    if (cp.detector.interval_count > BEAT_DETECTOR_MAX_WINDOW ||
+        length != fixed + cp.detector.interval_count * sizeof(float) ||
+        !start_rate(sqi, cp.sample_rate) ||
+        !beat_detector_resume(&sqi->detector, &cp.detector)) {
+        return false;
+    }
+
+    // Templates need history from this side of the gap; the smoothed features do not
+    sqi->m1 = cp.m1;
+    sqi->m2 = cp.m2;
+    sqi->m3 = cp.m3;
+    sqi->dc = cp.dc;
+    sqi->correlation = cp.correlation;
+    sqi->motion = cp.motion;
+    sqi->primed = true;
+    update_result(sqi);
+    return true;
+}
+
+static void stage_cleanup(pipeline_stage_t* stage)
+{
+    reset_features((sqi_state_t*)stage->context);
+}
+
+pipeline_stage_ops_t sqi_stage_ops = {
+    .init = stage_init,
+    .process = stage_process,
+    .reset = stage_reset,
+    .update_config = stage_update_config,
+    .get_status = stage_get_status,
+    .cleanup = stage_cleanup,
+    .save_state = stage_save_state,
+    .restore_state = stage_restore_state,
+};
+
+bool sqi_stage_bind(pipeline_stage_t* stage,
+                    sqi_state_t* state,
+                    const pipeline_stage_config_t* config)
+{
+    if (!stage || !state || !config) {
+        return false;
+    }
+
+    memset(stage, 0, sizeof(pipeline_stage_t));
+    stage->type = PIPELINE_STAGE_POSTPROCESS;
+    stage->ops = &sqi_stage_ops;
+    stage->multichannel = true;
+    stage->input_count = 2;
+    stage->context = state;
+
+    if (!stage_init(stage, config)) {
+        return false;
+    }
+    pipeline_stage_set_name(stage, "sqi");
+    return true;
+}
+
+const sqi_result_t* sqi_get_result(const sqi_state_t* state)
+{
+    return state ? &state->result : NULL;
+}
@@ -0,0 +1,148 @@
+#ifndef SIGNAL_QUALITY_H
+#define SIGNAL_QUALITY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "interfaces/signal_pipeline_interfaces.h"
+#include "beat_detector.h"
+
+/**
+ * @file signal_quality.h
+ * @brief Per-block PPG signal quality index (SQI)
+ *
+ * Four cheap features are scored 0-1 and multiplied: perfusion index
+ * (pulse AC over DC), correlation of consecutive beat templates, skewness
+ * of the band-passed pulse and accelerometer motion energy. Features are
+ * smoothed over a few seconds so the score does not flap between blocks.
+ *
+ * The stage passes the filtered signal through with quality_score set,
+ * so it sits between the filter and the feature nodes; with
+ * pipeline_set_quality_gate() the pipeline skips feature and algorithm
+ * nodes downstream of it while the score is below a threshold.
+ */
+
+// =============================================================================
+// Limits
+// =============================================================================
+
+#define SQI_HISTORY_SAMPLES          256   ///< Filtered history for beat templates (power of 2)
+#define SQI_TEMPLATE_POINTS          24    ///< Points per beat template
+#define SQI_MAX_BEATS_PER_BLOCK      8     ///< Beats scored per block
+
+/**
+ * @brief Index of SQI parameters in pipeline_stage_config_t.parameters
+ */
+typedef enum {
+    SQI_PARAM_MIN_PERFUSION = 0,          ///< Perfusion index scoring 0
+    SQI_PARAM_MIN_CORRELATION,            ///< Template correlation scoring 0
+    SQI_PARAM_MAX_SKEWNESS,               ///< |skewness| scoring 0
+    SQI_PARAM_MOTION_REF,                 ///< Motion energy (g^2) halving the score
+    SQI_PARAM_TIME_CONSTANT_S,            ///< Feature smoothing
+    SQI_PARAM_COUNT
+} sqi_param_t;
+
+// =============================================================================
+// Data Structures
+// =============================================================================
+
+/**
+ * @brief SQI configuration
+ *
+ * Each feature ramps linearly from 0 at its "min"/"max" bound to 1 at its
+ * "good" bound; motion scores ref / (ref + energy).
+ */
+typedef struct {
+    float min_perfusion;              ///< AC/DC at or below scores 0
+    float good_perfusion;             ///< AC/DC at or above scores 1
+    float max_perfusion;              ///< AC/DC above is saturation or motion (scores 0)
+    float min_correlation;            ///< Template correlation at or below scores 0
+    float good_correlation;           ///< Template correlation at or above scores 1
+    float good_skewness;              ///< |skewness| at or below scores 1
+    float max_skewness;               ///< |skewness| at or above scores 0
+    float motion_ref_g2;              ///< Accel magnitude variance giving 0.5
+    float time_constant_s;            ///< Feature smoothing time constant
+} sqi_config_t;
+
+/**
+ * @brief Published quality assessment
+ */
+typedef struct {
+    float quality;                    ///< Combined score (0-1)
+    float perfusion_index;            ///< Pulse AC / DC
+    float template_correlation;       ///< Smoothed consecutive-beat correlation
+    float skewness;                   ///< Skewness of the band-passed signal
+    float motion_energy;              ///< Accel magnitude variance (g^2)
+    float scores[4];                  ///< Perfusion, correlation, skewness, motion scores
+} sqi_result_t;
+
+/**
+ * @brief SQI state (owned by caller, bound via context)
+ */
+typedef struct {
+    sqi_config_t config;
+    uint32_t sample_rate;             ///< Rate the detector and templates run at
+    beat_detector_t detector;         ///< Beat alignment for templates
+    ppg_beat_t beats[SQI_MAX_BEATS_PER_BLOCK];
+
+    float history[SQI_HISTORY_SAMPLES]; ///< Filtered samples by detector index
+    uint32_t template_stride;         ///< Samples between template points
+    float template_prev[SQI_TEMPLATE_POINTS]; ///< Previous beat template
+    bool have_template;
+    uint32_t last_beat_index;         ///< Detector index of the last beat
+
+    // Smoothed features
+    bool primed;                      ///< Moments seeded from the first block
+    float m1, m2, m3;                 ///< Raw moments of the filtered signal
+    float dc;                         ///< Mean of the unfiltered signal
+    float correlation;                ///< Per-beat smoothed correlation
+    float motion;                     ///< Smoothed accel magnitude variance
+
+    const signal_buffer_t* imu_buffer; ///< Accel x/y/z interleaved in g, 3 * length
+                                      ///< samples aligned to the PPG block (NULL: no motion term)
+    sqi_result_t result;
+} sqi_state_t;
+
+// Adult wrist/finger PPG: 0.05% perfusion is the usual floor, beats that
+// correlate below 0.5 are not the same waveform, 0.1 g RMS is walking.
+static const sqi_config_t SQI_DEFAULT_CONFIG = {
+    .min_perfusion = 0.0005f,
+    .good_perfusion = 0.002f,
+    .max_perfusion = 0.2f,
+    .min_correlation = 0.5f,
+    .good_correlation = 0.9f,
+    .good_skewness = 1.0f,
+    .max_skewness = 2.0f,
+    .motion_ref_g2 = 0.01f,
+    .time_constant_s = 2.0f
+};
+
+// =============================================================================
+// Pipeline Stage Binding
+// =============================================================================
+
+/**
+ * @brief Stage operations for an SQI node
+ *
+ * Node inputs: [0] band-passed PPG, [1] preprocessed PPG (DC intact). The
+ * output is input [0] with quality_score set; its metadata points to the
+ * sqi_result_t. Row 0 is scored, every row is carried through.
+ */
+extern pipeline_stage_ops_t sqi_stage_ops;
+
+/**
+ * @brief Bind SQI state to a stage
+ *
+ * Settings come from config->parameters (sqi_param_t); unset entries keep
+ * SQI_DEFAULT_CONFIG. Set state->imu_buffer before each block to include
+ * motion energy.
+ */
+bool sqi_stage_bind(pipeline_stage_t* stage,
+                    sqi_state_t* state,
+                    const pipeline_stage_config_t* config);
+
+/**
+ * @brief Get the last quality assessment
+ */
+const sqi_result_t* sqi_get_result(const sqi_state_t* state);
+
+#endif // SIGNAL_QUALITY_H
@@ -0,0 +1,394 @@
+/*
+ * SpO2 Estimator Implementation
+ *
+ * Ratio-of-ratios on beat-aligned running min/max/mean of Red and IR.
+ * Constant work per sample; per-beat scoring touches only the small
+ * averaging ring.
+ */
+
+#include "spo2_estimator.h"
+#include "beat_detector.h"
+#include <string.h>
+#include <math.h>
+
+#define SPO2_MIN_WINDOW_SAMPLES  3
+#define SPO2_MAX_BEATS_PER_BLOCK 8
+#define SPO2_MIN_RATIO           0.2f
+#define SPO2_MAX_RATIO           3.0f
+#define SPO2_FLOOR_PERCENT       50.0f
+#define SPO2_CEILING_PERCENT     100.0f
+
+/* ==== PRIVATE FUNCTIONS ==== */
+
+static bool config_is_valid(const spo2_config_t* config)
+{
+    return config->average_beats > 0 &&
+           config->average_beats <= SPO2_MAX_AVERAGE_BEATS &&
+           config->min_quality >= 0.0f && config->min_quality <= 1.0f &&
+           config->max_perfusion > config->min_perfusion;
+}
+
+static void window_start(spo2_window_t* w, float x)
+{
+    w->min = x;
+    w->max = x;
+    w->min_index = 0;
+    w->max_index = 0;
+    w->sum = x;
+    w->first = x;
+    w->last = x;
+    w->count = 1;
+}
+
+static inline void window_add(spo2_window_t* w, float x)
+{
+    if (x < w->min) {
+        w->min = x;
+        w->min_index = w->count;
+    }
+    if (x > w->max) {
+        w->max = x;
+        w->max_index = w->count;
+    }
+    w->sum += x;
+    w->last = x;
+    w->count++;
+}
+
+/**
+ * Pulse amplitude with the baseline drift between the two beat boundaries
+ * (respiration, slow motion) removed as a straight line.
+ */
+static float window_ac(const spo2_window_t* w)
+{
+    float slope = (w->last - w->first) / (float)(w->count - 1);
+    return (w->max - w->min) - slope * ((float)w->max_index - (float)w->min_index);
+}
+
+/** Quality drops as the boundary-to-boundary drift approaches the pulse amplitude */
+static float window_quality(const spo2_window_t* w, float ac)
+{
+    float q = 1.0f - 0.5f * fabsf(w->last - w->first) / ac;
+    return q < 0.0f ? 0.0f : q;
+}
+
+static float apply_calibration(const float* c, float r)
+{
+    float spo2 = c[0] + r * (c[1] + r * (c[2] + r * c[3]));
+
+    if (spo2 > SPO2_CEILING_PERCENT) {
+        spo2 = SPO2_CEILING_PERCENT;
+    } else if (spo2 < SPO2_FLOOR_PERCENT) {
+        spo2 = SPO2_FLOOR_PERCENT;
+    }
+    return spo2;
+}
+
+static void update_average(spo2_estimator_t* est)
+{
+    float weighted = 0.0f;
+    float weights = 0.0f;
+
+    for (uint32_t i = 0; i < est->beat_count; i++) {
+        weighted += est->beat_quality[i] * est->beat_spo2[i];
+        weights += est->beat_quality[i];
+    }
+
+    if (weights > 0.0f) {
+        est->result.spo2 = weighted / weights;
+        est->result.quality = weights / (float)est->beat_count;
+        est->result.beats = est->beat_count;
+        est->result.valid = true;
+    }
+}
+
+/** Score the beat that just closed; true if it entered the average */
+static bool close_beat(spo2_estimator_t* est)
+{
+    const spo2_window_t* red = &est->red;
+    const spo2_window_t* ir = &est->ir;
+
+    if (red->count < SPO2_MIN_WINDOW_SAMPLES) {
+        return false;
+    }
+
+    float ac_red = window_ac(red);
+    float ac_ir = window_ac(ir);
+    float dc_red = red->sum / (float)red->count;
+    float dc_ir = ir->sum / (float)ir->count;
+
+    if (ac_red <= 0.0f || ac_ir <= 0.0f || dc_red <= 0.0f || dc_ir <= 0.0f) {
+        est->beats_rejected++;
+        return false;
+    }
+
+    float perfusion_ir = ac_ir / dc_ir;
+    float ratio = (ac_red / dc_red) / perfusion_ir;
+    float quality = fminf(window_quality(red, ac_red), window_quality(ir, ac_ir));
+
+    if (perfusion_ir < est->config.min_perfusion || perfusion_ir > est->config.max_perfusion ||
+        ratio < SPO2_MIN_RATIO || ratio > SPO2_MAX_RATIO ||
+        quality < est->config.min_quality) {
+        est->beats_rejected++;
+        return false;
+    }
+
+    uint32_t window = est->config.average_beats;
+    est->beat_spo2[est->beat_pos] = apply_calibration(est->config.calibration, ratio);
+    est->beat_quality[est->beat_pos] = quality;
+    est->beat_pos = (est->beat_pos + 1) % window;
+    if (est->beat_count < window) {
+        est->beat_count++;
+    }
+
+    est->result.ratio = ratio;
+    est->beats_accepted++;
+    update_average(est);
+    return true;
+}
+
+/* ==== PUBLIC FUNCTIONS ==== */
+
+bool spo2_estimator_init(spo2_estimator_t* est, const spo2_config_t* config)
+{
+    if (!est) {
+        return false;
+    }
+
+    const spo2_config_t* cfg = config ? config : &SPO2_DEFAULT_CONFIG;
+    if (!config_is_valid(cfg)) {
+        return false;
+    }
+
+    memset(est, 0, sizeof(spo2_estimator_t));
+    est->config = *cfg;
+    return true;
+}
+
+void spo2_estimator_reset(spo2_estimator_t* est)
+{
+    if (!est) {
+        return;
+    }
+
+    spo2_config_t config = est->config;
+    spo2_estimator_init(est, &config);
+}
+
+bool spo2_estimator_set_calibration(spo2_estimator_t* est, const float calibration[4])
+{
+    if (!est || !calibration) {
+        return false;
+    }
+
+    memcpy(est->config.calibration, calibration, sizeof(est->config.calibration));
+    return true;
+}
+
+uint32_t spo2_estimator_process(spo2_estimator_t* est,
+                                const float* red,
+                                const float* ir,
+                                uint32_t length,
+                                const uint32_t* beat_offsets,
+                                uint32_t beat_count)
+{
+    uint32_t accepted = 0;
+    uint32_t next_beat = 0;
+
+    if (!est || !red || !ir) {
+        return 0;
+    }
+
+    for (uint32_t n = 0; n < length; n++) {
+        if (est->window_open) {
+            window_add(&est->red, red[n]);
+            window_add(&est->ir, ir[n]);
+        }
+
+        // Beat boundary: the sample closes one window and opens the next
+        if (next_beat < beat_count && beat_offsets[next_beat] == n) {
+            if (est->window_open && close_beat(est)) {
+                accepted++;
+            }
+            window_start(&est->red, red[n]);
+            window_start(&est->ir, ir[n]);
+            est->window_open = true;
+
+            while (next_beat < beat_count && beat_offsets[next_beat] <= n) {
+                next_beat++;
+            }
+        }
+    }
+
+    return accepted;
+}
+
+const spo2_result_t* spo2_estimator_get_result(const spo2_estimator_t* est)
+{
+    return est ? &est->result : NULL;
+}
+
+/* ==== PIPELINE STAGE BINDING ==== */
+
+static void stage_apply_config(spo2_estimator_t* est, const pipeline_stage_config_t* config)
+{
+    spo2_config_t cfg = SPO2_DEFAULT_CONFIG;
+
+    // A calibration loaded with spo2_estimator_set_calibration() survives reconfiguration
+    memcpy(cfg.calibration, est->config.calibration, sizeof(cfg.calibration));
+
+    if (config->parameter_count > SPO2_PARAM_AVERAGE_BEATS &&
+        config->parameters[SPO2_PARAM_AVERAGE_BEATS] > 0.0f) {
+        cfg.average_beats = (uint32_t)config->parameters[SPO2_PARAM_AVERAGE_BEATS];
+    }
+    if (config->parameter_count > SPO2_PARAM_MIN_QUALITY) {
+        cfg.min_quality = config->parameters[SPO2_PARAM_MIN_QUALITY];
+    }
+    if (config->parameter_count > SPO2_PARAM_CAL_D && config->parameters[SPO2_PARAM_CAL_A] > 0.0f) {
+        for (int i = 0; i < 4; i++) {
+            cfg.calibration[i] = config->parameters[SPO2_PARAM_CAL_A + i];
+        }
+    }
+
+    est->config = cfg;
+}
+
+static uint32_t stage_row(const pipeline_stage_config_t* config, spo2_param_t param)
+{
+    return config->parameter_count > (uint32_t)param ? (uint32_t)config->parameters[param] : 0u;
+}
+
+static bool rows_are_valid(const pipeline_stage_config_t* config)
+{
+    return stage_row(config, SPO2_PARAM_RED_ROW) < PIPELINE_MAX_CHANNELS &&
+           stage_row(config, SPO2_PARAM_IR_ROW) < PIPELINE_MAX_CHANNELS;
+}
+
+static bool stage_init(pipeline_stage_t* stage, const pipeline_stage_config_t* config)
+{
+    spo2_estimator_t* est = (spo2_estimator_t*)stage->context;
+
+    if (!config || !rows_are_valid(config) || !spo2_estimator_init(est, NULL)) {
+        return false;
+    }
+
+    stage->config = *config;
+    stage_apply_config(est, config);
+    return config_is_valid(&est->config);
+}
+
+static bool stage_process(pipeline_stage_t* stage, const signal_buffer_t* input, signal_buffer_t* output)
+{
+    spo2_estimator_t* est = (spo2_estimator_t*)stage->context;
+    const ppg_beat_block_t* beats = (const ppg_beat_block_t*)input[0].metadata;
+    const signal_buffer_t* red = &input[1];
+    const signal_buffer_t* ir = &input[2];
+    uint32_t red_row = stage_row(&stage->config, SPO2_PARAM_RED_ROW);
+    uint32_t ir_row = stage_row(&stage->config, SPO2_PARAM_IR_ROW);
+    uint32_t offsets[SPO2_MAX_BEATS_PER_BLOCK];
+    uint32_t count = 0;
+
+    if (!beats || !red->data || !ir->data || red->length != ir->length ||
+        red_row >= SIGNAL_CHANNEL_COUNT(red) || ir_row >= SIGNAL_CHANNEL_COUNT(ir)) {
+        return false;
+    }
+
+    // Beats are confirmed a little after the peak; late ones close at the block start
+    for (uint32_t i = 0; i < beats->count && count < SPO2_MAX_BEATS_PER_BLOCK; i++) {
+        uint32_t index = beats->beats[i].sample_index;
+        uint32_t offset = index > beats->block_start_index ? index - beats->block_start_index : 0;
+        if (offset < red->length && (count == 0 || offset > offsets[count - 1])) {
+            offsets[count++] = offset;
+        }
+    }
+
+    spo2_estimator_process(est, SIGNAL_CHANNEL(red, red_row), SIGNAL_CHANNEL(ir, ir_row), red->length,
+                           offsets, count);
+
+    output->length = 0;
+    output->sample_rate = ir->sample_rate;
+    output->timestamp_start = ir->timestamp_start;
+    output->quality_score = est->result.quality;
+    output->metadata = &est->result;
+    return true;
+}
+
+static bool stage_reset(pipeline_stage_t* stage)
+{
+    spo2_estimator_reset((spo2_estimator_t*)stage->context);
+    return true;
+}
+
+static bool stage_update_config(pipeline_stage_t* stage, const pipeline_stage_config_t* config)
+{
+    spo2_estimator_t* est = (spo2_estimator_t*)stage->context;
+    spo2_config_t previous = est->config;
+
+    if (!config || !rows_are_valid(config)) {
+        return false;
+    }
+
+    stage_apply_config(est, config);
+    if (!config_is_valid(&est->config)) {
+        est->config = previous;
+        return false;
+    }
+
+    // A shorter average would index past the ring; restart it
+    if (est->config.average_beats != previous.average_beats) {
+        est->beat_pos = 0;
+        est->beat_count = 0;
+    }
+
+    stage->config = *config;
+    return true;
+}
+
+static bool stage_get_status(pipeline_stage_t* stage, float* quality, uint32_t* latency_us)
+{
+    const spo2_estimator_t* est = (const spo2_estimator_t*)stage->context;
+
+    if (quality) {
+        *quality = est->result.valid ? est->result.quality : 0.0f;
+    }
+    if (latency_us) {
+        *latency_us = stage->processing_time_us;
+    }
+    return true;
+}
+
+static void stage_cleanup(pipeline_stage_t* stage)
+{
+    spo2_estimator_reset((spo2_estimator_t*)stage->context);
+}
+
+pipeline_stage_ops_t spo2_stage_ops = {
+    .init = stage_init,
+    .process = stage_process,
+    .reset = stage_reset,
+    .update_config = stage_update_config,
+    .get_status = stage_get_status,
+    .cleanup = stage_cleanup,
+};
+
+bool spo2_stage_bind(pipeline_stage_t* stage,
+                     spo2_estimator_t* est,
+                     const pipeline_stage_config_t* config)
+{
+    if (!stage || !est || !config) {
+        return false;
+    }
+
+    memset(stage, 0, sizeof(pipeline_stage_t));
+    stage->type = PIPELINE_STAGE_ALGORITHM;
+    stage->ops = &spo2_stage_ops;
+    stage->multichannel = true;
+    stage->input_count = 3;
+    stage->context = est;
+
+    if (!stage_init(stage, config)) {
+        return false;
+    }
+    pipeline_stage_set_name(stage, "spo2");
+    return true;
+}
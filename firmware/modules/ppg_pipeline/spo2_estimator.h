@@ -0,0 +1,178 @@
+#ifndef SPO2_ESTIMATOR_H
+#define SPO2_ESTIMATOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "interfaces/signal_pipeline_interfaces.h"
+
+/**
+ * @file spo2_estimator.h
+ * @brief Streaming per-beat SpO2 (ratio of ratios)
+ *
+ * Red and IR are tracked with running min/max/mean over beat-to-beat
+ * windows, so each sample costs a few compares and adds and the result
+ * does not depend on a high sample rate: one AC/DC pair per heartbeat is
+ * enough, which 25 Hz delivers. Each beat's R is mapped through the
+ * sensor calibration polynomial and the reported value is a
+ * quality-weighted average over recent beats.
+ */
+
+// =============================================================================
+// Limits
+// =============================================================================
+
+#define SPO2_MAX_AVERAGE_BEATS       16    ///< Maximum beats in the average
+
+/**
+ * @brief Index of SpO2 parameters in pipeline_stage_config_t.parameters
+ */
+typedef enum {
+    SPO2_PARAM_AVERAGE_BEATS = 0,         ///< Beats in the weighted average
+    SPO2_PARAM_MIN_QUALITY,               ///< Per-beat quality gate
+    SPO2_PARAM_CAL_A,                     ///< Calibration constant term
+    SPO2_PARAM_CAL_B,                     ///< Calibration R term
+    SPO2_PARAM_CAL_C,                     ///< Calibration R^2 term
+    SPO2_PARAM_CAL_D,                     ///< Calibration R^3 term
+    SPO2_PARAM_RED_ROW,                   ///< Channel row of input [1] taken as Red
+    SPO2_PARAM_IR_ROW,                    ///< Channel row of input [2] taken as IR
+    SPO2_PARAM_COUNT
+} spo2_param_t;
+
+// =============================================================================
+// Data Structures
+// =============================================================================
+
+/**
+ * @brief Estimator configuration
+ */
+typedef struct {
+    float calibration[4];             ///< SpO2 = a + b*R + c*R^2 + d*R^3 (sensor_config_t.spo2_calibration)
+    uint32_t average_beats;           ///< Beats in the weighted average (1..SPO2_MAX_AVERAGE_BEATS)
+    float min_quality;                ///< Beats scoring below this are dropped
+    float min_perfusion;              ///< Minimum IR AC/DC
+    float max_perfusion;              ///< Maximum IR AC/DC
+} spo2_config_t;
+
+/**
+ * @brief Running statistics of one channel over the current beat
+ */
+typedef struct {
+    float min;
+    float max;
+    uint32_t min_index;               ///< Position of min within the window
+    uint32_t max_index;               ///< Position of max within the window
+    float sum;
+    float first;                      ///< Sample at the opening beat boundary
+    float last;                       ///< Most recent sample
+    uint32_t count;
+} spo2_window_t;
+
+/**
+ * @brief Published SpO2 estimate
+ */
+typedef struct {
+    float spo2;                       ///< Quality-weighted SpO2 in %
+    float ratio;                      ///< R of the last accepted beat
+    float quality;                    ///< Mean quality of averaged beats (0-1)
+    uint32_t beats;                   ///< Beats in the average
+    bool valid;                       ///< At least one beat accepted
+} spo2_result_t;
+
+/**
+ * @brief Estimator state
+ */
+typedef struct {
+    spo2_config_t config;
+    spo2_window_t red;
+    spo2_window_t ir;
+    bool window_open;                 ///< A beat boundary has been seen
+
+    float beat_spo2[SPO2_MAX_AVERAGE_BEATS];    ///< Recent per-beat SpO2 (ring)
+    float beat_quality[SPO2_MAX_AVERAGE_BEATS]; ///< Matching beat quality
+    uint32_t beat_pos;                ///< Next ring write position
+    uint32_t beat_count;              ///< Valid ring entries
+
+    spo2_result_t result;
+    uint32_t beats_accepted;          ///< Total beats used
+    uint32_t beats_rejected;          ///< Total beats dropped by quality gates
+} spo2_estimator_t;
+
+// Linear 110 - 25R approximation until a sensor calibration is loaded
+static const spo2_config_t SPO2_DEFAULT_CONFIG = {
+    .calibration = {110.0f, -25.0f, 0.0f, 0.0f},
+    .average_beats = 8,
+    .min_quality = 0.5f,
+    .min_perfusion = 0.0005f,
+    .max_perfusion = 0.2f
+};
+
+// =============================================================================
+// Estimator Functions
+// =============================================================================
+
+/**
+ * @brief Initialize estimator
+ * @param est Estimator instance
+ * @param config Configuration (NULL for SPO2_DEFAULT_CONFIG)
+ * @return true if the configuration is valid
+ */
+bool spo2_estimator_init(spo2_estimator_t* est, const spo2_config_t* config);
+
+/**
+ * @brief Clear beat windows and average, keep configuration
+ */
+void spo2_estimator_reset(spo2_estimator_t* est);
+
+/**
+ * @brief Load calibration polynomial (e.g. sensor_config_t.spo2_calibration)
+ */
+bool spo2_estimator_set_calibration(spo2_estimator_t* est, const float calibration[4]);
+
+/**
+ * @brief Process one block of Red/IR samples
+ * @param est Estimator instance
+ * @param red Red samples (with DC)
+ * @param ir IR samples (with DC)
+ * @param length Samples per channel
+ * @param beat_offsets Ascending sample offsets within the block where beats occur
+ * @param beat_count Number of beat offsets
+ * @return Number of beats accepted in this block
+ */
+uint32_t spo2_estimator_process(spo2_estimator_t* est,
+                                const float* red,
+                                const float* ir,
+                                uint32_t length,
+                                const uint32_t* beat_offsets,
+                                uint32_t beat_count);
+
+/**
+ * @brief Get current estimate
+ */
+const spo2_result_t* spo2_estimator_get_result(const spo2_estimator_t* est);
+
+// =============================================================================
+// Pipeline Stage Binding
+// =============================================================================
+
+/**
+ * @brief Stage operations for an SpO2 node
+ *
+ * Node inputs: [0] HR feature node (ppg_beat_block_t metadata),
+ * [1] preprocessed Red, [2] preprocessed IR. The output carries no
+ * samples; its metadata points to the spo2_result_t. In a multi-channel
+ * pipeline both inputs can be the same node, with Red and IR picked by
+ * SPO2_PARAM_RED_ROW and SPO2_PARAM_IR_ROW (row 0 by default).
+ */
+extern pipeline_stage_ops_t spo2_stage_ops;
+
+/**
+ * @brief Bind an estimator to an SpO2 algorithm stage
+ *
+ * Calibration comes from config->parameters (spo2_param_t) when set,
+ * otherwise the default; spo2_estimator_set_calibration() overrides it.
+ */
+bool spo2_stage_bind(pipeline_stage_t* stage,
+                     spo2_estimator_t* est,
+                     const pipeline_stage_config_t* config);
+
+#endif // SPO2_ESTIMATOR_H
@@ -0,0 +1,237 @@
+#ifndef STATIC_PIPELINE_H
+#define STATIC_PIPELINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "ppg_stages.h"
+#include "beat_detector.h"
+
+/**
+ * @file static_pipeline.h
+ * @brief Compiled preprocess -> filter -> HR chain for a fixed configuration
+ *
+ * The graph engine reaches every stage through pipeline_stage_ops_t and
+ * reads its parameters from pipeline_stage_config_t.parameters, so each
+ * stage is its own loop over the block with its settings loaded from
+ * memory. PPG_STATIC_PIPELINE_DEFINE() instead turns a fixed description
+ * into one specialized function per pipeline:
+ *
+ * - scale, DC pole and section count are literals at the call site of the
+ *   always-inlined kernel, so the section loop is unrolled and the
+ *   coefficients and delay state stay in registers for the block
+ * - preprocess scaling, DC blocker and band-pass run fused in one pass
+ *   over the samples; the beat detector then runs over the filtered chunk
+ *   while it is still in cache
+ *
+ * Biquad coefficients need cosf()/sinf() and are designed once by init
+ * with the filter stage's own design routine, so output matches the
+ * dynamic pre -> filter -> hr chain with the same settings sample for
+ * sample. There is no live reconfiguration, cross-fade or rate change:
+ * define one pipeline per sample rate. The graph engine stays the path
+ * for development and tuning.
+ *
+ * @code
+ * PPG_STATIC_PIPELINE_DEFINE(hr_50hz, 50, 1.0f, 0.99f, 2, 0.4f, 5.0f, 0.6f, 270.0f, 8)
+ *
+ * static ppg_static_pipeline_t hr;
+ * hr_50hz_init(&hr);
+ * const ppg_beat_block_t* beats = hr_50hz_process(&hr, samples, 25);
+ * @endcode
+ */
+
+// =============================================================================
+// Limits
+// =============================================================================
+
+#define PPG_STATIC_MAX_SECTIONS      4     ///< Order-4 band-pass, no notches
+#define PPG_STATIC_CHUNK             64    ///< Samples filtered ahead of the detector
+
+/** Band-pass sections for a filter order (same rule as the filter stage) */
+#define PPG_STATIC_SECTIONS(order)   ((order) >= 4 ? 4u : 2u)
+
+// =============================================================================
+// Data Structures
+// =============================================================================
+
+/**
+ * @brief State of one compiled pipeline (owned by caller)
+ */
+typedef struct {
+    ppg_biquad_t sections[PPG_STATIC_MAX_SECTIONS];
+    float dc_last_in;                 ///< DC blocker x[n-1]
+    float dc_last_out;                ///< DC blocker y[n-1]
+    bool primed;                      ///< DC blocker seeded from first sample
+    beat_detector_t detector;
+    ppg_beat_t beats[PPG_FEATURE_MAX_BEATS];  ///< Beats of the last call
+    ppg_beat_block_t block;           ///< Result of the last call
+    float filtered[PPG_STATIC_CHUNK]; ///< Filter output awaiting the detector
+} ppg_static_pipeline_t;
+
+// =============================================================================
+// Kernel (used through PPG_STATIC_PIPELINE_DEFINE)
+// =============================================================================
+
+#if defined(__GNUC__)
+#define PPG_STATIC_INLINE static inline __attribute__((always_inline))
+#else
+#define PPG_STATIC_INLINE static inline
+#endif
+
+/** Transposed direct form II section on local copies */
+#define PPG_STATIC_BIQUAD(bq, v)                                  \
+    do {                                                          \
+        float out_ = (bq).b0 * (v) + (bq).z1;                     \
+        (bq).z1 = (bq).b1 * (v) - (bq).a1 * out_ + (bq).z2;       \
+        (bq).z2 = (bq).b2 * (v) - (bq).a2 * out_;                 \
+        (v) = out_;                                               \
+    } while (0)
+
+static inline bool ppg_static_pipeline_setup(ppg_static_pipeline_t* p, uint32_t sample_rate,
+                                             uint32_t order, float low_hz, float high_hz,
+                                             float hysteresis, float min_interval_ms,
+                                             uint32_t hr_window)
+{
+    beat_detector_config_t config = BEAT_DETECTOR_DEFAULT_CONFIG;
+
+    if (!p) {
+        return false;
+    }
+
+    memset(p, 0, sizeof(ppg_static_pipeline_t));
+    p->block.beats = p->beats;
+    ppg_filter_design_bandpass(p->sections, order, low_hz, high_hz, sample_rate);
+
+    config.hysteresis = hysteresis;
+    config.min_interval_ms = min_interval_ms;
+    config.hr_window = hr_window;
+    return beat_detector_init(&p->detector, &config, sample_rate);
+}
+
+/**
+ * @brief Scale, DC-block and band-pass a chunk in one pass
+ *
+ * sections must be a constant after inlining: it selects the unrolled
+ * cascade at compile time.
+ */
+PPG_STATIC_INLINE void ppg_static_filter_chunk(ppg_static_pipeline_t* restrict p,
+                                               const float* restrict x,
+                                               float* restrict y,
+                                               uint32_t length,
+                                               const uint32_t sections,
+                                               const float scale,
+                                               const float alpha)
+{
+    ppg_biquad_t s0 = p->sections[0];
+    ppg_biquad_t s1 = p->sections[1];
+    ppg_biquad_t s2 = p->sections[2];
+    ppg_biquad_t s3 = p->sections[3];
+    float last_in = p->dc_last_in;
+    float last_out = p->dc_last_out;
+
+    for (uint32_t n = 0; n < length; n++) {
+        float in = x[n] * scale;
+        float v = in - last_in + alpha * last_out;
+        last_in = in;
+        last_out = v;
+
+        PPG_STATIC_BIQUAD(s0, v);
+        PPG_STATIC_BIQUAD(s1, v);
+        if (sections == 4) {
+            PPG_STATIC_BIQUAD(s2, v);
+            PPG_STATIC_BIQUAD(s3, v);
+        }
+        y[n] = v;
+    }
+
+    p->sections[0] = s0;
+    p->sections[1] = s1;
+    p->sections[2] = s2;
+    p->sections[3] = s3;
+    p->dc_last_in = last_in;
+    p->dc_last_out = last_out;
+}
+
+PPG_STATIC_INLINE const ppg_beat_block_t* ppg_static_pipeline_run(ppg_static_pipeline_t* p,
+                                                                  const float* samples,
+                                                                  uint32_t length,
+                                                                  const uint32_t sections,
+                                                                  const float scale,
+                                                                  const float alpha)
+{
+    if (!p || !samples) {
+        return NULL;
+    }
+
+    if (!p->primed && length > 0) {
+        p->dc_last_in = samples[0] * scale;
+        p->dc_last_out = 0.0f;
+        p->primed = true;
+    }
+
+    p->block.block_start_index = p->detector.sample_index;
+    p->block.count = 0;
+    for (uint32_t done = 0; done < length; ) {
+        uint32_t chunk = length - done < PPG_STATIC_CHUNK ? length - done : PPG_STATIC_CHUNK;
+        ppg_static_filter_chunk(p, samples + done, p->filtered, chunk, sections, scale, alpha);
+        p->block.count += beat_detector_process(&p->detector, p->filtered, chunk,
+                                                p->beats + p->block.count,
+                                                PPG_FEATURE_MAX_BEATS - p->block.count);
+        done += chunk;
+    }
+    p->block.hr_bpm = beat_detector_get_hr(&p->detector);
+    return &p->block;
+}
+
+/**
+ * @brief Clear filter and detector state, keeping the design
+ */
+static inline void ppg_static_pipeline_reset(ppg_static_pipeline_t* p)
+{
+    for (uint32_t s = 0; s < PPG_STATIC_MAX_SECTIONS; s++) {
+        p->sections[s].z1 = 0.0f;
+        p->sections[s].z2 = 0.0f;
+    }
+    p->primed = false;
+    beat_detector_reset(&p->detector);
+    p->block.count = 0;
+    p->block.hr_bpm = 0.0f;
+}
+
+// =============================================================================
+// Pipeline Definition
+// =============================================================================
+
+/**
+ * @brief Define name##_init() and name##_process() for a fixed pipeline
+ *
+ * @param name            Function prefix
+ * @param rate_hz         Input sample rate
+ * @param scale           Preprocess ADC scale factor
+ * @param dc_alpha        DC blocker pole
+ * @param order           Band-pass order (2 or 4)
+ * @param low_hz          Band-pass low cutoff
+ * @param high_hz         Band-pass high cutoff
+ * @param hysteresis      Beat detector threshold (fraction of p-p level)
+ * @param min_interval_ms Beat detector refractory period
+ * @param hr_window       Intervals in the HR median
+ *
+ * name##_process(p, samples, length) returns the beats confirmed during
+ * the call (at most PPG_FEATURE_MAX_BEATS) and the current HR.
+ */
+#define PPG_STATIC_PIPELINE_DEFINE(name, rate_hz, scale, dc_alpha, order, low_hz, high_hz, \
+                                   hysteresis, min_interval_ms, hr_window)                \
+    static inline bool name##_init(ppg_static_pipeline_t* p)                              \
+    {                                                                                     \
+        return ppg_static_pipeline_setup(p, (rate_hz), (order), (low_hz), (high_hz),      \
+                                         (hysteresis), (min_interval_ms), (hr_window));   \
+    }                                                                                     \
+    static inline const ppg_beat_block_t* name##_process(ppg_static_pipeline_t* p,        \
+                                                         const float* samples,            \
+                                                         uint32_t length)                 \
+    {                                                                                     \
+        return ppg_static_pipeline_run(p, samples, length, PPG_STATIC_SECTIONS(order),    \
+                                       (float)(scale), (float)(dc_alpha));                \
+    }
+
+#endif // STATIC_PIPELINE_H
@@ -0,0 +1,482 @@
+/*
+ * Respiratory Rate Estimator Implementation
+ *
+ * Per-beat RIIV/RIAV/RIFV values, linear resampling onto a 2 Hz grid and
+ * a periodic autocorrelation over the 32 s window. Per PPG sample the
+ * cost is one add; per beat a few grid pushes; per estimate about
+ * 3 x 20 x 64 multiply-adds.
+ */
+
+#include "resp_estimator.h"
+#include <string.h>
+#include <math.h>
+
+#define GRID_PERIOD_S          (1.0f / (float)RESP_GRID_RATE_HZ)
+#define MAX_BEAT_GAP_S         4.0f    /* longer gaps restart the window */
+#define MIN_ESTIMATE_SAMPLES   (RESP_WINDOW_SAMPLES / 2)
+#define PERIOD_PEAK_FRACTION   0.8f
+
+/* ==== PRIVATE FUNCTIONS ==== */
+
+static bool config_is_valid(const resp_config_t* config)
+{
+    return config->min_rate_bpm > 0.0f &&
+           config->max_rate_bpm > config->min_rate_bpm &&
+           config->max_rate_bpm <= 30.0f * RESP_GRID_RATE_HZ &&
+           config->update_interval_s > 0 &&
+           config->min_quality >= 0.0f && config->min_quality < 1.0f &&
+           config->agreement_bpm > 0.0f;
+}
+
+static void clear_series(resp_estimator_t* resp)
+{
+    resp->series_pos = 0;
+    resp->series_count = 0;
+    resp->samples_since_update = 0;
+}
+
+static void push_grid_sample(resp_estimator_t* resp, const float* values)
+{
+    for (int m = 0; m < RESP_MOD_COUNT; m++) {
+        resp->series[m][resp->series_pos] = values[m];
+    }
+    resp->series_pos = (resp->series_pos + 1) % RESP_WINDOW_SAMPLES;
+    if (resp->series_count < RESP_WINDOW_SAMPLES) {
+        resp->series_count++;
+    }
+    resp->samples_since_update++;
+}
+
+/** Linear interpolation from the previous beat up to this one onto the grid */
+static void add_beat(resp_estimator_t* resp, float time_s, const float* values)
+{
+    if (!resp->have_last_beat || time_s - resp->last_beat_time_s > MAX_BEAT_GAP_S) {
+        clear_series(resp);
+        resp->next_grid_time_s = time_s;
+    } else if (time_s > resp->last_beat_time_s) {
+        float span = time_s - resp->last_beat_time_s;
+        float grid[RESP_MOD_COUNT];
+
+        while (resp->next_grid_time_s <= time_s) {
+            float frac = (resp->next_grid_time_s - resp->last_beat_time_s) / span;
+            for (int m = 0; m < RESP_MOD_COUNT; m++) {
+                grid[m] = resp->last_values[m] + frac * (values[m] - resp->last_values[m]);
+            }
+            push_grid_sample(resp, grid);
+            resp->next_grid_time_s += GRID_PERIOD_S;
+        }
+    }
+
+    resp->have_last_beat = true;
+    resp->last_beat_time_s = time_s;
+    memcpy(resp->last_values, values, sizeof(resp->last_values));
+}
+
+static float series_mean(const resp_estimator_t* resp, int modality)
+{
+    float sum = 0.0f;
+
+    for (uint32_t i = 0; i < resp->series_count; i++) {
+        sum += resp->series[modality][i];
+    }
+    return sum / (float)resp->series_count;
+}
+
+/**
+ * Breathing rate of one series from its autocorrelation; returns the peak
+ * height as quality and the detrended RMS relative to scale as depth.
+ */
+static float estimate_series(const resp_estimator_t* resp, int modality, float scale,
+                             float* rate_bpm, float* depth)
+{
+    float x[RESP_WINDOW_SAMPLES];
+    uint32_t n = resp->series_count;
+    uint32_t start = (resp->series_pos + RESP_WINDOW_SAMPLES - n) % RESP_WINDOW_SAMPLES;
+    float mean = 0.0f;
+
+    for (uint32_t i = 0; i < n; i++) {
+        x[i] = resp->series[modality][(start + i) % RESP_WINDOW_SAMPLES];
+        mean += x[i];
+    }
+    mean /= (float)n;
+
+    // Remove mean and linear trend (slow posture/perfusion drift)
+    float center = 0.5f * (float)(n - 1);
+    float num = 0.0f, den = 0.0f;
+    for (uint32_t i = 0; i < n; i++) {
+        float di = (float)i - center;
+        num += di * (x[i] - mean);
+        den += di * di;
+    }
+    float slope = den > 0.0f ? num / den : 0.0f;
+    float energy = 0.0f;
+    for (uint32_t i = 0; i < n; i++) {
+        x[i] -= mean + slope * ((float)i - center);
+        energy += x[i] * x[i];
+    }
+
+    *depth = scale > 0.0f ? sqrtf(energy / (float)n) / scale : 0.0f;
+    if (energy <= 0.0f) {
+        return 0.0f;
+    }
+
+    float grid_rate = (float)RESP_GRID_RATE_HZ;
+    uint32_t lag_min = (uint32_t)(60.0f * grid_rate / resp->config.max_rate_bpm);
+    uint32_t lag_max = (uint32_t)ceilf(60.0f * grid_rate / resp->config.min_rate_bpm);
+    if (lag_min < 2) {
+        lag_min = 2;
+    }
+    if (lag_max > n / 2) {
+        lag_max = n / 2;
+    }
+    if (lag_max <= lag_min) {
+        return 0.0f;
+    }
+
+    // Normalized autocorrelation, scaled for the shrinking overlap
+    float r[RESP_WINDOW_SAMPLES / 2 + 2];
+    for (uint32_t k = lag_min - 1; k <= lag_max + 1; k++) {
+        float acc = 0.0f;
+        for (uint32_t i = 0; i + k < n; i++) {
+            acc += x[i] * x[i + k];
+        }
+        r[k] = acc / energy * (float)n / (float)(n - k);
+    }
+
+    float best = 0.0f;
+    for (uint32_t k = lag_min; k <= lag_max; k++) {
+        if (r[k] > r[k - 1] && r[k] >= r[k + 1] && r[k] > best) {
+            best = r[k];
+        }
+    }
+
+    // Multiples of the period peak about as high: take the shortest lag near the best
+    uint32_t best_lag = 0;
+    for (uint32_t k = lag_min; k <= lag_max && best_lag == 0; k++) {
+        if (r[k] > r[k - 1] && r[k] >= r[k + 1] && r[k] >= PERIOD_PEAK_FRACTION * best) {
+            best_lag = k;
+        }
+    }
+    if (best_lag == 0) {
+        return 0.0f;
+    }
+    best = r[best_lag];
+
+    float denom = r[best_lag - 1] - 2.0f * r[best_lag] + r[best_lag + 1];
+    float offset = denom < 0.0f ? 0.5f * (r[best_lag - 1] - r[best_lag + 1]) / denom : 0.0f;
+
+    *rate_bpm = 60.0f * grid_rate / ((float)best_lag + offset);
+    return best > 1.0f ? 1.0f : best;
+}
+
+/**
+ * Fuse the largest group of modalities that agree: each accepted modality
+ * is tried as anchor and the one gathering the most quality wins, so a
+ * lone outlier (e.g. RIIV locking onto a sub-harmonic) is left out.
+ */
+static void update_estimate(resp_estimator_t* resp)
+{
+    resp_result_t* result = &resp->result;
+
+    // Intensity and amplitude relative to the pulse amplitude, intervals to the mean interval
+    float pulse_amplitude = series_mean(resp, RESP_MOD_RIAV);
+    const float scale[RESP_MOD_COUNT] = {
+        pulse_amplitude, pulse_amplitude, series_mean(resp, RESP_MOD_RIFV)
+    };
+    bool accepted[RESP_MOD_COUNT];
+
+    for (int m = 0; m < RESP_MOD_COUNT; m++) {
+        float depth = 0.0f;
+
+        result->modality_rate[m] = 0.0f;
+        result->modality_quality[m] = estimate_series(resp, m, scale[m], &result->modality_rate[m], &depth);
+        result->modality_depth[m] = depth;
+
+        // Beat/grid quantization is periodic too; real breathing also has depth
+        accepted[m] = result->modality_quality[m] >= resp->config.min_quality &&
+                      depth >= resp->config.min_depth[m];
+    }
+
+    resp->estimates++;
+
+    float best_support = 0.0f;
+    int anchor = -1;
+    for (int a = 0; a < RESP_MOD_COUNT; a++) {
+        float support = 0.0f;
+        if (!accepted[a]) {
+            continue;
+        }
+        for (int m = 0; m < RESP_MOD_COUNT; m++) {
+            if (accepted[m] &&
+                fabsf(result->modality_rate[m] - result->modality_rate[a]) <= resp->config.agreement_bpm) {
+                support += result->modality_quality[m];
+            }
+        }
+        if (support > best_support) {
+            best_support = support;
+            anchor = a;
+        }
+    }
+
+    if (anchor < 0) {
+        result->valid = false;
+        result->modalities_used = 0;
+        return;
+    }
+
+    float weighted = 0.0f, weights = 0.0f;
+    uint32_t used = 0;
+    for (int m = 0; m < RESP_MOD_COUNT; m++) {
+        float q = result->modality_quality[m];
+        if (accepted[m] &&
+            fabsf(result->modality_rate[m] - result->modality_rate[anchor]) <= resp->config.agreement_bpm) {
+            weighted += q * result->modality_rate[m];
+            weights += q;
+            used++;
+        }
+    }
+
+    result->rate_bpm = weighted / weights;
+    result->quality = weights / (float)used;
+    result->modalities_used = used;
+    result->valid = true;
+}
+
+/* ==== PUBLIC FUNCTIONS ==== */
+
+bool resp_estimator_init(resp_estimator_t* resp, const resp_config_t* config, uint32_t sample_rate)
+{
+    if (!resp || sample_rate == 0) {
+        return false;
+    }
+
+    const resp_config_t* cfg = config ? config : &RESP_DEFAULT_CONFIG;
+    if (!config_is_valid(cfg)) {
+        return false;
+    }
+
+    memset(resp, 0, sizeof(resp_estimator_t));
+    resp->config = *cfg;
+    resp->sample_rate = sample_rate;
+    return true;
+}
+
+void resp_estimator_reset(resp_estimator_t* resp)
+{
+    if (!resp) {
+        return;
+    }
+
+    resp_config_t config = resp->config;
+    uint32_t sample_rate = resp->sample_rate;
+    resp_estimator_init(resp, &config, sample_rate);
+}
+
+bool resp_estimator_process(resp_estimator_t* resp,
+                            const float* ppg,
+                            uint32_t length,
+                            const ppg_beat_block_t* beats)
+{
+    uint32_t cursor = 0;
+
+    if (!resp || !ppg || !beats) {
+        return false;
+    }
+
+    const float fs = (float)resp->sample_rate;
+
+    for (uint32_t b = 0; b < beats->count; b++) {
+        const ppg_beat_t* beat = &beats->beats[b];
+        int32_t offset = (int32_t)(beat->sample_index - beats->block_start_index);
+
+        // Beats confirmed after the block boundary close the window at the block start
+        uint32_t boundary = offset < 0 ? 0 : (uint32_t)offset;
+        if (boundary >= length) {
+            boundary = length - 1;
+        }
+        for (; cursor <= boundary && cursor < length; cursor++) {
+            resp->window_sum += ppg[cursor];
+            resp->window_count++;
+        }
+
+        if (resp->window_open && resp->window_count > 0) {
+            float values[RESP_MOD_COUNT];
+            float time_s = ((float)resp->sample_index + (float)offset + beat->peak_offset) / fs;
+
+            values[RESP_MOD_RIIV] = resp->window_sum / (float)resp->window_count;
+            values[RESP_MOD_RIAV] = beat->amplitude;
+            values[RESP_MOD_RIFV] = beat->interval_ms > 0.0f ?
+                                    beat->interval_ms : resp->last_values[RESP_MOD_RIFV];
+            add_beat(resp, time_s, values);
+        }
+
+        resp->window_open = true;
+        resp->window_sum = 0.0f;
+        resp->window_count = 0;
+    }
+
+    for (; cursor < length; cursor++) {
+        resp->window_sum += ppg[cursor];
+        resp->window_count++;
+    }
+    resp->sample_index += length;
+
+    if (resp->series_count < MIN_ESTIMATE_SAMPLES ||
+        resp->samples_since_update < resp->config.update_interval_s * RESP_GRID_RATE_HZ) {
+        return false;
+    }
+
+    update_estimate(resp);
+    resp->samples_since_update = 0;
+    return true;
+}
+
+const resp_result_t* resp_estimator_get_result(const resp_estimator_t* resp)
+{
+    return resp ? &resp->result : NULL;
+}
+
+/* ==== PIPELINE STAGE BINDING ==== */
+
+static void stage_apply_config(resp_estimator_t* resp, const pipeline_stage_config_t* config)
+{
+    resp_config_t cfg = RESP_DEFAULT_CONFIG;
+
+    if (config->parameter_count > RESP_PARAM_UPDATE_INTERVAL_S &&
+        config->parameters[RESP_PARAM_UPDATE_INTERVAL_S] > 0.0f) {
+        cfg.update_interval_s = (uint32_t)config->parameters[RESP_PARAM_UPDATE_INTERVAL_S];
+    }
+    if (config->parameter_count > RESP_PARAM_MIN_QUALITY &&
+        config->parameters[RESP_PARAM_MIN_QUALITY] > 0.0f) {
+        cfg.min_quality = config->parameters[RESP_PARAM_MIN_QUALITY];
+    }
+    if (config->parameter_count > RESP_PARAM_AGREEMENT_BPM &&
+        config->parameters[RESP_PARAM_AGREEMENT_BPM] > 0.0f) {
+        cfg.agreement_bpm = config->parameters[RESP_PARAM_AGREEMENT_BPM];
+    }
+
+    resp->config = cfg;
+}
+
+static uint32_t stage_row(const pipeline_stage_config_t* config)
+{
+    return config->parameter_count > RESP_PARAM_ROW ? (uint32_t)config->parameters[RESP_PARAM_ROW] : 0u;
+}
+
+static bool stage_init(pipeline_stage_t* stage, const pipeline_stage_config_t* config)
+{
+    resp_estimator_t* resp = (resp_estimator_t*)stage->context;
+
+    if (!config || stage_row(config) >= PIPELINE_MAX_CHANNELS) {
+        return false;
+    }
+
+    // Sample rate is taken from the first block
+    memset(resp, 0, sizeof(resp_estimator_t));
+    stage->config = *config;
+    stage_apply_config(resp, config);
+    return config_is_valid(&resp->config);
+}
+
+static bool stage_process(pipeline_stage_t* stage, const signal_buffer_t* input, signal_buffer_t* output)
+{
+    resp_estimator_t* resp = (resp_estimator_t*)stage->context;
+    const ppg_beat_block_t* beats = (const ppg_beat_block_t*)input[0].metadata;
+    const signal_buffer_t* ppg = &input[1];
+    uint32_t row = stage_row(&stage->config);
+
+    if (!beats || !ppg->data || ppg->sample_rate == 0 || row >= SIGNAL_CHANNEL_COUNT(ppg)) {
+        return false;
+    }
+
+    if (resp->sample_rate != ppg->sample_rate) {
+        resp_config_t config = resp->config;
+        if (!resp_estimator_init(resp, &config, ppg->sample_rate)) {
+            return false;
+        }
+    }
+
+    resp_estimator_process(resp, SIGNAL_CHANNEL(ppg, row), ppg->length, beats);
+
+    output->length = 0;
+    output->sample_rate = ppg->sample_rate;
+    output->timestamp_start = ppg->timestamp_start;
+    output->quality_score = resp->result.valid ? resp->result.quality : 0.0f;
+    output->metadata = &resp->result;
+    return true;
+}
+
+static bool stage_reset(pipeline_stage_t* stage)
+{
+    resp_estimator_reset((resp_estimator_t*)stage->context);
+    return true;
+}
+
+static bool stage_update_config(pipeline_stage_t* stage, const pipeline_stage_config_t* config)
+{
+    resp_estimator_t* resp = (resp_estimator_t*)stage->context;
+    resp_config_t previous = resp->config;
+
+    if (!config || stage_row(config) >= PIPELINE_MAX_CHANNELS) {
+        return false;
+    }
+
+    // Thresholds only; the modulation history stays valid
+    stage_apply_config(resp, config);
+    if (!config_is_valid(&resp->config)) {
+        resp->config = previous;
+        return false;
+    }
+
+    stage->config = *config;
+    return true;
+}
+
+static bool stage_get_status(pipeline_stage_t* stage, float* quality, uint32_t* latency_us)
+{
+    const resp_estimator_t* resp = (const resp_estimator_t*)stage->context;
+
+    if (quality) {
+        *quality = resp->result.valid ? resp->result.quality : 0.0f;
+    }
+    if (latency_us) {
+        *latency_us = stage->processing_time_us;
+    }
+    return true;
+}
+
+static void stage_cleanup(pipeline_stage_t* stage)
+{
+    resp_estimator_reset((resp_estimator_t*)stage->context);
+}
+
+pipeline_stage_ops_t resp_stage_ops = {
+    .init = stage_init,
+    .process = stage_process,
+    .reset = stage_reset,
+    .update_config = stage_update_config,
+    .get_status = stage_get_status,
+    .cleanup = stage_cleanup,
+};
+
+bool resp_stage_bind(pipeline_stage_t* stage,
+                     resp_estimator_t* resp,
+                     const pipeline_stage_config_t* config)
+{
+    if (!stage || !resp || !config) {
+        return false;
+    }
+
+    memset(stage, 0, sizeof(pipeline_stage_t));
+    stage->type = PIPELINE_STAGE_ALGORITHM;
+    stage->ops = &resp_stage_ops;
+    stage->multichannel = true;
+    stage->input_count = 2;
+    stage->context = resp;
+
+    if (!stage_init(stage, config)) {
+        return false;
+    }
+    pipeline_stage_set_name(stage, "resp");
+    return true;
+}
@@ -0,0 +1,176 @@
+#ifndef RESP_ESTIMATOR_H
+#define RESP_ESTIMATOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "interfaces/signal_pipeline_interfaces.h"
+#include "beat_detector.h"
+
+/**
+ * @file resp_estimator.h
+ * @brief Respiratory rate from PPG beat modulations
+ *
+ * Breathing modulates the PPG three ways: baseline intensity (RIIV),
+ * pulse amplitude (RIAV) and beat-to-beat interval (RIFV). One value of
+ * each is taken per detected beat, resampled onto a 2 Hz grid and kept in
+ * a 32 s window. Every few seconds a short autocorrelation per modality
+ * gives a rate and a confidence; modalities that agree are fused.
+ *
+ * RIIV and RIAV depth is relative to the mean pulse amplitude, RIFV depth
+ * to the mean beat interval.
+ */
+
+// =============================================================================
+// Limits
+// =============================================================================
+
+#define RESP_GRID_RATE_HZ            2     ///< Resampled modulation rate
+#define RESP_WINDOW_SAMPLES          64    ///< Analysis window (32 s at 2 Hz)
+
+/**
+ * @brief Breathing modulation series
+ */
+typedef enum {
+    RESP_MOD_RIIV = 0,                ///< Respiratory-induced intensity variation
+    RESP_MOD_RIAV,                    ///< Respiratory-induced amplitude variation
+    RESP_MOD_RIFV,                    ///< Respiratory-induced frequency variation
+    RESP_MOD_COUNT
+} resp_modulation_t;
+
+/**
+ * @brief Index of respiration parameters in pipeline_stage_config_t.parameters
+ */
+typedef enum {
+    RESP_PARAM_UPDATE_INTERVAL_S = 0,     ///< Seconds between estimates
+    RESP_PARAM_MIN_QUALITY,               ///< Per-modality autocorrelation gate
+    RESP_PARAM_AGREEMENT_BPM,             ///< Max spread of fused modalities
+    RESP_PARAM_ROW,                       ///< Channel row of input [1] to analyse
+    RESP_PARAM_COUNT
+} resp_param_t;
+
+// =============================================================================
+// Data Structures
+// =============================================================================
+
+/**
+ * @brief Estimator configuration
+ */
+typedef struct {
+    float min_rate_bpm;               ///< Lowest detectable breathing rate
+    float max_rate_bpm;               ///< Highest detectable breathing rate
+    uint32_t update_interval_s;       ///< Seconds between estimates
+    float min_quality;                ///< Normalized autocorrelation peak to accept a modality
+    float min_depth[RESP_MOD_COUNT];  ///< Minimum relative modulation depth (RMS) per modality
+    float agreement_bpm;              ///< Accepted modalities must lie within this spread
+} resp_config_t;
+
+/**
+ * @brief Published respiration estimate
+ */
+typedef struct {
+    float rate_bpm;                   ///< Fused breathing rate (breaths/min)
+    float quality;                    ///< Mean quality of fused modalities (0-1)
+    float modality_rate[RESP_MOD_COUNT];    ///< Per-modality rate
+    float modality_quality[RESP_MOD_COUNT]; ///< Per-modality autocorrelation peak
+    float modality_depth[RESP_MOD_COUNT];   ///< Per-modality relative modulation depth
+    uint32_t modalities_used;         ///< Modalities in the fused rate
+    bool valid;                       ///< rate_bpm is current
+} resp_result_t;
+
+/**
+ * @brief Estimator state
+ */
+typedef struct {
+    resp_config_t config;
+    uint32_t sample_rate;             ///< PPG sample rate
+    uint32_t sample_index;            ///< PPG samples seen
+
+    // Per-beat intensity window over the raw PPG
+    float window_sum;
+    uint32_t window_count;
+    bool window_open;
+
+    // Resampling onto the 2 Hz grid
+    bool have_last_beat;
+    float last_beat_time_s;
+    float last_values[RESP_MOD_COUNT];
+    float next_grid_time_s;
+
+    float series[RESP_MOD_COUNT][RESP_WINDOW_SAMPLES]; ///< Grid samples (ring)
+    uint32_t series_pos;              ///< Next ring write position
+    uint32_t series_count;            ///< Valid grid samples
+    uint32_t samples_since_update;    ///< Grid samples since last estimate
+
+    resp_result_t result;
+    uint32_t estimates;               ///< Estimates computed
+} resp_estimator_t;
+
+// Adult breathing range; refresh every 5 s over the 32 s window. Depth
+// floors sit above the beat-boundary quantization of each modality.
+static const resp_config_t RESP_DEFAULT_CONFIG = {
+    .min_rate_bpm = 6.0f,
+    .max_rate_bpm = 40.0f,
+    .update_interval_s = 5,
+    .min_quality = 0.3f,
+    .min_depth = {0.05f, 0.02f, 0.01f},
+    .agreement_bpm = 4.0f
+};
+
+// =============================================================================
+// Estimator Functions
+// =============================================================================
+
+/**
+ * @brief Initialize estimator
+ * @param resp Estimator instance
+ * @param config Configuration (NULL for RESP_DEFAULT_CONFIG)
+ * @param sample_rate PPG sample rate in Hz
+ * @return true if the configuration is valid
+ */
+bool resp_estimator_init(resp_estimator_t* resp, const resp_config_t* config, uint32_t sample_rate);
+
+/**
+ * @brief Clear modulation history, keep configuration
+ */
+void resp_estimator_reset(resp_estimator_t* resp);
+
+/**
+ * @brief Feed one block of raw PPG with the beats detected in it
+ * @param resp Estimator instance
+ * @param ppg Unfiltered PPG block (baseline intact)
+ * @param length Number of samples
+ * @param beats Beats from the HR feature stage for the same block
+ * @return true if a new estimate was computed
+ */
+bool resp_estimator_process(resp_estimator_t* resp,
+                            const float* ppg,
+                            uint32_t length,
+                            const ppg_beat_block_t* beats);
+
+/**
+ * @brief Get current estimate
+ */
+const resp_result_t* resp_estimator_get_result(const resp_estimator_t* resp);
+
+// =============================================================================
+// Pipeline Stage Binding
+// =============================================================================
+
+/**
+ * @brief Stage operations for a respiration node
+ *
+ * Node inputs: [0] HR feature node (ppg_beat_block_t metadata),
+ * [1] preprocessed PPG. The output carries no samples; its metadata
+ * points to the resp_result_t. Of a multi-channel input, the row set by
+ * RESP_PARAM_ROW is analysed (row 0 by default).
+ */
+extern pipeline_stage_ops_t resp_stage_ops;
+
+/**
+ * @brief Bind an estimator to a respiration algorithm stage
+ */
+bool resp_stage_bind(pipeline_stage_t* stage,
+                     resp_estimator_t* resp,
+                     const pipeline_stage_config_t* config);
+
+#endif // RESP_ESTIMATOR_H
@@ -0,0 +1,385 @@
+/*
+ * Lossless Block Codec
+ *
+ * Second-order prediction and zigzag per channel, then 16-residual
+ * packed groups or Rice coding, whichever the channel's residuals make
+ * smaller. The encoder makes one pass to compute residuals and the cost
+ * of both modes, and one pass to emit; both are a handful of integer
+ * operations per sample.
+ */
+
+#include "block_codec.h"
+#include <stddef.h>
+#include <string.h>
+
+#define MODE_PACKED             0x00u
+#define MODE_RICE               0x80u
+#define MODE_RICE_K_MASK        0x1Fu
+#define RICE_ESCAPE             24u    /* Unary prefix that announces a raw 32-bit residual */
+
+/* ==== BIT STREAMS ==== */
+
+typedef struct {
+    uint8_t* out;
+    uint32_t pos;
+    uint32_t capacity;
+    uint64_t acc;
+    uint32_t bits;
+    bool overflow;
+} bit_writer_t;
+
+typedef struct {
+    const uint8_t* in;
+    uint32_t pos;
+    uint32_t length;
+    uint64_t acc;
+    uint32_t bits;
+    bool overrun;
+} bit_reader_t;
+
+/** Append the low n bits of value (n <= 32; higher bits must be zero) */
+static inline void put_bits(bit_writer_t* w, uint32_t value, uint32_t n)
+{
+    w->acc |= (uint64_t)value << w->bits;
+    w->bits += n;
+    while (w->bits >= 8) {
+        if (w->pos < w->capacity) {
+            w->out[w->pos++] = (uint8_t)w->acc;
+        } else {
+            w->overflow = true;
+        }
+        w->acc >>= 8;
+        w->bits -= 8;
+    }
+}
+
+static void align_writer(bit_writer_t* w)
+{
+    if (w->bits > 0) {
+        put_bits(w, 0, 8 - w->bits);
+    }
+}
+
+static inline void refill(bit_reader_t* r)
+{
+    while (r->bits <= 56 && r->pos < r->length) {
+        r->acc |= (uint64_t)r->in[r->pos++] << r->bits;
+        r->bits += 8;
+    }
+}
+
+static inline uint32_t get_bits(bit_reader_t* r, uint32_t n)
+{
+    if (r->bits < n) {
+        refill(r);
+        if (r->bits < n) {
+            r->overrun = true;
+            return 0;
+        }
+    }
+    uint32_t value = (uint32_t)(r->acc & ((1ull << n) - 1u));
+    r->acc >>= n;
+    r->bits -= n;
+    return value;
+}
+
+/** Drop the padding after a channel stream */
+static void align_reader(bit_reader_t* r)
+{
+    uint32_t pad = r->bits % 8u;
+    r->acc >>= pad;
+    r->bits -= pad;
+}
+
+/* ==== PRIVATE FUNCTIONS ==== */
+
+static inline uint32_t zigzag(uint32_t residual)
+{
+    return (residual << 1) ^ (0u - (residual >> 31));
+}
+
+static inline uint32_t unzigzag(uint32_t value)
+{
+    return (value >> 1) ^ (0u - (value & 1u));
+}
+
+static inline uint32_t bit_width(uint32_t value)
+{
+    return value ? 32u - (uint32_t)__builtin_clz(value) : 0u;
+}
+
+static inline uint32_t load_sample(const block_codec_channel_t* view, uint32_t index)
+{
+    const uint8_t* src = (const uint8_t*)view->data + (size_t)index * view->stride;
+
+    if (view->element_size == 2) {
+        int16_t value;
+        memcpy(&value, src, sizeof(value));
+        return (uint32_t)(int32_t)value;
+    }
+    uint32_t value;
+    memcpy(&value, src, sizeof(value));
+    return value;
+}
+
+static inline void store_sample(const block_codec_channel_t* view, uint32_t index, uint32_t value)
+{
+    uint8_t* dst = (uint8_t*)view->data + (size_t)index * view->stride;
+
+    if (view->element_size == 2) {
+        uint16_t low = (uint16_t)value;
+        memcpy(dst, &low, sizeof(low));
+    } else {
+        memcpy(dst, &value, sizeof(value));
+    }
+}
+
+static bool valid_view(const block_codec_channel_t* view)
+{
+    return view->data && (view->element_size == 2 || view->element_size == 4) &&
+           view->stride >= view->element_size;
+}
+
+/** Bits of a Rice code with parameter k */
+static inline uint32_t rice_bits(uint32_t value, uint32_t k)
+{
+    uint32_t quotient = value >> k;
+    return quotient < RICE_ESCAPE ? quotient + 1u + k : RICE_ESCAPE + 32u;
+}
+
+static void encode_channel(const block_codec_channel_t* view, uint32_t count, bit_writer_t* w)
+{
+    uint32_t residuals[BLOCK_CODEC_MAX_SAMPLES];
+    uint32_t n = count - 1;
+    uint32_t first = load_sample(view, 0);
+    uint32_t prev1 = first;
+    uint32_t prev2 = first;
+    uint64_t sum = 0;
+    uint32_t packed_bits = 0;
+    uint32_t group_or = 0;
+
+    // Residuals, the packed cost and the Rice parameter estimate in one pass
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t x = load_sample(view, i + 1);
+        uint32_t z = zigzag(x - (2u * prev1 - prev2));
+
+        residuals[i] = z;
+        sum += z;
+        group_or |= z;
+        if ((i + 1) % BLOCK_CODEC_GROUP == 0 || i + 1 == n) {
+            uint32_t in_group = (i % BLOCK_CODEC_GROUP) + 1;
+            packed_bits += 8u + in_group * bit_width(group_or);
+            group_or = 0;
+        }
+        prev2 = prev1;
+        prev1 = x;
+    }
+
+    // Rice parameter near log2(mean), refined over its neighbours
+    uint32_t mean = n ? (uint32_t)(sum / n) : 0;
+    uint32_t k0 = mean > 1 ? bit_width(mean) - 1u : 0u;
+    uint32_t k_lo = k0 > 0 ? k0 - 1u : 0u;
+    uint32_t k_hi = k0 < 30 ? k0 + 1u : 31u;
+    uint32_t cost[3] = { 0, 0, 0 };
+
+    for (uint32_t i = 0; i < n; i++) {
+        cost[0] += rice_bits(residuals[i], k_lo);
+        cost[1] += rice_bits(residuals[i], k0);
+        cost[2] += rice_bits(residuals[i], k_hi);
+    }
+    uint32_t k = k0;
+    uint32_t rice_cost = cost[1];
+    if (cost[0] < rice_cost) {
+        k = k_lo;
+        rice_cost = cost[0];
+    }
+    if (cost[2] < rice_cost) {
+        k = k_hi;
+        rice_cost = cost[2];
+    }
+
+    if (rice_cost < packed_bits) {
+        uint32_t k_mask = (uint32_t)((1ull << k) - 1u);
+
+        put_bits(w, MODE_RICE | k, 8);
+        put_bits(w, first, 32);
+        for (uint32_t i = 0; i < n; i++) {
+            uint32_t quotient = residuals[i] >> k;
+            if (quotient < RICE_ESCAPE) {
+                // quotient ones, then the terminating zero
+                put_bits(w, (1u << quotient) - 1u, quotient + 1u);
+                put_bits(w, residuals[i] & k_mask, k);
+            } else {
+                put_bits(w, (1u << RICE_ESCAPE) - 1u, RICE_ESCAPE);
+                put_bits(w, residuals[i], 32);
+            }
+        }
+    } else {
+        put_bits(w, MODE_PACKED, 8);
+        put_bits(w, first, 32);
+        for (uint32_t g = 0; g < n; g += BLOCK_CODEC_GROUP) {
+            uint32_t end = g + BLOCK_CODEC_GROUP < n ? g + BLOCK_CODEC_GROUP : n;
+            uint32_t width_or = 0;
+            for (uint32_t i = g; i < end; i++) {
+                width_or |= residuals[i];
+            }
+            uint32_t width = bit_width(width_or);
+            put_bits(w, width, 8);
+            if (width > 0) {
+                for (uint32_t i = g; i < end; i++) {
+                    put_bits(w, residuals[i], width);
+                }
+            }
+        }
+    }
+    align_writer(w);
+}
+
+static bool decode_channel(const block_codec_channel_t* view, uint32_t count, bit_reader_t* r)
+{
+    uint32_t mode = get_bits(r, 8);
+    uint32_t first = get_bits(r, 32);
+    uint32_t prev1 = first;
+    uint32_t prev2 = first;
+
+    store_sample(view, 0, first);
+
+    if (mode & MODE_RICE) {
+        uint32_t k = mode & MODE_RICE_K_MASK;
+
+        for (uint32_t i = 1; i < count && !r->overrun; i++) {
+            uint32_t z;
+
+            refill(r);
+            uint64_t inverted = ~r->acc;
+            uint32_t ones = inverted ? (uint32_t)__builtin_ctzll(inverted) : 64u;
+            if (ones >= RICE_ESCAPE) {
+                get_bits(r, RICE_ESCAPE);
+                z = get_bits(r, 32);
+            } else {
+                get_bits(r, ones + 1u);
+                z = (ones << k) | get_bits(r, k);
+            }
+
+            uint32_t x = unzigzag(z) + (2u * prev1 - prev2);
+            store_sample(view, i, x);
+            prev2 = prev1;
+            prev1 = x;
+        }
+    } else if (mode == MODE_PACKED) {
+        for (uint32_t g = 1; g < count && !r->overrun; g += BLOCK_CODEC_GROUP) {
+            uint32_t end = g + BLOCK_CODEC_GROUP < count ? g + BLOCK_CODEC_GROUP : count;
+            uint32_t width = get_bits(r, 8);
+            if (width > 32) {
+                return false;
+            }
+            for (uint32_t i = g; i < end; i++) {
+                uint32_t x = unzigzag(get_bits(r, width)) + (2u * prev1 - prev2);
+                store_sample(view, i, x);
+                prev2 = prev1;
+                prev1 = x;
+            }
+        }
+    } else {
+        return false;
+    }
+
+    align_reader(r);
+    return !r->overrun;
+}
+
+/* ==== PUBLIC FUNCTIONS ==== */
+
+int32_t block_codec_encode(const block_codec_channel_t* channels, uint32_t channel_count,
+                           uint32_t sample_count, uint8_t* out, uint32_t capacity)
+{
+    if (!channels || !out || channel_count == 0 || channel_count > BLOCK_CODEC_MAX_CHANNELS ||
+        sample_count == 0 || sample_count > BLOCK_CODEC_MAX_SAMPLES ||
+        capacity < sizeof(block_codec_header_t)) {
+        return -1;
+    }
+    for (uint32_t c = 0; c < channel_count; c++) {
+        if (!valid_view(&channels[c])) {
+            return -1;
+        }
+    }
+
+    block_codec_header_t header = {
+        .sample_count = (uint16_t)sample_count,
+        .channels = (uint8_t)channel_count,
+        .version = BLOCK_CODEC_VERSION,
+    };
+    memcpy(out, &header, sizeof(header));
+
+    bit_writer_t w = { .out = out, .pos = sizeof(header), .capacity = capacity };
+    for (uint32_t c = 0; c < channel_count; c++) {
+        encode_channel(&channels[c], sample_count, &w);
+    }
+    return w.overflow ? -1 : (int32_t)w.pos;
+}
+
+bool block_codec_peek(const uint8_t* in, uint32_t length, block_codec_header_t* header)
+{
+    if (!in || !header || length < sizeof(block_codec_header_t)) {
+        return false;
+    }
+    memcpy(header, in, sizeof(block_codec_header_t));
+    return header->version == BLOCK_CODEC_VERSION &&
+           header->channels > 0 && header->channels <= BLOCK_CODEC_MAX_CHANNELS &&
+           header->sample_count > 0 && header->sample_count <= BLOCK_CODEC_MAX_SAMPLES;
+}
+
+int32_t block_codec_decode(const uint8_t* in, uint32_t length, const block_codec_channel_t* channels,
+                           uint32_t channel_count, uint32_t sample_capacity)
+{
+    block_codec_header_t header;
+
+    if (!channels || !block_codec_peek(in, length, &header) ||
+        header.channels != channel_count || header.sample_count > sample_capacity) {
+        return -1;
+    }
+
+    bit_reader_t r = { .in = in, .pos = sizeof(header), .length = length };
+    for (uint32_t c = 0; c < channel_count; c++) {
+        if (!valid_view(&channels[c]) || !decode_channel(&channels[c], header.sample_count, &r)) {
+            return -1;
+        }
+    }
+    return header.sample_count;
+}
+
+uint32_t block_codec_ppg_channels(ppg_sample_t* samples, uint8_t led_slots,
+                                  block_codec_channel_t channels[4])
+{
+    uint32_t count = 0;
+
+    for (uint32_t slot = 0; slot < 4; slot++) {
+        if (led_slots & (1u << slot)) {
+            channels[count].data = &samples[0].channels[slot];
+            channels[count].stride = sizeof(ppg_sample_t);
+            channels[count].element_size = sizeof(samples[0].channels[slot]);
+            count++;
+        }
+    }
+    return count;
+}
+
+uint32_t block_codec_imu_channels(imu_sample_t* samples, bool include_gyro,
+                                  block_codec_channel_t channels[6])
+{
+    uint32_t count = 0;
+
+    for (uint32_t axis = 0; axis < 3; axis++) {
+        channels[count].data = &samples[0].accel[axis];
+        channels[count].stride = sizeof(imu_sample_t);
+        channels[count].element_size = sizeof(samples[0].accel[axis]);
+        count++;
+    }
+    for (uint32_t axis = 0; include_gyro && axis < 3; axis++) {
+        channels[count].data = &samples[0].gyro[axis];
+        channels[count].stride = sizeof(imu_sample_t);
+        channels[count].element_size = sizeof(samples[0].gyro[axis]);
+        count++;
+    }
+    return count;
+}
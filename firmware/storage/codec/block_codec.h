@@ -0,0 +1,129 @@
+#ifndef BLOCK_CODEC_H
+#define BLOCK_CODEC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "interfaces/sensor_interfaces.h"
+
+/**
+ * @file block_codec.h
+ * @brief Lossless block codec for PPG and IMU sample blocks
+ *
+ * Each channel is coded on its own: the first sample is stored raw, the
+ * rest as second-order prediction residuals (x[n] - 2 x[n-1] + x[n-2]),
+ * zigzag-mapped to unsigned. Smooth signals such as 18-bit PPG leave
+ * residuals of a few bits; the 12-bit accelerometer at rest even fewer.
+ * Residuals are then coded in whichever of two modes is smaller for the
+ * channel:
+ *
+ * - packed: groups of 16 residuals at the group's bit width (one width
+ *   byte per group), so a motion burst only widens its own group
+ * - Rice:   one parameter k for the channel; suits the near-Laplacian
+ *   residuals of quiet signals, with an escape for outliers
+ *
+ * Arithmetic wraps in 32 bits, so any int32 input round-trips exactly.
+ * Channels are read and written through strided views, so ppg_sample_t
+ * and imu_sample_t arrays are coded in place without gathering.
+ *
+ * Block layout: block_codec_header_t, then per channel a mode byte, the
+ * first sample (4 bytes, little endian) and the residual stream padded
+ * to a byte.
+ */
+
+// =============================================================================
+// Limits
+// =============================================================================
+
+#define BLOCK_CODEC_VERSION          1
+#define BLOCK_CODEC_MAX_CHANNELS     8
+#define BLOCK_CODEC_MAX_SAMPLES      256   ///< Per channel and block (residual scratch on the stack)
+#define BLOCK_CODEC_GROUP            16    ///< Residuals per packed group
+
+/** Worst-case encoded bytes: every residual at 32 bits plus group widths */
+#define BLOCK_CODEC_BOUND(channels, samples) \
+    (sizeof(block_codec_header_t) + \
+     (channels) * (5u + 4u * (samples) + ((samples) + BLOCK_CODEC_GROUP - 1u) / BLOCK_CODEC_GROUP))
+
+// =============================================================================
+// Data Structures
+// =============================================================================
+
+/**
+ * @brief Encoded block header
+ */
+typedef struct {
+    uint16_t sample_count;            ///< Samples per channel
+    uint8_t channels;
+    uint8_t version;                  ///< BLOCK_CODEC_VERSION
+} block_codec_header_t;
+
+/**
+ * @brief One channel of a sample array
+ *
+ * The encoder only reads through data; the decoder writes.
+ */
+typedef struct {
+    void* data;                       ///< First sample of the channel
+    uint16_t stride;                  ///< Bytes between samples
+    uint8_t element_size;             ///< 2 (int16_t) or 4 (int32_t)
+} block_codec_channel_t;
+
+// =============================================================================
+// Codec Functions
+// =============================================================================
+
+/**
+ * @brief Encode a block
+ *
+ * @param channels Channel views (1..BLOCK_CODEC_MAX_CHANNELS)
+ * @param channel_count Number of channels
+ * @param sample_count Samples per channel (1..BLOCK_CODEC_MAX_SAMPLES)
+ * @param out Output buffer
+ * @param capacity Output bytes (BLOCK_CODEC_BOUND always suffices)
+ * @return Encoded bytes, -1 on bad arguments or a short buffer
+ */
+int32_t block_codec_encode(const block_codec_channel_t* channels, uint32_t channel_count,
+                           uint32_t sample_count, uint8_t* out, uint32_t capacity);
+
+/**
+ * @brief Read the header of an encoded block
+ */
+bool block_codec_peek(const uint8_t* in, uint32_t length, block_codec_header_t* header);
+
+/**
+ * @brief Decode a block
+ *
+ * int16_t channels receive the low 16 bits, which restores what was
+ * encoded from an int16_t view.
+ *
+ * @param in Encoded block
+ * @param length Encoded bytes
+ * @param channels Channel views to write (count from block_codec_peek)
+ * @param channel_count Views available; must match the block
+ * @param sample_capacity Samples each view can hold
+ * @return Samples per channel, -1 on malformed input or short views
+ */
+int32_t block_codec_decode(const uint8_t* in, uint32_t length, const block_codec_channel_t* channels,
+                           uint32_t channel_count, uint32_t sample_capacity);
+
+/**
+ * @brief Views over the active LED slots of a ppg_sample_t array
+ *
+ * @param samples Samples
+ * @param led_slots Active slot mask (bits 0..3)
+ * @param channels Receives one view per active slot, lowest slot first
+ * @return Number of views
+ */
+uint32_t block_codec_ppg_channels(ppg_sample_t* samples, uint8_t led_slots,
+                                  block_codec_channel_t channels[4]);
+
+/**
+ * @brief Views over accel[3] and gyro[3] of an imu_sample_t array
+ *
+ * @param include_gyro false for accelerometer only (3 views)
+ * @return Number of views
+ */
+uint32_t block_codec_imu_channels(imu_sample_t* samples, bool include_gyro,
+                                  block_codec_channel_t channels[6]);
+
+#endif // BLOCK_CODEC_H
@@ -0,0 +1,548 @@
+/*
+ * Key-Value Configuration Store
+ *
+ * Index slots hold the key hash and a packed record position (ring
+ * sector and offset), which stays valid until compaction moves the
+ * record. Deletions use backward shifting, so probe chains never hold
+ * tombstones and stay as short as the load factor allows.
+ */
+
+#include "config_store.h"
+#include "storage_port.h"
+#include <string.h>
+
+LOG_MODULE_REGISTER(config_store, LOG_LEVEL_INF);
+
+#define FNV_OFFSET_BASIS        2166136261u
+#define FNV_PRIME               16777619u
+#define INDEX_MASK              (CONFIG_STORE_INDEX_SLOTS - 1u)
+#define SLOT_NONE               0xFFFFFFFFu
+#define HEADER_SIZE             ((uint32_t)sizeof(config_store_record_t))
+
+/* ==== PRIVATE FUNCTIONS ==== */
+
+static uint32_t fnv1a(const char* key, uint32_t length)
+{
+    uint32_t hash = FNV_OFFSET_BASIS;
+
+    for (uint32_t i = 0; i < length; i++) {
+        hash = (hash ^ (uint8_t)key[i]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+/** Log bytes taken by a record of this payload length */
+static uint32_t record_bytes(uint32_t length)
+{
+    return (uint32_t)sizeof(flash_log_record_header_t) +
+           ((length + FLASH_LOG_RECORD_ALIGN - 1u) & ~(FLASH_LOG_RECORD_ALIGN - 1u));
+}
+
+/** Bytes of current values the region can hold with compaction room to spare */
+static uint32_t capacity(const config_store_t* store)
+{
+    const flash_log_t* log = &store->log;
+    uint32_t reserved = log->config.erase_ahead + CONFIG_STORE_SLACK_SECTORS + 1u;
+
+    if (log->sector_count <= reserved) {
+        return 0;
+    }
+    return (log->sector_count - reserved) * (log->dev->sector_size - (uint32_t)sizeof(flash_log_sector_header_t));
+}
+
+static uint32_t pack(const flash_log_t* log, flash_log_pos_t pos)
+{
+    uint32_t sector = (log->tail_sector + FLASH_LOG_POS_SEQ(pos) - log->tail_sequence) % log->sector_count;
+    return sector << 16 | FLASH_LOG_POS_OFFSET(pos);
+}
+
+static flash_log_pos_t unpack(const flash_log_t* log, uint32_t where)
+{
+    uint32_t sector = where >> 16;
+    uint32_t sequence = log->tail_sequence + (sector + log->sector_count - log->tail_sector) % log->sector_count;
+    return FLASH_LOG_POS(sequence, where & 0xFFFFu);
+}
+
+static const config_store_record_t* scratch_record(const config_store_t* store)
+{
+    return (const config_store_record_t*)(const void*)store->scratch;
+}
+
+/** Payload length if the scratch holds a well-formed record of that length, else 0 */
+static uint32_t parse(const config_store_t* store, int32_t length)
+{
+    const config_store_record_t* record = scratch_record(store);
+
+    if (length < (int32_t)HEADER_SIZE || record->key_length == 0 || record->key_length > CONFIG_STORE_KEY_MAX ||
+        HEADER_SIZE + record->key_length + record->value_size != (uint32_t)length) {
+        return 0;
+    }
+    return (uint32_t)length;
+}
+
+static int32_t read_at(config_store_t* store, uint32_t where)
+{
+    flash_log_cursor_t cursor;
+
+    if (!flash_log_cursor_at(&store->log, unpack(&store->log, where), &cursor)) {
+        return -1;
+    }
+    return flash_log_read(&store->log, &cursor, store->scratch, sizeof(store->scratch), NULL);
+}
+
+/**
+ * Slot holding a key (its record left in the scratch buffer), or the
+ * free slot where it would go. The key must not point into the scratch.
+ */
+static bool find(config_store_t* store, const char* key, uint32_t key_length, uint32_t hash,
+                 uint32_t* slot, uint32_t* length)
+{
+    uint32_t i = hash & INDEX_MASK;
+
+    store->stats.lookups++;
+    while (store->index[i].where != CONFIG_STORE_SLOT_EMPTY) {
+        store->stats.probes++;
+        if (store->index[i].hash == hash) {
+            int32_t got = read_at(store, store->index[i].where);
+            store->stats.record_reads++;
+            if (got > 0 && parse(store, got) && scratch_record(store)->key_length == key_length &&
+                memcmp(scratch_record(store) + 1, key, key_length) == 0) {
+                *slot = i;
+                *length = (uint32_t)got;
+                return true;
+            }
+        }
+        i = (i + 1u) & INDEX_MASK;
+    }
+    *slot = i;
+    return false;
+}
+
+/** Slot pointing at a record position, SLOT_NONE if it is not current (no flash reads) */
+static uint32_t slot_of(const config_store_t* store, uint32_t hash, uint32_t where)
+{
+    for (uint32_t i = hash & INDEX_MASK; store->index[i].where != CONFIG_STORE_SLOT_EMPTY; i = (i + 1u) & INDEX_MASK) {
+        if (store->index[i].where == where) {
+            return i;
+        }
+    }
+    return SLOT_NONE;
+}
+
+static void remove_slot(config_store_t* store, uint32_t slot)
+{
+    uint32_t next = slot;
+
+    for (;;) {
+        store->index[slot].where = CONFIG_STORE_SLOT_EMPTY;
+        for (;;) {
+            next = (next + 1u) & INDEX_MASK;
+            if (store->index[next].where == CONFIG_STORE_SLOT_EMPTY) {
+                return;
+            }
+            // An entry stays put if its home slot lies cyclically in (slot, next]
+            uint32_t home = store->index[next].hash & INDEX_MASK;
+            if (slot <= next ? (slot < home && home <= next) : (slot < home || home <= next)) {
+                continue;
+            }
+            break;
+        }
+        store->index[slot] = store->index[next];
+        slot = next;
+    }
+}
+
+/** Apply one replayed record to the index */
+static void replay(config_store_t* store, uint8_t type, uint32_t length, uint32_t where)
+{
+    char key[CONFIG_STORE_KEY_MAX];
+    uint32_t key_length = scratch_record(store)->key_length;
+    uint32_t slot, old_length;
+
+    memcpy(key, scratch_record(store) + 1, key_length);
+    uint32_t hash = fnv1a(key, key_length);
+    bool found = find(store, key, key_length, hash, &slot, &old_length);
+
+    if (found) {
+        store->live_bytes -= record_bytes(old_length);
+    }
+    if (type == CONFIG_STORE_RECORD_DELETE) {
+        if (found) {
+            remove_slot(store, slot);
+            store->key_count--;
+        }
+        return;
+    }
+    if (!found) {
+        if (store->key_count >= CONFIG_STORE_MAX_KEYS) {
+            LOG_ERR("Config index full, key dropped");
+            return;
+        }
+        store->index[slot].hash = hash;
+        store->key_count++;
+    }
+    store->index[slot].where = where;
+    store->live_bytes += record_bytes(length);
+}
+
+/** Compact until the head has room without reaching the tail */
+static void make_room(config_store_t* store)
+{
+    flash_log_t* log = &store->log;
+
+    for (uint32_t n = 0; n < log->sector_count &&
+                         log->used_sectors + log->config.erase_ahead + CONFIG_STORE_SLACK_SECTORS >= log->sector_count;
+         n++) {
+        if (!config_store_compact(store)) {
+            break;
+        }
+    }
+}
+
+/** Append a record built in the scratch buffer */
+static bool append(config_store_t* store, uint8_t type, uint32_t length, uint32_t* where)
+{
+    flash_log_pos_t pos;
+
+    if (!flash_log_append(&store->log, type, store->scratch, length, &pos)) {
+        return false;
+    }
+    *where = pack(&store->log, pos);
+    return true;
+}
+
+/**
+ * Walk the tail sector on from compact_cursor, copying the records the
+ * index still points at, until max_moves are copied, the next record
+ * would take the bytes read past max_bytes, or copying it would take
+ * more than max_programs. The sector is dropped once walked (dropped
+ * set). A sector dropped meanwhile restarts the walk at the new tail.
+ * Returns the bytes of the records passed, -1 on errors.
+ */
+static int32_t compact_run(config_store_t* store, uint32_t max_bytes, uint32_t max_moves, uint32_t max_programs,
+                           bool* dropped)
+{
+    flash_log_t* log = &store->log;
+    flash_log_record_t info;
+    uint32_t read = 0;
+    uint32_t moves = 0;
+
+    if (!store->compacting || store->compact_cursor.sequence != log->tail_sequence) {
+        flash_log_cursor_first(log, &store->compact_cursor);
+        store->compacting = true;
+    }
+
+    while (moves < max_moves) {
+        flash_log_cursor_t cursor = store->compact_cursor;
+        int32_t length = flash_log_peek(log, &cursor, NULL, 0, &info);
+
+        if (length > 0 && FLASH_LOG_POS_SEQ(info.pos) == log->tail_sequence &&
+            read + (uint32_t)sizeof(flash_log_record_header_t) + (uint32_t)length > max_bytes) {
+            break;
+        }
+        if (length > 0) {
+            length = flash_log_read(log, &cursor, store->scratch, sizeof(store->scratch), &info);
+        }
+        if (length == 0 || cursor.sequence != log->tail_sequence ||
+            (length > 0 && FLASH_LOG_POS_SEQ(info.pos) != log->tail_sequence)) {
+            flash_log_drop_oldest(log, NULL);
+            store->compacting = false;
+            store->stats.compactions++;
+            *dropped = true;
+            return (int32_t)read;
+        }
+        if (length < 0 && length != FLASH_LOG_CORRUPT) {
+            return -1;
+        }
+        uint32_t passed = (uint32_t)sizeof(flash_log_record_header_t) + (length > 0 ? (uint32_t)length : 0u);
+        uint32_t slot = SLOT_NONE;
+
+        // Only the record the index points at is current; the rest is garbage
+        if (length > 0 && info.type == CONFIG_STORE_RECORD_SET && parse(store, length)) {
+            const config_store_record_t* record = scratch_record(store);
+            slot = slot_of(store, fnv1a((const char*)(record + 1), record->key_length), pack(log, info.pos));
+        }
+        if (slot != SLOT_NONE && flash_log_append_programs(log, (uint32_t)length) > max_programs) {
+            break;
+        }
+        store->compact_cursor = cursor;
+        read += passed;
+        if (slot == SLOT_NONE) {
+            continue;
+        }
+
+        uint32_t where;
+        if (!append(store, CONFIG_STORE_RECORD_SET, (uint32_t)length, &where)) {
+            return -1;
+        }
+        store->index[slot].where = where;
+        store->stats.relocated++;
+        moves++;
+    }
+    return (int32_t)read;
+}
+
+static uint32_t build(config_store_t* store, const char* key, uint32_t key_length, const void* value,
+                      uint32_t size, uint8_t type)
+{
+    config_store_record_t* record = (config_store_record_t*)(void*)store->scratch;
+
+    record->key_length = (uint8_t)key_length;
+    record->value_type = type;
+    record->value_size = (uint16_t)size;
+    record->timestamp = STORAGE_UPTIME_MS();
+    memcpy(record + 1, key, key_length);
+    if (size > 0) {
+        memcpy((uint8_t*)(record + 1) + key_length, value, size);
+    }
+    return HEADER_SIZE + key_length + size;
+}
+
+static bool key_ok(const char* key, uint32_t* key_length)
+{
+    if (!key) {
+        return false;
+    }
+    size_t length = strlen(key);
+    *key_length = (uint32_t)length;
+    return length > 0 && length <= CONFIG_STORE_KEY_MAX;
+}
+
+/* ==== PUBLIC FUNCTIONS ==== */
+
+bool config_store_open(config_store_t* store, const flash_device_t* dev, bool format)
+{
+    flash_log_cursor_t cursor;
+    flash_log_record_t info;
+    int32_t length;
+
+    if (!store || !dev || dev->sector_size == 0 || dev->size / dev->sector_size > 0x10000u ||
+        dev->sector_size > 0x10000u) {
+        return false;
+    }
+
+    memset(store->index, 0xFF, sizeof(store->index));
+    store->key_count = 0;
+    store->live_bytes = 0;
+    store->compacting = false;
+    memset(&store->stats, 0, sizeof(store->stats));
+
+    if (format ? !flash_log_format(&store->log, dev, NULL) : !flash_log_mount(&store->log, dev, NULL)) {
+        LOG_ERR("Config store %s failed", format ? "format" : "mount");
+        return false;
+    }
+
+    flash_log_cursor_first(&store->log, &cursor);
+    while ((length = flash_log_read(&store->log, &cursor, store->scratch, sizeof(store->scratch), &info)) != 0) {
+        if (length == FLASH_LOG_CORRUPT) {
+            continue;
+        }
+        if (length < 0) {
+            LOG_ERR("Config replay failed");
+            return false;
+        }
+        if ((info.type == CONFIG_STORE_RECORD_SET || info.type == CONFIG_STORE_RECORD_DELETE) && parse(store, length)) {
+            replay(store, info.type, (uint32_t)length, pack(&store->log, info.pos));
+            store->stats.replayed++;
+        }
+    }
+    store->stats.lookups = 0;
+    store->stats.probes = 0;
+    store->stats.record_reads = 0;
+    return true;
+}
+
+bool config_store_set(config_store_t* store, const char* key, const void* value, uint32_t size, uint8_t type)
+{
+    uint32_t key_length, slot, old_length = 0;
+
+    if (!store || !key_ok(key, &key_length) || size > CONFIG_STORE_MAX_VALUE || (size > 0 && !value)) {
+        return false;
+    }
+    const config_store_record_t* old = scratch_record(store);
+
+    uint32_t hash = fnv1a(key, key_length);
+    bool found = find(store, key, key_length, hash, &slot, &old_length);
+    if (found && old->value_type == type && old->value_size == size &&
+        (size == 0 || memcmp((const uint8_t*)(old + 1) + key_length, value, size) == 0)) {
+        store->stats.unchanged++;
+        return true;
+    }
+
+    uint32_t length = HEADER_SIZE + key_length + size;
+    uint32_t live = store->live_bytes - (found ? record_bytes(old_length) : 0u) + record_bytes(length);
+    if ((!found && store->key_count >= CONFIG_STORE_MAX_KEYS) || live > capacity(store)) {
+        LOG_WRN("Config store full, %s not stored", key);
+        return false;
+    }
+
+    uint32_t where;
+    make_room(store);
+    build(store, key, key_length, value, size, type);
+    if (!append(store, CONFIG_STORE_RECORD_SET, length, &where)) {
+        return false;
+    }
+
+    if (!found) {
+        store->index[slot].hash = hash;
+        store->key_count++;
+    }
+    store->index[slot].where = where;
+    store->live_bytes = live;
+    store->stats.sets++;
+    return true;
+}
+
+bool config_store_get(config_store_t* store, const char* key, void* value, uint32_t* size, uint8_t* type)
+{
+    uint32_t key_length, slot, length;
+
+    if (!store || !size || !key_ok(key, &key_length) ||
+        !find(store, key, key_length, fnv1a(key, key_length), &slot, &length)) {
+        return false;
+    }
+
+    const config_store_record_t* record = scratch_record(store);
+    uint32_t capacity_bytes = *size;
+    *size = record->value_size;
+    if (type) {
+        *type = record->value_type;
+    }
+    if (!value) {
+        return true;
+    }
+    if (record->value_size > capacity_bytes) {
+        return false;
+    }
+    memcpy(value, (const uint8_t*)(record + 1) + key_length, record->value_size);
+    return true;
+}
+
+bool config_store_delete(config_store_t* store, const char* key)
+{
+    uint32_t key_length, slot, old_length, where;
+
+    if (!store || !key_ok(key, &key_length) ||
+        !find(store, key, key_length, fnv1a(key, key_length), &slot, &old_length)) {
+        return false;
+    }
+
+    make_room(store);
+    uint32_t length = build(store, key, key_length, NULL, 0, 0);
+    if (!append(store, CONFIG_STORE_RECORD_DELETE, length, &where)) {
+        return false;
+    }
+
+    remove_slot(store, slot);
+    store->key_count--;
+    store->live_bytes -= record_bytes(old_length);
+    store->stats.deletes++;
+    return true;
+}
+
+int32_t config_store_list_keys(config_store_t* store, char* buffer, uint32_t buffer_size)
+{
+    uint32_t used = 0;
+    int32_t count = 0;
+
+    if (!store || !buffer) {
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < CONFIG_STORE_INDEX_SLOTS; i++) {
+        if (store->index[i].where == CONFIG_STORE_SLOT_EMPTY) {
+            continue;
+        }
+        int32_t got = read_at(store, store->index[i].where);
+        if (got <= 0 || !parse(store, got)) {
+            return -1;
+        }
+
+        uint32_t key_length = scratch_record(store)->key_length;
+        if (used + key_length + 1u > buffer_size) {
+            return -1;
+        }
+        memcpy(buffer + used, scratch_record(store) + 1, key_length);
+        buffer[used + key_length] = '\0';
+        used += key_length + 1u;
+        count++;
+    }
+    return count;
+}
+
+bool config_store_compact(config_store_t* store)
+{
+    bool dropped = false;
+
+    if (!store || !store->log.mounted || store->log.used_sectors <= 1) {
+        return false;
+    }
+    return compact_run(store, UINT32_MAX, UINT32_MAX, UINT32_MAX, &dropped) >= 0 && dropped;
+}
+
+bool config_store_gc_step(config_store_t* store, uint32_t max_bytes, uint32_t max_programs, bool* busy)
+{
+    flash_log_t* log = &store->log;
+    bool dropped = false;
+
+    *busy = false;
+    if (!log->mounted || log->used_sectors <= 1 ||
+        (!store->compacting && log->used_sectors + log->config.erase_ahead + CONFIG_STORE_SLACK_SECTORS +
+                                   CONFIG_STORE_GC_AHEAD_SECTORS < log->sector_count)) {
+        return false;
+    }
+
+    // Copies must not wait for an erase, neither a running one nor one they would need
+    if ((log->erasing || log->prepared == 0) && (flash_log_erase_step(log, busy) || *busy)) {
+        return !*busy;
+    }
+    flash_device_erase_poll(log->dev, false, busy);
+    if (*busy || log->prepared == 0) {
+        *busy = true;
+        return false;
+    }
+    int32_t read = compact_run(store, max_bytes, 1, max_programs, &dropped);
+    if (read == 0 && !dropped) {
+        // The next copy does not fit a step yet: the head moves on, or a set compacts in the foreground
+        *busy = true;
+    }
+    return read > 0 || dropped;
+}
+
+uint32_t config_store_maintain(config_store_t* store)
+{
+    if (!store || !store->log.mounted) {
+        return 0;
+    }
+    make_room(store);
+    return flash_log_maintain(&store->log, 1);
+}
+
+/* ==== STORAGE API BINDING ==== */
+
+static config_store_t* bound_config;
+
+void config_store_bind(config_store_t* store)
+{
+    bound_config = store;
+}
+
+bool storage_config_set(const char* key, const void* value, uint32_t size, uint8_t type)
+{
+    return config_store_set(bound_config, key, value, size, type);
+}
+
+bool storage_config_get(const char* key, void* value, uint32_t* size, uint8_t* type)
+{
+    return config_store_get(bound_config, key, value, size, type);
+}
+
+bool storage_config_delete(const char* key)
+{
+    return config_store_delete(bound_config, key);
+}
+
+int32_t storage_config_list_keys(char* keys_buffer, uint32_t buffer_size)
+{
+    return config_store_list_keys(bound_config, keys_buffer, buffer_size);
+}
@@ -0,0 +1,182 @@
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "flash_io/flash_log.h"
+#include "interfaces/storage_interfaces.h"
+
+/**
+ * @file config_store.h
+ * @brief Key-value configuration store with a RAM hash index
+ *
+ * Every set or delete appends one record to a flash_log on the config
+ * region: a short header, the key and the value. Nothing is updated in
+ * place, so a power cut leaves either the old or the new value.
+ *
+ * A RAM index maps FNV-1a(key) to the record of the key's current value
+ * (open addressing, linear probing, at most half full). A lookup probes
+ * the index and reads that one record, comparing the key to rule out
+ * hash collisions: O(1), whatever the number of keys. The index holds
+ * no keys, only 8 bytes per slot. It is rebuilt at mount by replaying
+ * the log, oldest first.
+ *
+ * Compaction keeps the ring from reclaiming live values: before the
+ * head needs the tail's sector, records in the tail sector that the
+ * index still points at are appended again, and the sector is dropped.
+ * Superseded values and deletions are simply left behind. Writing a
+ * value equal to the stored one appends nothing. config_store_gc_step()
+ * does the same a record at a time and a little earlier, so the
+ * incremental GC (storage_gc.h) usually leaves sets nothing to compact.
+ */
+
+// =============================================================================
+// Limits
+// =============================================================================
+
+#ifndef FLASH_CONFIG_SIZE_KB
+#define FLASH_CONFIG_SIZE_KB           64           ///< Config region budget (app_config.h)
+#endif
+
+#define CONFIG_STORE_REGION_BYTES      ((uint32_t)FLASH_CONFIG_SIZE_KB * 1024u)
+#define CONFIG_STORE_MAX_SECTORS       (CONFIG_STORE_REGION_BYTES / FLASH_SECTOR_SIZE)
+#define CONFIG_STORE_KEY_MAX           (sizeof(((config_entry_t*)0)->key) - 1u)  ///< 63 characters
+#define CONFIG_STORE_MAX_VALUE         1024u
+#define CONFIG_STORE_MAX_KEYS          512u
+#define CONFIG_STORE_INDEX_SLOTS       (2u * CONFIG_STORE_MAX_KEYS)   ///< Power of two
+#define CONFIG_STORE_SLACK_SECTORS     2u           ///< Kept free so compaction can always copy a sector
+#define CONFIG_STORE_GC_AHEAD_SECTORS  4u           ///< Background compaction starts this far ahead of a set
+
+#define CONFIG_STORE_RECORD_SET        0x03         ///< Log record types
+#define CONFIG_STORE_RECORD_DELETE     0x04
+
+// =============================================================================
+// Data Structures
+// =============================================================================
+
+/**
+ * @brief Record payload header; the key (not terminated) and value follow
+ */
+typedef struct {
+    uint8_t key_length;
+    uint8_t value_type;
+    uint16_t value_size;
+    uint32_t timestamp;               ///< Uptime ms at the update
+} config_store_record_t;
+
+#define CONFIG_STORE_MAX_RECORD        (sizeof(config_store_record_t) + CONFIG_STORE_KEY_MAX + CONFIG_STORE_MAX_VALUE)
+
+/**
+ * @brief Index slot
+ */
+typedef struct {
+    uint32_t hash;                    ///< FNV-1a of the key
+    uint32_t where;                   ///< Ring sector << 16 | offset, CONFIG_STORE_SLOT_EMPTY if free
+} config_store_slot_t;
+
+#define CONFIG_STORE_SLOT_EMPTY        0xFFFFFFFFu
+
+/**
+ * @brief Accounting
+ */
+typedef struct {
+    uint32_t lookups;
+    uint32_t probes;                  ///< Index slots examined
+    uint32_t record_reads;            ///< Flash records read by lookups
+    uint32_t sets;                    ///< Records appended by config_store_set()
+    uint32_t unchanged;               ///< Sets skipped, value already stored
+    uint32_t deletes;
+    uint32_t compactions;             ///< Sectors compacted
+    uint32_t relocated;               ///< Live records copied by compaction
+    uint32_t replayed;                ///< Records replayed by the last mount
+} config_store_stats_t;
+
+/**
+ * @brief Store instance
+ */
+typedef struct {
+    flash_log_t log;
+    config_store_slot_t index[CONFIG_STORE_INDEX_SLOTS];
+    uint32_t key_count;
+    uint32_t live_bytes;              ///< Log bytes of current values
+    uint32_t scratch[(CONFIG_STORE_MAX_RECORD + 3u) / 4u];
+    flash_log_cursor_t compact_cursor; ///< Next record of the tail sector to compact
+    bool compacting;                  ///< compact_cursor is in use
+    config_store_stats_t stats;
+} config_store_t;
+
+// =============================================================================
+// Store Functions
+// =============================================================================
+
+/**
+ * @brief Mount (or format) the store and rebuild the index
+ */
+bool config_store_open(config_store_t* store, const flash_device_t* dev, bool format);
+
+/**
+ * @brief Store a value
+ *
+ * @param key 1..CONFIG_STORE_KEY_MAX characters
+ * @param size 0..CONFIG_STORE_MAX_VALUE bytes
+ * @return false on bad arguments, full index or region, flash errors
+ */
+bool config_store_set(config_store_t* store, const char* key, const void* value, uint32_t size, uint8_t type);
+
+/**
+ * @brief Look a value up
+ *
+ * @param value Buffer, may be NULL to ask for the size
+ * @param size In: buffer bytes; out: value bytes
+ * @param type Value type, may be NULL
+ * @return false if the key is unknown or the buffer too small
+ */
+bool config_store_get(config_store_t* store, const char* key, void* value, uint32_t* size, uint8_t* type);
+
+/**
+ * @brief Remove a key
+ * @return false if the key is unknown or on flash errors
+ */
+bool config_store_delete(config_store_t* store, const char* key);
+
+/**
+ * @brief Copy every key, each terminated by '\0', in index order
+ * @return Keys copied, -1 if they do not all fit or on errors
+ */
+int32_t config_store_list_keys(config_store_t* store, char* buffer, uint32_t buffer_size);
+
+/**
+ * @brief Compact the tail sector: copy its live records to the head, drop it
+ * @return false if the head is the only sector
+ */
+bool config_store_compact(config_store_t* store);
+
+/**
+ * @brief One bounded compaction step (incremental GC)
+ *
+ * Copies at most one live record of the tail sector, reading at most
+ * max_bytes of records, or drops the sector once it has been walked.
+ * Does nothing until the ring is within CONFIG_STORE_GC_AHEAD_SECTORS of
+ * needing compaction, and never waits for an erase. Keeps the store's
+ * erase-ahead topped up first, since copies must not erase.
+ *
+ * @param max_programs Most page programs the copy may take (see
+ *                     flash_log_append_programs()); a record that needs
+ *                     more waits until the head has moved
+ * @param busy Set if compaction is due but cannot go on in this step
+ * @return true if the step did work
+ */
+bool config_store_gc_step(config_store_t* store, uint32_t max_bytes, uint32_t max_programs, bool* busy);
+
+/**
+ * @brief Background upkeep: compaction when due, erase ahead
+ * @return Sectors erased
+ */
+uint32_t config_store_maintain(config_store_t* store);
+
+/**
+ * @brief Route the storage_config_* API to a store
+ */
+void config_store_bind(config_store_t* store);
+
+#endif // CONFIG_STORE_H
@@ -0,0 +1,50 @@
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <stdint.h>
+
+/**
+ * @file crc32.h
+ * @brief CRC-32 for stored records and sensor blocks
+ *
+ * IEEE 802.3 polynomial, reflected, inverted in and out: the same value
+ * as zlib's crc32(), so host tools can check a flash dump with any
+ * standard library.
+ *
+ * The target uses a byte-at-a-time table (1 KB, const, in flash); the
+ * nRF52840 has no general-purpose CRC unit. Host builds use
+ * slicing-by-8, eight bytes per step over 8 KB of tables built at first
+ * use. Both give the same result; crc32_update_bytewise() is always
+ * available for comparison.
+ */
+
+#ifndef CRC32_SLICE_BY_8
+#ifdef __ZEPHYR__
+#define CRC32_SLICE_BY_8             0
+#else
+#define CRC32_SLICE_BY_8             1
+#endif
+#endif
+
+/**
+ * @brief Continue a CRC over more data
+ *
+ * @param crc Value so far (0 to start)
+ * @return CRC of everything fed so far
+ */
+uint32_t crc32_update(uint32_t crc, const void* data, uint32_t length);
+
+/**
+ * @brief crc32_update() one byte per table lookup
+ */
+uint32_t crc32_update_bytewise(uint32_t crc, const void* data, uint32_t length);
+
+/**
+ * @brief CRC of one buffer
+ */
+static inline uint32_t crc32_compute(const void* data, uint32_t length)
+{
+    return crc32_update(0, data, length);
+}
+
+#endif // CRC32_H
@@ -0,0 +1,219 @@
+/*
+ * Flash Region Helpers
+ *
+ * Page splitting shared by every backend, slices of a region, and the
+ * Zephyr flash map backend for the external W25Q64.
+ *
+ * The Zephyr flash API only erases blocking, so the backend defers an
+ * erase to a low-priority queue of its own. The driver holds the chip
+ * for the whole erase, which makes reads and programs meanwhile wait.
+ */
+
+#include "flash_device.h"
+#include <stddef.h>
+
+/* ==== PRIVATE FUNCTIONS ==== */
+
+static bool slice_read(const flash_device_t* dev, uint32_t addr, void* buffer, uint32_t length)
+{
+    const flash_slice_t* slice = (const flash_slice_t*)dev->context;
+    return flash_device_read(slice->parent, slice->offset + addr, buffer, length);
+}
+
+static bool slice_program(const flash_device_t* dev, uint32_t addr, const void* data, uint32_t length)
+{
+    const flash_slice_t* slice = (const flash_slice_t*)dev->context;
+    return slice->parent->ops->program(slice->parent, slice->offset + addr, data, length);
+}
+
+static bool slice_erase_sector(const flash_device_t* dev, uint32_t addr)
+{
+    const flash_slice_t* slice = (const flash_slice_t*)dev->context;
+    return flash_device_erase_sector(slice->parent, slice->offset + addr);
+}
+
+static bool slice_erase_begin(const flash_device_t* dev, uint32_t addr)
+{
+    const flash_slice_t* slice = (const flash_slice_t*)dev->context;
+    return flash_device_erase_begin(slice->parent, slice->offset + addr);
+}
+
+static bool slice_erase_poll(const flash_device_t* dev, bool wait, bool* busy)
+{
+    const flash_slice_t* slice = (const flash_slice_t*)dev->context;
+    return flash_device_erase_poll(slice->parent, wait, busy);
+}
+
+static const flash_device_ops_t slice_ops = {
+    .read = slice_read,
+    .program = slice_program,
+    .erase_sector = slice_erase_sector,
+    .erase_begin = slice_erase_begin,
+    .erase_poll = slice_erase_poll,
+};
+
+/* ==== PUBLIC FUNCTIONS ==== */
+
+bool flash_device_program(const flash_device_t* dev, uint32_t addr, const void* data, uint32_t length)
+{
+    const uint8_t* p = (const uint8_t*)data;
+
+    if (addr + length > dev->size) {
+        return false;
+    }
+
+    while (length > 0) {
+        uint32_t room = dev->page_size - addr % dev->page_size;
+        uint32_t chunk = length < room ? length : room;
+
+        if (!dev->ops->program(dev, addr, p, chunk)) {
+            return false;
+        }
+        addr += chunk;
+        p += chunk;
+        length -= chunk;
+    }
+    return true;
+}
+
+bool flash_device_erase_begin(const flash_device_t* dev, uint32_t addr)
+{
+    if (addr % dev->sector_size != 0 || addr >= dev->size) {
+        return false;
+    }
+    return dev->ops->erase_begin ? dev->ops->erase_begin(dev, addr) : dev->ops->erase_sector(dev, addr);
+}
+
+bool flash_device_erase_poll(const flash_device_t* dev, bool wait, bool* busy)
+{
+    *busy = false;
+    return dev->ops->erase_poll ? dev->ops->erase_poll(dev, wait, busy) : true;
+}
+
+bool flash_device_slice(flash_slice_t* slice, const flash_device_t* parent, uint32_t offset, uint32_t size)
+{
+    if (!slice || !parent || parent->sector_size == 0 || offset % parent->sector_size != 0 || size == 0 ||
+        size % parent->sector_size != 0 || offset > parent->size || size > parent->size - offset) {
+        return false;
+    }
+
+    slice->parent = parent;
+    slice->offset = offset;
+    slice->dev.ops = &slice_ops;
+    slice->dev.size = size;
+    slice->dev.page_size = parent->page_size;
+    slice->dev.sector_size = parent->sector_size;
+    slice->dev.context = slice;
+    slice->dev.map = parent->map ? parent->map + offset : NULL;
+    return true;
+}
+
+/* ==== ZEPHYR FLASH MAP BACKEND ==== */
+
+#ifdef __ZEPHYR__
+
+#include <zephyr/kernel.h>
+#include <zephyr/storage/flash_map.h>
+
+#define ERASE_STACK_SIZE        1024
+#define ERASE_PRIORITY          K_LOWEST_APPLICATION_THREAD_PRIO
+
+/** One erase in flight for the chip */
+static struct {
+    struct k_work work;
+    struct k_sem done;
+    const struct flash_area* area;
+    uint32_t addr;
+    uint32_t size;
+    atomic_t busy;
+    int result;
+} erase_job;
+
+static K_THREAD_STACK_DEFINE(erase_stack, ERASE_STACK_SIZE);
+static struct k_work_q erase_queue;
+static bool erase_queue_started;
+
+static void erase_handler(struct k_work* work)
+{
+    (void)work;
+    erase_job.result = flash_area_erase(erase_job.area, erase_job.addr, erase_job.size);
+    atomic_clear(&erase_job.busy);
+    k_sem_give(&erase_job.done);
+}
+
+static bool area_read(const flash_device_t* dev, uint32_t addr, void* buffer, uint32_t length)
+{
+    return flash_area_read((const struct flash_area*)dev->context, addr, buffer, length) == 0;
+}
+
+static bool area_program(const flash_device_t* dev, uint32_t addr, const void* data, uint32_t length)
+{
+    return flash_area_write((const struct flash_area*)dev->context, addr, data, length) == 0;
+}
+
+static bool area_erase_sector(const flash_device_t* dev, uint32_t addr)
+{
+    return flash_area_erase((const struct flash_area*)dev->context, addr, dev->sector_size) == 0;
+}
+
+static bool area_erase_poll(const flash_device_t* dev, bool wait, bool* busy)
+{
+    (void)dev;
+    if (wait && atomic_get(&erase_job.busy)) {
+        k_sem_take(&erase_job.done, K_FOREVER);
+    }
+    *busy = atomic_get(&erase_job.busy) != 0;
+    return *busy || erase_job.result == 0;
+}
+
+static bool area_erase_begin(const flash_device_t* dev, uint32_t addr)
+{
+    bool busy;
+
+    area_erase_poll(dev, true, &busy);
+    k_sem_reset(&erase_job.done);
+    erase_job.area = (const struct flash_area*)dev->context;
+    erase_job.addr = addr;
+    erase_job.size = dev->sector_size;
+    erase_job.result = 0;
+    atomic_set(&erase_job.busy, 1);
+    if (k_work_submit_to_queue(&erase_queue, &erase_job.work) < 0) {
+        atomic_clear(&erase_job.busy);
+        return false;
+    }
+    return true;
+}
+
+static const flash_device_ops_t area_ops = {
+    .read = area_read,
+    .program = area_program,
+    .erase_sector = area_erase_sector,
+    .erase_begin = area_erase_begin,
+    .erase_poll = area_erase_poll,
+};
+
+bool flash_device_open_area(flash_device_t* dev, uint8_t area_id)
+{
+    const struct flash_area* area;
+
+    if (!dev || flash_area_open(area_id, &area) != 0) {
+        return false;
+    }
+
+    if (!erase_queue_started) {
+        k_work_init(&erase_job.work, erase_handler);
+        k_sem_init(&erase_job.done, 0, 1);
+        k_work_queue_start(&erase_queue, erase_stack, K_THREAD_STACK_SIZEOF(erase_stack), ERASE_PRIORITY, NULL);
+        erase_queue_started = true;
+    }
+
+    dev->ops = &area_ops;
+    dev->size = (uint32_t)area->fa_size - (uint32_t)area->fa_size % FLASH_SECTOR_SIZE;
+    dev->page_size = FLASH_PAGE_SIZE;
+    dev->sector_size = FLASH_SECTOR_SIZE;
+    dev->context = (void*)area;
+    dev->map = NULL;
+    return dev->size > 0;
+}
+
+#endif
@@ -0,0 +1,124 @@
+#ifndef FLASH_DEVICE_H
+#define FLASH_DEVICE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @file flash_device.h
+ * @brief Raw NOR flash region used by the storage modules
+ *
+ * A region is a sector-aligned window of a NOR flash: programming can
+ * only clear bits, a program must not cross a page, and erase works on
+ * whole sectors. The log store and its siblings only ever see this
+ * interface, so the same code runs on the W25Q64 through the Zephyr
+ * flash map and on the host against the file-backed simulator
+ * (flash_sim.h) or a read-only mapped dump (flash_map.h).
+ *
+ * A sector erase takes ~45 ms. Backends that can start one and return
+ * (erase_begin, erase_poll) let background work erase without holding
+ * the storage thread; a read or program while it runs waits for it, as
+ * the chip does. Backends without them erase blocking.
+ */
+
+// =============================================================================
+// Geometry
+// =============================================================================
+
+#define FLASH_PAGE_SIZE              256   ///< W25Q64 program page
+#define FLASH_SECTOR_SIZE            4096  ///< W25Q64 erase sector
+#define FLASH_ERASED_BYTE            0xFF
+
+// =============================================================================
+// Data Structures
+// =============================================================================
+
+typedef struct flash_device flash_device_t;
+
+/**
+ * @brief Region operations; addresses are relative to the region start
+ */
+typedef struct {
+    bool (*read)(const flash_device_t* dev, uint32_t addr, void* buffer, uint32_t length);
+    /** Program within one page; bits already cleared stay cleared */
+    bool (*program)(const flash_device_t* dev, uint32_t addr, const void* data, uint32_t length);
+    /** Erase the sector starting at addr (blocking; ~45 ms on the W25Q64) */
+    bool (*erase_sector)(const flash_device_t* dev, uint32_t addr);
+    /** Start erasing the sector at addr and return (optional) */
+    bool (*erase_begin)(const flash_device_t* dev, uint32_t addr);
+    /** State of the erase started last: busy while it runs; wait blocks until done; false if it failed */
+    bool (*erase_poll)(const flash_device_t* dev, bool wait, bool* busy);
+} flash_device_ops_t;
+
+/**
+ * @brief Flash region descriptor
+ */
+struct flash_device {
+    const flash_device_ops_t* ops;
+    uint32_t size;                    ///< Region bytes (multiple of sector_size)
+    uint32_t page_size;               ///< Program page
+    uint32_t sector_size;             ///< Erase sector
+    void* context;                    ///< Backend state
+    const uint8_t* map;               ///< Region content in memory (mmap, XIP), NULL if not addressable
+};
+
+/**
+ * @brief Sector-aligned window of another region
+ */
+typedef struct {
+    flash_device_t dev;               ///< The window, addresses from 0
+    const flash_device_t* parent;
+    uint32_t offset;                  ///< Window start in the parent
+} flash_slice_t;
+
+// =============================================================================
+// Helpers
+// =============================================================================
+
+static inline bool flash_device_read(const flash_device_t* dev, uint32_t addr, void* buffer, uint32_t length)
+{
+    return addr + length <= dev->size && dev->ops->read(dev, addr, buffer, length);
+}
+
+/**
+ * @brief Program any range, split at page boundaries
+ */
+bool flash_device_program(const flash_device_t* dev, uint32_t addr, const void* data, uint32_t length);
+
+static inline bool flash_device_erase_sector(const flash_device_t* dev, uint32_t addr)
+{
+    return addr % dev->sector_size == 0 && addr < dev->size && dev->ops->erase_sector(dev, addr);
+}
+
+/**
+ * @brief Start a sector erase (blocking erase if the backend cannot defer it)
+ */
+bool flash_device_erase_begin(const flash_device_t* dev, uint32_t addr);
+
+/**
+ * @brief Poll the erase started by flash_device_erase_begin()
+ *
+ * @param wait Block until it is done
+ * @param busy Set while it runs
+ * @return false if it failed
+ */
+bool flash_device_erase_poll(const flash_device_t* dev, bool wait, bool* busy);
+
+/**
+ * @brief Cut a region into smaller ones (e.g. one log per slice)
+ *
+ * @param offset Slice start, a multiple of the parent's sector size
+ * @param size Slice bytes, a non-zero multiple of the sector size
+ */
+bool flash_device_slice(flash_slice_t* slice, const flash_device_t* parent, uint32_t offset, uint32_t size);
+
+#ifdef __ZEPHYR__
+/**
+ * @brief Open a fixed flash map partition as a region
+ * @param dev Descriptor to fill
+ * @param area_id Partition (FIXED_PARTITION_ID(...))
+ */
+bool flash_device_open_area(flash_device_t* dev, uint8_t area_id);
+#endif
+
+#endif // FLASH_DEVICE_H
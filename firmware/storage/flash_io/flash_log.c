@@ -0,0 +1,1032 @@
+/*
+ * Log-Structured Flash Store
+ *
+ * A ring of erase sectors: appends program at the head, upkeep prepares
+ * sectors ahead of it, and the oldest sector is dropped whole when the
+ * prepared run catches up with the tail. All positions are computed from
+ * the head, so nothing is searched on the write path.
+ */
+
+#include "flash_log.h"
+#include "crc32.h"
+#include "storage_port.h"
+#include <stddef.h>
+#include <string.h>
+
+LOG_MODULE_REGISTER(flash_log, LOG_LEVEL_INF);
+
+#define SECTOR_HEADER_SIZE      ((uint32_t)sizeof(flash_log_sector_header_t))
+#define RECORD_HEADER_SIZE      ((uint32_t)sizeof(flash_log_record_header_t))
+#define SEQUENCE_BLANK          0xFFFFFFFFu
+#define LENGTH_BLANK            0xFFFFu
+#define CRC_CHUNK               256u
+#define FIRST_PROGRAM_BYTES     FLASH_PAGE_SIZE
+#define W25Q64_ERASE_TIME_MS    45
+#define W25Q64_WEAR_CYCLES      100000
+
+typedef enum {
+    SECTOR_UNKNOWN = 0,
+    SECTOR_PREPARED,
+    SECTOR_DATA,
+} sector_state_t;
+
+/* ==== PRIVATE FUNCTIONS ==== */
+
+static uint32_t record_size(uint32_t length)
+{
+    return (RECORD_HEADER_SIZE + length + FLASH_LOG_RECORD_ALIGN - 1) & ~(FLASH_LOG_RECORD_ALIGN - 1);
+}
+
+/** CRC over the length and type, then the payload */
+static uint32_t record_crc(const flash_log_record_header_t* header, const void* data)
+{
+    uint32_t crc = crc32_update(0, header, offsetof(flash_log_record_header_t, flags));
+    return crc32_update(crc, data, header->length);
+}
+
+static uint32_t sector_addr(const flash_log_t* log, uint32_t sector)
+{
+    return sector * log->dev->sector_size;
+}
+
+static uint32_t ring_next(const flash_log_t* log, uint32_t sector, uint32_t steps)
+{
+    return (sector + steps) % log->sector_count;
+}
+
+static sector_state_t read_sector_header(flash_log_t* log, uint32_t sector, flash_log_sector_header_t* header)
+{
+    if (!flash_device_read(log->dev, sector_addr(log, sector), header, SECTOR_HEADER_SIZE)) {
+        log->stats.errors++;
+        return SECTOR_UNKNOWN;
+    }
+    if (header->magic != FLASH_LOG_MAGIC) {
+        return SECTOR_UNKNOWN;
+    }
+    if (header->erase_count > log->max_erase_count) {
+        log->max_erase_count = header->erase_count;
+    }
+    if (header->sequence == SEQUENCE_BLANK && header->sequence_check == SEQUENCE_BLANK) {
+        return SECTOR_PREPARED;
+    }
+    return header->sequence_check == ~header->sequence ? SECTOR_DATA : SECTOR_UNKNOWN;
+}
+
+/** Sector holding a sequence in the ring, if it still holds data */
+static bool sector_of(const flash_log_t* log, uint32_t sequence, uint32_t* sector)
+{
+    if (log->used_sectors == 0 || sequence < log->tail_sequence || sequence > log->head_sequence) {
+        return false;
+    }
+    *sector = ring_next(log, log->tail_sector, sequence - log->tail_sequence);
+    return true;
+}
+
+/** Clear a data sector's sequence (one 8-byte program) so mount no longer counts it */
+static bool retire_sector(flash_log_t* log, uint32_t sector)
+{
+    static const uint32_t cleared[2] = { 0, 0 };
+
+    if (!flash_device_program(log->dev, sector_addr(log, sector) + offsetof(flash_log_sector_header_t, sequence),
+                              cleared, sizeof(cleared))) {
+        log->stats.errors++;
+        return false;
+    }
+    return true;
+}
+
+static void drop_tail(flash_log_t* log)
+{
+    log->tail_sector = ring_next(log, log->tail_sector, 1);
+    log->tail_sequence++;
+    log->used_sectors--;
+    log->stats.sectors_dropped++;
+}
+
+/**
+ * Start erasing the first sector past the prepared run (it stays that
+ * sector: the head only moves into prepared sectors). Reclaims the tail
+ * when the run has reached it, unless config.keep_tail.
+ */
+static bool begin_prepare(flash_log_t* log)
+{
+    uint32_t sector = ring_next(log, log->head_sector, 1 + log->prepared);
+    flash_log_sector_header_t header;
+
+    if (log->used_sectors + log->prepared >= log->sector_count) {
+        // The head itself is never reclaimed
+        if (log->used_sectors <= 1 || log->config.keep_tail) {
+            return false;
+        }
+        drop_tail(log);
+    }
+
+    uint32_t erase_count = log->max_erase_count;
+    if (read_sector_header(log, sector, &header) != SECTOR_UNKNOWN) {
+        erase_count = header.erase_count;
+    }
+
+    if (!flash_device_erase_begin(log->dev, sector_addr(log, sector))) {
+        log->stats.errors++;
+        return false;
+    }
+    log->erasing = true;
+    log->erasing_count = erase_count + 1u;
+    return true;
+}
+
+/** Give the sector being erased its header once the erase is done (or wait for it) */
+static bool finish_prepare(flash_log_t* log, bool wait)
+{
+    uint32_t sector = ring_next(log, log->head_sector, 1 + log->prepared);
+    flash_log_sector_header_t header;
+    bool busy;
+
+    bool erased = flash_device_erase_poll(log->dev, wait, &busy);
+    if (busy) {
+        return false;
+    }
+    log->erasing = false;
+
+    memset(&header, FLASH_ERASED_BYTE, sizeof(header));
+    header.magic = FLASH_LOG_MAGIC;
+    header.erase_count = log->erasing_count;
+    if (!erased || !flash_device_program(log->dev, sector_addr(log, sector), &header,
+                                         offsetof(flash_log_sector_header_t, sequence))) {
+        log->stats.errors++;
+        return false;
+    }
+
+    if (header.erase_count > log->max_erase_count) {
+        log->max_erase_count = header.erase_count;
+    }
+    log->prepared++;
+    log->stats.sectors_erased++;
+    log->stats.bytes_programmed += offsetof(flash_log_sector_header_t, sequence);
+    return true;
+}
+
+/** Erase and prepare the next sector now, finishing an erase already running */
+static bool prepare_next(flash_log_t* log)
+{
+    return (log->erasing || begin_prepare(log)) && finish_prepare(log, true);
+}
+
+/** Make the first prepared sector the head */
+static bool open_sector(flash_log_t* log, uint32_t key)
+{
+    if (log->prepared == 0) {
+        if (!prepare_next(log)) {
+            return false;
+        }
+        log->stats.foreground_erases++;
+    }
+
+    uint32_t sector = ring_next(log, log->head_sector, 1);
+    uint32_t sequence = log->head_sequence + 1;
+    uint32_t* keys = log->config.sector_keys;
+
+    // Keep the table sorted: an unkeyed or older record inherits the head's key
+    if (keys && log->used_sectors > 0 && (key == FLASH_LOG_KEY_NONE || key < keys[log->head_sector])) {
+        key = keys[log->head_sector];
+    }
+    uint32_t seal[3] = { sequence, ~sequence, key };
+
+    if (!flash_device_program(log->dev, sector_addr(log, sector) + offsetof(flash_log_sector_header_t, sequence),
+                              seal, sizeof(seal))) {
+        log->stats.errors++;
+        return false;
+    }
+
+    if (log->used_sectors > 0) {
+        log->stats.bytes_padding += log->dev->sector_size - log->head_offset;
+    } else {
+        log->tail_sector = sector;
+        log->tail_sequence = sequence;
+    }
+    if (keys) {
+        keys[sector] = key;
+    }
+    log->head_sector = sector;
+    log->head_sequence = sequence;
+    log->head_offset = SECTOR_HEADER_SIZE;
+    log->used_sectors++;
+    log->prepared--;
+    log->stats.sectors_opened++;
+    log->stats.bytes_programmed += sizeof(seal);
+    return true;
+}
+
+/** Payload bytes that go out with the record header at addr, in its page program */
+static uint32_t lead_bytes(const flash_log_t* log, uint32_t addr, uint32_t length)
+{
+    uint32_t room = log->dev->page_size - addr % log->dev->page_size;
+    uint32_t first = room < FIRST_PROGRAM_BYTES ? room : FIRST_PROGRAM_BYTES;
+
+    first = first > RECORD_HEADER_SIZE ? first - RECORD_HEADER_SIZE : 0;
+    return first < length ? first : length;
+}
+
+static uint32_t pages_spanned(const flash_log_t* log, uint32_t addr, uint32_t length)
+{
+    return length == 0 ? 0 : (addr + length - 1u) / log->dev->page_size - addr / log->dev->page_size + 1u;
+}
+
+/** Read a record's payload from flash through the CRC */
+static bool record_intact(flash_log_t* log, uint32_t addr, const flash_log_record_header_t* header)
+{
+    uint8_t chunk[CRC_CHUNK];
+    uint32_t crc = crc32_update(0, header, offsetof(flash_log_record_header_t, flags));
+
+    for (uint32_t done = 0; done < header->length;) {
+        uint32_t length = header->length - done < CRC_CHUNK ? header->length - done : CRC_CHUNK;
+        if (!flash_device_read(log->dev, addr + RECORD_HEADER_SIZE + done, chunk, length)) {
+            log->stats.errors++;
+            return false;
+        }
+        crc = crc32_update(crc, chunk, length);
+        done += length;
+    }
+    return crc == header->crc;
+}
+
+/**
+ * Walk the head sector's records to the first blank header. A pending
+ * record, or a last record that fails its CRC, was torn by a power cut:
+ * the sector is closed there.
+ */
+static uint32_t find_head_offset(flash_log_t* log)
+{
+    uint32_t base = sector_addr(log, log->head_sector);
+    uint32_t offset = SECTOR_HEADER_SIZE;
+    uint32_t last = 0;
+    flash_log_record_header_t last_header;
+    bool torn = false;
+
+    while (offset + RECORD_HEADER_SIZE <= log->dev->sector_size) {
+        flash_log_record_header_t header;
+
+        if (!flash_device_read(log->dev, base + offset, &header, RECORD_HEADER_SIZE)) {
+            log->stats.errors++;
+            return log->dev->sector_size;
+        }
+        log->stats.mount_bytes_read += RECORD_HEADER_SIZE;
+        if (header.length == LENGTH_BLANK) {
+            break;
+        }
+        if ((header.flags & FLASH_LOG_FLAG_PENDING) || offset + record_size(header.length) > log->dev->sector_size) {
+            torn = true;
+            break;
+        }
+        last = offset;
+        last_header = header;
+        offset += record_size(header.length);
+    }
+
+    // The commit marker is programmed last, but a cut during it may leave it set over a bad payload
+    if (!torn && last != 0) {
+        log->stats.mount_bytes_read += last_header.length;
+        if (!record_intact(log, base + last, &last_header)) {
+            torn = true;
+            offset = last;
+        }
+    }
+    if (torn) {
+        LOG_WRN("Torn record at offset %u of sequence %u, sector closed", offset, log->head_sequence);
+        log->stats.torn_records++;
+        return log->dev->sector_size;
+    }
+    return offset;
+}
+
+/** Give unkeyed sectors the key before them so the table is sorted */
+static void fill_keys(flash_log_t* log)
+{
+    uint32_t* keys = log->config.sector_keys;
+    uint32_t previous = 0;
+
+    if (!keys) {
+        return;
+    }
+    for (uint32_t i = 0; i < log->used_sectors; i++) {
+        uint32_t sector = ring_next(log, log->tail_sector, i);
+        if (keys[sector] == FLASH_LOG_KEY_NONE || keys[sector] < previous) {
+            keys[sector] = previous;
+        }
+        previous = keys[sector];
+    }
+}
+
+static bool log_setup(flash_log_t* log, const flash_device_t* dev, const flash_log_config_t* config)
+{
+    if (!log || !dev || !dev->ops || dev->sector_size == 0 || dev->size < 2 * dev->sector_size) {
+        return false;
+    }
+
+    memset(log, 0, sizeof(flash_log_t));
+    log->dev = dev;
+    log->config = config ? *config : FLASH_LOG_DEFAULT_CONFIG;
+    log->sector_count = dev->size / dev->sector_size;
+    if (log->config.erase_ahead == 0 || log->config.erase_ahead >= log->sector_count - 1) {
+        return false;
+    }
+    return true;
+}
+
+/* ==== PUBLIC FUNCTIONS ==== */
+
+bool flash_log_format(flash_log_t* log, const flash_device_t* dev, const flash_log_config_t* config)
+{
+    if (!log_setup(log, dev, config)) {
+        return false;
+    }
+
+    for (uint32_t s = 0; s < log->sector_count; s++) {
+        flash_log_sector_header_t header;
+        if (read_sector_header(log, s, &header) == SECTOR_DATA && !retire_sector(log, s)) {
+            return false;
+        }
+    }
+
+    log->head_sector = log->sector_count - 1;
+    log->mounted = true;
+    flash_log_cursor_first(log, &log->scrub_cursor);
+    log->scrub_ms = STORAGE_UPTIME_MS();
+    return true;
+}
+
+bool flash_log_mount(flash_log_t* log, const flash_device_t* dev, const flash_log_config_t* config)
+{
+    uint32_t head_sequence = 0;
+    uint32_t tail_sequence = SEQUENCE_BLANK;
+    uint32_t data_sectors = 0;
+
+    if (!log_setup(log, dev, config)) {
+        return false;
+    }
+
+    for (uint32_t s = 0; s < log->sector_count; s++) {
+        flash_log_sector_header_t header;
+
+        log->stats.mount_bytes_read += SECTOR_HEADER_SIZE;
+        if (read_sector_header(log, s, &header) != SECTOR_DATA) {
+            continue;
+        }
+        data_sectors++;
+        if (log->config.sector_keys) {
+            log->config.sector_keys[s] = header.key;
+        }
+        if (header.sequence >= head_sequence) {
+            head_sequence = header.sequence;
+            log->head_sector = s;
+        }
+        if (header.sequence < tail_sequence) {
+            tail_sequence = header.sequence;
+            log->tail_sector = s;
+        }
+    }
+
+    if (data_sectors == 0) {
+        log->head_sector = log->sector_count - 1;
+    } else {
+        log->head_sequence = head_sequence;
+        log->tail_sequence = tail_sequence;
+        log->used_sectors = head_sequence - tail_sequence + 1;
+        if (log->used_sectors != data_sectors ||
+            ring_next(log, log->tail_sector, log->used_sectors - 1) != log->head_sector) {
+            LOG_WRN("Log ring has %u data sectors for sequences %u..%u",
+                    data_sectors, tail_sequence, head_sequence);
+        }
+        log->head_offset = find_head_offset(log);
+        fill_keys(log);
+    }
+
+    // Prepared run past the head; anything after it is erased on demand
+    while (log->used_sectors + log->prepared < log->sector_count) {
+        flash_log_sector_header_t header;
+        uint32_t sector = ring_next(log, log->head_sector, 1 + log->prepared);
+        if (read_sector_header(log, sector, &header) != SECTOR_PREPARED) {
+            break;
+        }
+        log->prepared++;
+    }
+
+    log->mounted = true;
+    flash_log_cursor_first(log, &log->scrub_cursor);
+    log->scrub_ms = STORAGE_UPTIME_MS();
+    LOG_INF("Flash log: %u data sectors (seq %u..%u), head at %u, %u prepared, %u bytes read",
+            log->used_sectors, log->tail_sequence, log->head_sequence, log->head_offset,
+            log->prepared, log->stats.mount_bytes_read);
+    return true;
+}
+
+bool flash_log_append(flash_log_t* log, uint8_t type, const void* data, uint32_t length,
+                      flash_log_pos_t* pos)
+{
+    return flash_log_append_keyed(log, type, FLASH_LOG_KEY_NONE, data, length, pos);
+}
+
+bool flash_log_append_keyed(flash_log_t* log, uint8_t type, uint32_t key, const void* data,
+                            uint32_t length, flash_log_pos_t* pos)
+{
+    if (!log || !log->mounted || !data || length == 0 ||
+        length > FLASH_LOG_MAX_RECORD(log->dev->sector_size)) {
+        return false;
+    }
+
+    uint32_t size = record_size(length);
+    if (log->used_sectors == 0 || log->head_offset + size > log->dev->sector_size) {
+        if (!open_sector(log, key)) {
+            return false;
+        }
+    }
+
+    uint32_t addr = sector_addr(log, log->head_sector) + log->head_offset;
+    flash_log_record_header_t header = { .length = (uint16_t)length, .type = type, .flags = 0xFF };
+    uint8_t committed = (uint8_t)~FLASH_LOG_FLAG_PENDING;
+    header.crc = record_crc(&header, data);
+
+    // The header and the payload's start share one page program
+    uint32_t lead[FIRST_PROGRAM_BYTES / sizeof(uint32_t)];
+    uint32_t first = lead_bytes(log, addr, length);
+    memcpy(lead, &header, RECORD_HEADER_SIZE);
+    memcpy((uint8_t*)lead + RECORD_HEADER_SIZE, data, first);
+
+    // Header, payload, then the commit marker: a cut anywhere leaves the record pending
+    if (!flash_device_program(log->dev, addr, lead, RECORD_HEADER_SIZE + first) ||
+        (first < length && !flash_device_program(log->dev, addr + RECORD_HEADER_SIZE + first,
+                                                 (const uint8_t*)data + first, length - first)) ||
+        !flash_device_program(log->dev, addr + offsetof(flash_log_record_header_t, flags), &committed, 1)) {
+        // Readers stop at a pending record, so nothing may follow it in this sector
+        log->head_offset = log->dev->sector_size;
+        log->stats.errors++;
+        return false;
+    }
+
+    if (pos) {
+        *pos = FLASH_LOG_POS(log->head_sequence, log->head_offset);
+    }
+    log->head_offset += size;
+    log->stats.records++;
+    log->stats.bytes_appended += length;
+    log->stats.bytes_programmed += RECORD_HEADER_SIZE + length + sizeof(committed);
+    return true;
+}
+
+uint32_t flash_log_append_programs(const flash_log_t* log, uint32_t length)
+{
+    uint32_t offset = log->head_offset;
+    uint32_t programs = 0;
+
+    if (!log->mounted || length == 0 || length > FLASH_LOG_MAX_RECORD(log->dev->sector_size)) {
+        return UINT32_MAX;
+    }
+    if (log->used_sectors == 0 || offset + record_size(length) > log->dev->sector_size) {
+        if (log->prepared == 0) {
+            return UINT32_MAX;
+        }
+        offset = SECTOR_HEADER_SIZE;
+        programs++;
+    }
+
+    // Addresses within a sector: sectors are page aligned
+    uint32_t first = lead_bytes(log, offset, length);
+    programs += pages_spanned(log, offset, RECORD_HEADER_SIZE + first);
+    programs += pages_spanned(log, offset + RECORD_HEADER_SIZE + first, length - first);
+    return programs + 1u;
+}
+
+uint32_t flash_log_maintain(flash_log_t* log, uint32_t max_erases)
+{
+    uint32_t erased = 0;
+
+    if (!log || !log->mounted) {
+        return 0;
+    }
+
+    while (erased < max_erases && log->prepared < log->config.erase_ahead) {
+        if (!prepare_next(log)) {
+            break;
+        }
+        erased++;
+        log->stats.background_erases++;
+    }
+    return erased;
+}
+
+bool flash_log_erase_step(flash_log_t* log, bool* busy)
+{
+    bool chip_busy = false;
+
+    if (busy) {
+        *busy = false;
+    }
+    if (!log || !log->mounted) {
+        return false;
+    }
+
+    if (log->erasing) {
+        if (finish_prepare(log, false)) {
+            log->stats.background_erases++;
+            return true;
+        }
+        if (busy) {
+            *busy = log->erasing;
+        }
+        return false;
+    }
+
+    if (log->prepared >= log->config.erase_ahead) {
+        return false;
+    }
+    // Reading the sector header would wait for another region's erase
+    flash_device_erase_poll(log->dev, false, &chip_busy);
+    if (chip_busy) {
+        if (busy) {
+            *busy = true;
+        }
+        return false;
+    }
+    return begin_prepare(log);
+}
+
+bool flash_log_drop_oldest(flash_log_t* log, uint32_t* sector)
+{
+    if (!log || !log->mounted || log->used_sectors <= 1) {
+        return false;
+    }
+
+    // Invalidated on flash first, or the next mount would bring it back
+    if (!retire_sector(log, log->tail_sector)) {
+        return false;
+    }
+    if (sector) {
+        *sector = log->tail_sector;
+    }
+    drop_tail(log);
+    return true;
+}
+
+bool flash_log_cursor_first(const flash_log_t* log, flash_log_cursor_t* cursor)
+{
+    if (!log || !cursor || !log->mounted) {
+        return false;
+    }
+
+    cursor->sequence = log->used_sectors ? log->tail_sequence : log->head_sequence + 1;
+    cursor->offset = SECTOR_HEADER_SIZE;
+    return true;
+}
+
+bool flash_log_cursor_at(const flash_log_t* log, flash_log_pos_t pos, flash_log_cursor_t* cursor)
+{
+    uint32_t sector;
+
+    if (!log || !cursor || !log->mounted || !sector_of(log, FLASH_LOG_POS_SEQ(pos), &sector) ||
+        FLASH_LOG_POS_OFFSET(pos) < SECTOR_HEADER_SIZE ||
+        FLASH_LOG_POS_OFFSET(pos) >= log->dev->sector_size) {
+        return false;
+    }
+    if (FLASH_LOG_POS_SEQ(pos) == log->head_sequence && FLASH_LOG_POS_OFFSET(pos) > log->head_offset) {
+        return false;
+    }
+
+    cursor->sequence = FLASH_LOG_POS_SEQ(pos);
+    cursor->offset = FLASH_LOG_POS_OFFSET(pos);
+    return true;
+}
+
+bool flash_log_seek(const flash_log_t* log, uint32_t key, flash_log_cursor_t* cursor, uint32_t* probes)
+{
+    const uint32_t* keys = log ? log->config.sector_keys : NULL;
+    uint32_t lo = 0;
+    uint32_t hi = log ? log->used_sectors : 0;
+    uint32_t count = 0;
+
+    if (!flash_log_cursor_first(log, cursor)) {
+        return false;
+    }
+
+    // Last ring position whose key is <= key: invariant keys[lo] <= key < keys[hi]
+    if (keys && hi > 0 && keys[log->tail_sector] <= key) {
+        while (hi - lo > 1) {
+            uint32_t mid = lo + (hi - lo) / 2;
+            count++;
+            if (keys[ring_next(log, log->tail_sector, mid)] <= key) {
+                lo = mid;
+            } else {
+                hi = mid;
+            }
+        }
+        cursor->sequence = log->tail_sequence + lo;
+    }
+    if (probes) {
+        *probes = count + 1;
+    }
+    return true;
+}
+
+/**
+ * Move the cursor onto the next record (skipping reclaimed sectors and
+ * sector tails) and read its header.
+ * @return 1 with a record, 0 at the head, -1 on errors
+ */
+static int32_t locate_record(flash_log_t* log, flash_log_cursor_t* cursor, uint32_t* addr,
+                             flash_log_record_header_t* header)
+{
+    while (log->used_sectors > 0 && cursor->sequence <= log->head_sequence) {
+        uint32_t sector = log->tail_sector;
+
+        if (cursor->sequence < log->tail_sequence) {
+            cursor->sequence = log->tail_sequence;
+            cursor->offset = SECTOR_HEADER_SIZE;
+        }
+        sector_of(log, cursor->sequence, &sector);
+
+        if (cursor->sequence == log->head_sequence && cursor->offset >= log->head_offset) {
+            return 0;
+        }
+
+        *addr = sector_addr(log, sector) + cursor->offset;
+        if (cursor->offset + RECORD_HEADER_SIZE > log->dev->sector_size ||
+            !flash_device_read(log->dev, *addr, header, RECORD_HEADER_SIZE) ||
+            header->length == LENGTH_BLANK || (header->flags & FLASH_LOG_FLAG_PENDING) ||
+            cursor->offset + record_size(header->length) > log->dev->sector_size) {
+            // End of a closed sector (or of one closed at a torn record)
+            cursor->sequence++;
+            cursor->offset = SECTOR_HEADER_SIZE;
+            continue;
+        }
+        return 1;
+    }
+    return 0;
+}
+
+static void fill_record(const flash_log_cursor_t* cursor, const flash_log_record_header_t* header,
+                        flash_log_record_t* record)
+{
+    if (record) {
+        record->pos = FLASH_LOG_POS(cursor->sequence, cursor->offset);
+        record->length = header->length;
+        record->type = header->type;
+    }
+}
+
+int32_t flash_log_read(flash_log_t* log, flash_log_cursor_t* cursor, void* buffer, uint32_t capacity,
+                       flash_log_record_t* record)
+{
+    flash_log_record_header_t header;
+    uint32_t addr;
+
+    if (!log || !cursor || !buffer || !log->mounted) {
+        return -1;
+    }
+
+    int32_t found = locate_record(log, cursor, &addr, &header);
+    if (found <= 0) {
+        return found;
+    }
+    if (header.length > capacity) {
+        return -1;
+    }
+    if (!flash_device_read(log->dev, addr + RECORD_HEADER_SIZE, buffer, header.length)) {
+        log->stats.errors++;
+        return -1;
+    }
+
+    fill_record(cursor, &header, record);
+    cursor->offset += record_size(header.length);
+    if (record_crc(&header, buffer) != header.crc) {
+        log->stats.corrupt_records++;
+        return FLASH_LOG_CORRUPT;
+    }
+    return header.length;
+}
+
+int32_t flash_log_read_mapped(flash_log_t* log, flash_log_cursor_t* cursor, const void** payload,
+                              flash_log_record_t* record)
+{
+    flash_log_record_header_t header;
+    uint32_t addr;
+
+    if (!log || !cursor || !payload || !log->mounted || !log->dev->map) {
+        return -1;
+    }
+
+    int32_t found = locate_record(log, cursor, &addr, &header);
+    if (found <= 0) {
+        return found;
+    }
+
+    fill_record(cursor, &header, record);
+    cursor->offset += record_size(header.length);
+    *payload = log->dev->map + addr + RECORD_HEADER_SIZE;
+    if (record_crc(&header, *payload) != header.crc) {
+        log->stats.corrupt_records++;
+        return FLASH_LOG_CORRUPT;
+    }
+    return header.length;
+}
+
+int32_t flash_log_peek(flash_log_t* log, flash_log_cursor_t* cursor, void* buffer, uint32_t capacity,
+                       flash_log_record_t* record)
+{
+    flash_log_record_header_t header;
+    uint32_t addr;
+
+    if (!log || !cursor || !log->mounted) {
+        return -1;
+    }
+
+    int32_t found = locate_record(log, cursor, &addr, &header);
+    if (found <= 0) {
+        return found;
+    }
+    uint32_t copy = header.length < capacity ? header.length : capacity;
+    if (copy > 0 && (!buffer || !flash_device_read(log->dev, addr + RECORD_HEADER_SIZE, buffer, copy))) {
+        log->stats.errors++;
+        return -1;
+    }
+
+    fill_record(cursor, &header, record);
+    return header.length;
+}
+
+bool flash_log_skip(flash_log_t* log, flash_log_cursor_t* cursor)
+{
+    flash_log_record_header_t header;
+    uint32_t addr;
+
+    if (!log || !cursor || !log->mounted || locate_record(log, cursor, &addr, &header) <= 0) {
+        return false;
+    }
+    cursor->offset += record_size(header.length);
+    return true;
+}
+
+uint32_t flash_log_scrub(flash_log_t* log, uint32_t max_bytes, uint32_t* corrupt)
+{
+    flash_log_record_header_t header;
+    uint32_t addr;
+    uint32_t used = 0;
+    uint32_t found = 0;
+
+    if (!log || !log->mounted) {
+        return 0;
+    }
+
+    for (;;) {
+        if (locate_record(log, &log->scrub_cursor, &addr, &header) <= 0) {
+            // Past the head: the next call starts over at the tail
+            if (log->used_sectors > 0) {
+                log->stats.scrub_passes++;
+            }
+            flash_log_cursor_first(log, &log->scrub_cursor);
+            break;
+        }
+
+        uint32_t size = RECORD_HEADER_SIZE + header.length;
+        if (used + size > max_bytes) {
+            break;
+        }
+        used += size;
+        if (!record_intact(log, addr, &header)) {
+            LOG_WRN("Corrupt record at offset %u of sequence %u",
+                    log->scrub_cursor.offset, log->scrub_cursor.sequence);
+            log->stats.corrupt_records++;
+            found++;
+        }
+        log->scrub_cursor.offset += record_size(header.length);
+    }
+
+    log->stats.bytes_scrubbed += used;
+    if (corrupt) {
+        *corrupt = found;
+    }
+    return used;
+}
+
+void flash_log_usage(const flash_log_t* log, uint32_t* used_bytes, uint32_t* free_bytes)
+{
+    uint32_t usable = (log->sector_count - log->config.erase_ahead) * log->dev->sector_size;
+    uint32_t used = log->used_sectors * log->dev->sector_size;
+
+    if (log->used_sectors > 0) {
+        used -= log->dev->sector_size - log->head_offset;
+    }
+    if (used_bytes) {
+        *used_bytes = used;
+    }
+    if (free_bytes) {
+        *free_bytes = used < usable ? usable - used : 0;
+    }
+}
+
+float flash_log_write_amplification(const flash_log_t* log)
+{
+    if (log->stats.bytes_appended == 0) {
+        return 0.0f;
+    }
+    return (float)log->stats.bytes_programmed / (float)log->stats.bytes_appended;
+}
+
+bool flash_log_wear(flash_log_t* log, uint32_t* min_erases, uint32_t* max_erases)
+{
+    uint32_t lo = UINT32_MAX;
+    uint32_t hi = 0;
+
+    if (!log || !log->mounted) {
+        return false;
+    }
+
+    for (uint32_t s = 0; s < log->sector_count; s++) {
+        flash_log_sector_header_t header;
+        uint32_t count = read_sector_header(log, s, &header) == SECTOR_UNKNOWN ? 0 : header.erase_count;
+        lo = count < lo ? count : lo;
+        hi = count > hi ? count : hi;
+    }
+    if (min_erases) {
+        *min_erases = lo;
+    }
+    if (max_erases) {
+        *max_erases = hi;
+    }
+    return true;
+}
+
+/* ==== STORAGE OPS BINDING ==== */
+
+static flash_log_t* bound_log;
+static const flash_device_t* bound_dev;
+static flash_log_config_t bound_config;
+
+/** Config of the mounted log, else the one it had when bound; a copy, as format clears the log */
+static const flash_log_config_t* ops_config(void)
+{
+    if (bound_log->mounted) {
+        bound_config = bound_log->config;
+    }
+    return &bound_config;
+}
+
+static bool ops_init(void)
+{
+    return flash_log_mount(bound_log, bound_dev, ops_config());
+}
+
+static bool ops_deinit(void)
+{
+    bound_log->mounted = false;
+    return true;
+}
+
+static bool ops_format(void)
+{
+    return flash_log_format(bound_log, bound_dev, ops_config());
+}
+
+static bool ops_get_info(storage_info_t* info)
+{
+    uint32_t free_bytes = 0;
+
+    if (!info || !bound_log->mounted) {
+        return false;
+    }
+
+    flash_log_usage(bound_log, NULL, &free_bytes);
+    memset(info, 0, sizeof(storage_info_t));
+    info->type = STORAGE_TYPE_PERSISTENT;
+    info->access_patterns[0] = STORAGE_ACCESS_RING_BUFFER;
+    info->access_patterns[1] = STORAGE_ACCESS_SEQUENTIAL;
+    info->total_size_bytes = bound_dev->size;
+    info->free_size_bytes = free_bytes;
+    info->block_size = bound_dev->page_size;
+    info->erase_size = bound_dev->sector_size;
+    info->erase_time_ms = W25Q64_ERASE_TIME_MS;
+    info->wear_cycles = W25Q64_WEAR_CYCLES;
+    info->supports_wear_leveling = true;
+    return true;
+}
+
+static bool ops_get_stats(storage_stats_t* stats)
+{
+    const flash_log_stats_t* s = &bound_log->stats;
+    uint64_t opened = (uint64_t)s->sectors_opened * bound_dev->sector_size;
+
+    if (!stats) {
+        return false;
+    }
+
+    memset(stats, 0, sizeof(storage_stats_t));
+    stats->bytes_written = (uint32_t)s->bytes_appended;
+    stats->write_cycles = s->records;
+    stats->erase_cycles = s->sectors_erased;
+    stats->errors = s->errors;
+    stats->fragmentation_percent = opened ? 100.0f * (float)s->bytes_padding / (float)opened : 0.0f;
+    return true;
+}
+
+static int32_t ops_read(uint32_t offset, void* buffer, uint32_t size)
+{
+    return flash_device_read(bound_dev, offset, buffer, size) ? (int32_t)size : -1;
+}
+
+static int32_t ops_write(uint32_t offset, const void* data, uint32_t size)
+{
+    (void)offset;
+    return flash_log_append(bound_log, 0, data, size, NULL) ? (int32_t)size : -1;
+}
+
+static bool ops_erase(uint32_t offset, uint32_t size)
+{
+    (void)offset;
+    (void)size;
+    return false;
+}
+
+static bool ops_sync(void)
+{
+    // Appends are programmed before they return
+    return bound_log->mounted;
+}
+
+static bool ops_set_power_mode(uint32_t mode)
+{
+    (void)mode;
+    return true;
+}
+
+static bool ops_enable_compression(bool enable)
+{
+    return !enable;
+}
+
+static bool ops_enable_encryption(bool enable, const uint8_t* key)
+{
+    (void)key;
+    return !enable;
+}
+
+static bool ops_maintain(void)
+{
+    flash_log_maintain(bound_log, bound_log->config.erase_ahead);
+    return bound_log->prepared >= bound_log->config.erase_ahead;
+}
+
+static bool ops_garbage_collect(void)
+{
+    uint32_t errors = bound_log->stats.errors;
+
+    flash_log_erase_step(bound_log, NULL);
+    return bound_log->mounted && bound_log->stats.errors == errors;
+}
+
+static bool ops_verify_integrity(void)
+{
+    flash_log_t* log = bound_log;
+    uint32_t rate = log->config.scrub_bytes_per_s;
+    uint32_t cap = rate > bound_dev->sector_size ? rate : bound_dev->sector_size;
+    uint32_t now = STORAGE_UPTIME_MS();
+    uint32_t errors = log->stats.errors;
+    uint32_t corrupt = 0;
+
+    if (!log->mounted) {
+        return false;
+    }
+
+    // Budget earned since the last step; a long gap does not become a long scrub
+    uint64_t credit = log->scrub_credit + (uint64_t)(now - log->scrub_ms) * rate / 1000u;
+    log->scrub_credit = credit > cap ? cap : (uint32_t)credit;
+    log->scrub_ms = now;
+    log->scrub_credit -= flash_log_scrub(log, log->scrub_credit, &corrupt);
+    return corrupt == 0 && log->stats.errors == errors;
+}
+
+static storage_ops_t flash_log_ops = {
+    .init = ops_init,
+    .deinit = ops_deinit,
+    .format = ops_format,
+    .get_info = ops_get_info,
+    .get_stats = ops_get_stats,
+    .read = ops_read,
+    .write = ops_write,
+    .erase = ops_erase,
+    .sync = ops_sync,
+    .set_power_mode = ops_set_power_mode,
+    .enable_compression = ops_enable_compression,
+    .enable_encryption = ops_enable_encryption,
+    .garbage_collect = ops_garbage_collect,
+    .wear_level = ops_maintain,
+    .verify_integrity = ops_verify_integrity,
+};
+
+storage_ops_t* flash_log_storage_bind(flash_log_t* log, const flash_device_t* dev)
+{
+    if (!log || !dev) {
+        return NULL;
+    }
+    bound_log = log;
+    bound_dev = dev;
+    bound_config = log->mounted ? log->config : FLASH_LOG_DEFAULT_CONFIG;
+    return &flash_log_ops;
+}
@@ -0,0 +1,420 @@
+#ifndef FLASH_LOG_H
+#define FLASH_LOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "flash_device.h"
+#include "interfaces/storage_interfaces.h"
+
+/**
+ * @file flash_log.h
+ * @brief Log-structured append-only store for sensor streams
+ *
+ * The region is used as a ring of erase sectors. Records are appended at
+ * the head and never rewritten; when the ring is full the oldest sector
+ * is reclaimed whole, so no live data is ever copied and the flash sees
+ * each byte programmed once (write amplification ~1 plus headers).
+ * Sectors are taken strictly in ring order, so every sector is erased
+ * once per lap: wear is level across the whole region by construction.
+ *
+ * Sector layout: a 20-byte header, then records, each an 8-byte header and
+ * its payload padded to 4 bytes. The sector header is written in two steps:
+ * magic and erase count right after the erase, then the sequence number
+ * (and its complement) and the key of its first record when the sector
+ * becomes the head. A sector is therefore one of
+ *
+ * - data:     valid sequence; the ring runs from the lowest to the highest
+ * - prepared: erased with header, sequence still blank; ready for the head
+ * - unknown:  blank or torn (erase interrupted), erased again before use
+ *
+ * Erasing takes ~45 ms per sector on the W25Q64. flash_log_maintain(),
+ * called from a low-priority work item, keeps erase_ahead sectors
+ * prepared past the head so appends only program pages; an append that
+ * outruns it erases in the foreground and is counted. flash_log_erase_step()
+ * does the same work split at the erase, for pause-bounded GC slices.
+ *
+ * Mount reads the 20-byte header of every sector and walks the record
+ * headers of the head sector only: 30 KB of flash for 6 MB.
+ *
+ * Records survive power loss: the header carries a CRC-32 of the length,
+ * type and payload, and the commit marker (FLASH_LOG_FLAG_PENDING in the
+ * flags byte) is cleared by a separate one-byte program once the payload
+ * is on flash (the header shares its page program with the start of the
+ * payload, so a small record costs two programs). A record still
+ * pending was torn by a power cut, and so is a committed one whose CRC
+ * fails when it is the last. Mount checks the last record of the head
+ * sector and, if it is torn, closes the sector there: readers stop at a
+ * pending record, and the next append opens a new sector rather than
+ * program over half-written bytes. Reads verify every record's CRC;
+ * flash_log_scrub() walks the ring in the background to find bit rot
+ * before a reader does.
+ *
+ * Keys: appends may carry a caller key (a timestamp for sensor blocks).
+ * The key of the first record in each sector is stored in the sector
+ * header, and with a key table configured it is also kept in RAM, one
+ * word per sector (0.1% of the data it indexes). flash_log_seek() then
+ * binary-searches the ring for a key. The mount scan fills the table
+ * from the headers it reads anyway, so rebuilding the index after a
+ * reboot costs no extra flash reads. Keys must not decrease; a smaller
+ * key is raised to the head's so the table stays sorted.
+ */
+
+// =============================================================================
+// Limits and Layout
+// =============================================================================
+
+#ifndef FLASH_LOG_SIZE_MB
+#define FLASH_LOG_SIZE_MB            6     ///< Sensor log budget (app_config.h)
+#endif
+
+#define FLASH_LOG_REGION_BYTES       ((uint32_t)FLASH_LOG_SIZE_MB * 1024u * 1024u)
+
+#define FLASH_LOG_MAGIC              0x32474C46u  ///< "FLG2"
+#define FLASH_LOG_RECORD_ALIGN       4u
+#define FLASH_LOG_ERASE_AHEAD        2     ///< Default sectors kept prepared
+#define FLASH_LOG_KEY_NONE           0xFFFFFFFFu  ///< Append without a key
+#define FLASH_LOG_MAX_SECTORS        (FLASH_LOG_REGION_BYTES / FLASH_SECTOR_SIZE)
+#define FLASH_LOG_SCRUB_RATE         2048  ///< Default scrub budget, bytes per second
+#define FLASH_LOG_FLAG_PENDING       0x01u ///< Set until the record is committed
+#define FLASH_LOG_CORRUPT            (-2)  ///< flash_log_read(): record failed its CRC
+
+/** Logical position: sector sequence and byte offset, ordered like the log */
+typedef uint64_t flash_log_pos_t;
+
+#define FLASH_LOG_POS(seq, offset)   (((flash_log_pos_t)(seq) << 32) | (uint32_t)(offset))
+#define FLASH_LOG_POS_SEQ(pos)       ((uint32_t)((pos) >> 32))
+#define FLASH_LOG_POS_OFFSET(pos)    ((uint32_t)(pos))
+
+// =============================================================================
+// On-Flash Format
+// =============================================================================
+
+/**
+ * @brief Sector header
+ */
+typedef struct {
+    uint32_t magic;                   ///< FLASH_LOG_MAGIC once erased and prepared
+    uint32_t erase_count;             ///< Erases of this sector, written with the magic
+    uint32_t sequence;                ///< Ring order, written when the sector becomes the head
+    uint32_t sequence_check;          ///< ~sequence: a torn sequence write does not validate
+    uint32_t key;                     ///< Key of the first record (FLASH_LOG_KEY_NONE if unkeyed)
+} flash_log_sector_header_t;
+
+/**
+ * @brief Record header
+ */
+typedef struct {
+    uint16_t length;                  ///< Payload bytes (0xFFFF: erased, end of sector)
+    uint8_t type;                     ///< Caller tag (stream or sensor type)
+    uint8_t flags;                    ///< 0xFF as appended; FLASH_LOG_FLAG_PENDING cleared to commit
+    uint32_t crc;                     ///< CRC-32 of length, type and payload
+} flash_log_record_header_t;
+
+/** Largest payload of one record */
+#define FLASH_LOG_MAX_RECORD(sector_size) \
+    ((sector_size) - sizeof(flash_log_sector_header_t) - sizeof(flash_log_record_header_t))
+
+// =============================================================================
+// Data Structures
+// =============================================================================
+
+/**
+ * @brief Log configuration
+ */
+typedef struct {
+    uint32_t erase_ahead;             ///< Sectors kept prepared past the head
+    uint32_t* sector_keys;            ///< Optional RAM key table, one entry per sector (NULL: no seek)
+    uint32_t scrub_bytes_per_s;       ///< Flash read budget of the storage_ops_t scrub
+    bool keep_tail;                   ///< A full ring refuses appends instead of reclaiming its oldest sector
+} flash_log_config_t;
+
+static const flash_log_config_t FLASH_LOG_DEFAULT_CONFIG = {
+    .erase_ahead = FLASH_LOG_ERASE_AHEAD,
+    .sector_keys = NULL,
+    .scrub_bytes_per_s = FLASH_LOG_SCRUB_RATE,
+    .keep_tail = false
+};
+
+/**
+ * @brief Write accounting since mount
+ */
+typedef struct {
+    uint64_t bytes_appended;          ///< Payload handed to flash_log_append()
+    uint64_t bytes_programmed;        ///< Payload plus record and sector headers
+    uint64_t bytes_padding;           ///< Sector tails left empty when a record did not fit
+    uint32_t records;
+    uint32_t sectors_opened;
+    uint32_t sectors_erased;
+    uint32_t background_erases;       ///< Done by flash_log_maintain()
+    uint32_t foreground_erases;       ///< An append had to wait for an erase
+    uint32_t sectors_dropped;         ///< Oldest sectors reclaimed for new data
+    uint32_t mount_bytes_read;        ///< Flash read by the last mount
+    uint32_t errors;                  ///< Failed flash operations
+    uint32_t torn_records;            ///< Found by mount (power cut during an append)
+    uint32_t corrupt_records;         ///< Failed their CRC on read or scrub
+    uint64_t bytes_scrubbed;
+    uint32_t scrub_passes;            ///< Complete scrubs of the ring
+} flash_log_stats_t;
+
+/**
+ * @brief Read position (advanced by flash_log_read)
+ */
+typedef struct {
+    uint32_t sequence;
+    uint32_t offset;
+} flash_log_cursor_t;
+
+/**
+ * @brief Log instance
+ *
+ * Sectors tail..head (ring order) hold data; head + 1 .. head + prepared
+ * are erased and ready. An empty log has used_sectors 0 and its next
+ * sector at head_sector + 1.
+ */
+typedef struct {
+    const flash_device_t* dev;
+    flash_log_config_t config;
+    uint32_t sector_count;
+    uint32_t head_sector;             ///< Sector being filled
+    uint32_t head_sequence;           ///< Its sequence (last one issued)
+    uint32_t head_offset;             ///< Next record offset in the head sector
+    uint32_t tail_sector;             ///< Oldest sector with data
+    uint32_t tail_sequence;
+    uint32_t used_sectors;            ///< Sectors tail..head (0: empty)
+    uint32_t prepared;                ///< Prepared sectors after the head
+    uint32_t max_erase_count;         ///< Highest erase count seen
+    flash_log_cursor_t scrub_cursor;  ///< Next record flash_log_scrub() checks
+    uint32_t scrub_credit;            ///< Scrub bytes earned and not yet spent
+    uint32_t scrub_ms;                ///< Uptime of the last storage_ops_t scrub
+    bool erasing;                     ///< Sector head + 1 + prepared is being erased (flash_log_erase_step)
+    uint32_t erasing_count;           ///< Erase count its header will carry
+    flash_log_stats_t stats;
+    bool mounted;
+} flash_log_t;
+
+/**
+ * @brief Record returned by flash_log_read
+ */
+typedef struct {
+    flash_log_pos_t pos;              ///< Position of the record header
+    uint16_t length;                  ///< Payload bytes
+    uint8_t type;
+} flash_log_record_t;
+
+// =============================================================================
+// Log Functions
+// =============================================================================
+
+/**
+ * @brief Discard all data and mount an empty log
+ *
+ * Data sectors are invalidated by clearing their sequence (one 8-byte
+ * program each) rather than erased, so formatting takes milliseconds;
+ * flash_log_maintain() erases them as the head reaches them.
+ *
+ * @param config Configuration (NULL for FLASH_LOG_DEFAULT_CONFIG)
+ */
+bool flash_log_format(flash_log_t* log, const flash_device_t* dev, const flash_log_config_t* config);
+
+/**
+ * @brief Recover the log from flash
+ *
+ * Scans sector headers for the tail, head and prepared run, then walks
+ * the head sector's record headers for the write offset. Never erases:
+ * unknown sectors are erased by flash_log_maintain() before use.
+ *
+ * @param config Configuration (NULL for FLASH_LOG_DEFAULT_CONFIG)
+ */
+bool flash_log_mount(flash_log_t* log, const flash_device_t* dev, const flash_log_config_t* config);
+
+/**
+ * @brief Append one record at the head
+ *
+ * O(1): one header and one payload program, plus opening the next
+ * prepared sector when the head is full.
+ *
+ * @param log Log
+ * @param type Caller tag
+ * @param data Payload
+ * @param length Payload bytes (1..FLASH_LOG_MAX_RECORD)
+ * @param pos Position of the record, may be NULL
+ */
+bool flash_log_append(flash_log_t* log, uint8_t type, const void* data, uint32_t length,
+                      flash_log_pos_t* pos);
+
+/**
+ * @brief Append one record with a key
+ *
+ * As flash_log_append(); if the record opens a sector, its key goes into
+ * the sector header and the key table.
+ *
+ * @param key Non-decreasing key, e.g. the block's first timestamp
+ */
+bool flash_log_append_keyed(flash_log_t* log, uint8_t type, uint32_t key, const void* data,
+                            uint32_t length, flash_log_pos_t* pos);
+
+/**
+ * @brief Page programs an append of length bytes would take now
+ *
+ * Header, payload and commit marker, plus the sector seal if the record
+ * opens a new sector. Lets bounded background work (storage_gc.h) skip
+ * an append that would not fit its pause budget.
+ *
+ * @return Programs, UINT32_MAX if the append would have to erase first
+ */
+uint32_t flash_log_append_programs(const flash_log_t* log, uint32_t length);
+
+/**
+ * @brief Background upkeep: erase and prepare sectors ahead of the head
+ *
+ * Drops the oldest sector when the prepared run reaches the tail.
+ *
+ * @param max_erases Most sectors to erase in this call (each ~45 ms)
+ * @return Sectors erased
+ */
+uint32_t flash_log_maintain(flash_log_t* log, uint32_t max_erases);
+
+/**
+ * @brief Erase-ahead in steps that never wait for the flash
+ *
+ * One step either starts erasing the next sector (a header read and the
+ * erase command) or, once that erase is done, programs its header. An
+ * append that needs the sector first finishes the erase. Meant for the
+ * incremental GC (storage_gc.h); devices without erase_begin erase
+ * blocking in the starting step.
+ *
+ * @param busy Set if work is pending but the flash is busy erasing, may be NULL
+ * @return true if the step did work
+ */
+bool flash_log_erase_step(flash_log_t* log, bool* busy);
+
+/**
+ * @brief Drop the oldest data sector now (eviction)
+ *
+ * O(1): its header's sequence is cleared (one 8-byte program, as in
+ * flash_log_format()) so a remount does not bring it back, and the
+ * sector is erased when the ring reaches it again. The head is never
+ * dropped.
+ *
+ * @param sector Sector dropped, may be NULL
+ * @return false if the head is the only data sector
+ */
+bool flash_log_drop_oldest(flash_log_t* log, uint32_t* sector);
+
+/**
+ * @brief Cursor at the oldest record
+ */
+bool flash_log_cursor_first(const flash_log_t* log, flash_log_cursor_t* cursor);
+
+/**
+ * @brief Cursor at a position returned by flash_log_append() or flash_log_read()
+ * @return false if the position has been reclaimed or is past the head
+ */
+bool flash_log_cursor_at(const flash_log_t* log, flash_log_pos_t pos, flash_log_cursor_t* cursor);
+
+/**
+ * @brief Cursor at the start of the last sector whose first key is <= key
+ *
+ * O(log n) probes of the RAM key table, no flash reads. Records before
+ * the key may follow the cursor; the caller skips them. A key older than
+ * the tail gives the tail. Without a key table this is cursor_first.
+ *
+ * @param probes Table entries examined, may be NULL
+ */
+bool flash_log_seek(const flash_log_t* log, uint32_t key, flash_log_cursor_t* cursor, uint32_t* probes);
+
+/**
+ * @brief Read the record at the cursor and advance
+ *
+ * A cursor whose sector has been reclaimed jumps to the tail. The
+ * payload's CRC is checked; a corrupt record is counted and skipped.
+ *
+ * @return Payload bytes, 0 at the head, -1 if capacity is too small or on
+ *         errors, FLASH_LOG_CORRUPT if the record failed its CRC (the
+ *         cursor is past it)
+ */
+int32_t flash_log_read(flash_log_t* log, flash_log_cursor_t* cursor, void* buffer, uint32_t capacity,
+                       flash_log_record_t* record);
+
+/**
+ * @brief Record at the cursor in place, and advance (memory-mapped devices)
+ *
+ * As flash_log_read() without the copy: payload points into dev->map
+ * (4-byte aligned when the map is). The CRC is checked.
+ *
+ * @param payload Set to the record's payload
+ * @return Payload bytes, 0 at the head, -1 on errors or if the device is
+ *         not mapped, FLASH_LOG_CORRUPT as flash_log_read()
+ */
+int32_t flash_log_read_mapped(flash_log_t* log, flash_log_cursor_t* cursor, const void** payload,
+                              flash_log_record_t* record);
+
+/**
+ * @brief Read the start of the record at the cursor without advancing
+ *
+ * Copies up to capacity payload bytes (e.g. just a block header) so the
+ * caller can decide between flash_log_read() and flash_log_skip(). The
+ * CRC is not checked (that needs the whole payload).
+ *
+ * @return Full payload bytes, 0 at the head, -1 on errors
+ */
+int32_t flash_log_peek(flash_log_t* log, flash_log_cursor_t* cursor, void* buffer, uint32_t capacity,
+                       flash_log_record_t* record);
+
+/**
+ * @brief Advance past the record at the cursor
+ * @return false at the head or on errors
+ */
+bool flash_log_skip(flash_log_t* log, flash_log_cursor_t* cursor);
+
+/**
+ * @brief Check the CRC of stored records, continuing from the last call
+ *
+ * Walks the ring oldest to newest, a whole record at a time, and starts
+ * over at the tail after the head. A reclaimed position jumps to the
+ * tail. Corrupt records are counted (stats.corrupt_records) and logged;
+ * readers skip them.
+ *
+ * @param max_bytes Most flash bytes to read; a record that does not fit
+ *                  is left for the next call
+ * @param corrupt Corrupt records found by this call, may be NULL
+ * @return Bytes read
+ */
+uint32_t flash_log_scrub(flash_log_t* log, uint32_t max_bytes, uint32_t* corrupt);
+
+/**
+ * @brief Bytes of data sectors (tail to head), and free bytes for new data
+ */
+void flash_log_usage(const flash_log_t* log, uint32_t* used_bytes, uint32_t* free_bytes);
+
+/**
+ * @brief Programmed bytes per appended payload byte
+ */
+float flash_log_write_amplification(const flash_log_t* log);
+
+/**
+ * @brief Lowest and highest erase count from the sector headers
+ *
+ * Reads every sector header (same cost as a mount scan).
+ */
+bool flash_log_wear(flash_log_t* log, uint32_t* min_erases, uint32_t* max_erases);
+
+/**
+ * @brief storage_ops_t over a log
+ *
+ * storage_ops_t has no instance argument, so the ops act on the log bound
+ * last. init() mounts it on dev with the config it was last mounted with
+ * (sector_keys table included), or the default if it never was; write()
+ * appends one record (type 0) and ignores the offset; read() reads the
+ * raw region; garbage_collect() is one flash_log_erase_step() and
+ * wear_level() runs flash_log_maintain(); erase() is refused (the log
+ * reclaims by itself). verify_integrity() is one background scrub step,
+ * meant for a work item about once a second: it scrubs what
+ * config.scrub_bytes_per_s has earned since the last call (capped at one
+ * second's worth, or one sector if larger, so any record fits) and
+ * returns false if that found a corrupt record.
+ */
+storage_ops_t* flash_log_storage_bind(flash_log_t* log, const flash_device_t* dev);
+
+#endif // FLASH_LOG_H
@@ -0,0 +1,114 @@
+/*
+ * Memory-Mapped Flash Images
+ *
+ * The file is mapped once, shared and read-only; regions are plain
+ * pointers into it. The kernel pages the file in on demand and is told
+ * access is sequential, so scanning an archive larger than RAM streams
+ * through the page cache.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "flash_map.h"
+#include "storage_port.h"
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* ==== PRIVATE FUNCTIONS ==== */
+
+static bool map_read(const flash_device_t* dev, uint32_t addr, void* buffer, uint32_t length)
+{
+    memcpy(buffer, dev->map + addr, length);
+    return true;
+}
+
+static bool map_program(const flash_device_t* dev, uint32_t addr, const void* data, uint32_t length)
+{
+    (void)dev;
+    (void)addr;
+    (void)data;
+    (void)length;
+    return false;
+}
+
+static bool map_erase_sector(const flash_device_t* dev, uint32_t addr)
+{
+    (void)dev;
+    (void)addr;
+    return false;
+}
+
+static const flash_device_ops_t map_ops = {
+    .read = map_read,
+    .program = map_program,
+    .erase_sector = map_erase_sector,
+};
+
+/* ==== PUBLIC FUNCTIONS ==== */
+
+bool flash_map_open(flash_map_t* map, const char* path)
+{
+    struct stat st;
+
+    if (!map || !path) {
+        return false;
+    }
+
+    memset(map, 0, sizeof(flash_map_t));
+    map->fd = open(path, O_RDONLY);
+    if (map->fd < 0) {
+        LOG_ERR("Cannot open flash image %s", path);
+        return false;
+    }
+    if (fstat(map->fd, &st) != 0 || st.st_size <= 0) {
+        LOG_ERR("Flash image %s is empty", path);
+        close(map->fd);
+        return false;
+    }
+
+    void* base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, map->fd, 0);
+    if (base == MAP_FAILED) {
+        LOG_ERR("Cannot map flash image %s", path);
+        close(map->fd);
+        return false;
+    }
+    posix_madvise(base, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+
+    map->base = (const uint8_t*)base;
+    map->size = (uint64_t)st.st_size;
+    return true;
+}
+
+void flash_map_close(flash_map_t* map)
+{
+    if (!map || !map->base) {
+        return;
+    }
+    munmap((void*)map->base, (size_t)map->size);
+    close(map->fd);
+    memset(map, 0, sizeof(flash_map_t));
+}
+
+bool flash_map_region(const flash_map_t* map, uint64_t offset, uint32_t size, flash_device_t* dev)
+{
+    if (!map || !map->base || !dev || offset % 4 != 0 || size == 0 || size % FLASH_SECTOR_SIZE != 0 ||
+        offset + size > map->size) {
+        return false;
+    }
+
+    dev->ops = &map_ops;
+    dev->size = size;
+    dev->page_size = FLASH_PAGE_SIZE;
+    dev->sector_size = FLASH_SECTOR_SIZE;
+    dev->context = (void*)map;
+    dev->map = map->base + offset;
+    return true;
+}
+
+uint32_t flash_map_region_count(const flash_map_t* map, uint32_t region_size)
+{
+    return map && region_size ? (uint32_t)(map->size / region_size) : 0;
+}
@@ -0,0 +1,69 @@
+#ifndef FLASH_MAP_H
+#define FLASH_MAP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "flash_device.h"
+
+/**
+ * @file flash_map.h
+ * @brief Read-only memory-mapped flash images (Linux host tools)
+ *
+ * Maps a flash dump, a simulator image or an archive of concatenated
+ * dumps with mmap(2), read-only, and hands out windows of it as
+ * flash_device_t regions. Reads are copies out of the page cache;
+ * programs and erases are refused. Each region sets dev.map, so
+ * flash_log_read_mapped() and sensor_store_next_block() return records
+ * in place: the firmware's own mount, seek and record parsing run
+ * unchanged, and a scan reads each byte once (for the CRC) instead of
+ * copying every record first.
+ *
+ * storage_ops_t: flash_log_storage_bind(log, &dev) over a region is the
+ * firmware's own binding; init() mounts the dump, read() reads it raw,
+ * and write(), erase() and format() fail.
+ */
+
+// =============================================================================
+// Data Structures
+// =============================================================================
+
+/**
+ * @brief Mapped file
+ */
+typedef struct {
+    const uint8_t* base;              ///< Whole file, read-only
+    uint64_t size;
+    int fd;
+} flash_map_t;
+
+// =============================================================================
+// Map Functions
+// =============================================================================
+
+/**
+ * @brief Map a file read-only
+ * @return false if the file cannot be opened or mapped, or is empty
+ */
+bool flash_map_open(flash_map_t* map, const char* path);
+
+/**
+ * @brief Unmap and close
+ */
+void flash_map_close(flash_map_t* map);
+
+/**
+ * @brief Window of the file as a flash region
+ *
+ * @param offset File offset of the region (4-byte aligned, so records are
+ *               aligned in place)
+ * @param size Region bytes, a multiple of FLASH_SECTOR_SIZE within the file
+ * @param dev Region to fill (W25Q64 geometry)
+ */
+bool flash_map_region(const flash_map_t* map, uint64_t offset, uint32_t size, flash_device_t* dev);
+
+/**
+ * @brief Number of whole regions of region_size bytes in the file
+ */
+uint32_t flash_map_region_count(const flash_map_t* map, uint32_t region_size);
+
+#endif // FLASH_MAP_H
@@ -0,0 +1,335 @@
+/*
+ * Erase Sector Pool
+ *
+ * Lanes see regions of sector_count virtual sectors, each the first
+ * sector_size - FLASH_POOL_TAG_SIZE bytes of whatever physical sector it
+ * is bound to. Unbound virtual sectors read as erased and refuse
+ * programs; erasing one binds the oldest free physical sector. Erases
+ * started with erase_begin() get their tag when a poll sees them done;
+ * the pool tracks one at a time, like the chip.
+ */
+
+#include "flash_pool.h"
+#include <stddef.h>
+#include <string.h>
+
+/* ==== PRIVATE FUNCTIONS ==== */
+
+static uint32_t tag_addr(const flash_pool_t* pool, uint32_t sector)
+{
+    return (sector + 1u) * pool->dev->sector_size - FLASH_POOL_TAG_SIZE;
+}
+
+static uint32_t tag_check(const flash_pool_tag_t* tag)
+{
+    return ~(tag->magic ^ ((uint32_t)tag->lane << 16 | tag->virtual_sector) ^ tag->erase_count);
+}
+
+static bool read_tag(const flash_pool_t* pool, uint32_t sector, flash_pool_tag_t* tag)
+{
+    return flash_device_read(pool->dev, tag_addr(pool, sector), tag, sizeof(*tag)) &&
+           tag->magic == FLASH_POOL_MAGIC && tag->check == tag_check(tag);
+}
+
+static void push_free(flash_pool_t* pool, uint32_t sector)
+{
+    pool->free_ring[(pool->free_head + pool->free_count) % pool->sector_count] = (uint16_t)sector;
+    pool->free_count++;
+}
+
+/** Clear a tag's check word so the sector reads as free after a reboot */
+static bool invalidate(flash_pool_t* pool, uint32_t sector)
+{
+    static const uint32_t cleared = 0;
+
+    if (!flash_device_program(pool->dev, tag_addr(pool, sector) + offsetof(flash_pool_tag_t, check),
+                              &cleared, sizeof(cleared))) {
+        pool->stats.errors++;
+        return false;
+    }
+    return true;
+}
+
+static bool lane_read(const flash_device_t* dev, uint32_t addr, void* buffer, uint32_t length)
+{
+    const flash_pool_lane_t* lane = (const flash_pool_lane_t*)dev->context;
+    uint8_t* out = (uint8_t*)buffer;
+
+    while (length > 0) {
+        uint32_t virtual_sector = addr / dev->sector_size;
+        uint32_t offset = addr % dev->sector_size;
+        uint32_t chunk = dev->sector_size - offset < length ? dev->sector_size - offset : length;
+        uint16_t physical = lane->map[virtual_sector];
+
+        if (physical == FLASH_POOL_NONE) {
+            memset(out, FLASH_ERASED_BYTE, chunk);
+        } else if (!flash_device_read(lane->pool->dev, physical * lane->pool->dev->sector_size + offset,
+                                      out, chunk)) {
+            return false;
+        }
+        addr += chunk;
+        out += chunk;
+        length -= chunk;
+    }
+    return true;
+}
+
+/** Called per virtual sector (the lane's page_size is its sector size) */
+static bool lane_program(const flash_device_t* dev, uint32_t addr, const void* data, uint32_t length)
+{
+    const flash_pool_lane_t* lane = (const flash_pool_lane_t*)dev->context;
+    uint16_t physical = lane->map[addr / dev->sector_size];
+
+    if (physical == FLASH_POOL_NONE) {
+        return false;
+    }
+    return flash_device_program(lane->pool->dev,
+                                physical * lane->pool->dev->sector_size + addr % dev->sector_size,
+                                data, length);
+}
+
+/** Physical sector behind a virtual one, bound from the free FIFO if it has none */
+static bool bind_sector(flash_pool_lane_t* lane, uint32_t virtual_sector, uint32_t* physical)
+{
+    flash_pool_t* pool = lane->pool;
+
+    *physical = lane->map[virtual_sector];
+    if (*physical != FLASH_POOL_NONE) {
+        return true;
+    }
+    if (pool->free_count == 0) {
+        return false;
+    }
+    *physical = pool->free_ring[pool->free_head];
+    pool->free_head = (pool->free_head + 1u) % pool->sector_count;
+    pool->free_count--;
+    lane->map[virtual_sector] = (uint16_t)*physical;
+    lane->mapped++;
+    pool->stats.allocations++;
+    return true;
+}
+
+/** Tag a sector gets once erased; released tags keep their erase count */
+static void next_tag(const flash_pool_lane_t* lane, uint32_t physical, uint32_t virtual_sector,
+                     flash_pool_tag_t* tag)
+{
+    const flash_pool_t* pool = lane->pool;
+    uint32_t erase_count = pool->max_erase_count;
+
+    if (flash_device_read(pool->dev, tag_addr(pool, physical), tag, sizeof(*tag)) &&
+        tag->magic == FLASH_POOL_MAGIC) {
+        erase_count = tag->erase_count;
+    }
+
+    memset(tag, FLASH_ERASED_BYTE, sizeof(*tag));
+    tag->magic = FLASH_POOL_MAGIC;
+    tag->lane = lane->lane;
+    tag->virtual_sector = (uint16_t)virtual_sector;
+    tag->erase_count = erase_count + 1u;
+    tag->check = tag_check(tag);
+}
+
+static bool write_tag(flash_pool_t* pool, uint32_t physical, const flash_pool_tag_t* tag)
+{
+    if (!flash_device_program(pool->dev, tag_addr(pool, physical), tag, sizeof(*tag))) {
+        pool->stats.errors++;
+        return false;
+    }
+    if (tag->erase_count > pool->max_erase_count) {
+        pool->max_erase_count = tag->erase_count;
+    }
+    pool->stats.erases++;
+    return true;
+}
+
+/** Tag the sector of an erase_begin() erase once it is done (or wait for it) */
+static bool finish_erase(flash_pool_t* pool, bool wait, bool* busy)
+{
+    bool erased = flash_device_erase_poll(pool->dev, wait, busy);
+
+    if (*busy || !pool->erasing) {
+        return erased;
+    }
+    pool->erasing = false;
+    if (!erased) {
+        pool->stats.errors++;
+        return false;
+    }
+    return write_tag(pool, pool->erasing_sector, &pool->erasing_tag);
+}
+
+static bool lane_erase_sector(const flash_device_t* dev, uint32_t addr)
+{
+    flash_pool_lane_t* lane = (flash_pool_lane_t*)dev->context;
+    flash_pool_t* pool = lane->pool;
+    uint32_t virtual_sector = addr / dev->sector_size;
+    uint32_t physical;
+    flash_pool_tag_t tag;
+    bool busy;
+
+    if (pool->erasing) {
+        finish_erase(pool, true, &busy);
+    }
+    if (!bind_sector(lane, virtual_sector, &physical)) {
+        return false;
+    }
+
+    next_tag(lane, physical, virtual_sector, &tag);
+    if (!flash_device_erase_sector(pool->dev, physical * pool->dev->sector_size)) {
+        pool->stats.errors++;
+        return false;
+    }
+    return write_tag(pool, physical, &tag);
+}
+
+/** Same as lane_erase_sector(), with the tag programmed by lane_erase_poll() */
+static bool lane_erase_begin(const flash_device_t* dev, uint32_t addr)
+{
+    flash_pool_lane_t* lane = (flash_pool_lane_t*)dev->context;
+    flash_pool_t* pool = lane->pool;
+    uint32_t virtual_sector = addr / dev->sector_size;
+    uint32_t physical;
+    bool busy;
+
+    if (pool->erasing) {
+        finish_erase(pool, true, &busy);
+    }
+    if (!bind_sector(lane, virtual_sector, &physical)) {
+        return false;
+    }
+
+    next_tag(lane, physical, virtual_sector, &pool->erasing_tag);
+    if (!flash_device_erase_begin(pool->dev, physical * pool->dev->sector_size)) {
+        pool->stats.errors++;
+        return false;
+    }
+    pool->erasing = true;
+    pool->erasing_sector = physical;
+    return true;
+}
+
+/** Any lane's poll finishes the pool's erase: they share one chip */
+static bool lane_erase_poll(const flash_device_t* dev, bool wait, bool* busy)
+{
+    const flash_pool_lane_t* lane = (const flash_pool_lane_t*)dev->context;
+    return finish_erase(lane->pool, wait, busy);
+}
+
+static const flash_device_ops_t lane_ops = {
+    .read = lane_read,
+    .program = lane_program,
+    .erase_sector = lane_erase_sector,
+    .erase_begin = lane_erase_begin,
+    .erase_poll = lane_erase_poll,
+};
+
+/* ==== PUBLIC FUNCTIONS ==== */
+
+bool flash_pool_open(flash_pool_t* pool, const flash_device_t* dev, uint32_t lane_count)
+{
+    if (!pool || !dev || dev->sector_size <= FLASH_POOL_TAG_SIZE || dev->size % dev->sector_size != 0 ||
+        dev->size / dev->sector_size > FLASH_POOL_MAX_SECTORS || dev->size == 0 ||
+        lane_count == 0 || lane_count > FLASH_POOL_MAX_LANES) {
+        return false;
+    }
+
+    memset(pool, 0, sizeof(flash_pool_t));
+    pool->dev = dev;
+    pool->sector_count = dev->size / dev->sector_size;
+    pool->lane_count = lane_count;
+
+    for (uint32_t i = 0; i < lane_count; i++) {
+        flash_pool_lane_t* lane = &pool->lanes[i];
+        lane->pool = pool;
+        lane->lane = (uint8_t)i;
+        memset(lane->map, 0xFF, sizeof(lane->map));
+        lane->dev.ops = &lane_ops;
+        lane->dev.sector_size = dev->sector_size - FLASH_POOL_TAG_SIZE;
+        lane->dev.page_size = lane->dev.sector_size;
+        lane->dev.size = pool->sector_count * lane->dev.sector_size;
+        lane->dev.context = lane;
+    }
+
+    for (uint32_t sector = 0; sector < pool->sector_count; sector++) {
+        flash_pool_tag_t tag;
+
+        if (!read_tag(pool, sector, &tag) || tag.lane >= lane_count || tag.virtual_sector >= pool->sector_count) {
+            push_free(pool, sector);
+            continue;
+        }
+
+        // A virtual sector bound twice (release interrupted): the newer erase wins
+        flash_pool_lane_t* lane = &pool->lanes[tag.lane];
+        uint16_t bound = lane->map[tag.virtual_sector];
+        if (bound != FLASH_POOL_NONE) {
+            flash_pool_tag_t other;
+            read_tag(pool, bound, &other);
+            if (other.erase_count >= tag.erase_count) {
+                invalidate(pool, sector);
+                push_free(pool, sector);
+                continue;
+            }
+            invalidate(pool, bound);
+            push_free(pool, bound);
+            lane->mapped--;
+        }
+        lane->map[tag.virtual_sector] = (uint16_t)sector;
+        lane->mapped++;
+        if (tag.erase_count > pool->max_erase_count) {
+            pool->max_erase_count = tag.erase_count;
+        }
+    }
+    return true;
+}
+
+bool flash_pool_format(flash_pool_t* pool)
+{
+    bool ok = true;
+
+    if (!pool || !pool->dev) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < pool->lane_count; i++) {
+        for (uint32_t v = 0; v < pool->sector_count; v++) {
+            if (pool->lanes[i].map[v] != FLASH_POOL_NONE) {
+                ok = flash_pool_release(pool, i, v) && ok;
+            }
+        }
+    }
+    return ok;
+}
+
+const flash_device_t* flash_pool_lane(flash_pool_t* pool, uint32_t lane)
+{
+    return pool && lane < pool->lane_count ? &pool->lanes[lane].dev : NULL;
+}
+
+bool flash_pool_release(flash_pool_t* pool, uint32_t lane, uint32_t virtual_sector)
+{
+    if (!pool || lane >= pool->lane_count || virtual_sector >= pool->sector_count) {
+        return false;
+    }
+
+    flash_pool_lane_t* owner = &pool->lanes[lane];
+    uint16_t physical = owner->map[virtual_sector];
+    if (physical == FLASH_POOL_NONE) {
+        return false;
+    }
+
+    // Unbound even if the program fails: the lane has given the sector up
+    bool ok = invalidate(pool, physical);
+    owner->map[virtual_sector] = FLASH_POOL_NONE;
+    owner->mapped--;
+    push_free(pool, physical);
+    pool->stats.releases++;
+    return ok;
+}
+
+uint32_t flash_pool_usage_percent(const flash_pool_t* pool)
+{
+    if (!pool || pool->sector_count == 0) {
+        return 0;
+    }
+    return (pool->sector_count - pool->free_count) * 100u / pool->sector_count;
+}
@@ -0,0 +1,136 @@
+#ifndef FLASH_POOL_H
+#define FLASH_POOL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "flash_device.h"
+
+/**
+ * @file flash_pool.h
+ * @brief Erase sectors shared by several logs (lanes)
+ *
+ * Each lane is a virtual flash region handed to its own flash_log. A
+ * virtual sector is bound to a physical one when the lane's log erases
+ * it, from a FIFO of free sectors, so a lane grows as long as the pool
+ * has room. Releasing a virtual sector (the lane dropped it) returns the
+ * physical sector to the back of the FIFO, which spreads erases over the
+ * whole region.
+ *
+ * Every physical sector ends in a 16-byte tag {magic, lane, virtual
+ * sector, erase count, check}, programmed right after the erase. Virtual
+ * sectors are the first sector_size - 16 bytes, at the same offsets, so
+ * page boundaries line up. Release clears the check word (one 4-byte
+ * program); a torn tag or release fails the check and the sector is free
+ * at the next open. Opening reads the 6144 tag bytes of a 6 MB region.
+ *
+ * RAM: two bytes per sector per lane for the virtual-to-physical maps
+ * and two for the free FIFO (15 KB for four lanes over 6 MB).
+ */
+
+// =============================================================================
+// Limits and Layout
+// =============================================================================
+
+#ifndef FLASH_POOL_MAX_SECTORS
+#define FLASH_POOL_MAX_SECTORS       1536  ///< 6 MB of 4 KB sectors
+#endif
+
+#define FLASH_POOL_MAX_LANES         4
+#define FLASH_POOL_MAGIC             0x4C4F4F50u  ///< "POOL"
+#define FLASH_POOL_TAG_SIZE          16u
+#define FLASH_POOL_NONE              0xFFFFu      ///< Unmapped virtual sector
+
+/**
+ * @brief Physical sector tag (last bytes of the sector)
+ */
+typedef struct {
+    uint32_t magic;
+    uint8_t lane;
+    uint8_t reserved;                 ///< 0xFF
+    uint16_t virtual_sector;
+    uint32_t erase_count;             ///< Erases of this physical sector
+    uint32_t check;                   ///< Binds the fields above; cleared on release
+} flash_pool_tag_t;
+
+// =============================================================================
+// Data Structures
+// =============================================================================
+
+struct flash_pool;
+
+/**
+ * @brief One lane: a virtual region over the pool
+ */
+typedef struct {
+    flash_device_t dev;               ///< Region for the lane's log (sector_size - 16 per sector)
+    struct flash_pool* pool;
+    uint8_t lane;
+    uint32_t mapped;                  ///< Physical sectors held
+    uint16_t map[FLASH_POOL_MAX_SECTORS];
+} flash_pool_lane_t;
+
+/**
+ * @brief Pool accounting
+ */
+typedef struct {
+    uint32_t allocations;             ///< Free sectors bound to a lane
+    uint32_t releases;
+    uint32_t erases;
+    uint32_t errors;
+} flash_pool_stats_t;
+
+/**
+ * @brief Pool instance
+ */
+typedef struct flash_pool {
+    const flash_device_t* dev;        ///< Physical region
+    uint32_t sector_count;
+    uint32_t lane_count;
+    flash_pool_lane_t lanes[FLASH_POOL_MAX_LANES];
+    uint16_t free_ring[FLASH_POOL_MAX_SECTORS];
+    uint32_t free_head;               ///< Oldest free sector in free_ring
+    uint32_t free_count;
+    uint32_t max_erase_count;
+    bool erasing;                     ///< An erase_begin() erase still waits for its tag
+    uint32_t erasing_sector;          ///< Its physical sector
+    flash_pool_tag_t erasing_tag;     ///< Tag programmed once it is done
+    flash_pool_stats_t stats;
+} flash_pool_t;
+
+// =============================================================================
+// Pool Functions
+// =============================================================================
+
+/**
+ * @brief Rebuild the lanes from the sector tags
+ *
+ * Sectors without a valid tag (never used, released, torn) are free.
+ *
+ * @param lane_count Lanes (1..FLASH_POOL_MAX_LANES); tags of other lanes are freed
+ */
+bool flash_pool_open(flash_pool_t* pool, const flash_device_t* dev, uint32_t lane_count);
+
+/**
+ * @brief Release every sector (the lanes become empty)
+ */
+bool flash_pool_format(flash_pool_t* pool);
+
+/**
+ * @brief Virtual region of a lane, for flash_log_mount()/flash_log_format()
+ */
+const flash_device_t* flash_pool_lane(flash_pool_t* pool, uint32_t lane);
+
+/**
+ * @brief Return a lane's virtual sector to the free FIFO
+ *
+ * For sectors the lane's log no longer uses (flash_log_drop_oldest()).
+ * O(1): one 4-byte program, no erase.
+ */
+bool flash_pool_release(flash_pool_t* pool, uint32_t lane, uint32_t virtual_sector);
+
+/**
+ * @brief Sectors bound to lanes, in percent of the pool
+ */
+uint32_t flash_pool_usage_percent(const flash_pool_t* pool);
+
+#endif // FLASH_POOL_H
@@ -0,0 +1,221 @@
+/*
+ * File-Backed NOR Flash Simulator
+ *
+ * The image lives in memory; programs and erases are written through to
+ * the backing file so its content always matches what the flash would
+ * hold after a power cut between two operations.
+ */
+
+#include "flash_sim.h"
+#include "storage_port.h"
+#include <stdlib.h>
+#include <string.h>
+
+uint32_t storage_host_clock_ms;
+uint32_t storage_host_clock_us;
+
+/* ==== PRIVATE FUNCTIONS ==== */
+
+static void write_through(flash_sim_t* sim, uint32_t addr, uint32_t length)
+{
+    if (sim->file && fseek(sim->file, (long)addr, SEEK_SET) == 0) {
+        fwrite(sim->image + addr, 1, length, sim->file);
+        fflush(sim->file);
+    }
+}
+
+static void spend(flash_sim_t* sim, uint32_t us)
+{
+    sim->stats.busy_us += us;
+    storage_host_clock_us += us;
+}
+
+/** Whether the running erase is still busy; wait lets the clock run to its end */
+static bool erase_running(flash_sim_t* sim, bool wait)
+{
+    if (!sim->erasing) {
+        return false;
+    }
+    if ((int32_t)(sim->erase_done_us - storage_host_clock_us) > 0) {
+        if (!wait) {
+            return true;
+        }
+        storage_host_clock_us = sim->erase_done_us;
+        sim->stats.erase_waits++;
+    }
+    sim->erasing = false;
+    return false;
+}
+
+static bool sim_read(const flash_device_t* dev, uint32_t addr, void* buffer, uint32_t length)
+{
+    flash_sim_t* sim = (flash_sim_t*)dev->context;
+
+    erase_running(sim, true);
+    memcpy(buffer, sim->image + addr, length);
+    sim->stats.reads++;
+    sim->stats.bytes_read += length;
+    spend(sim, (uint32_t)(((uint64_t)length * FLASH_SIM_READ_NS_PER_BYTE) / 1000u));
+    return true;
+}
+
+static bool sim_program(const flash_device_t* dev, uint32_t addr, const void* data, uint32_t length)
+{
+    flash_sim_t* sim = (flash_sim_t*)dev->context;
+    const uint8_t* src = (const uint8_t*)data;
+    uint32_t landed = length;
+
+    if (sim->powered_off || length == 0 || addr + length > dev->size ||
+        addr / dev->page_size != (addr + length - 1) / dev->page_size) {
+        return false;
+    }
+    erase_running(sim, true);
+
+    if (sim->cut_armed) {
+        if (sim->cut_budget < length) {
+            landed = sim->cut_budget;
+            sim->powered_off = true;
+        }
+        sim->cut_budget -= landed;
+    }
+
+    for (uint32_t i = 0; i < landed; i++) {
+        uint8_t* cell = &sim->image[addr + i];
+        if (src[i] & ~*cell) {
+            sim->stats.violations++;
+        }
+        *cell &= src[i];
+    }
+    write_through(sim, addr, length);
+
+    sim->stats.programs++;
+    sim->stats.bytes_programmed += landed;
+    spend(sim, FLASH_SIM_PAGE_PROGRAM_US);
+    return !sim->powered_off;
+}
+
+static bool sim_erase_begin(const flash_device_t* dev, uint32_t addr)
+{
+    flash_sim_t* sim = (flash_sim_t*)dev->context;
+
+    if (sim->powered_off) {
+        return false;
+    }
+    erase_running(sim, true);
+    memset(sim->image + addr, FLASH_ERASED_BYTE, dev->sector_size);
+    write_through(sim, addr, dev->sector_size);
+
+    sim->erase_counts[addr / dev->sector_size]++;
+    sim->stats.erases++;
+    sim->stats.busy_us += FLASH_SIM_SECTOR_ERASE_US;
+    sim->erasing = true;
+    sim->erase_done_us = storage_host_clock_us + FLASH_SIM_SECTOR_ERASE_US;
+    return true;
+}
+
+static bool sim_erase_poll(const flash_device_t* dev, bool wait, bool* busy)
+{
+    *busy = erase_running((flash_sim_t*)dev->context, wait);
+    return true;
+}
+
+static bool sim_erase_sector(const flash_device_t* dev, uint32_t addr)
+{
+    flash_sim_t* sim = (flash_sim_t*)dev->context;
+
+    if (!sim_erase_begin(dev, addr)) {
+        return false;
+    }
+    storage_host_clock_us = sim->erase_done_us;
+    sim->erasing = false;
+    return true;
+}
+
+static const flash_device_ops_t sim_ops = {
+    .read = sim_read,
+    .program = sim_program,
+    .erase_sector = sim_erase_sector,
+    .erase_begin = sim_erase_begin,
+    .erase_poll = sim_erase_poll,
+};
+
+/* ==== PUBLIC FUNCTIONS ==== */
+
+bool flash_sim_open(flash_sim_t* sim, const char* path, uint32_t size)
+{
+    if (!sim || size == 0 || size % FLASH_SECTOR_SIZE != 0) {
+        return false;
+    }
+
+    memset(sim, 0, sizeof(flash_sim_t));
+    sim->image = malloc(size);
+    sim->erase_counts = calloc(size / FLASH_SECTOR_SIZE, sizeof(uint32_t));
+    if (!sim->image || !sim->erase_counts) {
+        flash_sim_close(sim);
+        return false;
+    }
+
+    bool loaded = false;
+    if (path) {
+        sim->file = fopen(path, "r+b");
+        if (sim->file) {
+            loaded = fread(sim->image, 1, size, sim->file) == size;
+        } else {
+            sim->file = fopen(path, "w+b");
+        }
+        if (!sim->file) {
+            LOG_ERR("Cannot open flash image %s", path);
+            flash_sim_close(sim);
+            return false;
+        }
+    }
+
+    if (!loaded) {
+        memset(sim->image, FLASH_ERASED_BYTE, size);
+        write_through(sim, 0, size);
+    }
+
+    sim->dev.ops = &sim_ops;
+    sim->dev.size = size;
+    sim->dev.page_size = FLASH_PAGE_SIZE;
+    sim->dev.sector_size = FLASH_SECTOR_SIZE;
+    sim->dev.context = sim;
+    return true;
+}
+
+void flash_sim_close(flash_sim_t* sim)
+{
+    if (!sim) {
+        return;
+    }
+    if (sim->file) {
+        fclose(sim->file);
+    }
+    free(sim->image);
+    free(sim->erase_counts);
+    memset(sim, 0, sizeof(flash_sim_t));
+}
+
+void flash_sim_reset_stats(flash_sim_t* sim)
+{
+    memset(&sim->stats, 0, sizeof(sim->stats));
+}
+
+void flash_sim_power_cut(flash_sim_t* sim, uint32_t bytes_left)
+{
+    sim->cut_armed = true;
+    sim->cut_budget = bytes_left;
+}
+
+void flash_sim_erase_range(const flash_sim_t* sim, uint32_t* min_erases, uint32_t* max_erases)
+{
+    uint32_t lo = UINT32_MAX;
+    uint32_t hi = 0;
+
+    for (uint32_t s = 0; s < sim->dev.size / sim->dev.sector_size; s++) {
+        lo = sim->erase_counts[s] < lo ? sim->erase_counts[s] : lo;
+        hi = sim->erase_counts[s] > hi ? sim->erase_counts[s] : hi;
+    }
+    *min_erases = lo;
+    *max_erases = hi;
+}
@@ -0,0 +1,115 @@
+#ifndef FLASH_SIM_H
+#define FLASH_SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "flash_device.h"
+
+/**
+ * @file flash_sim.h
+ * @brief File-backed NOR flash simulator (host builds only)
+ *
+ * Keeps the region image in memory and writes every program and erase
+ * through to a file, so a test can "reboot" by closing the simulator and
+ * opening the same file again. NOR rules are enforced: a program that
+ * would set a cleared bit is counted as a violation (the bit stays
+ * cleared, as on silicon), a program may not cross a page, and erase
+ * counts are kept per sector. Busy time follows W25Q64 typical timings
+ * so tools can report what the flash traffic would cost on target.
+ *
+ * Erases can also be started and left running (erase_begin): the
+ * content changes at once, but the simulated chip stays busy for tSE on
+ * storage_host_clock_us, and a read, program or erase in that time first
+ * waits for it. Every operation advances that clock by its busy time.
+ *
+ * flash_sim_power_cut() arms a simulated power loss after a number of
+ * programmed bytes: the program in flight is torn at that byte and the
+ * flash refuses everything after it, so a test can reopen the image and
+ * mount what a brownout would have left.
+ */
+
+// =============================================================================
+// Timing (W25Q64 typical, 8 MHz SPI)
+// =============================================================================
+
+#define FLASH_SIM_PAGE_PROGRAM_US    700   ///< tPP per program operation
+#define FLASH_SIM_SECTOR_ERASE_US    45000 ///< tSE per sector
+#define FLASH_SIM_READ_NS_PER_BYTE   1000  ///< 8 MHz SPI
+
+// =============================================================================
+// Data Structures
+// =============================================================================
+
+/**
+ * @brief Flash traffic counters
+ */
+typedef struct {
+    uint64_t reads;
+    uint64_t bytes_read;
+    uint64_t programs;                ///< Program operations (each within one page)
+    uint64_t bytes_programmed;
+    uint64_t erases;
+    uint64_t busy_us;                 ///< Simulated device busy time
+    uint32_t violations;              ///< Programs that tried to set cleared bits
+    uint32_t erase_waits;             ///< Operations that had to wait for a running erase
+} flash_sim_stats_t;
+
+/**
+ * @brief Simulator instance
+ */
+typedef struct {
+    flash_device_t dev;               ///< Region handed to the storage modules
+    uint8_t* image;
+    uint32_t* erase_counts;           ///< Per sector
+    FILE* file;                       ///< Backing file (NULL: memory only)
+    bool cut_armed;
+    uint32_t cut_budget;              ///< Bytes still programmed before the cut
+    bool powered_off;                 ///< Cut happened: programs and erases fail
+    bool erasing;                     ///< An erase_begin() erase may still be running
+    uint32_t erase_done_us;           ///< storage_host_clock_us when it completes
+    flash_sim_stats_t stats;
+} flash_sim_t;
+
+// =============================================================================
+// Simulator Functions
+// =============================================================================
+
+/**
+ * @brief Open a simulated region
+ *
+ * An existing file of the right size is loaded as the flash content;
+ * otherwise the file is created fully erased. Erase counts start at zero
+ * on every open (they are not part of the image).
+ *
+ * @param sim Instance
+ * @param path Backing file, NULL for a memory-only region
+ * @param size Region bytes (multiple of FLASH_SECTOR_SIZE)
+ * @return false on allocation or file errors
+ */
+bool flash_sim_open(flash_sim_t* sim, const char* path, uint32_t size);
+
+/**
+ * @brief Release the image and close the file
+ */
+void flash_sim_close(flash_sim_t* sim);
+
+/**
+ * @brief Clear traffic counters (erase counts are kept)
+ */
+void flash_sim_reset_stats(flash_sim_t* sim);
+
+/**
+ * @brief Lose power after the next bytes_left programmed bytes
+ *
+ * The program that crosses the budget lands only its first bytes. Reopen
+ * the simulator to power back up.
+ */
+void flash_sim_power_cut(flash_sim_t* sim, uint32_t bytes_left);
+
+/**
+ * @brief Lowest and highest per-sector erase count
+ */
+void flash_sim_erase_range(const flash_sim_t* sim, uint32_t* min_erases, uint32_t* max_erases);
+
+#endif // FLASH_SIM_H
@@ -0,0 +1,305 @@
+/*
+ * Rollup Store
+ *
+ * Open periods are float accumulators in RAM, one per level and metric.
+ * A period's record is keyed by its start, so each level log is sorted by
+ * time and its key table answers seeks without flash reads.
+ */
+
+#include "rollup_store.h"
+#include "storage_port.h"
+#include <math.h>
+#include <string.h>
+
+LOG_MODULE_REGISTER(rollup_store, LOG_LEVEL_INF);
+
+#define MINUTE_MS               60000u
+#define HOUR_MS                 3600000u
+#define DAY_MS                  86400000u
+#define NIGHT_START_MS          ((uint32_t)ROLLUP_NIGHT_START_MIN * MINUTE_MS)
+#define NIGHT_LENGTH_MS         ((uint32_t)((ROLLUP_NIGHT_END_MIN + 24 * 60 - ROLLUP_NIGHT_START_MIN) % (24 * 60)) * MINUTE_MS)
+
+/** Stored units per metric unit */
+static const float metric_scale[ROLLUP_METRIC_COUNT] = {
+    [ROLLUP_METRIC_HR] = 10.0f,
+    [ROLLUP_METRIC_HRV] = 10.0f,
+    [ROLLUP_METRIC_ACTIVITY] = 1.0f,
+    [ROLLUP_METRIC_TEMPERATURE] = 100.0f,
+};
+
+/* ==== PRIVATE FUNCTIONS ==== */
+
+static bool in_night(uint32_t timestamp_ms)
+{
+    return (timestamp_ms % DAY_MS + DAY_MS - NIGHT_START_MS) % DAY_MS < NIGHT_LENGTH_MS;
+}
+
+static uint32_t period_start(rollup_level_t level, uint32_t timestamp_ms)
+{
+    switch (level) {
+    case ROLLUP_LEVEL_MINUTE:
+        return timestamp_ms - timestamp_ms % MINUTE_MS;
+    case ROLLUP_LEVEL_HOUR:
+        return timestamp_ms - timestamp_ms % HOUR_MS;
+    default:
+        return timestamp_ms - (timestamp_ms % DAY_MS + DAY_MS - NIGHT_START_MS) % DAY_MS;
+    }
+}
+
+static uint32_t period_length(rollup_level_t level)
+{
+    return level == ROLLUP_LEVEL_MINUTE ? MINUTE_MS : level == ROLLUP_LEVEL_HOUR ? HOUR_MS : NIGHT_LENGTH_MS;
+}
+
+static int16_t to_stored(rollup_metric_t metric, float value)
+{
+    float scaled = roundf(value * metric_scale[metric]);
+    return scaled > INT16_MAX ? INT16_MAX : scaled < INT16_MIN ? INT16_MIN : (int16_t)scaled;
+}
+
+/** Write a level's open period and start over */
+static bool close_period(rollup_store_t* store, rollup_level_t level)
+{
+    rollup_record_t record;
+
+    memset(&record, 0, sizeof(record));
+    record.start_ms = store->period_start[level];
+    record.end_ms = record.start_ms + period_length(level);
+    for (uint32_t m = 0; m < ROLLUP_METRIC_COUNT; m++) {
+        const rollup_acc_t* acc = &store->acc[level][m];
+        if (acc->count > 0) {
+            record.metrics[m].count = acc->count > UINT16_MAX ? UINT16_MAX : (uint16_t)acc->count;
+            record.metrics[m].mean = to_stored((rollup_metric_t)m, acc->sum / (float)acc->count);
+            record.metrics[m].min = to_stored((rollup_metric_t)m, acc->min);
+            record.metrics[m].max = to_stored((rollup_metric_t)m, acc->max);
+        }
+    }
+
+    memset(store->acc[level], 0, sizeof(store->acc[level]));
+    store->open[level] = false;
+
+    if (!flash_log_append_keyed(&store->logs[level], ROLLUP_RECORD_TYPE, record.start_ms, &record,
+                                sizeof(record), NULL)) {
+        LOG_WRN("Rollup level %u period %u lost", level, record.start_ms);
+        store->stats.write_errors++;
+        return false;
+    }
+    store->stats.records_written[level]++;
+    return true;
+}
+
+static uint32_t close_due(rollup_store_t* store, uint32_t now_ms)
+{
+    uint32_t closed = 0;
+
+    for (uint32_t level = 0; level < ROLLUP_LEVEL_COUNT; level++) {
+        if (store->open[level] &&
+            now_ms - store->period_start[level] >= period_length((rollup_level_t)level)) {
+            closed += close_period(store, (rollup_level_t)level) ? 1u : 0u;
+        }
+    }
+    return closed;
+}
+
+/** Next record of a level starting before end_ms; false at the end of the window or on errors */
+static bool next_record(rollup_store_t* store, rollup_level_t level, flash_log_cursor_t* cursor,
+                        uint32_t end_ms, rollup_record_t* record, bool* error)
+{
+    flash_log_record_t info;
+    int32_t length;
+
+    while ((length = flash_log_read(&store->logs[level], cursor, record, sizeof(*record), &info)) != 0) {
+        if (length == FLASH_LOG_CORRUPT) {
+            continue;
+        }
+        if (length < 0) {
+            *error = true;
+            return false;
+        }
+        store->stats.records_read++;
+        if (info.type != ROLLUP_RECORD_TYPE || length != (int32_t)sizeof(*record)) {
+            continue;
+        }
+        return record->start_ms < end_ms;
+    }
+    return false;
+}
+
+/* ==== PUBLIC FUNCTIONS ==== */
+
+bool rollup_store_open(rollup_store_t* store, const flash_device_t* dev, bool format)
+{
+    if (!store || !dev || dev->sector_size == 0) {
+        return false;
+    }
+
+    uint32_t sectors = dev->size / dev->sector_size;
+    uint32_t counts[ROLLUP_LEVEL_COUNT] = {
+        [ROLLUP_LEVEL_MINUTE] = sectors - ROLLUP_HOUR_SECTORS - ROLLUP_NIGHT_SECTORS,
+        [ROLLUP_LEVEL_HOUR] = ROLLUP_HOUR_SECTORS,
+        [ROLLUP_LEVEL_NIGHT] = ROLLUP_NIGHT_SECTORS,
+    };
+    if (sectors > ROLLUP_MAX_SECTORS || sectors < ROLLUP_HOUR_SECTORS + ROLLUP_NIGHT_SECTORS + 3u) {
+        LOG_ERR("Rollup region of %u sectors does not fit", sectors);
+        return false;
+    }
+
+    memset(store->open, 0, sizeof(store->open));
+    memset(store->acc, 0, sizeof(store->acc));
+    memset(&store->stats, 0, sizeof(store->stats));
+
+    uint32_t first = 0;
+    for (uint32_t level = 0; level < ROLLUP_LEVEL_COUNT; level++) {
+        flash_log_config_t config = FLASH_LOG_DEFAULT_CONFIG;
+        config.sector_keys = store->sector_keys + first;
+
+        if (!flash_device_slice(&store->slices[level], dev, first * dev->sector_size,
+                                counts[level] * dev->sector_size) ||
+            (format ? !flash_log_format(&store->logs[level], &store->slices[level].dev, &config)
+                    : !flash_log_mount(&store->logs[level], &store->slices[level].dev, &config))) {
+            LOG_ERR("Rollup level %u %s failed", level, format ? "format" : "mount");
+            return false;
+        }
+        first += counts[level];
+    }
+    return true;
+}
+
+bool rollup_store_add(rollup_store_t* store, rollup_metric_t metric, uint32_t timestamp_ms, float value)
+{
+    bool late = false;
+
+    if (!store || metric >= ROLLUP_METRIC_COUNT || isnan(value)) {
+        return false;
+    }
+
+    close_due(store, timestamp_ms);
+    for (uint32_t level = 0; level < ROLLUP_LEVEL_COUNT; level++) {
+        if (level == ROLLUP_LEVEL_NIGHT && !in_night(timestamp_ms)) {
+            continue;
+        }
+
+        uint32_t start = period_start((rollup_level_t)level, timestamp_ms);
+        if (!store->open[level]) {
+            store->open[level] = true;
+            store->period_start[level] = start;
+        } else if (start != store->period_start[level]) {
+            late = true;
+            continue;
+        }
+
+        rollup_acc_t* acc = &store->acc[level][metric];
+        if (acc->count == 0 || value < acc->min) {
+            acc->min = value;
+        }
+        if (acc->count == 0 || value > acc->max) {
+            acc->max = value;
+        }
+        acc->sum += value;
+        acc->count++;
+    }
+
+    store->stats.values++;
+    store->stats.late_values += late ? 1u : 0u;
+    return true;
+}
+
+uint32_t rollup_store_poll(rollup_store_t* store, uint32_t now_ms)
+{
+    return store ? close_due(store, now_ms) : 0;
+}
+
+bool rollup_store_flush(rollup_store_t* store)
+{
+    bool ok = true;
+
+    if (!store) {
+        return false;
+    }
+    for (uint32_t level = 0; level < ROLLUP_LEVEL_COUNT; level++) {
+        if (store->open[level]) {
+            ok = close_period(store, (rollup_level_t)level) && ok;
+        }
+    }
+    return ok;
+}
+
+uint32_t rollup_store_maintain(rollup_store_t* store)
+{
+    uint32_t erased = 0;
+
+    if (!store) {
+        return 0;
+    }
+    for (uint32_t level = 0; level < ROLLUP_LEVEL_COUNT; level++) {
+        erased += flash_log_maintain(&store->logs[level], 1);
+    }
+    return erased;
+}
+
+int32_t rollup_store_query(rollup_store_t* store, rollup_level_t level, uint32_t start_ms, uint32_t duration_ms,
+                           rollup_record_t* records, uint32_t max_records)
+{
+    flash_log_cursor_t cursor;
+    rollup_record_t record;
+    uint32_t count = 0;
+    bool error = false;
+
+    if (!store || level >= ROLLUP_LEVEL_COUNT || !records ||
+        !flash_log_seek(&store->logs[level], start_ms, &cursor, NULL)) {
+        return -1;
+    }
+
+    uint32_t end_ms = start_ms > UINT32_MAX - duration_ms ? UINT32_MAX : start_ms + duration_ms;
+    while (count < max_records && next_record(store, level, &cursor, end_ms, &record, &error)) {
+        if (record.start_ms >= start_ms) {
+            records[count++] = record;
+        }
+    }
+    return error ? -1 : (int32_t)count;
+}
+
+bool rollup_store_summary(rollup_store_t* store, rollup_level_t level, rollup_metric_t metric,
+                          uint32_t start_ms, uint32_t duration_ms, rollup_summary_t* summary)
+{
+    flash_log_cursor_t cursor;
+    rollup_record_t record;
+    bool error = false;
+    float sum = 0.0f;
+
+    if (!store || level >= ROLLUP_LEVEL_COUNT || metric >= ROLLUP_METRIC_COUNT || !summary ||
+        !flash_log_seek(&store->logs[level], start_ms, &cursor, NULL)) {
+        return false;
+    }
+
+    memset(summary, 0, sizeof(*summary));
+    uint32_t end_ms = start_ms > UINT32_MAX - duration_ms ? UINT32_MAX : start_ms + duration_ms;
+    while (next_record(store, level, &cursor, end_ms, &record, &error)) {
+        const rollup_agg_t* agg = &record.metrics[metric];
+        if (record.start_ms < start_ms || agg->count == 0) {
+            continue;
+        }
+
+        float min = rollup_store_value(metric, agg->min);
+        float max = rollup_store_value(metric, agg->max);
+        if (summary->periods == 0 || min < summary->min) {
+            summary->min = min;
+        }
+        if (summary->periods == 0 || max > summary->max) {
+            summary->max = max;
+        }
+        sum += rollup_store_value(metric, agg->mean) * (float)agg->count;
+        summary->count += agg->count;
+        summary->periods++;
+    }
+
+    if (summary->count > 0) {
+        summary->mean = sum / (float)summary->count;
+    }
+    return !error;
+}
+
+float rollup_store_value(rollup_metric_t metric, int16_t stored)
+{
+    return metric < ROLLUP_METRIC_COUNT ? (float)stored / metric_scale[metric] : 0.0f;
+}
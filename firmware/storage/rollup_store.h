@@ -0,0 +1,200 @@
+#ifndef ROLLUP_STORE_H
+#define ROLLUP_STORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "flash_io/flash_device.h"
+#include "flash_io/flash_log.h"
+
+/**
+ * @file rollup_store.h
+ * @brief Minute, hour and night aggregates of HR, HRV, activity and temperature
+ *
+ * Raw sensor blocks cover days, not the month that LOG_RETENTION_DAYS and
+ * HRV_BASELINE_DAYS ask for. Aggregates are kept instead: every value
+ * handed to rollup_store_add() updates the open minute, hour and (inside
+ * the night window) night of its metric in RAM, and a period is written
+ * as one 40-byte record when a later value or rollup_store_poll() passes
+ * its end.
+ *
+ * Each level is its own flash_log on a slice of the rollup region, with
+ * its own time index, so a query touches only records of the level it
+ * asks for: a 30-day baseline reads about 30 night records, whatever the
+ * sample rates were. The rollup region is separate from the sensor log,
+ * so raw blocks can be evicted (tier_store.h) without touching it; each
+ * level's ring drops its own oldest records. With the default split of
+ * a 512 KB region, minutes last about 6 days, hours about 35 and nights
+ * about 5 months.
+ *
+ * The time of day for the night window is the block clock modulo 24 h:
+ * time sync sets the block clock to local time. Periods still open in
+ * RAM are lost on a reset.
+ */
+
+// =============================================================================
+// Limits and Layout
+// =============================================================================
+
+#ifndef ROLLUP_REGION_BYTES
+#define ROLLUP_REGION_BYTES            (512u * 1024u)
+#endif
+
+#define ROLLUP_MAX_SECTORS             (ROLLUP_REGION_BYTES / FLASH_SECTOR_SIZE)
+#define ROLLUP_HOUR_SECTORS            12           ///< 10 in use: 35 days of hours
+#define ROLLUP_NIGHT_SECTORS           4            ///< 2 in use: 168 nights
+#define ROLLUP_RECORD_TYPE             0x02         ///< Log record type of rollups
+
+#ifndef ROLLUP_NIGHT_START_MIN
+#define ROLLUP_NIGHT_START_MIN         (22 * 60)    ///< Night window start, minute of day
+#endif
+#ifndef ROLLUP_NIGHT_END_MIN
+#define ROLLUP_NIGHT_END_MIN           (7 * 60)     ///< Night window end, minute of day
+#endif
+
+// =============================================================================
+// Data Structures
+// =============================================================================
+
+typedef enum {
+    ROLLUP_METRIC_HR = 0,             ///< bpm, stored in 0.1 bpm
+    ROLLUP_METRIC_HRV,                ///< RMSSD ms, stored in 0.1 ms
+    ROLLUP_METRIC_ACTIVITY,           ///< Motion mg, stored in mg
+    ROLLUP_METRIC_TEMPERATURE,        ///< Skin °C, stored in 0.01 °C
+    ROLLUP_METRIC_COUNT
+} rollup_metric_t;
+
+typedef enum {
+    ROLLUP_LEVEL_MINUTE = 0,
+    ROLLUP_LEVEL_HOUR,
+    ROLLUP_LEVEL_NIGHT,
+    ROLLUP_LEVEL_COUNT
+} rollup_level_t;
+
+/**
+ * @brief One metric over one period, in stored units (rollup_store_value)
+ */
+typedef struct {
+    uint16_t count;                   ///< Values (saturates; 0: no data)
+    int16_t mean;
+    int16_t min;
+    int16_t max;
+} rollup_agg_t;
+
+/**
+ * @brief Stored period (one log record)
+ */
+typedef struct {
+    uint32_t start_ms;                ///< Period start, block clock
+    uint32_t end_ms;                  ///< Period end
+    rollup_agg_t metrics[ROLLUP_METRIC_COUNT];
+} rollup_record_t;
+
+/**
+ * @brief Several periods of one metric merged, in metric units
+ */
+typedef struct {
+    uint32_t periods;                 ///< Periods with data
+    uint32_t count;                   ///< Values behind them
+    float mean;                       ///< Count-weighted
+    float min;
+    float max;
+} rollup_summary_t;
+
+/**
+ * @brief Open period of one metric
+ */
+typedef struct {
+    float sum;
+    float min;
+    float max;
+    uint32_t count;
+} rollup_acc_t;
+
+/**
+ * @brief Accounting
+ */
+typedef struct {
+    uint32_t values;                  ///< Handed to rollup_store_add()
+    uint32_t late_values;             ///< Older than an open period, ignored
+    uint32_t records_written[ROLLUP_LEVEL_COUNT];
+    uint32_t records_read;            ///< By queries and summaries
+    uint32_t write_errors;
+} rollup_stats_t;
+
+/**
+ * @brief Store instance
+ */
+typedef struct {
+    flash_slice_t slices[ROLLUP_LEVEL_COUNT];
+    flash_log_t logs[ROLLUP_LEVEL_COUNT];
+    uint32_t sector_keys[ROLLUP_MAX_SECTORS];    ///< Time index, split between the levels
+    bool open[ROLLUP_LEVEL_COUNT];
+    uint32_t period_start[ROLLUP_LEVEL_COUNT];
+    rollup_acc_t acc[ROLLUP_LEVEL_COUNT][ROLLUP_METRIC_COUNT];
+    rollup_stats_t stats;
+} rollup_store_t;
+
+// =============================================================================
+// Store Functions
+// =============================================================================
+
+/**
+ * @brief Mount (or format) the rollup logs on a region
+ *
+ * The region is split into the minute, hour and night slices; it needs
+ * at least three sectors beyond ROLLUP_HOUR_SECTORS + ROLLUP_NIGHT_SECTORS.
+ */
+bool rollup_store_open(rollup_store_t* store, const flash_device_t* dev, bool format);
+
+/**
+ * @brief Add one value to the open periods of its metric
+ *
+ * Closes (writes) periods that end at or before timestamp_ms first. A
+ * value older than a level's open period is left out of that level.
+ *
+ * @param timestamp_ms Block clock; values must not go back past an open period
+ * @param value In metric units (rollup_metric_t)
+ */
+bool rollup_store_add(rollup_store_t* store, rollup_metric_t metric, uint32_t timestamp_ms, float value);
+
+/**
+ * @brief Write the periods that have ended by now (periodic work item)
+ * @return Records written
+ */
+uint32_t rollup_store_poll(rollup_store_t* store, uint32_t now_ms);
+
+/**
+ * @brief Write every open period as it stands
+ */
+bool rollup_store_flush(rollup_store_t* store);
+
+/**
+ * @brief Background upkeep of the level logs (erase ahead)
+ * @return Sectors erased
+ */
+uint32_t rollup_store_maintain(rollup_store_t* store);
+
+/**
+ * @brief Copy the stored periods of a level that start in a window
+ *
+ * @return Records copied (oldest first), -1 on errors
+ */
+int32_t rollup_store_query(rollup_store_t* store, rollup_level_t level, uint32_t start_ms, uint32_t duration_ms,
+                           rollup_record_t* records, uint32_t max_records);
+
+/**
+ * @brief Merge a metric over the stored periods of a level that start in a window
+ *
+ * E.g. the night level over HRV_BASELINE_DAYS for a baseline.
+ *
+ * @return false on errors; a window without data gives periods == 0
+ */
+bool rollup_store_summary(rollup_store_t* store, rollup_level_t level, rollup_metric_t metric,
+                          uint32_t start_ms, uint32_t duration_ms, rollup_summary_t* summary);
+
+/**
+ * @brief Stored value in metric units
+ */
+float rollup_store_value(rollup_metric_t metric, int16_t stored);
+
+#endif // ROLLUP_STORE_H
@@ -0,0 +1,189 @@
+/*
+ * Sensor Sample Staging
+ *
+ * Blocks are laid out back to back in the stage buffer: sealed blocks
+ * first, then at most one open block. A flush hands the sealed blocks to
+ * the sink in order and moves the open block (if it stays) to the front.
+ */
+
+#include "sensor_stage.h"
+#include <string.h>
+
+#define HEADER_SIZE             ((uint32_t)sizeof(sensor_data_header_t))
+
+/* ==== PRIVATE FUNCTIONS ==== */
+
+static inline uint32_t align4(uint32_t offset)
+{
+    return (offset + 3u) & ~3u;
+}
+
+static inline sensor_data_header_t* block_at(const sensor_stage_t* stage, uint32_t offset)
+{
+    return (sensor_data_header_t*)(void*)(stage->buffer + offset);
+}
+
+static void seal(sensor_stage_t* stage)
+{
+    if (stage->open != SENSOR_STAGE_NONE) {
+        stage->fill = align4(stage->fill);
+        stage->open = SENSOR_STAGE_NONE;
+    }
+}
+
+/** Hand sealed blocks (and the open one if include_open) to the sink */
+static bool drain(sensor_stage_t* stage, sensor_stage_trigger_t trigger, bool include_open)
+{
+    bool stored = true;
+
+    if (include_open) {
+        seal(stage);
+    }
+
+    uint32_t end = stage->open == SENSOR_STAGE_NONE ? stage->fill : stage->open;
+    if (end == 0) {
+        return true;
+    }
+
+    for (uint32_t offset = 0; offset < end;) {
+        sensor_data_header_t* block = block_at(stage, offset);
+        uint32_t size = HEADER_SIZE + block->data_size;
+
+        if (stage->sink(stage->sink_context, block, stage->priority)) {
+            stage->stats.blocks++;
+            stage->stats.bytes += size;
+        } else {
+            stage->stats.dropped += block->sample_count;
+            stored = false;
+        }
+        offset = align4(offset + size);
+    }
+
+    if (stage->open != SENSOR_STAGE_NONE) {
+        uint32_t open_bytes = stage->fill - stage->open;
+        memmove(stage->buffer, stage->buffer + stage->open, open_bytes);
+        stage->open = 0;
+        stage->fill = open_bytes;
+        stage->oldest_ms = block_at(stage, 0)->timestamp_start;
+    } else {
+        stage->fill = 0;
+    }
+    stage->stats.flushes[trigger]++;
+    return stored;
+}
+
+/* ==== PUBLIC FUNCTIONS ==== */
+
+bool sensor_stage_init(sensor_stage_t* stage, const data_stream_t* stream, uint8_t* buffer,
+                       uint32_t buffer_bytes, uint16_t sensor_type, uint32_t sample_rate,
+                       sensor_stage_sink_t sink, void* sink_context)
+{
+    if (!stage || !stream || !buffer || !sink || ((uintptr_t)buffer & 3u) != 0) {
+        return false;
+    }
+
+    uint32_t buffer_size = stream->buffer_size < buffer_bytes ? stream->buffer_size : buffer_bytes;
+    if (stream->chunk_size <= HEADER_SIZE || align4(stream->chunk_size) > buffer_size) {
+        return false;
+    }
+
+    memset(stage, 0, sizeof(sensor_stage_t));
+    stage->buffer = buffer;
+    stage->buffer_size = buffer_size;
+    stage->chunk_size = stream->chunk_size;
+    stage->auto_sync = stream->auto_sync;
+    stage->sync_interval_ms = stream->sync_interval_ms;
+    stage->priority = stream->priority;
+    stage->sensor_type = sensor_type;
+    stage->sample_rate = sample_rate;
+    stage->open = SENSOR_STAGE_NONE;
+    stage->sink = sink;
+    stage->sink_context = sink_context;
+    return true;
+}
+
+bool sensor_stage_write(sensor_stage_t* stage, const void* sample, uint32_t size, uint32_t now_ms)
+{
+    if (!stage || !sample || size == 0 || HEADER_SIZE + size > stage->chunk_size) {
+        return false;
+    }
+
+    // A sample that does not fit the open block, or changes the sample size, seals it
+    if (stage->open != SENSOR_STAGE_NONE) {
+        sensor_data_header_t* block = block_at(stage, stage->open);
+        if (HEADER_SIZE + block->data_size + size > stage->chunk_size ||
+            block->data_size != block->sample_count * size) {
+            seal(stage);
+            if (stage->priority >= STORAGE_PRIORITY_HIGH) {
+                drain(stage, SENSOR_STAGE_FLUSH_PRIORITY, false);
+            }
+        }
+    }
+
+    if (stage->open == SENSOR_STAGE_NONE) {
+        if (align4(stage->fill) + stage->chunk_size > stage->buffer_size) {
+            drain(stage, SENSOR_STAGE_FLUSH_SIZE, false);
+        }
+        if (stage->fill == 0) {
+            stage->oldest_ms = now_ms;
+        }
+
+        stage->open = align4(stage->fill);
+        sensor_data_header_t* block = block_at(stage, stage->open);
+        memset(block, 0, HEADER_SIZE);
+        block->sensor_type = stage->sensor_type;
+        block->timestamp_start = now_ms;
+        block->sample_rate = stage->sample_rate;
+        stage->fill = stage->open + HEADER_SIZE;
+    }
+
+    sensor_data_header_t* block = block_at(stage, stage->open);
+    memcpy(stage->buffer + stage->fill, sample, size);
+    block->sample_count++;
+    block->data_size += size;
+    stage->fill += size;
+    stage->stats.samples++;
+
+    if (stage->priority == STORAGE_PRIORITY_CRITICAL) {
+        return drain(stage, SENSOR_STAGE_FLUSH_PRIORITY, true);
+    }
+
+    // Seal as soon as the next sample cannot fit, so a full block never waits for it
+    if (HEADER_SIZE + block->data_size + size > stage->chunk_size) {
+        seal(stage);
+        if (stage->priority >= STORAGE_PRIORITY_HIGH) {
+            drain(stage, SENSOR_STAGE_FLUSH_PRIORITY, false);
+        }
+    }
+
+    sensor_stage_poll(stage, now_ms);
+    return true;
+}
+
+bool sensor_stage_poll(sensor_stage_t* stage, uint32_t now_ms)
+{
+    if (!stage || stage->fill == 0) {
+        return false;
+    }
+
+    uint32_t age = now_ms - stage->oldest_ms;
+    if (!(stage->auto_sync && age >= stage->sync_interval_ms) &&
+        !(stage->max_age_ms > 0 && age >= stage->max_age_ms)) {
+        return false;
+    }
+    drain(stage, SENSOR_STAGE_FLUSH_TIME, true);
+    return true;
+}
+
+bool sensor_stage_flush(sensor_stage_t* stage, sensor_stage_trigger_t trigger)
+{
+    if (!stage || trigger >= SENSOR_STAGE_FLUSH_COUNT) {
+        return false;
+    }
+    return drain(stage, trigger, true);
+}
+
+uint32_t sensor_stage_pending(const sensor_stage_t* stage)
+{
+    return stage ? stage->fill : 0;
+}
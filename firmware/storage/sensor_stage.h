@@ -0,0 +1,128 @@
+#ifndef SENSOR_STAGE_H
+#define SENSOR_STAGE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "interfaces/storage_interfaces.h"
+
+/**
+ * @file sensor_stage.h
+ * @brief RAM staging that coalesces sensor samples into flash-sized blocks
+ *
+ * Samples are appended to an open block (sensor_data_header_t followed
+ * by the samples) in a RAM buffer. A block is sealed when the next
+ * sample would take it past chunk_size; sealed blocks wait in the buffer
+ * and are handed to the sink (one flash record each) when a trigger
+ * fires:
+ *
+ * - size:     no room for another chunk in buffer_size
+ * - time:     auto_sync and the oldest staged sample is sync_interval_ms old
+ * - priority: HIGH flushes each block as it seals; CRITICAL flushes
+ *             every sample before the write returns
+ * - explicit: sensor_stage_flush() (stream sync, logging stopped)
+ * - age:      max_age_ms, a bound the owner may set regardless of
+ *             auto_sync (the sensor store needs one for its time index)
+ *
+ * Sizing follows data_stream_t: buffer_size bytes of RAM, chunk_size
+ * bytes per block. Staged samples are lost on a power cut, which is the
+ * trade the priority triggers let a stream opt out of.
+ */
+
+// =============================================================================
+// Data Structures
+// =============================================================================
+
+/**
+ * @brief What made a flush happen
+ */
+typedef enum {
+    SENSOR_STAGE_FLUSH_SIZE = 0,
+    SENSOR_STAGE_FLUSH_TIME,
+    SENSOR_STAGE_FLUSH_PRIORITY,
+    SENSOR_STAGE_FLUSH_EXPLICIT,
+    SENSOR_STAGE_FLUSH_COUNT
+} sensor_stage_trigger_t;
+
+/** Receives each block to store, with the stage's priority; false counts its samples as dropped */
+typedef bool (*sensor_stage_sink_t)(void* context, sensor_data_header_t* block, storage_priority_t priority);
+
+/**
+ * @brief Staging accounting
+ */
+typedef struct {
+    uint32_t samples;                 ///< Accepted by sensor_stage_write()
+    uint32_t blocks;                  ///< Handed to the sink
+    uint32_t bytes;                   ///< Block bytes handed to the sink
+    uint32_t flushes[SENSOR_STAGE_FLUSH_COUNT];
+    uint32_t dropped;                 ///< Samples in blocks the sink refused
+} sensor_stage_stats_t;
+
+/**
+ * @brief Stage for one sensor stream
+ */
+typedef struct {
+    uint8_t* buffer;                  ///< buffer_size bytes, 4-byte aligned
+    uint32_t buffer_size;
+    uint32_t chunk_size;              ///< Largest block (header and samples)
+    bool auto_sync;
+    uint32_t sync_interval_ms;
+    uint32_t max_age_ms;              ///< Flush at this age even without auto_sync (0: none)
+    storage_priority_t priority;
+
+    uint16_t sensor_type;
+    uint32_t sample_rate;
+
+    uint32_t fill;                    ///< Bytes in use (sealed blocks, then the open one)
+    uint32_t open;                    ///< Offset of the open block, SENSOR_STAGE_NONE if none
+    uint32_t oldest_ms;               ///< Time of the oldest staged sample
+
+    sensor_stage_sink_t sink;
+    void* sink_context;
+    sensor_stage_stats_t stats;
+} sensor_stage_t;
+
+#define SENSOR_STAGE_NONE            0xFFFFFFFFu
+
+// =============================================================================
+// Stage Functions
+// =============================================================================
+
+/**
+ * @brief Set up a stage over a buffer
+ *
+ * @param stream buffer_size, chunk_size, auto_sync, sync_interval_ms and
+ *               priority are used; buffer_size is clamped to buffer_bytes
+ * @param buffer Staging RAM (4-byte aligned)
+ * @return false if a chunk does not fit the buffer or holds no sample room
+ */
+bool sensor_stage_init(sensor_stage_t* stage, const data_stream_t* stream, uint8_t* buffer,
+                       uint32_t buffer_bytes, uint16_t sensor_type, uint32_t sample_rate,
+                       sensor_stage_sink_t sink, void* sink_context);
+
+/**
+ * @brief Stage one sample
+ *
+ * May flush (size, time or priority trigger) before returning.
+ *
+ * @param now_ms Block clock; the first sample of a block sets timestamp_start
+ * @return false if the sample cannot fit a chunk
+ */
+bool sensor_stage_write(sensor_stage_t* stage, const void* sample, uint32_t size, uint32_t now_ms);
+
+/**
+ * @brief Time trigger check, for a periodic work item
+ * @return true if a flush happened
+ */
+bool sensor_stage_poll(sensor_stage_t* stage, uint32_t now_ms);
+
+/**
+ * @brief Hand every staged block, the open one included, to the sink
+ */
+bool sensor_stage_flush(sensor_stage_t* stage, sensor_stage_trigger_t trigger);
+
+/**
+ * @brief Bytes staged and not yet stored
+ */
+uint32_t sensor_stage_pending(const sensor_stage_t* stage);
+
+#endif // SENSOR_STAGE_H
@@ -0,0 +1,378 @@
+/*
+ * Time-Indexed Sensor Block Store
+ *
+ * Sensor blocks are keyed log records; the log's per-sector key table is
+ * the time index. Queries seek with a binary search over that table and
+ * scan block headers only from the sector holding the window start.
+ */
+
+#include "sensor_store.h"
+#include "flash_io/crc32.h"
+#include "storage_port.h"
+#include <string.h>
+
+LOG_MODULE_REGISTER(sensor_store, LOG_LEVEL_INF);
+
+#define FNV_OFFSET_BASIS        2166136261u
+#define FNV_PRIME               16777619u
+
+/* ==== PRIVATE FUNCTIONS ==== */
+
+static uint32_t saturating_add(uint32_t a, uint32_t b)
+{
+    return a > UINT32_MAX - b ? UINT32_MAX : a + b;
+}
+
+/** First ms after the block's last sample */
+static uint32_t block_end_ms(const sensor_data_header_t* header)
+{
+    if (header->sample_rate == 0) {
+        return header->timestamp_start;
+    }
+    uint64_t span = (uint64_t)header->sample_count * 1000u / header->sample_rate;
+    return saturating_add(header->timestamp_start, span > UINT32_MAX ? UINT32_MAX : (uint32_t)span);
+}
+
+static bool store_sink(void* context, sensor_data_header_t* block, storage_priority_t priority)
+{
+    (void)priority;
+    return sensor_store_append((sensor_store_t*)context, block);
+}
+
+/** Stage buffer from the arena (reused if large enough), then the stage itself */
+static bool setup_stage(sensor_store_t* store, sensor_store_sensor_t* sensor)
+{
+    uint8_t* buffer = sensor->stage.buffer;
+    uint32_t buffer_bytes = (sensor->stream.buffer_size + 3u) & ~3u;
+
+    if (!buffer || sensor->stage.buffer_size < buffer_bytes) {
+        if (store->arena_used + buffer_bytes > sizeof(store->stage_arena)) {
+            LOG_ERR("Stage arena full for %s (%u bytes)", sensor->name, buffer_bytes);
+            return false;
+        }
+        buffer = (uint8_t*)store->stage_arena + store->arena_used;
+        store->arena_used += buffer_bytes;
+    } else {
+        buffer_bytes = sensor->stage.buffer_size;
+    }
+
+    if (!sensor_stage_init(&sensor->stage, &sensor->stream, buffer, buffer_bytes, sensor->sensor_type,
+                           sensor->sample_rate, store_sink, store)) {
+        return false;
+    }
+    sensor->stage.max_age_ms = SENSOR_STORE_MAX_STAGE_MS;
+    return true;
+}
+
+static sensor_store_sensor_t* register_sensor(sensor_store_t* store, const char* name)
+{
+    uint16_t sensor_type = sensor_store_type_of(name);
+
+    for (uint32_t i = 0; i < store->sensor_count; i++) {
+        if (store->sensors[i].sensor_type == sensor_type) {
+            LOG_ERR("Sensor %s collides with %s", name, store->sensors[i].name);
+            return NULL;
+        }
+    }
+    if (store->sensor_count >= SENSOR_STORE_MAX_SENSORS) {
+        return NULL;
+    }
+
+    sensor_store_sensor_t* sensor = &store->sensors[store->sensor_count++];
+    memset(sensor, 0, sizeof(sensor_store_sensor_t));
+    strncpy(sensor->name, name, SENSOR_STORE_NAME_LENGTH - 1);
+    sensor->sensor_type = sensor_type;
+    return sensor;
+}
+
+/* ==== PUBLIC FUNCTIONS ==== */
+
+bool sensor_store_open(sensor_store_t* store, const flash_device_t* dev, bool format)
+{
+    if (!store || !dev || dev->sector_size == 0 || dev->size / dev->sector_size > FLASH_LOG_MAX_SECTORS) {
+        return false;
+    }
+
+    flash_log_config_t config = FLASH_LOG_DEFAULT_CONFIG;
+    config.sector_keys = store->sector_keys;
+    memset(&store->stats, 0, sizeof(store->stats));
+
+    bool ok = format ? flash_log_format(&store->log, dev, &config) : flash_log_mount(&store->log, dev, &config);
+    if (!ok) {
+        LOG_ERR("Sensor store %s failed", format ? "format" : "mount");
+    }
+    return ok;
+}
+
+bool sensor_store_append(sensor_store_t* store, sensor_data_header_t* block)
+{
+    if (!store || !block) {
+        return false;
+    }
+
+    sensor_store_seal(block);
+    if (!flash_log_append_keyed(&store->log, SENSOR_STORE_RECORD_TYPE, block->timestamp_start, block,
+                                sizeof(sensor_data_header_t) + block->data_size, NULL)) {
+        return false;
+    }
+    store->stats.blocks_appended++;
+    return true;
+}
+
+int32_t sensor_store_read(sensor_store_t* store, uint16_t sensor_type, uint32_t start_ms,
+                          uint32_t duration_ms, void* buffer, uint32_t buffer_size)
+{
+    if (!store) {
+        return -1;
+    }
+    return sensor_store_read_log(&store->log, &store->stats, sensor_type, start_ms, duration_ms,
+                                 buffer, buffer_size);
+}
+
+int32_t sensor_store_read_log(flash_log_t* log, sensor_store_stats_t* stats, uint16_t sensor_type,
+                              uint32_t start_ms, uint32_t duration_ms, void* buffer, uint32_t buffer_size)
+{
+    uint8_t* out = (uint8_t*)buffer;
+    uint32_t copied = 0;
+    uint32_t probes = 0;
+    flash_log_cursor_t cursor;
+
+    if (!log || !stats || !buffer || !flash_log_seek(log, start_ms > SENSOR_STORE_ORDER_SLACK_MS ?
+                                                         start_ms - SENSOR_STORE_ORDER_SLACK_MS : 0,
+                                                     &cursor, &probes)) {
+        return -1;
+    }
+
+    uint32_t end_ms = saturating_add(start_ms, duration_ms);
+    uint32_t stop_ms = saturating_add(end_ms, SENSOR_STORE_ORDER_SLACK_MS);
+    stats->reads++;
+    stats->seek_probes += probes;
+
+    for (;;) {
+        sensor_data_header_t header;
+        flash_log_record_t record;
+        int32_t length = flash_log_peek(log, &cursor, &header, sizeof(header), &record);
+
+        if (length <= 0) {
+            if (length < 0) {
+                return -1;
+            }
+            break;
+        }
+        stats->records_scanned++;
+
+        if (record.type == SENSOR_STORE_RECORD_TYPE && (uint32_t)length >= sizeof(header) &&
+            header.magic == SENSOR_STORE_MAGIC) {
+            if (header.timestamp_start >= stop_ms) {
+                break;
+            }
+            if (header.sensor_type == sensor_type && sensor_store_block_overlaps(&header, start_ms, end_ms)) {
+                if (copied + (uint32_t)length > buffer_size) {
+                    break;
+                }
+                int32_t got = flash_log_read(log, &cursor, out + copied, (uint32_t)length, NULL);
+                if (got == FLASH_LOG_CORRUPT) {
+                    continue;
+                }
+                if (got != length) {
+                    return -1;
+                }
+                copied += (uint32_t)length;
+                stats->blocks_returned++;
+                continue;
+            }
+        }
+        flash_log_skip(log, &cursor);
+    }
+    return (int32_t)copied;
+}
+
+const sensor_data_header_t* sensor_store_next_block(sensor_store_t* store, flash_log_cursor_t* cursor)
+{
+    flash_log_record_t record;
+    const void* payload;
+    int32_t length;
+
+    if (!store || !cursor) {
+        return NULL;
+    }
+
+    while ((length = flash_log_read_mapped(&store->log, cursor, &payload, &record)) > 0 ||
+           length == FLASH_LOG_CORRUPT) {
+        const sensor_data_header_t* block = (const sensor_data_header_t*)payload;
+        if (length > 0 && record.type == SENSOR_STORE_RECORD_TYPE && (uint32_t)length >= sizeof(*block) &&
+            block->magic == SENSOR_STORE_MAGIC && block->data_size <= (uint32_t)length - sizeof(*block)) {
+            return block;
+        }
+    }
+    return NULL;
+}
+
+void sensor_store_seal(sensor_data_header_t* block)
+{
+    block->magic = SENSOR_STORE_MAGIC;
+    block->version = SENSOR_STORE_VERSION;
+    block->checksum = crc32_compute(block + 1, block->data_size);
+}
+
+bool sensor_store_block_overlaps(const sensor_data_header_t* block, uint32_t start_ms, uint32_t end_ms)
+{
+    return block->timestamp_start < end_ms &&
+           (block->timestamp_start >= start_ms || block_end_ms(block) > start_ms);
+}
+
+bool sensor_store_block_valid(const sensor_data_header_t* block, uint32_t size)
+{
+    return block && size >= sizeof(sensor_data_header_t) && block->magic == SENSOR_STORE_MAGIC &&
+           block->version == SENSOR_STORE_VERSION && block->data_size <= size - sizeof(sensor_data_header_t) &&
+           crc32_compute(block + 1, block->data_size) == block->checksum;
+}
+
+bool sensor_store_configure_stream(sensor_store_t* store, const char* name, const data_stream_t* stream)
+{
+    sensor_store_sensor_t* sensor = sensor_store_find(store, name);
+
+    if (!sensor || !stream || sensor_stage_pending(&sensor->stage) > 0 ||
+        stream->chunk_size <= sizeof(sensor_data_header_t) || stream->chunk_size > stream->buffer_size) {
+        return false;
+    }
+
+    sensor->stream = *stream;
+    return sensor->stage.buffer ? setup_stage(store, sensor) : true;
+}
+
+uint32_t sensor_store_poll(sensor_store_t* store)
+{
+    uint32_t flushed = 0;
+    uint32_t now = sensor_store_now(store);
+
+    for (uint32_t i = 0; store && i < store->sensor_count; i++) {
+        if (store->sensors[i].stage.buffer && sensor_stage_poll(&store->sensors[i].stage, now)) {
+            flushed++;
+        }
+    }
+    return flushed;
+}
+
+bool sensor_store_flush(sensor_store_t* store)
+{
+    bool stored = store != NULL;
+
+    for (uint32_t i = 0; store && i < store->sensor_count; i++) {
+        if (store->sensors[i].stage.buffer) {
+            stored &= sensor_stage_flush(&store->sensors[i].stage, SENSOR_STAGE_FLUSH_EXPLICIT);
+        }
+    }
+    return stored;
+}
+
+void sensor_store_set_time(sensor_store_t* store, uint32_t now_ms)
+{
+    store->time_offset_ms = now_ms - STORAGE_UPTIME_MS();
+}
+
+uint32_t sensor_store_now(const sensor_store_t* store)
+{
+    return STORAGE_UPTIME_MS() + store->time_offset_ms;
+}
+
+uint16_t sensor_store_type_of(const char* name)
+{
+    uint32_t hash = FNV_OFFSET_BASIS;
+
+    for (const char* c = name; c && *c; c++) {
+        hash = (hash ^ (uint8_t)*c) * FNV_PRIME;
+    }
+    uint16_t folded = (uint16_t)(hash ^ (hash >> 16));
+    return folded ? folded : 1;
+}
+
+sensor_store_sensor_t* sensor_store_find(sensor_store_t* store, const char* name)
+{
+    for (uint32_t i = 0; store && name && i < store->sensor_count; i++) {
+        if (strncmp(store->sensors[i].name, name, SENSOR_STORE_NAME_LENGTH) == 0) {
+            return &store->sensors[i];
+        }
+    }
+    return NULL;
+}
+
+void sensor_store_index_cost(const sensor_store_t* store, uint32_t* index_bytes, uint32_t* data_bytes)
+{
+    const flash_log_t* log = &store->log;
+
+    if (index_bytes) {
+        *index_bytes = log->sector_count * (uint32_t)sizeof(store->sector_keys[0]);
+    }
+    if (data_bytes) {
+        *data_bytes = log->sector_count * log->dev->sector_size;
+    }
+}
+
+/* ==== STORAGE API BINDING ==== */
+
+static sensor_store_t* bound_store;
+
+void sensor_store_bind(sensor_store_t* store)
+{
+    bound_store = store;
+}
+
+bool storage_start_sensor_logging(const char* sensor_name, uint32_t sample_rate, storage_priority_t priority)
+{
+    if (!bound_store || !sensor_name || strlen(sensor_name) >= SENSOR_STORE_NAME_LENGTH) {
+        return false;
+    }
+
+    sensor_store_sensor_t* sensor = sensor_store_find(bound_store, sensor_name);
+    if (!sensor) {
+        sensor = register_sensor(bound_store, sensor_name);
+        if (!sensor) {
+            return false;
+        }
+        sensor->stream = SENSOR_STORE_DEFAULT_STREAM;
+    }
+
+    sensor->sample_rate = sample_rate;
+    sensor->priority = priority;
+    sensor->stream.priority = priority;
+    if (sensor->stage.buffer) {
+        sensor->stage.sample_rate = sample_rate;
+        sensor->stage.priority = priority;
+    }
+    sensor->logging = true;
+    return true;
+}
+
+bool storage_log_sensor_sample(const char* sensor_name, const void* sample_data, uint32_t sample_size)
+{
+    sensor_store_sensor_t* sensor = sensor_store_find(bound_store, sensor_name);
+
+    if (!sensor || !sensor->logging || (!sensor->stage.buffer && !setup_stage(bound_store, sensor))) {
+        return false;
+    }
+    return sensor_stage_write(&sensor->stage, sample_data, sample_size, sensor_store_now(bound_store));
+}
+
+bool storage_stop_sensor_logging(const char* sensor_name)
+{
+    sensor_store_sensor_t* sensor = sensor_store_find(bound_store, sensor_name);
+
+    if (!sensor) {
+        return false;
+    }
+    sensor->logging = false;
+    return !sensor->stage.buffer || sensor_stage_flush(&sensor->stage, SENSOR_STAGE_FLUSH_EXPLICIT);
+}
+
+int32_t storage_read_sensor_data(const char* sensor_name, uint32_t start_time, uint32_t duration_s,
+                                 void* buffer, uint32_t buffer_size)
+{
+    if (!bound_store || !sensor_name) {
+        return -1;
+    }
+
+    uint32_t duration_ms = duration_s > UINT32_MAX / 1000u ? UINT32_MAX : duration_s * 1000u;
+    return sensor_store_read(bound_store, sensor_store_type_of(sensor_name), start_time, duration_ms,
+                             buffer, buffer_size);
+}
@@ -0,0 +1,236 @@
+#ifndef SENSOR_STORE_H
+#define SENSOR_STORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "flash_io/flash_log.h"
+#include "sensor_stage.h"
+#include "interfaces/storage_interfaces.h"
+
+/**
+ * @file sensor_store.h
+ * @brief Time-indexed sensor block store on the flash log
+ *
+ * Each sensor block (sensor_data_header_t followed by its data) is one
+ * log record keyed by timestamp_start. The log keeps the first key of
+ * every sector in a RAM table (flash_log_seek), which is the sparse time
+ * index: 4 bytes per 4 KB sector, mirrored in the sector headers and
+ * rebuilt by the mount scan. A read binary-searches the table, then
+ * walks records from that sector until blocks start past the window.
+ *
+ * Blocks of different sensors are appended as they fill, so their start
+ * times interleave out of order by up to the staging latency. Stages are
+ * flushed at SENSOR_STORE_MAX_STAGE_MS at the latest, and seeks and the
+ * end-of-window test allow SENSOR_STORE_ORDER_SLACK_MS for that.
+ *
+ * Samples logged through storage_log_sensor_sample() are coalesced per
+ * sensor by a sensor_stage_t (sensor_stage.h) into chunk-sized blocks,
+ * so the flash sees one record per chunk instead of one per sample.
+ * Stage buffers come from a fixed arena in the store.
+ *
+ * Blocks are self-checking: sensor_store_append() fills in magic,
+ * version and a CRC-32 of the data in checksum, so a block stays
+ * verifiable after it leaves the log (BLE sync, flash dumps). On flash
+ * the log's record CRC covers it as well; corrupt records are skipped.
+ *
+ * Timestamps are in ms on the block clock: uptime plus an offset set by
+ * sensor_store_set_time() (e.g. from BLE time sync), so it does not go
+ * backwards across reboots. The storage_* API binds to one store.
+ */
+
+// =============================================================================
+// Limits
+// =============================================================================
+
+#define SENSOR_STORE_MAGIC             0x534E5342u  ///< "BSNS" in sensor_data_header_t.magic
+#define SENSOR_STORE_VERSION           2            ///< 2: checksum is the CRC-32 of the data
+#define SENSOR_STORE_RECORD_TYPE       0x01         ///< Log record type of sensor blocks
+#define SENSOR_STORE_MAX_SENSORS       8
+#define SENSOR_STORE_NAME_LENGTH       16
+#define SENSOR_STORE_MAX_STAGE_MS      30000        ///< Oldest sample a stage may hold
+#define SENSOR_STORE_ORDER_SLACK_MS    60000        ///< Start-time disorder allowed (staging plus poll delay)
+
+#ifndef SENSOR_STORE_STAGE_ARENA
+#define SENSOR_STORE_STAGE_ARENA       8192         ///< Staging RAM shared by all sensors
+#endif
+
+/** Staging used by storage_start_sensor_logging() until configured otherwise */
+static const data_stream_t SENSOR_STORE_DEFAULT_STREAM = {
+    .buffer_size = 2048,              // Two chunks: one filling, one waiting
+    .chunk_size = 1024,               // Four flash pages per block
+    .auto_sync = true,
+    .sync_interval_ms = 30000,        // Bound what a power cut loses
+    .priority = STORAGE_PRIORITY_MEDIUM
+};
+
+// =============================================================================
+// Data Structures
+// =============================================================================
+
+/**
+ * @brief Registered sensor stream
+ */
+typedef struct {
+    char name[SENSOR_STORE_NAME_LENGTH];
+    uint16_t sensor_type;             ///< Stable id derived from the name
+    uint32_t sample_rate;
+    storage_priority_t priority;
+    bool logging;
+    data_stream_t stream;             ///< Staging settings
+    sensor_stage_t stage;             ///< Set up at the first sample
+} sensor_store_sensor_t;
+
+/**
+ * @brief Read accounting
+ */
+typedef struct {
+    uint32_t blocks_appended;
+    uint32_t reads;
+    uint32_t seek_probes;             ///< Key table entries examined
+    uint32_t records_scanned;         ///< Block headers read by queries
+    uint32_t blocks_returned;
+} sensor_store_stats_t;
+
+/**
+ * @brief Store instance
+ */
+typedef struct {
+    flash_log_t log;
+    uint32_t sector_keys[FLASH_LOG_MAX_SECTORS];  ///< Time index (first timestamp per sector)
+    sensor_store_sensor_t sensors[SENSOR_STORE_MAX_SENSORS];
+    uint32_t sensor_count;
+    uint32_t stage_arena[SENSOR_STORE_STAGE_ARENA / sizeof(uint32_t)];
+    uint32_t arena_used;              ///< Bytes handed out (never returned)
+    uint32_t time_offset_ms;          ///< Block clock minus uptime
+    sensor_store_stats_t stats;
+} sensor_store_t;
+
+// =============================================================================
+// Store Functions
+// =============================================================================
+
+/**
+ * @brief Mount (or format) the store on a flash region
+ *
+ * Registered sensors are kept.
+ */
+bool sensor_store_open(sensor_store_t* store, const flash_device_t* dev, bool format);
+
+/**
+ * @brief Append one block
+ *
+ * @param block Header followed in memory by data_size bytes; magic,
+ *              version and checksum are filled in
+ */
+bool sensor_store_append(sensor_store_t* store, sensor_data_header_t* block);
+
+/**
+ * @brief Copy the blocks of one sensor that overlap a time window
+ *
+ * Whole blocks (header and data) are packed into the buffer in log
+ * order; blocks that do not fit end the read.
+ *
+ * @param sensor_type Sensor id (sensor_store_type_of)
+ * @param start_ms Window start
+ * @param duration_ms Window length
+ * @return Bytes copied, -1 on errors
+ */
+int32_t sensor_store_read(sensor_store_t* store, uint16_t sensor_type, uint32_t start_ms,
+                          uint32_t duration_ms, void* buffer, uint32_t buffer_size);
+
+/**
+ * @brief sensor_store_read() over any log of sensor blocks
+ *
+ * For stores that keep blocks in several logs (tier_store.h). The log
+ * must have a key table.
+ *
+ * @param stats Read accounting to update
+ */
+int32_t sensor_store_read_log(flash_log_t* log, sensor_store_stats_t* stats, uint16_t sensor_type,
+                              uint32_t start_ms, uint32_t duration_ms, void* buffer, uint32_t buffer_size);
+
+/**
+ * @brief Next sensor block in place (memory-mapped devices, flash_map.h)
+ *
+ * Zero-copy walk for host tools: records that are not sensor blocks or
+ * fail their CRC are skipped.
+ *
+ * @param cursor From flash_log_cursor_first() or flash_log_seek()
+ * @return Block inside the device map, NULL at the end
+ */
+const sensor_data_header_t* sensor_store_next_block(sensor_store_t* store, flash_log_cursor_t* cursor);
+
+/**
+ * @brief Fill in a block's magic, version and data checksum
+ */
+void sensor_store_seal(sensor_data_header_t* block);
+
+/**
+ * @brief Whether a block has samples in [start_ms, end_ms)
+ *
+ * Instant blocks (sample_rate 0) count at their start time.
+ */
+bool sensor_store_block_overlaps(const sensor_data_header_t* block, uint32_t start_ms, uint32_t end_ms);
+
+/**
+ * @brief Check a block's magic, version and data checksum
+ *
+ * @param size Bytes available at block (header and data)
+ */
+bool sensor_store_block_valid(const sensor_data_header_t* block, uint32_t size);
+
+/**
+ * @brief Stage a sensor's samples according to a stream description
+ *
+ * Uses buffer_size, chunk_size, auto_sync, sync_interval_ms and priority.
+ * The sensor must be registered and its stage empty. The buffer is
+ * taken from the arena at the first sample, so configuring right after
+ * storage_start_sensor_logging() costs no RAM twice. Staging never
+ * exceeds SENSOR_STORE_MAX_STAGE_MS, whatever auto_sync says.
+ */
+bool sensor_store_configure_stream(sensor_store_t* store, const char* name, const data_stream_t* stream);
+
+/**
+ * @brief Time trigger for every stage (periodic work item)
+ * @return Stages flushed
+ */
+uint32_t sensor_store_poll(sensor_store_t* store);
+
+/**
+ * @brief Store everything staged
+ */
+bool sensor_store_flush(sensor_store_t* store);
+
+/**
+ * @brief Set the block clock
+ */
+void sensor_store_set_time(sensor_store_t* store, uint32_t now_ms);
+
+/**
+ * @brief Current block clock
+ */
+uint32_t sensor_store_now(const sensor_store_t* store);
+
+/**
+ * @brief Stable sensor id for a name (FNV-1a folded to 16 bits, never 0)
+ */
+uint16_t sensor_store_type_of(const char* name);
+
+/**
+ * @brief Registered sensor by name, NULL if unknown
+ */
+sensor_store_sensor_t* sensor_store_find(sensor_store_t* store, const char* name);
+
+/**
+ * @brief Time index footprint: RAM bytes and the data bytes it covers
+ */
+void sensor_store_index_cost(const sensor_store_t* store, uint32_t* index_bytes, uint32_t* data_bytes);
+
+/**
+ * @brief Route the storage_*_sensor_* API to a store
+ *
+ * storage_read_sensor_data() takes start_time in ms on the block clock.
+ */
+void sensor_store_bind(sensor_store_t* store);
+
+#endif // SENSOR_STORE_H
@@ -0,0 +1,472 @@
+/*
+ * Incremental Garbage Collection
+ *
+ * A slice goes round the jobs, one step each, for as long as steps make
+ * progress and fit the budget; the next slice starts after the job the
+ * last one stopped at, so a busy job cannot starve the others. On
+ * target a delayable work item runs the slices and reschedules itself.
+ */
+
+#include "storage_gc.h"
+#include "storage_port.h"
+#include <stdio.h>
+#include <string.h>
+
+LOG_MODULE_REGISTER(storage_gc, LOG_LEVEL_INF);
+
+#define FIRST_OCTAVE            4u      /* Bucket 0 holds everything below 16 us */
+#define HEADER_READ_US          ((32u * STORAGE_GC_READ_NS_PER_BYTE + 999u) / 1000u)
+
+/* ==== PRIVATE FUNCTIONS ==== */
+
+static uint32_t bucket_of(uint32_t us)
+{
+    if (us < (1u << FIRST_OCTAVE)) {
+        return 0;
+    }
+
+    uint32_t bucket = 31u - (uint32_t)__builtin_clz(us) - FIRST_OCTAVE + 1u;
+    return bucket < STORAGE_GC_PAUSE_BUCKETS ? bucket : STORAGE_GC_PAUSE_BUCKETS - 1u;
+}
+
+/** Longest pause that falls in a bucket */
+static uint32_t bucket_upper(uint32_t bucket)
+{
+    return (1u << (bucket + FIRST_OCTAVE)) - 1u;
+}
+
+static void record_pause(storage_gc_t* gc, uint32_t us)
+{
+    storage_gc_stats_t* stats = &gc->stats;
+
+    stats->slices++;
+    stats->total_us += us;
+    stats->histogram[bucket_of(us)]++;
+    if (us > stats->max_us) {
+        stats->max_us = us;
+    }
+    if (us > gc->config.budget_us) {
+        stats->overruns++;
+        LOG_WRN("GC slice took %u us, budget %u us", us, gc->config.budget_us);
+    }
+}
+
+static void put_u32(uint8_t* p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+/**
+ * Raise the step estimate to a longer measurement at once, and let it
+ * fall back towards the declared cost (or the step just measured) by
+ * 1/2^STORAGE_GC_COST_DECAY_SHIFT per step, so one preempted step does
+ * not keep the job out of slices for good.
+ */
+static void update_cost(storage_gc_t* gc, storage_gc_job_t* job, uint32_t took)
+{
+    uint32_t floor = took > job->declared_us ? took : job->declared_us;
+
+    if (took > job->declared_us) {
+        job->overruns++;
+    }
+    if (took > job->cost_us) {
+        job->cost_us = took;
+        if (took > gc->config.budget_us) {
+            LOG_WRN("GC job %s step took %u us, budget %u us", job->name, took, gc->config.budget_us);
+        }
+    } else {
+        job->cost_us -= (job->cost_us - floor) >> STORAGE_GC_COST_DECAY_SHIFT;
+    }
+}
+
+static storage_gc_result_t log_step(void* context)
+{
+    bool busy;
+
+    if (flash_log_erase_step((flash_log_t*)context, &busy)) {
+        return STORAGE_GC_PROGRESS;
+    }
+    return busy ? STORAGE_GC_BLOCKED : STORAGE_GC_IDLE;
+}
+
+static storage_gc_result_t config_step(void* context)
+{
+    bool busy;
+
+    if (config_store_gc_step((config_store_t*)context, STORAGE_GC_COMPACT_BYTES, STORAGE_GC_COMPACT_PROGRAMS, &busy)) {
+        return STORAGE_GC_PROGRESS;
+    }
+    return busy ? STORAGE_GC_BLOCKED : STORAGE_GC_IDLE;
+}
+
+/* ==== PUBLIC FUNCTIONS ==== */
+
+bool storage_gc_init(storage_gc_t* gc, const storage_gc_config_t* config, storage_gc_yield_t yield,
+                     void* yield_context)
+{
+    if (!gc || (config && (config->budget_us == 0 || config->period_ms == 0))) {
+        return false;
+    }
+
+    memset(gc, 0, sizeof(storage_gc_t));
+    gc->config = config ? *config : STORAGE_GC_DEFAULT_CONFIG;
+    gc->yield = yield;
+    gc->yield_context = yield_context;
+    return true;
+}
+
+bool storage_gc_add(storage_gc_t* gc, const char* name, storage_gc_step_t step, void* context, uint32_t cost_us)
+{
+    if (!gc || !name || !step || gc->job_count >= STORAGE_GC_MAX_JOBS) {
+        return false;
+    }
+    if (cost_us > gc->config.budget_us) {
+        LOG_WRN("GC job %s needs %u us per step, budget %u us: left to the foreground", name, cost_us,
+                gc->config.budget_us);
+    }
+
+    storage_gc_job_t* job = &gc->jobs[gc->job_count++];
+    memset(job, 0, sizeof(storage_gc_job_t));
+    job->name = name;
+    job->step = step;
+    job->context = context;
+    job->declared_us = cost_us;
+    job->cost_us = cost_us;
+    return true;
+}
+
+bool storage_gc_add_log(storage_gc_t* gc, const char* name, flash_log_t* log)
+{
+    // Header read and erase command, or the header program once erased
+    return log && storage_gc_add(gc, name, log_step, log, HEADER_READ_US + STORAGE_GC_PROGRAM_US);
+}
+
+bool storage_gc_add_config(storage_gc_t* gc, const char* name, config_store_t* store)
+{
+    // Record headers and bodies read, then one record copied
+    uint32_t read_us = (STORAGE_GC_COMPACT_BYTES * STORAGE_GC_READ_NS_PER_BYTE + 999u) / 1000u + 3u * HEADER_READ_US;
+    return store && storage_gc_add(gc, name, config_step, store,
+                                   read_us + STORAGE_GC_COMPACT_PROGRAMS * STORAGE_GC_PROGRAM_US);
+}
+
+uint32_t storage_gc_slice(storage_gc_t* gc)
+{
+    uint32_t start = STORAGE_UPTIME_US();
+    uint32_t done = 0;
+    bool progress = true;
+    bool stepped = false;
+    bool yielded = false;
+    uint32_t first_deferred = STORAGE_GC_MAX_JOBS;
+
+    if (!gc) {
+        return 0;
+    }
+    gc->pending = false;
+    while (progress) {
+        progress = false;
+        for (uint32_t n = 0; n < gc->job_count; n++) {
+            uint32_t index = (gc->next_job + n) % gc->job_count;
+            storage_gc_job_t* job = &gc->jobs[index];
+
+            if (gc->yield && gc->yield(gc->yield_context)) {
+                gc->stats.yields++;
+                gc->pending = true;
+                gc->next_job = index;
+                yielded = true;
+                progress = false;
+                break;
+            }
+
+            // Declared too slow for any slice: left to the foreground. Grown too slow: runs alone
+            uint32_t begin = STORAGE_UPTIME_US();
+            if (job->declared_us > gc->config.budget_us ||
+                (stepped && begin - start + job->cost_us > gc->config.budget_us)) {
+                job->deferred++;
+                if (job->declared_us <= gc->config.budget_us) {
+                    gc->pending = true;
+                    first_deferred = first_deferred < STORAGE_GC_MAX_JOBS ? first_deferred : index;
+                }
+                continue;
+            }
+
+            stepped = true;
+            storage_gc_result_t result = job->step(job->context);
+            uint32_t took = STORAGE_UPTIME_US() - begin;
+            if (result == STORAGE_GC_IDLE) {
+                continue;
+            }
+            update_cost(gc, job, took);
+            gc->pending = true;
+            if (result == STORAGE_GC_BLOCKED) {
+                job->blocked++;
+                continue;
+            }
+            job->steps++;
+            done++;
+            progress = true;
+            gc->next_job = (index + 1u) % gc->job_count;
+        }
+    }
+
+    // A deferred job opens the next slice, where it fits or at least runs alone
+    if (!yielded && first_deferred < STORAGE_GC_MAX_JOBS) {
+        gc->next_job = first_deferred;
+    }
+    record_pause(gc, STORAGE_UPTIME_US() - start);
+    gc->stats.steps += done;
+    return done;
+}
+
+uint32_t storage_gc_next_delay_ms(const storage_gc_t* gc)
+{
+    return gc->pending ? gc->config.period_ms : gc->config.idle_ms;
+}
+
+void storage_gc_summary(const storage_gc_t* gc, storage_gc_summary_t* summary)
+{
+    const storage_gc_stats_t* stats = &gc->stats;
+
+    memset(summary, 0, sizeof(storage_gc_summary_t));
+    if (stats->slices == 0) {
+        return;
+    }
+
+    // Smallest bucket holding at least 99% of slices
+    uint32_t target = (uint32_t)(((uint64_t)stats->slices * 99u + 99u) / 100u);
+    uint32_t seen = 0;
+    uint32_t p99 = stats->max_us;
+    for (uint32_t b = 0; b < STORAGE_GC_PAUSE_BUCKETS; b++) {
+        seen += stats->histogram[b];
+        if (seen >= target) {
+            p99 = bucket_upper(b);
+            break;
+        }
+    }
+
+    summary->slices = stats->slices;
+    summary->mean_us = (uint32_t)(stats->total_us / stats->slices);
+    summary->p99_us = p99 < stats->max_us ? p99 : stats->max_us;
+    summary->max_us = stats->max_us;
+    summary->overruns = stats->overruns;
+}
+
+uint32_t storage_gc_format(const storage_gc_t* gc, char* text, uint32_t size)
+{
+    storage_gc_summary_t s;
+
+    if (!gc || !text || size == 0) {
+        return 0;
+    }
+
+    storage_gc_summary(gc, &s);
+    int n = snprintf(text, size, "slices %u, mean %u us, p99 %u us, max %u us, budget %u us, overruns %u\n",
+                     (unsigned)s.slices, (unsigned)s.mean_us, (unsigned)s.p99_us, (unsigned)s.max_us,
+                     (unsigned)gc->config.budget_us, (unsigned)s.overruns);
+    if (n < 0 || (uint32_t)n >= size) {
+        text[0] = '\0';
+        return 0;
+    }
+    uint32_t pos = (uint32_t)n;
+
+    for (uint32_t b = 0; b < STORAGE_GC_PAUSE_BUCKETS && pos < size; b++) {
+        if (gc->stats.histogram[b] == 0) {
+            continue;
+        }
+        n = snprintf(text + pos, size - pos, "  <%6u us %8u\n", (unsigned)(bucket_upper(b) + 1u),
+                     (unsigned)gc->stats.histogram[b]);
+        if (n < 0 || (uint32_t)n >= size - pos) {
+            text[pos] = '\0';
+            return pos;
+        }
+        pos += (uint32_t)n;
+    }
+
+    for (uint32_t i = 0; i < gc->job_count; i++) {
+        const storage_gc_job_t* job = &gc->jobs[i];
+        n = snprintf(text + pos, size - pos,
+                     "%-12.12s cost %5u us, steps %u, blocked %u, deferred %u, overruns %u\n",
+                     job->name, (unsigned)job->cost_us, (unsigned)job->steps, (unsigned)job->blocked,
+                     (unsigned)job->deferred, (unsigned)job->overruns);
+        if (n < 0 || (uint32_t)n >= size - pos) {
+            text[pos] = '\0';
+            break;
+        }
+        pos += (uint32_t)n;
+    }
+    return pos;
+}
+
+uint32_t storage_gc_pack(const storage_gc_t* gc, uint8_t* data, uint32_t size)
+{
+    storage_gc_summary_t s;
+    uint32_t pos = 4u + STORAGE_GC_SUMMARY_SIZE;
+    uint32_t records = 0;
+
+    if (!gc || !data || size < pos) {
+        return 0;
+    }
+
+    storage_gc_summary(gc, &s);
+    put_u32(data + 4, s.slices);
+    put_u32(data + 8, s.mean_us);
+    put_u32(data + 12, s.p99_us);
+    put_u32(data + 16, s.max_us);
+    put_u32(data + 20, gc->config.budget_us);
+    put_u32(data + 24, s.overruns);
+    put_u32(data + 28, gc->stats.yields);
+
+    for (uint32_t i = 0; i < gc->job_count && pos + STORAGE_GC_RECORD_SIZE <= size; i++) {
+        const storage_gc_job_t* job = &gc->jobs[i];
+        uint8_t* p = data + pos;
+
+        memset(p, 0, STORAGE_GC_NAME_LEN);
+        strncpy((char*)p, job->name, STORAGE_GC_NAME_LEN);
+        put_u32(p + 12, job->cost_us);
+        put_u32(p + 16, job->steps);
+        put_u32(p + 20, job->blocked);
+        put_u32(p + 24, job->deferred);
+        pos += STORAGE_GC_RECORD_SIZE;
+        records++;
+    }
+
+    data[0] = STORAGE_GC_PACK_VERSION;
+    data[1] = (uint8_t)records;
+    data[2] = 0;
+    data[3] = 0;
+    return pos;
+}
+
+void storage_gc_reset_stats(storage_gc_t* gc)
+{
+    memset(&gc->stats, 0, sizeof(gc->stats));
+    for (uint32_t i = 0; i < gc->job_count; i++) {
+        gc->jobs[i].steps = 0;
+        gc->jobs[i].blocked = 0;
+        gc->jobs[i].deferred = 0;
+        gc->jobs[i].overruns = 0;
+    }
+}
+
+/* ==== STORAGE API BINDING ==== */
+
+static storage_gc_t* bound_gc;
+
+void storage_gc_bind(storage_gc_t* gc)
+{
+    bound_gc = gc;
+}
+
+bool storage_garbage_collect(void)
+{
+    if (!bound_gc) {
+        return false;
+    }
+    storage_gc_slice(bound_gc);
+    return true;
+}
+
+bool storage_gc_ble_read(ble_char_value_t* value, uint32_t* length)
+{
+    if (!value || !value->data) {
+        return false;
+    }
+
+    uint32_t pos = storage_gc_pack(bound_gc, (uint8_t*)value->data, value->max_length);
+    if (pos == 0) {
+        return false;
+    }
+    value->current_length = pos;
+    if (length) {
+        *length = pos;
+    }
+    return true;
+}
+
+/* ==== WORK ITEM ==== */
+
+#ifdef __ZEPHYR__
+
+static void gc_work_handler(struct k_work* work)
+{
+    struct k_work_delayable* dwork = k_work_delayable_from_work(work);
+    storage_gc_t* gc = CONTAINER_OF(dwork, storage_gc_t, work);
+
+    storage_gc_slice(gc);
+    if (gc->queue) {
+        k_work_reschedule_for_queue(gc->queue, &gc->work, K_MSEC(storage_gc_next_delay_ms(gc)));
+    } else {
+        k_work_reschedule(&gc->work, K_MSEC(storage_gc_next_delay_ms(gc)));
+    }
+}
+
+bool storage_gc_start(storage_gc_t* gc, struct k_work_q* queue)
+{
+    if (!gc) {
+        return false;
+    }
+
+    gc->queue = queue;
+    k_work_init_delayable(&gc->work, gc_work_handler);
+    int ret = queue ? k_work_schedule_for_queue(queue, &gc->work, K_NO_WAIT)
+                    : k_work_schedule(&gc->work, K_NO_WAIT);
+    if (ret < 0) {
+        LOG_ERR("GC work item not scheduled: %d", ret);
+        return false;
+    }
+    return true;
+}
+
+void storage_gc_stop(storage_gc_t* gc)
+{
+    if (gc) {
+        k_work_cancel_delayable(&gc->work);
+    }
+}
+
+#endif
+
+/* ==== SHELL COMMANDS ==== */
+
+#if defined(__ZEPHYR__) && defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+
+static int cmd_gc_show(const struct shell* sh, size_t argc, char** argv)
+{
+    static char text[640];
+
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    if (!bound_gc) {
+        shell_print(sh, "no GC scheduler bound");
+        return 0;
+    }
+    storage_gc_format(bound_gc, text, sizeof(text));
+    shell_fprintf(sh, SHELL_NORMAL, "%s", text);
+    return 0;
+}
+
+static int cmd_gc_reset(const struct shell* sh, size_t argc, char** argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    if (bound_gc) {
+        storage_gc_reset_stats(bound_gc);
+    }
+    shell_print(sh, "GC statistics cleared");
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_storage_gc,
+    SHELL_CMD(show, NULL, "Slice pauses (mean/p99/max, histogram) and job counters", cmd_gc_show),
+    SHELL_CMD(reset, NULL, "Clear pause statistics and job counters", cmd_gc_reset),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(storage_gc, &sub_storage_gc, "Incremental storage GC", NULL);
+
+#endif
@@ -0,0 +1,260 @@
+#ifndef STORAGE_GC_H
+#define STORAGE_GC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "flash_io/flash_log.h"
+#include "config_store.h"
+#include "interfaces/ble_service_interfaces.h"
+
+#ifdef __ZEPHYR__
+#include <zephyr/kernel.h>
+#endif
+
+/**
+ * @file storage_gc.h
+ * @brief Incremental garbage collection in pause-bounded slices
+ *
+ * Storage upkeep (erasing ahead of log heads, compacting the config
+ * store) is split into small steps registered as jobs. On target,
+ * storage_gc_start() puts a delayable work item on the storage thread's
+ * queue that calls storage_gc_slice() every period_ms while work is
+ * pending and every idle_ms otherwise; one slice runs steps round robin
+ * until the jobs are done, the pause budget is used up, or the yield
+ * callback reports foreground work (a stage flush due, a BLE transfer).
+ * Everything runs on the storage thread, so a slice is a pause for
+ * acquisition and BLE; steps are only started when they fit.
+ *
+ * Every job declares the worst case of one step from the flash timings
+ * below; the scheduler raises its estimate to any longer step it
+ * measures and lets it decay back towards the declared cost as steps
+ * run faster, so one step stretched by preemption does not shut the job
+ * out. A step starts only if the time spent so far plus that estimate
+ * stays within the budget, so no slice exceeds it as long as the flash
+ * keeps to its typical timings; a job whose estimate has outgrown the
+ * budget opens the next slice and runs alone. A job whose declared step
+ * cannot fit a slice at all is never run; its work falls back to the foreground path (an append that
+ * erases, a set that compacts), which the stores keep as before.
+ *
+ * Erases are started here and left running (flash_device_erase_begin);
+ * a later step writes the sector header. Steps never wait for a busy
+ * flash, they report the job blocked instead.
+ *
+ * Slice pauses go into a log2 histogram (16 us to 64 ms) for
+ * storage_gc_summary() and storage_gc_format(). The bound scheduler
+ * (storage_gc_bind()) is readable with the `storage_gc show|reset` shell
+ * command and through storage_gc_ble_read(), the read callback for the
+ * BLE diagnostics characteristic; storage_garbage_collect() runs one
+ * slice of it.
+ */
+
+// =============================================================================
+// Limits
+// =============================================================================
+
+#define STORAGE_GC_MAX_JOBS            8
+#define STORAGE_GC_PAUSE_BUCKETS       14           ///< Bucket 0: < 16 us; bucket b: [2^(b+3), 2^(b+4)) us
+#define STORAGE_GC_PROGRAM_US          700          ///< W25Q64 tPP (typical), one page program
+#define STORAGE_GC_READ_NS_PER_BYTE    1000         ///< 8 MHz SPI
+#define STORAGE_GC_COMPACT_BYTES       256          ///< Config records read per compaction step
+#define STORAGE_GC_COMPACT_PROGRAMS    2            ///< Page programs per compaction step
+#define STORAGE_GC_COST_DECAY_SHIFT    3            ///< Estimate falls 1/8 of the way back per faster step
+#define STORAGE_GC_NAME_LEN            12           ///< Job name bytes in a packed record
+#define STORAGE_GC_SUMMARY_SIZE        28           ///< Packed pause summary size
+#define STORAGE_GC_RECORD_SIZE         28           ///< Packed job record size
+#define STORAGE_GC_PACK_VERSION        1
+
+// =============================================================================
+// Data Structures
+// =============================================================================
+
+/**
+ * @brief Outcome of one step
+ */
+typedef enum {
+    STORAGE_GC_IDLE = 0,              ///< Nothing to do
+    STORAGE_GC_PROGRESS,              ///< Did one unit of work
+    STORAGE_GC_BLOCKED,               ///< Work pending, waiting for the flash
+} storage_gc_result_t;
+
+/**
+ * @brief One bounded unit of work
+ */
+typedef storage_gc_result_t (*storage_gc_step_t)(void* context);
+
+/**
+ * @brief Foreground work is waiting: end the slice
+ */
+typedef bool (*storage_gc_yield_t)(void* context);
+
+/**
+ * @brief Registered job
+ */
+typedef struct {
+    const char* name;
+    storage_gc_step_t step;
+    void* context;
+    uint32_t declared_us;             ///< Worst step from the flash timings
+    uint32_t cost_us;                 ///< Step estimate: raised by measurement, decays to declared_us
+    uint32_t steps;                   ///< Steps that did work
+    uint32_t blocked;                 ///< Steps that found the flash busy
+    uint32_t deferred;                ///< Steps put off to a later slice by the budget
+    uint32_t overruns;                ///< Steps longer than declared_us
+} storage_gc_job_t;
+
+/**
+ * @brief Scheduler settings
+ */
+typedef struct {
+    uint32_t budget_us;               ///< Longest pause of one slice
+    uint32_t period_ms;               ///< Slice period while work is pending
+    uint32_t idle_ms;                 ///< Slice period when all jobs are idle
+} storage_gc_config_t;
+
+static const storage_gc_config_t STORAGE_GC_DEFAULT_CONFIG = {
+    .budget_us = 2000,
+    .period_ms = 20,                  // An erase is done within three slices
+    .idle_ms = 1000                   // Well within the time appends take to use up erase-ahead
+};
+
+/**
+ * @brief Slice pause statistics
+ */
+typedef struct {
+    uint32_t slices;
+    uint32_t steps;
+    uint32_t yields;                  ///< Slices ended early for foreground work
+    uint32_t overruns;                ///< Slices longer than the budget
+    uint32_t max_us;
+    uint64_t total_us;
+    uint32_t histogram[STORAGE_GC_PAUSE_BUCKETS];
+} storage_gc_stats_t;
+
+/**
+ * @brief Pause summary in microseconds
+ */
+typedef struct {
+    uint32_t slices;
+    uint32_t mean_us;
+    uint32_t p99_us;                  ///< Upper edge of the p99 histogram bucket (<= max)
+    uint32_t max_us;
+    uint32_t overruns;
+} storage_gc_summary_t;
+
+/**
+ * @brief Scheduler instance
+ */
+typedef struct {
+    storage_gc_config_t config;
+    storage_gc_job_t jobs[STORAGE_GC_MAX_JOBS];
+    uint32_t job_count;
+    uint32_t next_job;                ///< Round-robin start of the next slice
+    bool pending;                     ///< The last slice left work behind
+    storage_gc_yield_t yield;
+    void* yield_context;
+    storage_gc_stats_t stats;
+#ifdef __ZEPHYR__
+    struct k_work_delayable work;     ///< Runs slices (storage_gc_start)
+    struct k_work_q* queue;           ///< Storage thread's queue, NULL for the system queue
+#endif
+} storage_gc_t;
+
+// =============================================================================
+// Scheduler Functions
+// =============================================================================
+
+/**
+ * @brief Set up a scheduler without jobs
+ *
+ * @param config NULL for STORAGE_GC_DEFAULT_CONFIG
+ * @param yield Checked before every step, may be NULL
+ */
+bool storage_gc_init(storage_gc_t* gc, const storage_gc_config_t* config, storage_gc_yield_t yield,
+                     void* yield_context);
+
+/**
+ * @brief Register a job
+ *
+ * @param cost_us Worst-case duration of one step
+ */
+bool storage_gc_add(storage_gc_t* gc, const char* name, storage_gc_step_t step, void* context, uint32_t cost_us);
+
+/**
+ * @brief Erase-ahead of a log as a job (flash_log_erase_step)
+ */
+bool storage_gc_add_log(storage_gc_t* gc, const char* name, flash_log_t* log);
+
+/**
+ * @brief Config store compaction as a job (config_store_gc_step)
+ */
+bool storage_gc_add_config(storage_gc_t* gc, const char* name, config_store_t* store);
+
+/**
+ * @brief Run one slice
+ * @return Steps that did work
+ */
+uint32_t storage_gc_slice(storage_gc_t* gc);
+
+/**
+ * @brief Delay until the next slice (work item reschedule)
+ */
+uint32_t storage_gc_next_delay_ms(const storage_gc_t* gc);
+
+/**
+ * @brief Summarize slice pauses
+ */
+void storage_gc_summary(const storage_gc_t* gc, storage_gc_summary_t* summary);
+
+/**
+ * @brief Format pauses and jobs for shell or log output
+ * @return Characters written, excluding the terminator
+ */
+uint32_t storage_gc_format(const storage_gc_t* gc, char* text, uint32_t size);
+
+/**
+ * @brief Clear the pause statistics and job counters
+ */
+void storage_gc_reset_stats(storage_gc_t* gc);
+
+/**
+ * @brief Pack the pause summary and job counters for BLE
+ *
+ * Layout (little endian): a 4-byte header {version, record_count, 0, 0},
+ * the summary {slices, mean_us, p99_us, max_us, budget_us, overruns,
+ * yields}, then per job: name[12] (NUL padded), cost_us, steps, blocked,
+ * deferred. Jobs that do not fit are dropped.
+ *
+ * @return Bytes written (0 if the header and summary do not fit)
+ */
+uint32_t storage_gc_pack(const storage_gc_t* gc, uint8_t* data, uint32_t size);
+
+/**
+ * @brief BLE diagnostics characteristic read callback
+ *
+ * Packs the bound scheduler into value->data (up to value->max_length).
+ */
+bool storage_gc_ble_read(ble_char_value_t* value, uint32_t* length);
+
+/**
+ * @brief Route storage_garbage_collect(), the shell command and the BLE read to a scheduler
+ */
+void storage_gc_bind(storage_gc_t* gc);
+
+#ifdef __ZEPHYR__
+/**
+ * @brief Run slices from a delayable work item
+ *
+ * The first slice runs right away; each one schedules the next after
+ * storage_gc_next_delay_ms(). Register the jobs first.
+ *
+ * @param queue The storage thread's work queue (NULL: system work queue)
+ */
+bool storage_gc_start(storage_gc_t* gc, struct k_work_q* queue);
+
+/**
+ * @brief Cancel the work item (a slice already running completes)
+ */
+void storage_gc_stop(storage_gc_t* gc);
+#endif
+
+#endif // STORAGE_GC_H
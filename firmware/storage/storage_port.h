@@ -0,0 +1,43 @@
+#ifndef STORAGE_PORT_H
+#define STORAGE_PORT_H
+
+/**
+ * @file storage_port.h
+ * @brief Zephyr/host portability shims for the storage modules
+ *
+ * Storage modules are plain C99 and also build on the host against the
+ * flash simulator (flash_io/flash_sim.h); logging and the uptime clock go
+ * through these macros. All storage calls are made from one storage
+ * thread, so there is no locking here.
+ */
+
+#ifdef __ZEPHYR__
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#define STORAGE_UPTIME_MS()     k_uptime_get_32()
+#define STORAGE_UPTIME_US()     ((uint32_t)k_ticks_to_us_floor64(k_uptime_ticks()))
+
+#else
+
+#include <stdio.h>
+#include <stdint.h>
+
+/** Host clock, advanced by tests and tools (storage_host_clock_ms) */
+extern uint32_t storage_host_clock_ms;
+#define STORAGE_UPTIME_MS()     (storage_host_clock_ms)
+
+/** Fine host clock for pause budgets, advanced by the flash simulator's busy time and by tests */
+extern uint32_t storage_host_clock_us;
+#define STORAGE_UPTIME_US()     (storage_host_clock_us)
+
+#define LOG_MODULE_REGISTER(...)
+#define LOG_ERR(...)            do { fprintf(stderr, __VA_ARGS__); fputc('\n', stderr); } while (0)
+#define LOG_WRN(...)            do { fprintf(stderr, __VA_ARGS__); fputc('\n', stderr); } while (0)
+#define LOG_INF(...)            do { } while (0)
+#define LOG_DBG(...)            do { } while (0)
+
+#endif
+
+#endif // STORAGE_PORT_H
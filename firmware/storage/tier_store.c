@@ -0,0 +1,267 @@
+/*
+ * Two-Tier Sensor Block Store
+ *
+ * The RAM tier is a ring of entries, each a 4-byte header {size,
+ * priority} and the block, padded to 4 bytes. An entry never wraps: when
+ * it does not fit before the end, a zero-size marker (or fewer than 4
+ * spare bytes) sends the head back to the start. Demotion takes entries
+ * from the tail, so blocks reach flash in the order they arrived.
+ */
+
+#include "tier_store.h"
+#include "storage_port.h"
+#include <string.h>
+
+LOG_MODULE_REGISTER(tier_store, LOG_LEVEL_INF);
+
+#define HEADER_SIZE             ((uint32_t)sizeof(sensor_data_header_t))
+#define RAM_SIZE                ((uint32_t)sizeof(((tier_store_t*)0)->ram))
+
+typedef struct {
+    uint16_t size;                    ///< Entry bytes, 0 for the wrap marker
+    uint8_t priority;
+    uint8_t reserved;
+} ram_entry_t;
+
+#define ENTRY_SIZE              ((uint32_t)sizeof(ram_entry_t))
+
+/* ==== PRIVATE FUNCTIONS ==== */
+
+static inline uint32_t align4(uint32_t offset)
+{
+    return (offset + 3u) & ~3u;
+}
+
+static inline ram_entry_t* entry_at(tier_store_t* tier, uint32_t offset)
+{
+    return (ram_entry_t*)(void*)((uint8_t*)tier->ram + offset);
+}
+
+static inline sensor_data_header_t* entry_block(ram_entry_t* entry)
+{
+    return (sensor_data_header_t*)(void*)(entry + 1);
+}
+
+/** Evict down to the cleanup threshold so the lanes can always take a sector */
+static void make_room(tier_store_t* tier)
+{
+    while (flash_pool_usage_percent(&tier->pool) >= tier->policy.cleanup_threshold_percent &&
+           tier_store_evict(tier)) {
+    }
+}
+
+static void demote(tier_store_t* tier, ram_entry_t* entry)
+{
+    sensor_data_header_t* block = entry_block(entry);
+    storage_priority_t priority = (storage_priority_t)entry->priority;
+
+    if (priority < tier->policy.min_priority) {
+        tier->stats.dropped[priority]++;
+        return;
+    }
+
+    make_room(tier);
+    if (!flash_log_append_keyed(&tier->lanes[tier_store_lane_of(priority)], SENSOR_STORE_RECORD_TYPE,
+                                block->timestamp_start, block, HEADER_SIZE + block->data_size, NULL)) {
+        tier->stats.demote_failures++;
+        return;
+    }
+    tier->stats.demoted[priority]++;
+}
+
+/** Demote the oldest RAM entry and free its space */
+static void pop_oldest(tier_store_t* tier)
+{
+    ram_entry_t* entry = entry_at(tier, tier->ram_tail);
+
+    demote(tier, entry);
+    tier->ram_tail += entry->size;
+    tier->ram_count--;
+
+    if (tier->ram_count == 0) {
+        tier->ram_head = 0;
+        tier->ram_tail = 0;
+    } else if (tier->ram_tail + ENTRY_SIZE > RAM_SIZE || entry_at(tier, tier->ram_tail)->size == 0) {
+        tier->ram_tail = 0;
+    }
+}
+
+/** Offset for a new entry of size bytes, demoting old entries until it fits */
+static uint32_t reserve(tier_store_t* tier, uint32_t size)
+{
+    for (;;) {
+        if (tier->ram_count == 0) {
+            return 0;
+        }
+        if (tier->ram_head > tier->ram_tail) {
+            if (tier->ram_head + size <= RAM_SIZE) {
+                return tier->ram_head;
+            }
+            if (size <= tier->ram_tail) {
+                if (tier->ram_head + ENTRY_SIZE <= RAM_SIZE) {
+                    entry_at(tier, tier->ram_head)->size = 0;
+                }
+                tier->ram_head = 0;
+                return 0;
+            }
+        } else if (tier->ram_head + size <= tier->ram_tail) {
+            return tier->ram_head;
+        }
+        pop_oldest(tier);
+    }
+}
+
+/* ==== PUBLIC FUNCTIONS ==== */
+
+bool tier_store_open(tier_store_t* tier, const flash_device_t* dev, const storage_policy_t* policy, bool format)
+{
+    if (!tier || !dev || !flash_pool_open(&tier->pool, dev, TIER_STORE_LANES)) {
+        return false;
+    }
+    if (format && !flash_pool_format(&tier->pool)) {
+        LOG_ERR("Tier pool format failed");
+        return false;
+    }
+
+    tier->policy = policy ? *policy : STORAGE_POLICY_SENSOR_DATA;
+    tier->ram_head = 0;
+    tier->ram_tail = 0;
+    tier->ram_count = 0;
+    memset(&tier->read_stats, 0, sizeof(tier->read_stats));
+    memset(&tier->stats, 0, sizeof(tier->stats));
+
+    for (uint32_t i = 0; i < TIER_STORE_LANES; i++) {
+        flash_log_config_t config = FLASH_LOG_DEFAULT_CONFIG;
+        const flash_device_t* lane = flash_pool_lane(&tier->pool, i);
+
+        config.erase_ahead = 1;
+        config.sector_keys = tier->lane_keys[i];
+        config.keep_tail = i == TIER_STORE_CRITICAL_LANE;
+        if (format ? !flash_log_format(&tier->lanes[i], lane, &config)
+                   : !flash_log_mount(&tier->lanes[i], lane, &config)) {
+            LOG_ERR("Tier lane %u %s failed", i, format ? "format" : "mount");
+            return false;
+        }
+    }
+    return true;
+}
+
+bool tier_store_append(tier_store_t* tier, const sensor_data_header_t* block, storage_priority_t priority)
+{
+    if (!tier || !block || priority >= STORAGE_PRIORITY_COUNT) {
+        return false;
+    }
+
+    uint32_t length = HEADER_SIZE + block->data_size;
+    uint32_t size = align4(ENTRY_SIZE + length);
+    if (length > FLASH_LOG_MAX_RECORD(tier->lanes[0].dev->sector_size) || size > RAM_SIZE) {
+        return false;
+    }
+
+    uint32_t offset = reserve(tier, size);
+    ram_entry_t* entry = entry_at(tier, offset);
+    entry->size = (uint16_t)size;
+    entry->priority = (uint8_t)priority;
+    entry->reserved = 0;
+    memcpy(entry_block(entry), block, length);
+    sensor_store_seal(entry_block(entry));
+
+    tier->ram_head = offset + size;
+    tier->ram_count++;
+    tier->stats.ram_blocks++;
+    return true;
+}
+
+bool tier_store_sink(void* context, sensor_data_header_t* block, storage_priority_t priority)
+{
+    return tier_store_append((tier_store_t*)context, block, priority);
+}
+
+int32_t tier_store_read(tier_store_t* tier, uint16_t sensor_type, uint32_t start_ms,
+                        uint32_t duration_ms, void* buffer, uint32_t buffer_size)
+{
+    uint8_t* out = (uint8_t*)buffer;
+    uint32_t copied = 0;
+
+    if (!tier || !buffer) {
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < TIER_STORE_LANES; i++) {
+        int32_t got = sensor_store_read_log(&tier->lanes[i], &tier->read_stats, sensor_type, start_ms,
+                                            duration_ms, out + copied, buffer_size - copied);
+        if (got < 0) {
+            return -1;
+        }
+        copied += (uint32_t)got;
+    }
+
+    uint32_t end_ms = start_ms > UINT32_MAX - duration_ms ? UINT32_MAX : start_ms + duration_ms;
+    uint32_t offset = tier->ram_tail;
+    for (uint32_t n = 0; n < tier->ram_count;) {
+        ram_entry_t* entry = entry_at(tier, offset);
+
+        if (offset + ENTRY_SIZE > RAM_SIZE || entry->size == 0) {
+            offset = 0;
+            continue;
+        }
+
+        sensor_data_header_t* block = entry_block(entry);
+        uint32_t length = HEADER_SIZE + block->data_size;
+        if (block->sensor_type == sensor_type && sensor_store_block_overlaps(block, start_ms, end_ms) &&
+            copied + length <= buffer_size) {
+            memcpy(out + copied, block, length);
+            copied += length;
+            tier->read_stats.blocks_returned++;
+        }
+        offset += entry->size;
+        n++;
+    }
+    return (int32_t)copied;
+}
+
+uint32_t tier_store_maintain(tier_store_t* tier)
+{
+    uint32_t erased = 0;
+
+    if (!tier) {
+        return 0;
+    }
+
+    make_room(tier);
+    for (uint32_t i = 0; i < TIER_STORE_LANES; i++) {
+        erased += flash_log_maintain(&tier->lanes[i], 1);
+    }
+    return erased;
+}
+
+bool tier_store_evict(tier_store_t* tier)
+{
+    if (!tier) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < TIER_STORE_CRITICAL_LANE; i++) {
+        uint32_t sector;
+
+        if (flash_log_drop_oldest(&tier->lanes[i], &sector)) {
+            flash_pool_release(&tier->pool, i, sector);
+            tier->stats.evicted_sectors[i]++;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool tier_store_flush(tier_store_t* tier)
+{
+    if (!tier) {
+        return false;
+    }
+
+    uint32_t failures = tier->stats.demote_failures;
+    while (tier->ram_count > 0) {
+        pop_oldest(tier);
+    }
+    return tier->stats.demote_failures == failures;
+}
@@ -0,0 +1,144 @@
+#ifndef TIER_STORE_H
+#define TIER_STORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "flash_io/flash_pool.h"
+#include "flash_io/flash_log.h"
+#include "sensor_store.h"
+#include "interfaces/storage_interfaces.h"
+
+/**
+ * @file tier_store.h
+ * @brief Two-tier sensor block store: RAM for recent data, flash by priority
+ *
+ * Hot tier (STORAGE_TYPE_VOLATILE): new blocks go to a RAM ring, where
+ * live views read them without touching flash. When the ring needs room
+ * its oldest block is demoted: written to flash if its priority is at
+ * least the policy's min_priority, dropped otherwise. So high-rate data
+ * nobody asked to keep never costs a flash program.
+ *
+ * Cold tier: one flash_log per priority lane (LOW, MEDIUM, HIGH,
+ * CRITICAL), sharing the region's erase sectors through a flash_pool, so
+ * every erase block holds one lane only. Once the pool reaches the
+ * policy's cleanup_threshold_percent, whole erase blocks are evicted:
+ * the oldest one of the LOW lane, then MEDIUM, then HIGH. The CRITICAL
+ * lane is never evicted, nor does it reclaim its own tail: when nothing
+ * else is left to evict, demoting a CRITICAL block fails (and is counted
+ * in demote_failures) rather than losing older ones. Each eviction
+ * is O(1): clear the lane log's tail sector header and one pool tag,
+ * with no scan and no copying, and the sector is erased when it is reused.
+ *
+ * Each lane keeps its own time index, so reads return a sensor's blocks
+ * lane by lane (each in time order), then the blocks still in RAM.
+ *
+ * RAM over a 6 MB region: 24 KB of key tables, 15 KB of pool maps and
+ * TIER_STORE_RAM_BYTES for the hot tier.
+ */
+
+// =============================================================================
+// Limits
+// =============================================================================
+
+#define TIER_STORE_LANES               4            ///< LOW, MEDIUM, HIGH, CRITICAL
+#define TIER_STORE_CRITICAL_LANE       3            ///< Never evicted
+
+#ifndef TIER_STORE_RAM_BYTES
+#define TIER_STORE_RAM_BYTES           16384        ///< Hot tier ring
+#endif
+
+// =============================================================================
+// Data Structures
+// =============================================================================
+
+/**
+ * @brief Tier accounting
+ */
+typedef struct {
+    uint32_t ram_blocks;                              ///< Blocks entering the hot tier
+    uint32_t demoted[STORAGE_PRIORITY_COUNT];         ///< Moved from RAM to flash
+    uint32_t dropped[STORAGE_PRIORITY_COUNT];         ///< Left RAM below min_priority
+    uint32_t demote_failures;                         ///< Flash refused a demoted block
+    uint32_t evicted_sectors[TIER_STORE_LANES];       ///< Erase blocks given up per lane
+} tier_store_stats_t;
+
+/**
+ * @brief Store instance
+ */
+typedef struct {
+    flash_pool_t pool;
+    flash_log_t lanes[TIER_STORE_LANES];
+    uint32_t lane_keys[TIER_STORE_LANES][FLASH_POOL_MAX_SECTORS];  ///< Time index per lane
+    storage_policy_t policy;
+    uint32_t ram[TIER_STORE_RAM_BYTES / sizeof(uint32_t)];
+    uint32_t ram_head;                ///< Next entry offset
+    uint32_t ram_tail;                ///< Oldest entry offset
+    uint32_t ram_count;               ///< Blocks in RAM
+    sensor_store_stats_t read_stats;
+    tier_store_stats_t stats;
+} tier_store_t;
+
+// =============================================================================
+// Store Functions
+// =============================================================================
+
+/**
+ * @brief Mount (or format) the flash tier; the RAM tier starts empty
+ *
+ * @param policy min_priority and cleanup_threshold_percent are used
+ *               (NULL for STORAGE_POLICY_SENSOR_DATA)
+ */
+bool tier_store_open(tier_store_t* tier, const flash_device_t* dev, const storage_policy_t* policy, bool format);
+
+/**
+ * @brief Copy a block into the RAM tier, demoting the oldest as needed
+ *
+ * @param block Header followed in memory by data_size bytes
+ * @return false if the block is larger than a flash record or the ring
+ */
+bool tier_store_append(tier_store_t* tier, const sensor_data_header_t* block, storage_priority_t priority);
+
+/**
+ * @brief sensor_stage_t sink for a tier store (context is the store)
+ */
+bool tier_store_sink(void* context, sensor_data_header_t* block, storage_priority_t priority);
+
+/**
+ * @brief Copy the blocks of one sensor that overlap a time window
+ *
+ * Flash lanes first, then RAM; blocks that do not fit are left out.
+ *
+ * @return Bytes copied, -1 on errors
+ */
+int32_t tier_store_read(tier_store_t* tier, uint16_t sensor_type, uint32_t start_ms,
+                        uint32_t duration_ms, void* buffer, uint32_t buffer_size);
+
+/**
+ * @brief Background upkeep: evict down to the threshold, erase ahead per lane
+ * @return Sectors erased
+ */
+uint32_t tier_store_maintain(tier_store_t* tier);
+
+/**
+ * @brief Evict the oldest erase block of the lowest non-empty lane
+ *
+ * The CRITICAL lane and a lane's head sector are never evicted.
+ *
+ * @return false if nothing can be evicted
+ */
+bool tier_store_evict(tier_store_t* tier);
+
+/**
+ * @brief Demote everything in RAM (before power-down)
+ */
+bool tier_store_flush(tier_store_t* tier);
+
+/**
+ * @brief Flash tier lane for a priority
+ */
+static inline uint32_t tier_store_lane_of(storage_priority_t priority)
+{
+    return priority < TIER_STORE_LANES ? (uint32_t)priority : TIER_STORE_LANES - 1u;
+}
+
+#endif // TIER_STORE_H
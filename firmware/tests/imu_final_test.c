@@ -10,6 +10,10 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#ifndef M_PI
+#define M_PI 3.14159265358979323846f
+#endif
+
 // Simple counter for time simulation
 static uint32_t sample_counter = 0;
 
@@ -0,0 +1,2196 @@
+/*
+ * PPG Pipeline Host Test
+ *
+ * Exercises the signal pipeline modules on the host without Zephyr:
+ * - NLMS motion artifact canceller (IMU reference)
+ * - Fan-out pipeline graph (shared preprocess/filter, HR feature node)
+ * - Per-beat SpO2 at 25 Hz
+ * - Respiratory rate from fused RIIV/RIAV/RIFV
+ * - Signal quality index gating a simulated night
+ * - Polyphase decimation and pipeline cost at 100 Hz
+ * - Live reconfiguration swapped in at a block boundary
+ * - Stage checkpoint/restore across sleep
+ * - Static pool for pipelines, buffers and scratch
+ * - Per-stage profiling (CONFIG_PIPELINE_PROFILING)
+ * - Tuned configurations and sensor migration
+ * - Compiled static pipeline against the graph engine
+ * - Running median/quantile, min/max and MAD (window 8..1024 benchmark)
+ * - Streaming RR artifact detection and correction
+ * - Multi-channel (struct of arrays) pipeline against one pipeline per LED
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "ppg_simulator_host.h"
+#include "motion_canceller.h"
+#include "ppg_stages.h"
+#include "spo2_estimator.h"
+#include "resp_estimator.h"
+#include "signal_quality.h"
+#include "decimator.h"
+#include "pipeline_port.h"
+#include "pipeline_pool.h"
+#include "pipeline_profile.h"
+#include "pipeline_tuning.h"
+#include "static_pipeline.h"
+#include "running_filters.h"
+#include "rr_artifact.h"
+
+#define SAMPLE_RATE_HZ  50
+#define BLOCK_SIZE      25
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+static void check(bool condition, const char *description)
+{
+    if (condition) {
+        printf("   ✅ %s\n", description);
+        tests_passed++;
+    } else {
+        printf("   ❌ %s\n", description);
+        tests_failed++;
+    }
+}
+
+// =============================================================================
+// Motion Canceller
+// =============================================================================
+
+static void generate_arm_motion(float t, bool moving, float *xyz, float *artifact)
+{
+    float ax = 0.0f, ay = 0.0f, az = 0.0f;
+
+    if (moving) {
+        ax = 0.30f * sinf(2.0f * M_PI * 1.6f * t);
+        ay = 0.20f * sinf(2.0f * M_PI * 1.6f * t + 0.8f) + 0.10f * sinf(2.0f * M_PI * 3.2f * t);
+        az = 0.15f * sinf(2.0f * M_PI * 3.2f * t + 0.3f);
+    }
+
+    xyz[0] = ax + 0.002f * ((float)rand() / RAND_MAX - 0.5f);
+    xyz[1] = ay + 0.002f * ((float)rand() / RAND_MAX - 0.5f);
+    xyz[2] = 1.0f + az + 0.002f * ((float)rand() / RAND_MAX - 0.5f);
+
+    // Optical coupling of the motion into the PPG (tissue/sensor displacement)
+    *artifact = 0.25f * ax - 0.15f * ay + 0.10f * az;
+}
+
+static void test_motion_canceller(void)
+{
+    printf("\n🏃 Motion Canceller (NLMS, 3-axis IMU reference)\n");
+
+    const int rest_blocks = 10 * SAMPLE_RATE_HZ / BLOCK_SIZE;
+    const int motion_blocks = 40 * SAMPLE_RATE_HZ / BLOCK_SIZE;
+    const int settle_blocks = 10 * SAMPLE_RATE_HZ / BLOCK_SIZE;
+    const int total_blocks = rest_blocks + motion_blocks + rest_blocks;
+
+    struct ppg_sim_config sim = {
+        .heart_rate_bpm = 70.0f,
+        .noise_level = 0.05f,
+        .motion_artifacts = 0.0f,
+        .sleep_mode = 0,
+        .breathing_rate_bpm = 15.0f,
+        .signal_quality = 95
+    };
+    ppg_sim_init(&sim);
+    srand(26);
+
+    motion_canceller_t mc;
+    check(motion_canceller_init(&mc, NULL), "Canceller initializes with defaults");
+
+    float clean[BLOCK_SIZE], input[BLOCK_SIZE], output[BLOCK_SIZE];
+    float accel[BLOCK_SIZE * MOTION_CANCELLER_AXES];
+    double err_in = 0.0, err_out = 0.0;
+    uint32_t adapted_at_rest = 0;
+
+    for (int b = 0; b < total_blocks; b++) {
+        bool moving = (b >= rest_blocks) && (b < rest_blocks + motion_blocks);
+
+        for (int i = 0; i < BLOCK_SIZE; i++) {
+            uint32_t n = (uint32_t)(b * BLOCK_SIZE + i);
+            uint32_t t_ms = n * 1000 / SAMPLE_RATE_HZ;
+            float artifact;
+
+            clean[i] = ppg_sim_generate_sample(t_ms);
+            generate_arm_motion(t_ms / 1000.0f, moving, &accel[i * 3], &artifact);
+            input[i] = clean[i] + artifact;
+        }
+
+        uint32_t adapted_before = mc.blocks_adapted;
+        motion_canceller_process(&mc, input, accel, output, BLOCK_SIZE);
+
+        if (b < rest_blocks && mc.blocks_adapted != adapted_before) {
+            adapted_at_rest++;
+        }
+
+        // Score the second half of the motion segment (after convergence)
+        if (moving && b >= rest_blocks + settle_blocks) {
+            for (int i = 0; i < BLOCK_SIZE; i++) {
+                err_in += (input[i] - clean[i]) * (input[i] - clean[i]);
+                err_out += (output[i] - clean[i]) * (output[i] - clean[i]);
+            }
+        }
+    }
+
+    float reduction_db = 10.0f * log10f((float)(err_in / (err_out + 1e-12)));
+    printf("   Artifact reduction: %.1f dB\n", reduction_db);
+    printf("   Blocks adapted: %u of %u (%.0f%% CPU-gated)\n",
+           mc.blocks_adapted, mc.blocks_processed,
+           100.0f * (1.0f - (float)mc.blocks_adapted / mc.blocks_processed));
+
+    check(reduction_db > 8.0f, "Motion artifact reduced by more than 8 dB");
+    check(adapted_at_rest == 0, "No adaptation while the arm is at rest");
+    check(mc.blocks_adapted <= (uint32_t)(motion_blocks + MOTION_CANCELLER_DEFAULT_CONFIG.hangover_blocks),
+          "Adaptation stops after motion ends (hangover only)");
+
+    // Aligning 25 Hz IMU samples onto the 50 Hz PPG grid
+    imu_sample_t imu[3] = {
+        {.timestamp = 1000, .accel = {0, 0, 1000}},
+        {.timestamp = 1040, .accel = {400, 0, 1000}},
+        {.timestamp = 1080, .accel = {800, 0, 1000}},
+    };
+    float aligned[4 * 3];
+    motion_canceller_align_accel(imu, 3, 1000, 50, 4, aligned);
+    check(fabsf(aligned[3] - 0.2f) < 1e-4f && fabsf(aligned[9] - 0.6f) < 1e-4f,
+          "IMU reference interpolated onto PPG timestamps");
+}
+
+// =============================================================================
+// Pipeline Graph
+// =============================================================================
+
+static uint32_t filter_runs;
+static uint32_t probe_runs;
+static const float* probe_last_data;
+static bool probes_shared_input = true;
+static bool (*filter_process_impl)(pipeline_stage_t*, const signal_buffer_t*, signal_buffer_t*);
+
+static bool counting_filter_process(pipeline_stage_t* stage, const signal_buffer_t* input, signal_buffer_t* output)
+{
+    filter_runs++;
+    return filter_process_impl(stage, input, output);
+}
+
+// Stand-in for the SpO2/respiration consumers: records what it was fed
+static bool probe_process(pipeline_stage_t* stage, const signal_buffer_t* input, signal_buffer_t* output)
+{
+    (void)stage;
+    if (probe_runs & 1) {
+        probes_shared_input &= (input->data == probe_last_data);
+    }
+    probe_last_data = input->data;
+    probe_runs++;
+    output->length = 0;
+    return true;
+}
+
+static pipeline_stage_ops_t probe_ops = { .process = probe_process };
+
+static pipeline_stage_config_t stage_config(const char* name)
+{
+    pipeline_stage_config_t config = { .enabled = true, .buffer_size = BLOCK_SIZE };
+    strncpy(config.algorithm_name, name, sizeof(config.algorithm_name) - 1);
+    return config;
+}
+
+static void test_pipeline_graph(void)
+{
+    printf("\n🕸️  Pipeline Graph (shared filter fan-out)\n");
+
+    ppg_preprocess_stage_t pre;
+    ppg_filter_stage_t filter;
+    ppg_filter_state_t filter_state;
+    ppg_feature_stage_t hr;
+    ppg_feature_state_t hr_state;
+    pipeline_stage_t spo2_probe = { .name = "spo2", .ops = &probe_ops, .config = { .enabled = true } };
+    pipeline_stage_t resp_probe = { .name = "resp", .ops = &probe_ops, .config = { .enabled = true } };
+
+    pipeline_stage_config_t pre_config = stage_config("pre");
+    pipeline_stage_config_t filter_config = stage_config("filter");
+    pipeline_stage_config_t hr_config = stage_config("hr");
+
+    check(ppg_preprocess_stage_bind(&pre, &pre_config) &&
+          ppg_filter_stage_bind(&filter, &filter_state, &filter_config) &&
+          ppg_feature_stage_bind(&hr, &hr_state, &hr_config),
+          "Standard stages bind with default parameters");
+
+    pipeline_stage_ops_t counting_ops = ppg_filter_stage_ops;
+    filter_process_impl = counting_ops.process;
+    counting_ops.process = counting_filter_process;
+    filter.base.ops = &counting_ops;
+
+    const pipeline_node_desc_t graph[] = {
+        { &pre.base,    { PIPELINE_SOURCE_NAME_0 }, false },
+        { &filter.base, { "pre" },                  false },
+        { &hr.base,     { "filter" },               true  },
+        { &spo2_probe,  { "filter" },               true  },
+        { &resp_probe,  { "filter" },               true  },
+    };
+
+    signal_pipeline_t* pipeline = pipeline_create_graph(PIPELINE_SIGNAL_PPG, graph, 5, BLOCK_SIZE);
+    check(pipeline != NULL, "Fan-out graph accepted");
+    if (!pipeline) {
+        return;
+    }
+    check(pipeline->buffer_count < pipeline->stage_count,
+          "Buffer pool smaller than node count (refcounted reuse)");
+
+    struct ppg_sim_config sim = {
+        .heart_rate_bpm = 72.0f,
+        .noise_level = 0.05f,
+        .breathing_rate_bpm = 15.0f,
+        .signal_quality = 95
+    };
+    ppg_sim_init(&sim);
+    srand(27);
+
+    const uint32_t blocks = 60 * SAMPLE_RATE_HZ / BLOCK_SIZE;
+    float samples[BLOCK_SIZE];
+
+    for (uint32_t b = 0; b < blocks; b++) {
+        for (int i = 0; i < BLOCK_SIZE; i++) {
+            samples[i] = ppg_sim_generate_sample((b * BLOCK_SIZE + i) * 1000 / SAMPLE_RATE_HZ);
+        }
+        signal_buffer_t input = {
+            .data = samples,
+            .length = BLOCK_SIZE,
+            .sample_rate = SAMPLE_RATE_HZ,
+            .timestamp_start = b * BLOCK_SIZE * 1000 / SAMPLE_RATE_HZ,
+            .quality_score = 1.0f
+        };
+        pipeline_process(pipeline, &input);
+    }
+
+    const signal_buffer_t* hr_out = pipeline_get_node_output(pipeline, "hr");
+    const ppg_beat_block_t* beats = hr_out ? (const ppg_beat_block_t*)hr_out->metadata : NULL;
+
+    printf("   Filter runs: %u for %u blocks, pool buffers: %u for %u nodes\n",
+           filter_runs, blocks, pipeline->buffer_count, pipeline->stage_count);
+    printf("   HR: %.1f bpm (simulated 72), RMSSD %.1f ms\n", hr.last_hr_bpm, hr.last_hrv_rmssd);
+
+    check(filter_runs == blocks, "Shared filter runs exactly once per block");
+    check(probe_runs == 2 * blocks && probes_shared_input,
+          "Both consumers read the same filtered buffer");
+    check(fabsf(hr.last_hr_bpm - 72.0f) < 3.0f, "HR node tracks the simulated heart rate");
+    check(beats && fabsf(beats->hr_bpm - hr.last_hr_bpm) < 1e-3f,
+          "Beat block published through the HR node output");
+    check(pipeline->errors == 0, "No pipeline errors");
+
+    // A stage that may write past a pool buffer is not run at all
+    pipeline_stage_config_t wide = stage_config("spo2");
+    wide.buffer_size = pipeline->buffer_samples + 1;
+    uint32_t runs = probe_runs;
+    signal_buffer_t block = { .data = samples, .length = BLOCK_SIZE, .sample_rate = SAMPLE_RATE_HZ };
+    pipeline_request_config(pipeline, "spo2", &wide);
+    pipeline_process(pipeline, &block);
+    check(probe_runs == runs + 1 && pipeline->errors == 1,
+          "Stage whose output would overrun its buffer is refused before it runs");
+
+    // A config swap with another (or no) algorithm_name keeps the stage's name
+    pipeline_stage_config_t renamed = hr.base.config;
+    renamed.algorithm_name[0] = '\0';
+    pipeline_request_config(pipeline, "hr", &renamed);
+    pipeline_process(pipeline, &block);
+    check(strcmp(hr.base.name, "hr") == 0 && pipeline_get_node_output(pipeline, "hr") != NULL,
+          "Config swap does not rename the stage");
+
+    pipeline_destroy(pipeline);
+
+    // Topology validation
+    pipeline_stage_t a = { .name = "a", .ops = &probe_ops };
+    pipeline_stage_t b = { .name = "b", .ops = &probe_ops };
+    const pipeline_node_desc_t cycle[] = {
+        { &a, { "b" }, false },
+        { &b, { "a" }, true },
+    };
+    const pipeline_node_desc_t dangling[] = {
+        { &a, { PIPELINE_SOURCE_NAME_0 }, false },
+        { &b, { "missing" }, true },
+    };
+    const pipeline_node_desc_t orphan[] = {
+        { &a, { PIPELINE_SOURCE_NAME_0 }, false },
+        { &b, { NULL }, true },
+    };
+    check(pipeline_create_graph(PIPELINE_SIGNAL_PPG, cycle, 2, BLOCK_SIZE) == NULL,
+          "Cycle rejected at creation");
+    check(pipeline_create_graph(PIPELINE_SIGNAL_PPG, dangling, 2, BLOCK_SIZE) == NULL,
+          "Unknown input rejected at creation");
+    check(pipeline_create_graph(PIPELINE_SIGNAL_PPG, orphan, 2, BLOCK_SIZE) == NULL,
+          "Node without inputs rejected at creation");
+
+    // Linear chain through the classic add/remove API
+    ppg_preprocess_stage_bind(&pre, &pre_config);
+    ppg_filter_stage_bind(&filter, &filter_state, &filter_config);
+    pipeline = pipeline_create(PIPELINE_SIGNAL_PPG);
+    check(pipeline && pipeline_add_stage(pipeline, &pre.base) &&
+          pipeline_add_stage(pipeline, &filter.base) &&
+          !pipeline_add_stage(pipeline, &filter.base),
+          "Linear chain built, duplicate stage refused");
+
+    signal_buffer_t input = { .data = samples, .length = BLOCK_SIZE, .sample_rate = SAMPLE_RATE_HZ };
+    pipeline_process(pipeline, &input);
+    const signal_buffer_t* out = pipeline_get_output(pipeline);
+    bool filtered = out && out->length == BLOCK_SIZE && out->data[BLOCK_SIZE - 1] != samples[BLOCK_SIZE - 1];
+
+    pipeline_remove_stage(pipeline, "filter");
+    pipeline_process(pipeline, &input);
+    out = pipeline_get_output(pipeline);
+    check(filtered && out && out->data[BLOCK_SIZE - 1] == samples[BLOCK_SIZE - 1],
+          "Removing the tail stage makes its predecessor the output");
+    pipeline_destroy(pipeline);
+}
+
+// =============================================================================
+// SpO2
+// =============================================================================
+
+#define SPO2_RATE_HZ     25
+#define SPO2_BLOCK       25
+
+static void test_spo2(void)
+{
+    printf("\n🫁 SpO2 (ratio of ratios, 25 Hz, shared HR beats)\n");
+
+    ppg_preprocess_stage_t pre_red, pre_ir;
+    ppg_filter_stage_t filter;
+    ppg_filter_state_t filter_state;
+    ppg_feature_stage_t hr;
+    ppg_feature_state_t hr_state;
+    pipeline_stage_t spo2;
+    spo2_estimator_t est;
+
+    pipeline_stage_config_t red_config = stage_config("pre_red");
+    pipeline_stage_config_t ir_config = stage_config("pre_ir");
+    pipeline_stage_config_t filter_config = stage_config("filter");
+    pipeline_stage_config_t hr_config = stage_config("hr");
+    pipeline_stage_config_t spo2_config = stage_config("spo2");
+
+    ppg_preprocess_stage_bind(&pre_red, &red_config);
+    ppg_preprocess_stage_bind(&pre_ir, &ir_config);
+    ppg_filter_stage_bind(&filter, &filter_state, &filter_config);
+    ppg_feature_stage_bind(&hr, &hr_state, &hr_config);
+    check(spo2_stage_bind(&spo2, &est, &spo2_config), "SpO2 stage binds");
+
+    // Same 110 - 25R calibration as loaded from sensor_config_t.spo2_calibration
+    const float calibration[4] = {110.0f, -25.0f, 0.0f, 0.0f};
+    spo2_estimator_set_calibration(&est, calibration);
+
+    const pipeline_node_desc_t graph[] = {
+        { &pre_red.base, { PIPELINE_SOURCE_NAME_0 },  false },
+        { &pre_ir.base,  { PIPELINE_SOURCE_NAME_1 },  false },
+        { &filter.base,  { "pre_ir" },                false },
+        { &hr.base,      { "filter" },                true  },
+        { &spo2,         { "hr", "pre_red", "pre_ir" }, true },
+    };
+    const pipeline_node_desc_t short_graph[] = {
+        { &pre_red.base, { PIPELINE_SOURCE_NAME_0 },  false },
+        { &pre_ir.base,  { PIPELINE_SOURCE_NAME_1 },  false },
+        { &filter.base,  { "pre_ir" },                false },
+        { &hr.base,      { "filter" },                true  },
+        { &spo2,         { "hr", "pre_red" },         true  },
+    };
+    check(pipeline_create_graph(PIPELINE_SIGNAL_PPG, short_graph, 5, SPO2_BLOCK) == NULL,
+          "SpO2 node wired with fewer than three inputs rejected at creation");
+    signal_pipeline_t* pipeline = pipeline_create_graph(PIPELINE_SIGNAL_PPG, graph, 5, SPO2_BLOCK);
+    check(pipeline != NULL, "Red/IR graph with SpO2 node accepted");
+    if (!pipeline) {
+        return;
+    }
+
+    struct ppg_sim_config sim = { .heart_rate_bpm = 66.0f, .breathing_rate_bpm = 14.0f };
+    ppg_sim_init(&sim);
+    srand(28);
+
+    // R = 0.5 (97.5 %) for 60 s, then desaturation to R = 0.8 (90 %)
+    const float phases[2][2] = { {0.5f, 97.5f}, {0.8f, 90.0f} };
+    float red[SPO2_BLOCK], ir[SPO2_BLOCK];
+    uint32_t n = 0;
+
+    for (int p = 0; p < 2; p++) {
+        float ratio = phases[p][0];
+
+        for (uint32_t b = 0; b < 60 * SPO2_RATE_HZ / SPO2_BLOCK; b++) {
+            for (int i = 0; i < SPO2_BLOCK; i++, n++) {
+                float t = (float)n / SPO2_RATE_HZ;
+                float pulse = ppg_sim_generate_heartbeat(t, sim.heart_rate_bpm / 60.0f) - 0.7f;
+                float baseline = 0.004f * sinf(2.0f * M_PI * sim.breathing_rate_bpm / 60.0f * t);
+                float noise = 0.0004f * ((float)rand() / RAND_MAX - 0.5f);
+
+                ir[i] = 80000.0f * (1.0f + baseline + 0.02f * pulse + noise);
+                red[i] = 50000.0f * (1.0f + baseline + 0.02f * ratio * pulse + noise);
+            }
+
+            signal_buffer_t sources[2] = {
+                { .data = red, .length = SPO2_BLOCK, .sample_rate = SPO2_RATE_HZ, .quality_score = 1.0f },
+                { .data = ir,  .length = SPO2_BLOCK, .sample_rate = SPO2_RATE_HZ, .quality_score = 1.0f },
+            };
+            pipeline_process_sources(pipeline, sources, 2);
+        }
+
+        const signal_buffer_t* out = pipeline_get_node_output(pipeline, "spo2");
+        const spo2_result_t* result = out ? (const spo2_result_t*)out->metadata : NULL;
+        char description[64];
+
+        printf("   R=%.2f: SpO2 %.1f%% (expected %.1f%%), quality %.2f, HR %.1f bpm\n",
+               ratio, result ? result->spo2 : 0.0f, phases[p][1],
+               result ? result->quality : 0.0f, hr.last_hr_bpm);
+        snprintf(description, sizeof(description), "SpO2 within 1.5%% at R=%.1f", ratio);
+        check(result && result->valid && fabsf(result->spo2 - phases[p][1]) < 1.5f, description);
+    }
+
+    printf("   Beats accepted %u, rejected %u\n", est.beats_accepted, est.beats_rejected);
+    check(est.beats_accepted > 100, "Most beats contribute at 25 Hz");
+    pipeline_destroy(pipeline);
+
+    // Flat (unperfused) signal never produces a reading
+    spo2_estimator_t flat;
+    float dc[50];
+    uint32_t beats[2] = {10, 35};
+    for (int i = 0; i < 50; i++) {
+        dc[i] = 60000.0f;
+    }
+    spo2_estimator_init(&flat, NULL);
+    spo2_estimator_process(&flat, dc, dc, 50, beats, 2);
+    check(!flat.result.valid && flat.beats_rejected == 1, "Beats without perfusion are rejected");
+}
+
+// =============================================================================
+// Respiration
+// =============================================================================
+
+typedef struct {
+    float cardiac_phase;
+    float resp_phase;
+} breathing_ppg_t;
+
+/** PPG with baseline, amplitude and HR modulated by breathing (depth 0..1) */
+static float breathing_ppg_sample(breathing_ppg_t* gen, float resp_bpm, float depth, float dt)
+{
+    float resp = sinf(gen->resp_phase);
+    float hr_bpm = 66.0f + 4.0f * depth * resp;
+
+    gen->cardiac_phase += 2.0f * M_PI * hr_bpm / 60.0f * dt;
+    gen->resp_phase += 2.0f * M_PI * resp_bpm / 60.0f * dt;
+
+    float pulse = 0.2f * sinf(gen->cardiac_phase) + 0.05f * sinf(gen->cardiac_phase + 0.3f * M_PI) +
+                  0.02f * sinf(2.0f * gen->cardiac_phase);
+    float noise = 0.001f * ((float)rand() / RAND_MAX - 0.5f);
+
+    return 1.0f + 0.01f * depth * resp +
+           0.1f * (1.0f + 0.2f * depth * sinf(gen->resp_phase + 0.5f)) * pulse + noise;
+}
+
+static void test_respiration(void)
+{
+    printf("\n🌬️  Respiration (RIIV/RIAV/RIFV fusion)\n");
+
+    ppg_preprocess_stage_t pre;
+    ppg_filter_stage_t filter;
+    ppg_filter_state_t filter_state;
+    ppg_feature_stage_t hr;
+    ppg_feature_state_t hr_state;
+    pipeline_stage_t resp_stage;
+    resp_estimator_t resp;
+
+    pipeline_stage_config_t pre_config = stage_config("pre");
+    pipeline_stage_config_t filter_config = stage_config("filter");
+    pipeline_stage_config_t hr_config = stage_config("hr");
+    pipeline_stage_config_t resp_config = stage_config("resp");
+
+    ppg_preprocess_stage_bind(&pre, &pre_config);
+    ppg_filter_stage_bind(&filter, &filter_state, &filter_config);
+    ppg_feature_stage_bind(&hr, &hr_state, &hr_config);
+    check(resp_stage_bind(&resp_stage, &resp, &resp_config), "Respiration stage binds");
+
+    const pipeline_node_desc_t graph[] = {
+        { &pre.base,    { PIPELINE_SOURCE_NAME_0 }, false },
+        { &filter.base, { "pre" },                  false },
+        { &hr.base,     { "filter" },               true  },
+        { &resp_stage,  { "hr", "pre" },            true  },
+    };
+    signal_pipeline_t* pipeline = pipeline_create_graph(PIPELINE_SIGNAL_PPG, graph, 4, BLOCK_SIZE);
+    check(pipeline != NULL, "Graph with respiration node accepted");
+    if (!pipeline) {
+        return;
+    }
+
+    // 15 brpm for 90 s, then 22 brpm for 90 s, then no breathing modulation
+    const float phases[3][2] = { {15.0f, 1.0f}, {22.0f, 1.0f}, {15.0f, 0.0f} };
+    breathing_ppg_t gen = {0};
+    float samples[BLOCK_SIZE];
+    srand(29);
+
+    for (int p = 0; p < 3; p++) {
+        for (uint32_t b = 0; b < 90 * SAMPLE_RATE_HZ / BLOCK_SIZE; b++) {
+            for (int i = 0; i < BLOCK_SIZE; i++) {
+                samples[i] = breathing_ppg_sample(&gen, phases[p][0], phases[p][1], 1.0f / SAMPLE_RATE_HZ);
+            }
+            signal_buffer_t input = { .data = samples, .length = BLOCK_SIZE, .sample_rate = SAMPLE_RATE_HZ };
+            pipeline_process(pipeline, &input);
+        }
+
+        const resp_result_t* r = resp_estimator_get_result(&resp);
+        printf("   %s: %.1f brpm (q %.2f, %u modalities; RIIV %.1f/%.2f RIAV %.1f/%.2f RIFV %.1f/%.2f)\n",
+               phases[p][1] > 0.0f ? "breathing" : "no modulation",
+               r->valid ? r->rate_bpm : 0.0f, r->quality, r->modalities_used,
+               r->modality_rate[RESP_MOD_RIIV], r->modality_quality[RESP_MOD_RIIV],
+               r->modality_rate[RESP_MOD_RIAV], r->modality_quality[RESP_MOD_RIAV],
+               r->modality_rate[RESP_MOD_RIFV], r->modality_quality[RESP_MOD_RIFV]);
+
+        if (phases[p][1] > 0.0f) {
+            char description[64];
+            snprintf(description, sizeof(description), "Rate within 1.5 brpm at %.0f brpm", phases[p][0]);
+            check(r->valid && fabsf(r->rate_bpm - phases[p][0]) < 1.5f && r->modalities_used >= 2, description);
+        } else {
+            check(!r->valid, "No estimate without breathing modulation");
+        }
+    }
+
+    // 5 s refresh: one estimate per 5 s once the window holds 16 s
+    printf("   Estimates: %u over %u s\n", resp.estimates, 270);
+    check(resp.estimates <= 270 / RESP_DEFAULT_CONFIG.update_interval_s,
+          "Estimate refreshed every few seconds, not per sample");
+    pipeline_destroy(pipeline);
+}
+
+// =============================================================================
+// Signal Quality Gating
+// =============================================================================
+
+typedef enum {
+    NIGHT_CLEAN = 0,
+    NIGHT_MOTION,
+    NIGHT_LOW_PERFUSION,
+    NIGHT_OFF_WRIST,
+    NIGHT_SEGMENT_COUNT
+} night_segment_t;
+
+static const char* const night_segment_names[NIGHT_SEGMENT_COUNT] = {
+    "clean", "motion", "low perfusion", "off wrist"
+};
+
+/** One IR sample and the matching accel x/y/z for a night segment */
+static float night_sample(night_segment_t segment, float t, float* xyz)
+{
+    float artifact = 0.0f;
+    float noise = 0.0004f * ((float)rand() / RAND_MAX - 0.5f);
+    float pulse = ppg_sim_generate_heartbeat(t, 58.0f / 60.0f) - 0.7f;
+
+    generate_arm_motion(t, segment == NIGHT_MOTION, xyz, &artifact);
+
+    switch (segment) {
+    case NIGHT_MOTION:
+        return 80000.0f * (1.0f + 0.02f * pulse + 0.1f * artifact + noise);
+    case NIGHT_LOW_PERFUSION:
+        return 80000.0f * (1.0f + 0.0001f * pulse + noise);
+    case NIGHT_OFF_WRIST:
+        return 600.0f * (1.0f + 20.0f * noise);
+    default:
+        return 80000.0f * (1.0f + 0.02f * pulse + noise);
+    }
+}
+
+static void test_signal_quality(void)
+{
+    printf("\n🌙 Signal Quality Index (gating a simulated night)\n");
+
+    ppg_preprocess_stage_t pre;
+    ppg_filter_stage_t filter;
+    ppg_filter_state_t filter_state;
+    pipeline_stage_t sqi_stage;
+    sqi_state_t sqi;
+    ppg_feature_stage_t hr;
+    ppg_feature_state_t hr_state;
+    pipeline_stage_t resp_stage;
+    resp_estimator_t resp;
+
+    pipeline_stage_config_t pre_config = stage_config("pre");
+    pipeline_stage_config_t filter_config = stage_config("filter");
+    pipeline_stage_config_t sqi_config = stage_config("sqi");
+    pipeline_stage_config_t hr_config = stage_config("hr");
+    pipeline_stage_config_t resp_config = stage_config("resp");
+
+    ppg_preprocess_stage_bind(&pre, &pre_config);
+    ppg_filter_stage_bind(&filter, &filter_state, &filter_config);
+    check(sqi_stage_bind(&sqi_stage, &sqi, &sqi_config), "SQI stage binds");
+    ppg_feature_stage_bind(&hr, &hr_state, &hr_config);
+    resp_stage_bind(&resp_stage, &resp, &resp_config);
+
+    const pipeline_node_desc_t graph[] = {
+        { &pre.base,    { PIPELINE_SOURCE_NAME_0 }, false },
+        { &filter.base, { "pre" },                  false },
+        { &sqi_stage,   { "filter", "pre" },        true  },
+        { &hr.base,     { "sqi" },                  true  },
+        { &resp_stage,  { "hr", "pre" },            true  },
+    };
+    signal_pipeline_t* pipeline = pipeline_create_graph(PIPELINE_SIGNAL_PPG, graph, 5, BLOCK_SIZE);
+    check(pipeline && pipeline_set_quality_gate(pipeline, "sqi", 0.5f), "Quality gate set on SQI node");
+    if (!pipeline) {
+        return;
+    }
+    check(pipeline->gated_mask == ((1u << 3) | (1u << 4)), "HR and respiration nodes are gated");
+
+    // 8 h night in 10 min cycles: 7 min still, then 1 min each of arm
+    // motion, weak perfusion and sensor off the wrist
+    const night_segment_t cycle[10] = {
+        NIGHT_CLEAN, NIGHT_CLEAN, NIGHT_CLEAN, NIGHT_CLEAN, NIGHT_CLEAN, NIGHT_CLEAN, NIGHT_CLEAN,
+        NIGHT_MOTION, NIGHT_LOW_PERFUSION, NIGHT_OFF_WRIST
+    };
+    const uint32_t blocks_per_minute = 60 * SAMPLE_RATE_HZ / BLOCK_SIZE;
+    float samples[BLOCK_SIZE];
+    float accel[3 * BLOCK_SIZE];
+    signal_buffer_t imu = { .data = accel, .length = 3 * BLOCK_SIZE, .sample_rate = SAMPLE_RATE_HZ };
+    float quality_sum[NIGHT_SEGMENT_COUNT] = {0};
+    uint32_t quality_blocks[NIGHT_SEGMENT_COUNT] = {0};
+    uint32_t hr_ok_minutes = 0;
+    uint32_t clean_minutes = 0;
+    uint32_t n = 0;
+    srand(30);
+
+    sqi.imu_buffer = &imu;
+    for (uint32_t minute = 0; minute < 8 * 60; minute++) {
+        night_segment_t segment = cycle[minute % 10];
+
+        for (uint32_t b = 0; b < blocks_per_minute; b++) {
+            for (int i = 0; i < BLOCK_SIZE; i++, n++) {
+                samples[i] = night_sample(segment, (float)n / SAMPLE_RATE_HZ, &accel[3 * i]);
+            }
+            signal_buffer_t input = { .data = samples, .length = BLOCK_SIZE, .sample_rate = SAMPLE_RATE_HZ };
+            pipeline_process(pipeline, &input);
+
+            // Skip the first 15 s of each segment while the features settle
+            if (b >= blocks_per_minute / 4) {
+                quality_sum[segment] += sqi.result.quality;
+                quality_blocks[segment]++;
+            }
+        }
+
+        if (segment == NIGHT_CLEAN && cycle[(minute + 1) % 10] == NIGHT_CLEAN) {
+            clean_minutes++;
+            hr_ok_minutes += fabsf(hr.last_hr_bpm - 58.0f) < 3.0f;
+        }
+    }
+
+    float mean_quality[NIGHT_SEGMENT_COUNT];
+    for (int s = 0; s < NIGHT_SEGMENT_COUNT; s++) {
+        mean_quality[s] = quality_sum[s] / (float)quality_blocks[s];
+        printf("   %-14s SQI %.2f\n", night_segment_names[s], mean_quality[s]);
+    }
+
+    uint32_t runs = 0, skipped = 0;
+    pipeline_get_gate_stats(pipeline, &runs, &skipped);
+    float skipped_fraction = (float)skipped / (float)(runs + skipped);
+    printf("   Feature/algorithm executions: %u run, %u skipped (%.1f%% of gated compute)\n",
+           runs, skipped, 100.0f * skipped_fraction);
+
+    check(mean_quality[NIGHT_CLEAN] > 0.8f, "Clean sleep scores high");
+    check(mean_quality[NIGHT_MOTION] < 0.3f && mean_quality[NIGHT_LOW_PERFUSION] < 0.3f &&
+          mean_quality[NIGHT_OFF_WRIST] < 0.3f, "Motion, weak perfusion and off-wrist score low");
+    check(skipped_fraction > 0.25f && skipped_fraction < 0.4f,
+          "Gate skips about the 30% of the night that is unusable");
+    check(hr_ok_minutes == clean_minutes, "HR recovers after every gated stretch");
+    check(pipeline->errors == 0, "No pipeline errors");
+    pipeline_destroy(pipeline);
+}
+
+// =============================================================================
+// Decimation
+// =============================================================================
+
+#define DECIM_RATE_HZ   100
+#define DECIM_BLOCK     128
+#define DECIM_LOOP_S    160     ///< Multiple of 2.5 s (3 beats) and of DECIM_BLOCK samples
+
+static float tone_amplitude(const float* x, uint32_t length, uint32_t skip)
+{
+    float peak = 0.0f;
+    for (uint32_t i = skip; i < length; i++) {
+        peak = fmaxf(peak, fabsf(x[i]));
+    }
+    return peak;
+}
+
+/** CPU time per second of 100 Hz signal for the full HR/SQI/respiration graph */
+static float pipeline_cost_us(bool decimate, float* hr_bpm)
+{
+    pipeline_stage_t dec_stage;
+    decimator_t dec;
+    ppg_preprocess_stage_t pre;
+    ppg_filter_stage_t filter;
+    ppg_filter_state_t filter_state;
+    pipeline_stage_t sqi_stage;
+    sqi_state_t sqi;
+    ppg_feature_stage_t hr;
+    ppg_feature_state_t hr_state;
+    pipeline_stage_t resp_stage;
+    resp_estimator_t resp;
+
+    pipeline_stage_config_t dec_config = stage_config("decimate");
+    pipeline_stage_config_t pre_config = stage_config("pre");
+    pipeline_stage_config_t filter_config = stage_config("filter");
+    pipeline_stage_config_t sqi_config = stage_config("sqi");
+    pipeline_stage_config_t hr_config = stage_config("hr");
+    pipeline_stage_config_t resp_config = stage_config("resp");
+
+    decimator_stage_bind(&dec_stage, &dec, &dec_config);
+    ppg_preprocess_stage_bind(&pre, &pre_config);
+    ppg_filter_stage_bind(&filter, &filter_state, &filter_config);
+    sqi_stage_bind(&sqi_stage, &sqi, &sqi_config);
+    ppg_feature_stage_bind(&hr, &hr_state, &hr_config);
+    resp_stage_bind(&resp_stage, &resp, &resp_config);
+
+    // Decimating at the source puts every downstream node at 25 Hz
+    const pipeline_node_desc_t graph[] = {
+        { &dec_stage,   { PIPELINE_SOURCE_NAME_0 }, false },
+        { &pre.base,    { decimate ? "decimate" : PIPELINE_SOURCE_NAME_0 }, false },
+        { &filter.base, { "pre" },                  false },
+        { &sqi_stage,   { "filter", "pre" },        false },
+        { &hr.base,     { "sqi" },                  true  },
+        { &resp_stage,  { "hr", "pre" },            true  },
+    };
+    signal_pipeline_t* pipeline = decimate ?
+        pipeline_create_graph(PIPELINE_SIGNAL_PPG, graph, 6, DECIM_BLOCK) :
+        pipeline_create_graph(PIPELINE_SIGNAL_PPG, graph + 1, 5, DECIM_BLOCK);
+
+    // 160 s of 72 bpm PPG (whole beats and blocks) replayed for an hour,
+    // generated up front so only the pipeline is timed
+    static float signal[DECIM_LOOP_S * DECIM_RATE_HZ];
+    const uint32_t seconds = 3600;
+    srand(31);
+    for (uint32_t i = 0; i < DECIM_LOOP_S * DECIM_RATE_HZ; i++) {
+        float t = (float)i / DECIM_RATE_HZ;
+        float noise = 0.0004f * ((float)rand() / RAND_MAX - 0.5f);
+        signal[i] = 80000.0f * (1.0f + 0.02f * (ppg_sim_generate_heartbeat(t, 1.2f) - 0.7f) + noise);
+    }
+
+    clock_t start = clock();
+    for (uint32_t b = 0; b < seconds * DECIM_RATE_HZ / DECIM_BLOCK; b++) {
+        uint32_t offset = (b * DECIM_BLOCK) % (DECIM_LOOP_S * DECIM_RATE_HZ);
+        signal_buffer_t input = { .data = &signal[offset], .length = DECIM_BLOCK, .sample_rate = DECIM_RATE_HZ };
+        pipeline_process(pipeline, &input);
+    }
+    clock_t elapsed = clock() - start;
+
+    *hr_bpm = hr.last_hr_bpm;
+    pipeline_destroy(pipeline);
+    return (float)elapsed * 1e6f / (float)CLOCKS_PER_SEC / (float)seconds;
+}
+
+static void test_decimator(void)
+{
+    printf("\n🪜 Polyphase Decimator (100 Hz input)\n");
+
+    decimator_t dec;
+    check(decimator_init(&dec, NULL), "Decimator initializes with defaults (M=4)");
+
+    // Polyphase output equals the full-rate FIR sampled every M-th sample
+    const uint32_t taps = dec.config.factor * dec.config.taps_per_phase;
+    float h[DECIMATOR_MAX_TAPS];
+    for (uint32_t p = 0; p < dec.config.factor; p++) {
+        for (uint32_t j = 0; j < dec.config.taps_per_phase; j++) {
+            h[j * dec.config.factor + p] = dec.coeffs[p * dec.config.taps_per_phase +
+                                                      dec.config.taps_per_phase - 1 - j];
+        }
+    }
+    float x[200], y[200];
+    srand(310);
+    for (int i = 0; i < 200; i++) {
+        x[i] = (float)rand() / RAND_MAX - 0.5f;
+    }
+    uint32_t produced = decimator_process(&dec, x, 97, y);
+    produced += decimator_process(&dec, x + 97, 103, y + produced);
+    float max_err = 0.0f;
+    for (uint32_t m = 0; m < produced; m++) {
+        float ref = 0.0f;
+        for (uint32_t k = 0; k < taps && k <= m * dec.config.factor; k++) {
+            ref += h[k] * x[m * dec.config.factor - k];
+        }
+        max_err = fmaxf(max_err, fabsf(ref - y[m]));
+    }
+    check(produced == 50 && max_err < 1e-5f, "Matches direct FIR + downsample across block boundaries");
+
+    // 1.5 Hz cardiac tone passes, 40 Hz interference does not alias into the band
+    float pass[400], stop[400], pass_out[100], stop_out[100];
+    for (int i = 0; i < 400; i++) {
+        pass[i] = sinf(2.0f * M_PI * 1.5f * i / DECIM_RATE_HZ);
+        stop[i] = sinf(2.0f * M_PI * 40.0f * i / DECIM_RATE_HZ);
+    }
+    decimator_reset(&dec);
+    uint32_t n_out = decimator_process(&dec, pass, 400, pass_out);
+    decimator_reset(&dec);
+    decimator_process(&dec, stop, 400, stop_out);
+    float gain_db = 20.0f * log10f(tone_amplitude(pass_out, n_out, 10));
+    float reject_db = 20.0f * log10f(tone_amplitude(stop_out, n_out, 10));
+    printf("   1.5 Hz: %.2f dB, 40 Hz: %.1f dB\n", gain_db, reject_db);
+    check(fabsf(gain_db) < 0.1f && reject_db < -40.0f, "Pass band flat, 40 Hz rejected by >40 dB");
+
+    // Chained 100 Hz -> 25 Hz -> 5 Hz publishes the rate of each hop
+    pipeline_stage_t hop1, hop2;
+    decimator_t dec1, dec2;
+    pipeline_stage_config_t hop1_config = stage_config("to25");
+    pipeline_stage_config_t hop2_config = stage_config("to5");
+    hop2_config.parameters[DECIMATOR_PARAM_FACTOR] = 5.0f;
+    hop2_config.parameter_count = 1;
+    decimator_stage_bind(&hop1, &dec1, &hop1_config);
+    check(decimator_stage_bind(&hop2, &dec2, &hop2_config) && dec2.config.taps_per_phase == 8,
+          "Second hop binds with factor 5");
+
+    signal_pipeline_t* chain = pipeline_create(PIPELINE_SIGNAL_PPG);
+    pipeline_add_stage(chain, &hop1);
+    pipeline_add_stage(chain, &hop2);
+    uint32_t total_out = 0;
+    for (int b = 0; b < 10; b++) {
+        signal_buffer_t input = { .data = pass, .length = PIPELINE_DEFAULT_BLOCK_SIZE, .sample_rate = DECIM_RATE_HZ };
+        pipeline_process(chain, &input);
+        total_out += pipeline_get_output(chain)->length;
+    }
+    const signal_buffer_t* out = pipeline_get_output(chain);
+    check(out && out->sample_rate == 5 && total_out == 10 * PIPELINE_DEFAULT_BLOCK_SIZE / 20 && chain->errors == 0,
+          "Chained hops tag 5 Hz output with one sample per 20 inputs");
+    pipeline_destroy(chain);
+
+    // Benchmark: same HR chain fed at 100 Hz, with and without a /4 hop
+    float hr_full = 0.0f, hr_decimated = 0.0f;
+    float cost_full = pipeline_cost_us(false, &hr_full);
+    float cost_decimated = pipeline_cost_us(true, &hr_decimated);
+    printf("   Full rate:  %.1f us CPU per signal second (HR %.1f)\n", cost_full, hr_full);
+    printf("   Decimated:  %.1f us CPU per signal second (HR %.1f, %.0f%% of full rate)\n",
+           cost_decimated, hr_decimated, cost_full > 0.0f ? 100.0f * cost_decimated / cost_full : 0.0f);
+    check(fabsf(hr_full - 72.0f) < 2.0f && fabsf(hr_decimated - 72.0f) < 2.0f,
+          "HR unchanged after decimating to 25 Hz");
+}
+
+// =============================================================================
+// Live Reconfiguration
+// =============================================================================
+
+static void test_live_reconfig(void)
+{
+    printf("\n🔁 Live Reconfiguration (block-boundary swap)\n");
+
+    ppg_preprocess_stage_t pre;
+    ppg_filter_stage_t filter;
+    ppg_filter_state_t filter_state;
+    ppg_feature_stage_t hr;
+    ppg_feature_state_t hr_state;
+    pipeline_stage_config_t pre_config = stage_config("pre");
+    pipeline_stage_config_t filter_config = stage_config("filter");
+    pipeline_stage_config_t hr_config = stage_config("hr");
+
+    ppg_preprocess_stage_bind(&pre, &pre_config);
+    ppg_filter_stage_bind(&filter, &filter_state, &filter_config);
+    ppg_feature_stage_bind(&hr, &hr_state, &hr_config);
+
+    const pipeline_node_desc_t graph[] = {
+        { &pre.base,    { PIPELINE_SOURCE_NAME_0 }, false },
+        { &filter.base, { "pre" },                  true  },
+        { &hr.base,     { "filter" },               true  },
+    };
+    signal_pipeline_t* pipeline = pipeline_create_graph(PIPELINE_SIGNAL_PPG, graph, 3, BLOCK_SIZE);
+    if (!pipeline) {
+        check(false, "Pipeline created");
+        return;
+    }
+
+    struct ppg_sim_config sim = {
+        .heart_rate_bpm = 66.0f,
+        .noise_level = 0.02f,
+        .breathing_rate_bpm = 14.0f,
+        .signal_quality = 95
+    };
+    ppg_sim_init(&sim);
+    srand(32);
+
+    const uint32_t switch_block = 40 * SAMPLE_RATE_HZ / BLOCK_SIZE;
+    const uint32_t blocks = switch_block + 20 * SAMPLE_RATE_HZ / BLOCK_SIZE;
+    const uint32_t window = 4 * SAMPLE_RATE_HZ / BLOCK_SIZE;
+    float samples[BLOCK_SIZE];
+    float prev = 0.0f;
+    float jump_before = 0.0f, jump_after = 0.0f;
+    float hr_min = 1e9f, hr_max = 0.0f;
+    bool staged_only = false, applied = false, full_blocks = true;
+
+    for (uint32_t b = 0; b < blocks; b++) {
+        if (b == switch_block) {
+            bool accepted = pipeline_update_config(pipeline, "filter:0=0.7,1=3.5;hr:2=4");
+            staged_only = accepted && filter.params.bandpass_low_hz < 0.6f &&
+                          hr_state.detector.config.hr_window == 8;
+        }
+
+        for (int i = 0; i < BLOCK_SIZE; i++) {
+            samples[i] = ppg_sim_generate_sample((b * BLOCK_SIZE + i) * 1000 / SAMPLE_RATE_HZ);
+        }
+        signal_buffer_t input = {
+            .data = samples,
+            .length = BLOCK_SIZE,
+            .sample_rate = SAMPLE_RATE_HZ,
+            .timestamp_start = b * BLOCK_SIZE * 1000 / SAMPLE_RATE_HZ,
+            .quality_score = 1.0f
+        };
+        pipeline_process(pipeline, &input);
+
+        if (b == switch_block) {
+            applied = fabsf(filter.params.bandpass_low_hz - 0.7f) < 1e-6f &&
+                      hr_state.detector.config.hr_window == 4;
+        }
+
+        const signal_buffer_t* out = pipeline_get_node_output(pipeline, "filter");
+        if (!out || out->length != BLOCK_SIZE) {
+            full_blocks = false;
+            continue;
+        }
+        for (uint32_t i = 0; i < out->length; i++) {
+            float jump = fabsf(out->data[i] - prev);
+            prev = out->data[i];
+            if (b >= switch_block - window && b < switch_block) {
+                jump_before = fmaxf(jump_before, jump);
+            } else if (b >= switch_block && b < switch_block + window) {
+                jump_after = fmaxf(jump_after, jump);
+            }
+        }
+        if (b >= switch_block - window) {
+            hr_min = fminf(hr_min, hr.last_hr_bpm);
+            hr_max = fmaxf(hr_max, hr.last_hr_bpm);
+        }
+    }
+
+    printf("   Max step: %.4f before, %.4f after the swap\n", jump_before, jump_after);
+    printf("   HR around the swap: %.1f - %.1f bpm (simulated 66)\n", hr_min, hr_max);
+
+    check(staged_only, "Configuration staged, active stages untouched until the boundary");
+    check(applied, "New filter band and HR window active from the next block");
+    check(full_blocks, "Every block produced a full output (no gap)");
+    check(jump_after < 1.5f * jump_before, "No step in the filtered signal at the swap");
+    check(hr_min > 63.0f && hr_max < 69.0f, "HR stays valid and continuous across the swap");
+
+    uint32_t applied_filter = filter.base.applied_sequence;
+    check(!pipeline_update_config(pipeline, "filter:0=0.6;hr:x=1") &&
+          !pipeline_update_config(pipeline, "nosuch:0=1") &&
+          filter.base.pending_sequence == applied_filter,
+          "Malformed update rejected without staging anything");
+    check(pipeline->errors == 0, "No pipeline errors");
+
+    pipeline_destroy(pipeline);
+
+    // A shorter window keeps the newest intervals: HR follows them right away
+    beat_detector_t bd;
+    beat_detector_config_t bd_config = BEAT_DETECTOR_DEFAULT_CONFIG;
+    beat_detector_snapshot_t history = { .interval_count = 8 };
+    for (uint32_t i = 0; i < 8; i++) {
+        history.intervals[i] = i < 4 ? 1000.0f : 500.0f;
+    }
+    bd_config.hr_window = 8;
+    beat_detector_init(&bd, &bd_config, SAMPLE_RATE_HZ);
+    beat_detector_resume(&bd, &history);
+    bd_config.hr_window = 4;
+    check(beat_detector_set_config(&bd, &bd_config) && fabsf(beat_detector_get_hr(&bd) - 120.0f) < 1e-3f,
+          "HR recomputed from the re-packed intervals on a window change");
+}
+
+// =============================================================================
+// Sleep Checkpoint
+// =============================================================================
+
+#define WAKE_SECONDS    30
+
+static PIPELINE_RETAINED uint8_t sleep_checkpoint[PIPELINE_CHECKPOINT_MAX_SIZE];
+
+/** Seconds of wake signal until HR is back within 3 bpm (-1: never) */
+static float time_to_valid_hr(signal_pipeline_t* pipeline, const ppg_feature_stage_t* hr,
+                              const float* signal, float true_bpm)
+{
+    for (uint32_t b = 0; b < WAKE_SECONDS * SAMPLE_RATE_HZ / BLOCK_SIZE; b++) {
+        signal_buffer_t input = {
+            .data = (float*)&signal[b * BLOCK_SIZE],
+            .length = BLOCK_SIZE,
+            .sample_rate = SAMPLE_RATE_HZ
+        };
+        pipeline_process(pipeline, &input);
+        if (hr->last_hr_bpm > 0.0f && fabsf(hr->last_hr_bpm - true_bpm) < 3.0f) {
+            return (float)((b + 1) * BLOCK_SIZE) / SAMPLE_RATE_HZ;
+        }
+    }
+    return -1.0f;
+}
+
+static void test_sleep_checkpoint(void)
+{
+    printf("\n💤 Sleep Checkpoint (warm resume from retained RAM)\n");
+
+    ppg_preprocess_stage_t pre;
+    ppg_filter_stage_t filter;
+    ppg_filter_state_t filter_state;
+    pipeline_stage_t sqi_stage;
+    sqi_state_t sqi;
+    ppg_feature_stage_t hr;
+    ppg_feature_state_t hr_state;
+
+    pipeline_stage_config_t pre_config = stage_config("pre");
+    pipeline_stage_config_t filter_config = stage_config("filter");
+    pipeline_stage_config_t sqi_config = stage_config("sqi");
+    pipeline_stage_config_t hr_config = stage_config("hr");
+
+    ppg_preprocess_stage_bind(&pre, &pre_config);
+    ppg_filter_stage_bind(&filter, &filter_state, &filter_config);
+    sqi_stage_bind(&sqi_stage, &sqi, &sqi_config);
+    ppg_feature_stage_bind(&hr, &hr_state, &hr_config);
+
+    const pipeline_node_desc_t graph[] = {
+        { &pre.base,    { PIPELINE_SOURCE_NAME_0 }, false },
+        { &filter.base, { "pre" },                  false },
+        { &sqi_stage,   { "filter", "pre" },        false },
+        { &hr.base,     { "sqi" },                  true  },
+    };
+    signal_pipeline_t* pipeline = pipeline_create_graph(PIPELINE_SIGNAL_PPG, graph, 4, BLOCK_SIZE);
+    if (!pipeline || !pipeline_set_quality_gate(pipeline, "sqi", 0.5f)) {
+        check(false, "Gated HR pipeline created");
+        return;
+    }
+
+    // Two minutes of clean sleep, then the device sleeps for ten
+    float samples[BLOCK_SIZE];
+    float xyz[3];
+    uint32_t n = 0;
+    srand(33);
+    for (uint32_t b = 0; b < 120 * SAMPLE_RATE_HZ / BLOCK_SIZE; b++) {
+        for (int i = 0; i < BLOCK_SIZE; i++, n++) {
+            samples[i] = night_sample(NIGHT_CLEAN, (float)n / SAMPLE_RATE_HZ, xyz);
+        }
+        signal_buffer_t input = { .data = samples, .length = BLOCK_SIZE, .sample_rate = SAMPLE_RATE_HZ };
+        pipeline_process(pipeline, &input);
+    }
+    float hr_before = hr.last_hr_bpm;
+
+    uint32_t size = pipeline_checkpoint(pipeline, sleep_checkpoint, sizeof(sleep_checkpoint));
+    printf("   Checkpoint: %u bytes (HR %.1f bpm at sleep)\n", size, hr_before);
+    check(size > 0 && size <= PIPELINE_CHECKPOINT_MAX_SIZE, "Checkpoint fits the retained buffer");
+
+    static float wake[WAKE_SECONDS * SAMPLE_RATE_HZ];
+    n += 600 * SAMPLE_RATE_HZ;
+    for (uint32_t i = 0; i < WAKE_SECONDS * SAMPLE_RATE_HZ; i++, n++) {
+        wake[i] = night_sample(NIGHT_CLEAN, (float)n / SAMPLE_RATE_HZ, xyz);
+    }
+
+    pipeline_reset(pipeline);
+    float cold_s = time_to_valid_hr(pipeline, &hr, wake, 58.0f);
+
+    check(pipeline_restore(pipeline, sleep_checkpoint, size), "Checkpoint accepted on wake");
+    bool no_stale_hr = hr.last_hr_bpm == 0.0f && hr_state.detector.interval_count > 0;
+    float warm_s = time_to_valid_hr(pipeline, &hr, wake, 58.0f);
+
+    printf("   Time to valid HR after wake: %.1f s cold, %.1f s warm\n", cold_s, warm_s);
+    check(no_stale_hr, "Interval history restored, no HR reported from before the gap");
+    check(warm_s > 0.0f && cold_s > 0.0f && warm_s < 0.5f * cold_s, "Warm resume at least halves time to valid HR");
+
+    sleep_checkpoint[size - 1] ^= 0x5A;
+    check(!pipeline_restore(pipeline, sleep_checkpoint, size), "Corrupted checkpoint rejected");
+    sleep_checkpoint[size - 1] ^= 0x5A;
+    sleep_checkpoint[5 * sizeof(uint32_t)] ^= 1;    // Header gate_open
+    check(!pipeline_restore(pipeline, sleep_checkpoint, size), "Corrupted checkpoint header rejected");
+    check(pipeline->errors == 0, "No pipeline errors");
+    pipeline_destroy(pipeline);
+}
+
+// =============================================================================
+// Static Pool
+// =============================================================================
+
+#define SCRATCH_PROBE_BYTES   512
+
+// Uses its whole scratch every block, then passes the input through
+static bool scratch_probe_process(pipeline_stage_t* stage, const signal_buffer_t* input, signal_buffer_t* output)
+{
+    if (!stage->scratch) {
+        return false;
+    }
+    memset(stage->scratch, 0xA5, stage->scratch_bytes);
+    memcpy(output->data, input->data, input->length * sizeof(float));
+    output->length = input->length;
+    return true;
+}
+
+static pipeline_stage_ops_t scratch_probe_ops = { .process = scratch_probe_process };
+
+static void test_static_pool(void)
+{
+    printf("\n🧱 Static Pool (no heap after create)\n");
+
+    ppg_preprocess_stage_t pre;
+    ppg_filter_stage_t filter;
+    ppg_filter_state_t filter_state;
+    pipeline_stage_t probe = {
+        .name = "scratch", .ops = &scratch_probe_ops,
+        .config = { .enabled = true, .buffer_size = 2 * BLOCK_SIZE },
+        .scratch_bytes = SCRATCH_PROBE_BYTES
+    };
+    pipeline_stage_config_t pre_config = stage_config("pre");
+    pipeline_stage_config_t filter_config = stage_config("filter");
+
+    ppg_preprocess_stage_bind(&pre, &pre_config);
+    ppg_filter_stage_bind(&filter, &filter_state, &filter_config);
+
+    const pipeline_node_desc_t graph[] = {
+        { &pre.base,    { PIPELINE_SOURCE_NAME_0 }, false },
+        { &filter.base, { "pre" },                  false },
+        { &probe,       { "filter" },               true  },
+    };
+    signal_pipeline_t* pipeline = pipeline_create_graph(PIPELINE_SIGNAL_PPG, graph, 3, BLOCK_SIZE);
+    if (!pipeline) {
+        check(false, "Pipeline created from the pool");
+        return;
+    }
+
+    uint32_t reserved = pipeline_pool_used(pipeline);
+    printf("   Reserved at create: %u bytes (%u buffers x %u samples, %u scratch)\n",
+           reserved, pipeline->buffer_count, pipeline->buffer_samples, pipeline->scratch_bytes);
+    check(pipeline->buffer_samples == 2 * BLOCK_SIZE,
+          "Pool buffers sized from the largest stage buffer_size");
+    check(probe.scratch != NULL && pipeline->scratch_bytes == SCRATCH_PROBE_BYTES &&
+          filter.base.scratch == NULL, "Scratch handed only to the stage that declared it");
+
+    float samples[BLOCK_SIZE];
+    for (int i = 0; i < BLOCK_SIZE; i++) {
+        samples[i] = 1000.0f + (float)i;
+    }
+    for (uint32_t b = 0; b < 10 * 60 * SAMPLE_RATE_HZ / BLOCK_SIZE; b++) {
+        signal_buffer_t input = { .data = samples, .length = BLOCK_SIZE, .sample_rate = SAMPLE_RATE_HZ };
+        pipeline_process(pipeline, &input);
+    }
+    check(pipeline_pool_used(pipeline) == reserved && pipeline->errors == 0,
+          "Nothing reserved while processing");
+
+    // Growing scratch through add/remove extends the one area in place
+    pipeline_stage_t grower = {
+        .name = "grower", .ops = &scratch_probe_ops,
+        .config = { .enabled = true }
+    };
+    bool regrown = true;
+    for (uint32_t k = 2; k <= 4; k++) {
+        grower.scratch_bytes = k * SCRATCH_PROBE_BYTES;
+        regrown = regrown && pipeline_add_stage(pipeline, &grower) &&
+                  pipeline_remove_stage(pipeline, "grower");
+    }
+    check(regrown && pipeline->scratch_bytes == 4 * SCRATCH_PROBE_BYTES &&
+          pipeline_pool_used(pipeline) == reserved + 3 * SCRATCH_PROBE_BYTES,
+          "Scratch regrown without leaking the smaller areas");
+    check(probe.scratch == pipeline->scratch, "Stages follow the regrown scratch area");
+    reserved = pipeline_pool_used(pipeline);
+
+    // Exhaust the slots, then recycle one
+    signal_pipeline_t* extra[PIPELINE_POOL_SLOTS];
+    uint32_t created = 0;
+    pipeline_pool_stats_t before, stats;
+    pipeline_pool_get_stats(&before);
+    while (created < PIPELINE_POOL_SLOTS && (extra[created] = pipeline_create(PIPELINE_SIGNAL_PPG)) != NULL) {
+        created++;
+    }
+    pipeline_pool_get_stats(&stats);
+    check(created == PIPELINE_POOL_SLOTS - 1 && stats.slots_in_use == PIPELINE_POOL_SLOTS &&
+          stats.failures == before.failures + 1, "Creation fails cleanly once every slot is taken");
+    pipeline_destroy(extra[--created]);
+    extra[created] = pipeline_create(PIPELINE_SIGNAL_PPG);
+    check(extra[created] != NULL, "Destroyed slot is reused");
+    created++;
+    while (created > 0) {
+        pipeline_destroy(extra[--created]);
+    }
+
+    pipeline_pool_get_stats(&stats);
+    printf("   Pool: %u slots x %u bytes, peak %u slots, arena high-water %u bytes\n",
+           stats.slots_total, stats.arena_bytes, stats.slots_peak, stats.arena_peak);
+    check(stats.arena_peak < stats.arena_bytes, "Every graph so far fits its arena with room to spare");
+
+    // A graph that cannot fit its arena is refused at creation, not mid-stream
+    probe.config.buffer_size = PIPELINE_POOL_ARENA_BYTES / sizeof(float);
+    pipeline_destroy(pipeline);
+    pipeline_pool_get_stats(&before);
+    pipeline = pipeline_create_graph(PIPELINE_SIGNAL_PPG, graph, 3, BLOCK_SIZE);
+    pipeline_pool_get_stats(&stats);
+    check(pipeline == NULL && stats.slots_in_use == before.slots_in_use,
+          "Oversized graph rejected and its slot returned");
+}
+
+// =============================================================================
+// Profiling
+// =============================================================================
+
+#ifdef CONFIG_PIPELINE_PROFILING
+static void test_pipeline_profile(void)
+{
+    printf("\n⏱️  Per-Stage Profiling\n");
+
+    ppg_preprocess_stage_t pre;
+    ppg_filter_stage_t filter;
+    ppg_filter_state_t filter_state;
+    pipeline_stage_t sqi_stage;
+    sqi_state_t sqi;
+    ppg_feature_stage_t hr;
+    ppg_feature_state_t hr_state;
+
+    pipeline_stage_config_t pre_config = stage_config("pre");
+    pipeline_stage_config_t filter_config = stage_config("filter");
+    pipeline_stage_config_t sqi_config = stage_config("sqi");
+    pipeline_stage_config_t hr_config = stage_config("hr");
+
+    ppg_preprocess_stage_bind(&pre, &pre_config);
+    ppg_filter_stage_bind(&filter, &filter_state, &filter_config);
+    sqi_stage_bind(&sqi_stage, &sqi, &sqi_config);
+    ppg_feature_stage_bind(&hr, &hr_state, &hr_config);
+
+    const pipeline_node_desc_t graph[] = {
+        { &pre.base,    { PIPELINE_SOURCE_NAME_0 }, false },
+        { &filter.base, { "pre" },                  false },
+        { &sqi_stage,   { "filter", "pre" },        false },
+        { &hr.base,     { "sqi" },                  true  },
+    };
+    signal_pipeline_t* pipeline = pipeline_create_graph(PIPELINE_SIGNAL_PPG, graph, 4, BLOCK_SIZE);
+    if (!pipeline) {
+        check(false, "Profiled pipeline created");
+        return;
+    }
+
+    const uint32_t blocks = 60 * SAMPLE_RATE_HZ / BLOCK_SIZE;
+    float samples[BLOCK_SIZE];
+    float xyz[3];
+    uint32_t n = 0;
+    srand(35);
+    for (uint32_t b = 0; b < blocks; b++) {
+        for (int i = 0; i < BLOCK_SIZE; i++, n++) {
+            samples[i] = night_sample(NIGHT_CLEAN, (float)n / SAMPLE_RATE_HZ, xyz);
+        }
+        signal_buffer_t input = { .data = samples, .length = BLOCK_SIZE, .sample_rate = SAMPLE_RATE_HZ };
+        pipeline_process(pipeline, &input);
+    }
+
+    char table[512];
+    pipeline_profile_format(pipeline, table, sizeof(table));
+    printf("%s", table);
+
+    const char* names[] = { NULL, "pre", "filter", "sqi", "hr" };
+    bool counted = true;
+    bool ordered = true;
+    for (uint32_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        pipeline_profile_summary_t s;
+        if (!pipeline_profile_get(pipeline, names[i], &s)) {
+            counted = false;
+            continue;
+        }
+        counted = counted && s.count == blocks;
+        ordered = ordered && s.min_ns <= s.avg_ns && s.avg_ns <= s.max_ns &&
+                  s.min_ns <= s.p99_ns && s.p99_ns <= s.max_ns;
+    }
+    check(counted, "Every stage and block measured once per block");
+    check(ordered, "min <= avg <= max and min <= p99 <= max");
+
+    float quality;
+    uint32_t stage_us = 0;
+    uint32_t latency_us = 0;
+    filter.base.ops->get_status(&filter.base, &quality, &stage_us);
+    pipeline_get_metrics(pipeline, &latency_us, NULL, NULL);
+    check(stage_us > 0 && latency_us >= stage_us,
+          "get_status() and pipeline_get_metrics() report measured time");
+
+    uint8_t packed[4 + 5 * PIPELINE_PROFILE_RECORD_SIZE];
+    pipeline_profile_summary_t filter_summary;
+    pipeline_profile_get(pipeline, "filter", &filter_summary);
+    uint32_t packed_len = pipeline_profile_pack(pipeline, packed, sizeof(packed));
+    const uint8_t* rec = &packed[4 + 2 * PIPELINE_PROFILE_RECORD_SIZE];
+    uint32_t packed_max = rec[28] | rec[29] << 8 | rec[30] << 16 | (uint32_t)rec[31] << 24;
+    check(packed_len == sizeof(packed) && packed[1] == 5 && strcmp((const char*)rec, "filter") == 0 &&
+          packed_max == filter_summary.max_ns, "BLE records carry the same numbers as the shell");
+
+    uint8_t ble_data[2 * PIPELINE_PROFILE_RECORD_SIZE + 4];
+    ble_char_value_t value = { .type = BLE_DATA_TYPE_BYTES, .max_length = sizeof(ble_data), .data = ble_data };
+    uint32_t ble_len = 0;
+    check(pipeline_profile_ble_read(&value, &ble_len) && ble_len == sizeof(ble_data) && ble_data[1] == 2,
+          "BLE read truncates to whole records");
+
+    pipeline_profile_reset(pipeline);
+    pipeline_profile_summary_t cleared;
+    pipeline_profile_get(pipeline, "hr", &cleared);
+    check(cleared.count == 0, "Reset clears the histograms");
+
+    pipeline_destroy(pipeline);
+}
+#endif
+
+// =============================================================================
+// Tuned Configurations
+// =============================================================================
+
+static bool stage_runs_point(const pipeline_stage_t* stage, const pipeline_stage_config_t* tuned)
+{
+    return stage->config.enabled == tuned->enabled &&
+           stage->config.parameter_count == tuned->parameter_count &&
+           memcmp(stage->config.parameters, tuned->parameters,
+                  tuned->parameter_count * sizeof(float)) == 0;
+}
+
+static void test_sensor_retune(void)
+{
+    printf("\n🎛️  Tuned Configurations (sensor migration)\n");
+
+    ppg_preprocess_stage_t pre;
+    ppg_artifact_removal_stage_t artifact;
+    motion_canceller_t mc;
+    ppg_filter_stage_t filter;
+    ppg_filter_state_t filter_state;
+    ppg_feature_stage_t hr;
+    ppg_feature_state_t hr_state;
+
+    ppg_preprocess_stage_bind(&pre, &PPG_MAX30101_PREPROCESS_CONFIG);
+    motion_canceller_stage_bind(&artifact, &mc, &PPG_MAX30101_ARTIFACT_CONFIG);
+    ppg_filter_stage_bind(&filter, &filter_state, &PPG_MAX30101_FILTER_CONFIG);
+    ppg_feature_stage_bind(&hr, &hr_state, &PPG_MAX30101_FEATURE_CONFIG);
+
+    const pipeline_node_desc_t graph[] = {
+        { &pre.base,      { PIPELINE_SOURCE_NAME_0 }, false },
+        { &artifact.base, { "pre" },                  false },
+        { &filter.base,   { "artifact" },             false },
+        { &hr.base,       { "filter" },               true  },
+    };
+    signal_pipeline_t* pipeline = pipeline_create_graph(PIPELINE_SIGNAL_PPG, graph, 4, BLOCK_SIZE);
+    if (!pipeline) {
+        check(false, "Pipeline created from the MAX30101 constants");
+        return;
+    }
+
+    const pipeline_tuned_point_t* accurate_30101 = pipeline_tuned_lookup("MAX30101", "accuracy");
+    const pipeline_tuned_point_t* accurate_86141 = pipeline_tuned_lookup("MAX86141", "accuracy");
+    const pipeline_tuned_point_t* balanced_86141 = pipeline_tuned_lookup("MAX86141", NULL);
+    check(accurate_30101 && accurate_86141 && balanced_86141 &&
+          balanced_86141->cost_ns_per_sample <= accurate_86141->cost_ns_per_sample &&
+          balanced_86141->hr_error_bpm >= accurate_86141->hr_error_bpm,
+          "Every sensor has accuracy and balanced points on its front");
+    check(pipeline_tuned_lookup("MAX86141", "turbo") == NULL &&
+          !pipeline_get_recommended_config("balanced", "AFE4404", pipeline),
+          "Unknown use case or sensor rejected");
+
+    float samples[BLOCK_SIZE];
+    float accel[BLOCK_SIZE * MOTION_CANCELLER_AXES];
+    signal_buffer_t imu = { .data = accel, .length = BLOCK_SIZE * MOTION_CANCELLER_AXES, .sample_rate = SAMPLE_RATE_HZ };
+    artifact.imu_buffer = &imu;
+    uint32_t n = 0;
+    srand(36);
+
+    check(pipeline_get_recommended_config("accuracy", "MAX30101", pipeline),
+          "Accuracy point staged for the MAX30101");
+
+    // Migration happens mid-stream, one block after the accuracy point took effect
+    bool migrated = false;
+    for (uint32_t b = 0; b < 40 * SAMPLE_RATE_HZ / BLOCK_SIZE; b++) {
+        for (int i = 0; i < BLOCK_SIZE; i++, n++) {
+            samples[i] = night_sample(NIGHT_CLEAN, (float)n / SAMPLE_RATE_HZ, &accel[3 * i]);
+        }
+        signal_buffer_t input = { .data = samples, .length = BLOCK_SIZE, .sample_rate = SAMPLE_RATE_HZ };
+        pipeline_process(pipeline, &input);
+
+        if (b == 0) {
+            check(stage_runs_point(&filter.base, &accurate_30101->filter) &&
+                  stage_runs_point(&hr.base, &accurate_30101->feature),
+                  "Recommended config swapped in at the block boundary");
+            migrated = pipeline_auto_tune_for_sensor(pipeline, "MAX30101", "MAX86141");
+        }
+    }
+
+    check(migrated && stage_runs_point(&filter.base, &accurate_86141->filter) &&
+          stage_runs_point(&artifact.base, &accurate_86141->artifact) &&
+          stage_runs_point(&hr.base, &accurate_86141->feature),
+          "Migration to the MAX86141 keeps the accuracy use case");
+    printf("   MAX86141 accuracy point: %.2f bpm on the corpus, HR %.1f bpm here (simulated 58)\n",
+           accurate_86141->hr_error_bpm, hr.last_hr_bpm);
+    check(fabsf(hr.last_hr_bpm - 58.0f) < 3.0f && pipeline->errors == 0,
+          "Retuned pipeline tracks HR without errors");
+
+    pipeline_destroy(pipeline);
+}
+
+// =============================================================================
+// Compiled Static Pipeline
+// =============================================================================
+
+#define STATIC_SIGNAL_S  120
+
+// Same settings as the dynamic chain below, baked in at compile time
+PPG_STATIC_PIPELINE_DEFINE(test_hr_50hz, SAMPLE_RATE_HZ, 2.0f, 0.99f, 2, 0.4f, 5.0f, 0.6f, 270.0f, 8)
+PPG_STATIC_PIPELINE_DEFINE(test_hr4_50hz, SAMPLE_RATE_HZ, 2.0f, 0.99f, 4, 0.4f, 5.0f, 0.6f, 270.0f, 8)
+
+static void test_static_pipeline(void)
+{
+    printf("\n🧱 Compiled Static Pipeline\n");
+
+    ppg_preprocess_stage_t pre;
+    ppg_filter_stage_t filter;
+    ppg_filter_state_t filter_state;
+    ppg_feature_stage_t hr;
+    ppg_feature_state_t hr_state;
+
+    pipeline_stage_config_t pre_config = stage_config("pre");
+    pipeline_stage_config_t filter_config = stage_config("filter");
+    pipeline_stage_config_t hr_config = stage_config("hr");
+    pre_config.parameters[PPG_PREPROCESS_PARAM_SCALE] = 2.0f;
+    pre_config.parameter_count = PPG_PREPROCESS_PARAM_COUNT;
+    filter_config.parameters[PPG_FILTER_PARAM_LOW_HZ] = 0.4f;
+    filter_config.parameters[PPG_FILTER_PARAM_HIGH_HZ] = 5.0f;
+    filter_config.parameters[PPG_FILTER_PARAM_ORDER] = 2.0f;
+    filter_config.parameters[PPG_FILTER_PARAM_DC_ALPHA] = 0.99f;
+    filter_config.parameter_count = PPG_FILTER_PARAM_COUNT;
+    hr_config.parameters[PPG_FEATURE_PARAM_HYSTERESIS] = 0.6f;
+    hr_config.parameters[PPG_FEATURE_PARAM_MIN_DISTANCE_MS] = 270.0f;
+    hr_config.parameters[PPG_FEATURE_PARAM_HR_WINDOW] = 8.0f;
+    hr_config.parameter_count = PPG_FEATURE_PARAM_COUNT;
+
+    ppg_preprocess_stage_bind(&pre, &pre_config);
+    ppg_filter_stage_bind(&filter, &filter_state, &filter_config);
+    ppg_feature_stage_bind(&hr, &hr_state, &hr_config);
+
+    signal_pipeline_t* pipeline = pipeline_create(PIPELINE_SIGNAL_PPG);
+    pipeline_add_stage(pipeline, &pre.base);
+    pipeline_add_stage(pipeline, &filter.base);
+    pipeline_add_stage(pipeline, &hr.base);
+
+    static ppg_static_pipeline_t compiled;
+    check(test_hr_50hz_init(&compiled), "Static pipeline initializes");
+
+    static float signal[STATIC_SIGNAL_S * SAMPLE_RATE_HZ];
+    float xyz[3];
+    srand(37);
+    for (uint32_t i = 0; i < STATIC_SIGNAL_S * SAMPLE_RATE_HZ; i++) {
+        signal[i] = night_sample(NIGHT_CLEAN, (float)i / SAMPLE_RATE_HZ, xyz);
+    }
+
+    // Same beats, positions and HR in every block
+    const uint32_t blocks = STATIC_SIGNAL_S * SAMPLE_RATE_HZ / BLOCK_SIZE;
+    uint32_t mismatches = 0;
+    uint32_t beats = 0;
+    for (uint32_t b = 0; b < blocks; b++) {
+        signal_buffer_t input = { .data = &signal[b * BLOCK_SIZE], .length = BLOCK_SIZE,
+                                  .sample_rate = SAMPLE_RATE_HZ };
+        pipeline_process(pipeline, &input);
+        const ppg_beat_block_t* out = test_hr_50hz_process(&compiled, input.data, BLOCK_SIZE);
+
+        bool same = out->count == hr_state.block.count && out->hr_bpm == hr_state.block.hr_bpm;
+        for (uint32_t k = 0; same && k < out->count; k++) {
+            same = out->beats[k].sample_index == hr_state.beats[k].sample_index &&
+                   out->beats[k].amplitude == hr_state.beats[k].amplitude;
+        }
+        mismatches += same ? 0 : 1;
+        beats += out->count;
+    }
+    printf("   %u beats, HR %.1f bpm, %u mismatched blocks\n", beats, compiled.block.hr_bpm, mismatches);
+    check(mismatches == 0 && beats > 100, "Static output identical to the dynamic chain");
+
+    // Calls longer than the fused chunk are split without losing beats
+    ppg_static_pipeline_t long_call;
+    test_hr_50hz_init(&long_call);
+    uint32_t long_beats = 0;
+    for (uint32_t s = 0; s < STATIC_SIGNAL_S; s += 2) {
+        long_beats += test_hr_50hz_process(&long_call, &signal[s * SAMPLE_RATE_HZ], 2 * SAMPLE_RATE_HZ)->count;
+    }
+    check(long_beats == beats && long_call.block.hr_bpm == compiled.block.hr_bpm,
+          "Blocks longer than the chunk give the same beats");
+
+    ppg_static_pipeline_reset(&compiled);
+    test_hr_50hz_process(&compiled, signal, BLOCK_SIZE);
+    check(compiled.block.block_start_index == 0 && compiled.block.hr_bpm == 0.0f,
+          "Reset restarts the detector");
+
+    // Cost per sample: replay the recording for an hour of signal
+    const uint32_t repeats = 3600 / STATIC_SIGNAL_S;
+    pipeline_reset(pipeline);
+    clock_t start = clock();
+    for (uint32_t r = 0; r < repeats; r++) {
+        for (uint32_t b = 0; b < blocks; b++) {
+            signal_buffer_t input = { .data = &signal[b * BLOCK_SIZE], .length = BLOCK_SIZE,
+                                      .sample_rate = SAMPLE_RATE_HZ };
+            pipeline_process(pipeline, &input);
+        }
+    }
+    clock_t dynamic_ticks = clock() - start;
+
+    ppg_static_pipeline_t order4;
+    test_hr4_50hz_init(&order4);
+    test_hr_50hz_init(&compiled);
+    start = clock();
+    for (uint32_t r = 0; r < repeats; r++) {
+        for (uint32_t b = 0; b < blocks; b++) {
+            test_hr_50hz_process(&compiled, &signal[b * BLOCK_SIZE], BLOCK_SIZE);
+        }
+    }
+    clock_t static_ticks = clock() - start;
+    start = clock();
+    for (uint32_t r = 0; r < repeats; r++) {
+        for (uint32_t b = 0; b < blocks; b++) {
+            test_hr4_50hz_process(&order4, &signal[b * BLOCK_SIZE], BLOCK_SIZE);
+        }
+    }
+    clock_t order4_ticks = clock() - start;
+
+    const float samples = (float)repeats * blocks * BLOCK_SIZE;
+    float dynamic_ns = (float)dynamic_ticks * 1e9f / (float)CLOCKS_PER_SEC / samples;
+    float static_ns = (float)static_ticks * 1e9f / (float)CLOCKS_PER_SEC / samples;
+    float order4_ns = (float)order4_ticks * 1e9f / (float)CLOCKS_PER_SEC / samples;
+#ifdef CONFIG_PIPELINE_PROFILING
+    const char* note = " (profiling hooks on)";
+#else
+    const char* note = "";
+#endif
+    printf("   Dynamic pre->filter->hr: %.1f ns/sample%s\n", dynamic_ns, note);
+    printf("   Static, order 2:         %.1f ns/sample (%.1fx)\n", static_ns,
+           static_ns > 0.0f ? dynamic_ns / static_ns : 0.0f);
+    printf("   Static, order 4:         %.1f ns/sample\n", order4_ns);
+    check(fabsf(order4.block.hr_bpm - 58.0f) < 3.0f, "Order-4 static pipeline tracks HR");
+
+    pipeline_destroy(pipeline);
+}
+
+// =============================================================================
+// Running Order Statistics
+// =============================================================================
+
+#define RF_MAX_WINDOW   1024
+#define RF_SAMPLES      20000
+
+static int compare_float(const void* a, const void* b)
+{
+    float x = *(const float*)a, y = *(const float*)b;
+    return (x > y) - (x < y);
+}
+
+/** Reference quantile: sort the last window samples ending at x[end - 1] */
+static float sorted_quantile(const float* x, uint32_t end, uint32_t window, float q, float* scratch)
+{
+    uint32_t n = end < window ? end : window;
+    memcpy(scratch, x + end - n, n * sizeof(float));
+    qsort(scratch, n, sizeof(float), compare_float);
+    float rank = q * (float)(n - 1);
+    uint32_t k = (uint32_t)floorf(rank);
+    float frac = rank - (float)k;
+    return frac > 0.0f ? scratch[k] + frac * (scratch[k + 1] - scratch[k]) : scratch[k];
+}
+
+static float elapsed_ns(clock_t start, uint32_t samples)
+{
+    return (float)(clock() - start) * 1e9f / (float)CLOCKS_PER_SEC / (float)samples;
+}
+
+static void test_running_filters(void)
+{
+    printf("\n📐 Running Median / Min-Max / MAD\n");
+
+    static float values[2 * RF_MAX_WINDOW];
+    static uint16_t index[4 * RF_MAX_WINDOW];
+    static float x[RF_SAMPLES];
+    static float scratch[RF_MAX_WINDOW];
+    static float deviation[RF_MAX_WINDOW];
+    running_quantile_t rq;
+    running_minmax_t rm;
+    running_mad_t mad;
+
+    // Heavy ties and outliers: integer noise with occasional spikes
+    srand(38);
+    for (uint32_t i = 0; i < RF_SAMPLES; i++) {
+        x[i] = (float)(rand() % 16) + (rand() % 50 == 0 ? 1000.0f : 0.0f);
+    }
+
+    check(!running_median_init(&rq, 0, values, index) &&
+          !running_quantile_init(&rq, 8, 1.5f, values, index) &&
+          !running_median_init(&rq, RUNNING_FILTER_MAX_WINDOW + 1, values, index),
+          "Zero, oversized windows and quantiles outside 0..1 are rejected");
+
+    // Every sample, filling and sliding, against a sorted copy of the window
+    const uint32_t windows[] = { 1, 2, 7, 8, 33, 200 };
+    const float quantiles[] = { 0.0f, 0.25f, 0.5f, 0.9f, 1.0f };
+    uint32_t wrong = 0;
+    for (uint32_t w = 0; w < sizeof(windows) / sizeof(windows[0]); w++) {
+        for (uint32_t q = 0; q < sizeof(quantiles) / sizeof(quantiles[0]); q++) {
+            running_quantile_init(&rq, windows[w], quantiles[q], values, index);
+            for (uint32_t i = 0; i < 2000; i++) {
+                running_quantile_push(&rq, x[i]);
+                float ref = sorted_quantile(x, i + 1, windows[w], quantiles[q], scratch);
+                wrong += fabsf(running_quantile_get(&rq) - ref) > 1e-4f * (1.0f + fabsf(ref)) ? 1 : 0;
+            }
+        }
+    }
+    check(wrong == 0, "Running quantiles match a sorted window (windows 1..200, q 0..1)");
+
+    wrong = 0;
+    for (uint32_t w = 0; w < sizeof(windows) / sizeof(windows[0]); w++) {
+        running_minmax_init(&rm, windows[w], values, index);
+        for (uint32_t i = 0; i < 2000; i++) {
+            running_minmax_push(&rm, x[i]);
+            float lo = sorted_quantile(x, i + 1, windows[w], 0.0f, scratch);
+            float hi = sorted_quantile(x, i + 1, windows[w], 1.0f, scratch);
+            wrong += running_minmax_min(&rm) != lo || running_minmax_max(&rm) != hi ? 1 : 0;
+        }
+    }
+    check(wrong == 0, "Running min/max match a sorted window");
+
+    // Gaussian noise (sigma 2): median and MAD against a sorted window
+    const uint32_t mad_window = 101;
+    running_mad_init(&mad, mad_window, values, values + RF_MAX_WINDOW);
+    float max_error = 0.0f;
+    for (uint32_t i = 0; i < 3000; i++) {
+        // Quantized so the window holds ties
+        float u1 = ((float)rand() + 1.0f) / ((float)RAND_MAX + 2.0f);
+        float u2 = (float)rand() / (float)RAND_MAX;
+        x[i] = roundf(8.0f * (50.0f + 2.0f * sqrtf(-2.0f * logf(u1)) * cosf(2.0f * (float)M_PI * u2))) / 8.0f;
+        running_mad_push(&mad, x[i]);
+        float median = sorted_quantile(x, i + 1, mad_window, 0.5f, scratch);
+        uint32_t n = i + 1 < mad_window ? i + 1 : mad_window;
+        for (uint32_t k = 0; k < n; k++) {
+            deviation[k] = fabsf(x[i + 1 - n + k] - median);
+        }
+        float mad_ref = sorted_quantile(deviation, n, n, 0.5f, scratch);
+        max_error = fmaxf(max_error, fabsf(running_mad_get(&mad) - mad_ref) +
+                                     fabsf(running_mad_median(&mad) - median));
+    }
+    float sigma = RUNNING_MAD_TO_SIGMA * running_mad_get(&mad);
+    printf("   MAD sigma %.2f (true 2.00)\n", sigma);
+    check(max_error == 0.0f && fabsf(sigma - 2.0f) < 0.8f, "Running median and MAD match the sorted window exactly");
+
+    // RR outlier gate: 5 MAD around the median of the last 15 intervals
+    running_mad_init(&mad, 15, values, values + RF_MAX_WINDOW);
+    uint32_t flagged = 0, ectopic = 0;
+    for (uint32_t i = 0; i < 300; i++) {
+        bool is_ectopic = i > 20 && i % 37 == 0;
+        float rr = 1000.0f + 40.0f * sinf((float)i * 0.3f) + (is_ectopic ? -350.0f : 0.0f);
+        if (i >= 15) {
+            float limit = 5.0f * RUNNING_MAD_TO_SIGMA * running_mad_get(&mad);
+            bool outlier = fabsf(rr - running_mad_median(&mad)) > limit;
+            flagged += outlier ? 1 : 0;
+            ectopic += outlier && is_ectopic ? 1 : 0;
+        }
+        running_mad_push(&mad, rr);
+    }
+    check(flagged == 8 && ectopic == 8, "Median/MAD gate flags exactly the ectopic RR intervals");
+
+    // Baseline wander: a 1.5 s running median follows the drift, not the pulse
+    running_median_init(&rq, 75, values, index);
+    float residual = 0.0f;
+    for (uint32_t i = 0; i < 50 * 60; i++) {
+        float t = (float)i / SAMPLE_RATE_HZ;
+        float drift = 500.0f * sinf(2.0f * (float)M_PI * 0.05f * t);
+        running_quantile_push(&rq, drift + 100.0f * (ppg_sim_generate_heartbeat(t, 1.2f) - 0.7f));
+        if (i >= 50 * 10) {
+            // Median lags half a window
+            float past = (float)(i - 37) / SAMPLE_RATE_HZ;
+            residual = fmaxf(residual, fabsf(running_quantile_get(&rq) -
+                                             500.0f * sinf(2.0f * (float)M_PI * 0.05f * past)));
+        }
+    }
+    printf("   Baseline residual %.1f on 1000 p-p drift\n", residual);
+    check(residual < 100.0f, "Running median removes baseline wander");
+
+    // Perfusion index from one-beat min/max over the DC level
+    running_minmax_init(&rm, SAMPLE_RATE_HZ, values, index);
+    for (uint32_t i = 0; i < 5 * SAMPLE_RATE_HZ; i++) {
+        float t = (float)i / SAMPLE_RATE_HZ;
+        running_minmax_push(&rm, 80000.0f * (1.0f + 0.02f * (ppg_sim_generate_heartbeat(t, 1.0f) - 0.7f)));
+    }
+    float pi = (running_minmax_max(&rm) - running_minmax_min(&rm)) / 80000.0f;
+    printf("   Perfusion index %.4f\n", pi);
+    check(pi > 0.005f && pi < 0.03f, "Perfusion index from running min/max");
+
+    // Benchmark: per-sample cost against sorting the window
+    printf("   window   median   min/max   MAD      sort (ns/sample)\n");
+    for (uint32_t i = 0; i < RF_SAMPLES; i++) {
+        x[i] = (float)rand() / (float)RAND_MAX;
+    }
+    bool log_scaling = true;
+    float median_ns_8 = 0.0f;
+    volatile float sink = 0.0f;
+    for (uint32_t w = 8; w <= RF_MAX_WINDOW; w *= 2) {
+        running_median_init(&rq, w, values, index);
+        clock_t start = clock();
+        for (uint32_t i = 0; i < RF_SAMPLES; i++) {
+            running_quantile_push(&rq, x[i]);
+            sink += running_quantile_get(&rq);
+        }
+        float median_ns = elapsed_ns(start, RF_SAMPLES);
+
+        running_minmax_init(&rm, w, values, index);
+        start = clock();
+        for (uint32_t i = 0; i < RF_SAMPLES; i++) {
+            running_minmax_push(&rm, x[i]);
+            sink += running_minmax_max(&rm) - running_minmax_min(&rm);
+        }
+        float minmax_ns = elapsed_ns(start, RF_SAMPLES);
+
+        running_mad_init(&mad, w, values, values + RF_MAX_WINDOW);
+        start = clock();
+        for (uint32_t i = 0; i < RF_SAMPLES; i++) {
+            running_mad_push(&mad, x[i]);
+            sink += running_mad_get(&mad);
+        }
+        float mad_ns = elapsed_ns(start, RF_SAMPLES);
+
+        const uint32_t sorted = 2000;
+        start = clock();
+        for (uint32_t i = RF_SAMPLES - sorted; i < RF_SAMPLES; i++) {
+            sink += sorted_quantile(x, i + 1, w, 0.5f, scratch);
+        }
+        float sort_ns = elapsed_ns(start, sorted);
+
+        printf("   %6u  %7.1f  %8.1f  %7.1f  %9.0f\n", w, median_ns, minmax_ns, mad_ns, sort_ns);
+        if (w == 8) {
+            median_ns_8 = median_ns;
+        } else if (w == RF_MAX_WINDOW) {
+            // 7 more heap levels than at 8, not 128x the work
+            log_scaling = median_ns < 10.0f * median_ns_8 + 50.0f;
+        }
+    }
+    (void)sink;
+    check(log_scaling, "Running median cost grows with log(window)");
+}
+
+// =============================================================================
+// RR Artifact Correction
+// =============================================================================
+
+#define RR_BEATS  600
+
+typedef struct {
+    float rr[RR_BEATS + 8];           ///< Series as detected
+    uint8_t truth[RR_BEATS + 8];      ///< Injected artifact per detected interval
+    float clean_rmssd;                ///< RMSSD of the series before injection
+    uint32_t count;
+} rr_series_t;
+
+/** Sinus rhythm with respiratory arrhythmia and injected detection errors */
+static void make_rr_series(rr_series_t* s)
+{
+    float clean[RR_BEATS];
+    float sum_sq = 0.0f;
+
+    srand(39);
+    for (uint32_t i = 0; i < RR_BEATS; i++) {
+        clean[i] = 950.0f + 40.0f * sinf(2.0f * (float)M_PI * (float)i / 4.5f) +
+                   60.0f * sinf(2.0f * (float)M_PI * (float)i / 180.0f) +
+                   10.0f * ((float)rand() / RAND_MAX - 0.5f);
+        if (i > 0) {
+            sum_sq += (clean[i] - clean[i - 1]) * (clean[i] - clean[i - 1]);
+        }
+    }
+    s->clean_rmssd = sqrtf(sum_sq / (RR_BEATS - 1));
+
+    s->count = 0;
+    for (uint32_t i = 0; i < RR_BEATS; i++) {
+        uint32_t n = s->count;
+        if (i % 50 == 20 && i + 1 < RR_BEATS) {
+            // Premature beat, compensatory pause
+            s->rr[n] = 0.65f * clean[i];
+            s->rr[n + 1] = clean[i + 1] + 0.35f * clean[i];
+            s->truth[n] = RR_ECTOPIC;
+            s->truth[n + 1] = RR_ECTOPIC;
+            s->count += 2;
+            i++;
+        } else if (i % 50 == 35 && i + 1 < RR_BEATS) {
+            // Missed beat: two intervals detected as one
+            s->rr[n] = clean[i] + clean[i + 1];
+            s->truth[n] = RR_MISSED;
+            s->count += 1;
+            i++;
+        } else if (i % 100 == 45) {
+            // Dicrotic notch taken for a beat
+            s->rr[n] = 0.4f * clean[i];
+            s->rr[n + 1] = 0.6f * clean[i];
+            s->truth[n] = RR_EXTRA;
+            s->truth[n + 1] = RR_EXTRA;
+            s->count += 2;
+        } else {
+            s->rr[n] = clean[i];
+            s->truth[n] = RR_NORMAL;
+            s->count += 1;
+        }
+    }
+}
+
+static void test_rr_artifacts(void)
+{
+    printf("\n💓 RR Artifact Correction\n");
+
+    static rr_series_t series;
+    static rr_artifact_t rr;
+    rr_clean_interval_t out[RR_ARTIFACT_MAX_OUTPUT * 3];
+    make_rr_series(&series);
+
+    rr_artifact_config_t bad = RR_ARTIFACT_DEFAULT_CONFIG;
+    bad.quantile_window = RR_ARTIFACT_MAX_QUANTILE_WINDOW + 1;
+    check(!rr_artifact_init(&rr, &bad) && rr_artifact_init(&rr, NULL),
+          "Oversized quantile window rejected, defaults accepted");
+
+    // Correct mode: every injected artifact found, corrected series keeps beat time
+    uint32_t injected = 0, found = 0, false_alarms = 0;
+    float raw_total = 0.0f, clean_total = 0.0f;
+    float last = 0.0f, diff_sq = 0.0f;
+    uint32_t emitted = 0, diffs = 0;
+    for (uint32_t i = 0; i <= series.count; i++) {
+        uint32_t n = i < series.count ? rr_artifact_push(&rr, series.rr[i], out, 6)
+                                      : rr_artifact_flush(&rr, out, 6);
+        raw_total += i < series.count ? series.rr[i] : 0.0f;
+        for (uint32_t k = 0; k < n; k++) {
+            clean_total += out[k].interval_ms;
+            if (last > 0.0f) {
+                diff_sq += (out[k].interval_ms - last) * (out[k].interval_ms - last);
+                diffs++;
+            }
+            last = out[k].interval_ms;
+            emitted++;
+        }
+    }
+
+    // Classification per detected interval, replayed with flag mode
+    rr_artifact_config_t flag = RR_ARTIFACT_DEFAULT_CONFIG;
+    flag.mode = RR_ARTIFACT_FLAG;
+    rr_artifact_init(&rr, &flag);
+    uint32_t position = 0;
+    for (uint32_t i = 0; i <= series.count; i++) {
+        uint32_t n = i < series.count ? rr_artifact_push(&rr, series.rr[i], out, 6)
+                                      : rr_artifact_flush(&rr, out, 6);
+        for (uint32_t k = 0; k < n; k++, position++) {
+            bool truth = series.truth[position] != RR_NORMAL;
+            bool flagged = out[k].type != RR_NORMAL;
+            injected += truth ? 1 : 0;
+            found += truth && flagged ? 1 : 0;
+            false_alarms += !truth && flagged ? 1 : 0;
+        }
+    }
+
+    float rmssd = sqrtf(diff_sq / (float)diffs);
+    printf("   %u/%u artifact intervals flagged, %u false alarms in %u\n",
+           found, injected, false_alarms, series.count);
+    printf("   RMSSD clean %.1f ms, corrected %.1f ms; %u intervals out for %u in\n",
+           series.clean_rmssd, rmssd, emitted, series.count);
+    check(position == series.count && found == injected && false_alarms <= series.count / 100,
+          "Ectopic, missed and extra beats flagged with <1% false alarms");
+    check(fabsf(rmssd - series.clean_rmssd) < 0.15f * series.clean_rmssd,
+          "RMSSD of the corrected series within 15% of the artifact-free one");
+    check(fabsf(clean_total - raw_total) < 0.02f * raw_total,
+          "Corrected series keeps the recording length");
+
+    // Reports: artifact percentage per window, HRV from clean intervals only
+    const rr_artifact_report_t* report = rr_artifact_get_report(&rr);
+    check(report && rr.reports == series.count / RR_ARTIFACT_DEFAULT_CONFIG.report_beats &&
+          report->artifact_percent > 0.0f && report->artifact_percent < 20.0f && report->valid,
+          "Each 60-beat window reports its artifact percentage");
+
+    // Drop mode: nothing flagged is emitted
+    rr_artifact_config_t drop = RR_ARTIFACT_DEFAULT_CONFIG;
+    drop.mode = RR_ARTIFACT_DROP;
+    rr_artifact_init(&rr, &drop);
+    uint32_t kept = 0;
+    bool only_normal = true;
+    for (uint32_t i = 0; i < series.count; i++) {
+        uint32_t n = rr_artifact_push(&rr, series.rr[i], out, 6);
+        for (uint32_t k = 0; k < n; k++) {
+            only_normal = only_normal && out[k].type == RR_NORMAL;
+        }
+        kept += n;
+    }
+    check(only_normal && kept + injected + 2 >= series.count && kept < series.count,
+          "Drop mode emits normal intervals only");
+
+    // More artifacts than the limit: report not valid for HRV
+    rr_artifact_config_t strict = RR_ARTIFACT_DEFAULT_CONFIG;
+    strict.max_artifact_percent = 5.0f;
+    rr_artifact_init(&rr, &strict);
+    for (uint32_t i = 0; i < 2 * strict.report_beats; i++) {
+        float beat = 900.0f + 30.0f * sinf((float)i);
+        rr_artifact_push(&rr, i % 10 == 5 ? 2.0f * beat : beat, out, 6);
+    }
+    report = rr_artifact_get_report(&rr);
+    printf("   Every 10th beat missed: %.0f%% artifacts\n", report ? report->artifact_percent : 0.0f);
+    check(report && report->artifact_percent > strict.max_artifact_percent && !report->valid,
+          "Window above the artifact limit is not valid for HRV");
+
+    // Stage: fed by the HR node's beat block, gap (interval 0) flushes
+    pipeline_stage_t stage;
+    static rr_artifact_stage_state_t state;
+    pipeline_stage_config_t config = stage_config("rr");
+    check(rr_artifact_stage_bind(&stage, &state, &config), "Artifact stage binds");
+    ppg_beat_t beats[3] = { { .interval_ms = 1000.0f }, { .interval_ms = 980.0f }, { .interval_ms = 1010.0f } };
+    ppg_beat_block_t block = { .beats = beats, .count = 3 };
+    signal_buffer_t input = { .metadata = &block, .sample_rate = SAMPLE_RATE_HZ };
+    signal_buffer_t output = { 0 };
+    stage.ops->process(&stage, &input, &output);
+    const rr_artifact_block_t* published = (const rr_artifact_block_t*)output.metadata;
+    uint32_t first = published ? published->count : 0;
+    beats[0].interval_ms = 0.0f;
+    block.count = 1;
+    stage.ops->process(&stage, &input, &output);
+    check(first == 1 && published->count == 2 && published->intervals[1].interval_ms == 1010.0f,
+          "Stage releases two beats late and flushes at a gap");
+}
+
+// =============================================================================
+// Multi-Channel Pipeline
+// =============================================================================
+
+#define MC_SIGNAL_S     60
+#define MC_SLOTS        0x07      /* Red, IR, Green */
+#define MC_ROWS         3
+
+/** One preprocess/filter/HR chain; channel picks the calibration entry */
+static void mc_bind_chain(pipeline_stage_config_t* configs, ppg_preprocess_stage_t* pre,
+                          ppg_filter_stage_t* filter, ppg_filter_state_t* filter_state,
+                          ppg_feature_stage_t* hr, ppg_feature_state_t* hr_state, uint32_t channel)
+{
+    configs[0] = stage_config("pre");
+    configs[1] = stage_config("filter");
+    configs[2] = stage_config("hr");
+
+    configs[0].parameters[PPG_PREPROCESS_PARAM_CHANNEL] = (float)channel;
+    configs[0].parameter_count = PPG_PREPROCESS_PARAM_COUNT;
+    ppg_preprocess_stage_bind(pre, &configs[0]);
+    pre->params.enable_calibration = true;
+    pre->params.dc_offset[channel] = 1000.0f * (float)(channel + 1);
+    pre->params.gain_correction[channel] = 1.0f + 0.25f * (float)channel;
+    ppg_filter_stage_bind(filter, filter_state, &configs[1]);
+    ppg_feature_stage_bind(hr, hr_state, &configs[2]);
+}
+
+static void test_multichannel(void)
+{
+    printf("\n🌈 Multi-Channel Pipeline (struct of arrays)\n");
+
+    // Three single-channel chains [0..2] and one chain over all rows [3]
+    static ppg_preprocess_stage_t pre[MC_ROWS + 1];
+    static ppg_filter_stage_t filter[MC_ROWS + 1];
+    static ppg_filter_state_t filter_state[MC_ROWS + 1];
+    static ppg_feature_stage_t hr[MC_ROWS + 1];
+    static ppg_feature_state_t hr_state[MC_ROWS + 1];
+    static pipeline_stage_config_t configs[MC_ROWS + 1][3];
+    signal_pipeline_t* pipelines[MC_ROWS + 1];
+
+    for (uint32_t p = 0; p <= MC_ROWS; p++) {
+        mc_bind_chain(configs[p], &pre[p], &filter[p], &filter_state[p], &hr[p], &hr_state[p], p < MC_ROWS ? p : 0);
+        const pipeline_node_desc_t graph[] = {
+            { &pre[p].base,    { PIPELINE_SOURCE_NAME_0 }, false },
+            { &filter[p].base, { "pre" },                  true  },
+            { &hr[p].base,     { "filter" },               true  },
+        };
+        pipelines[p] = p < MC_ROWS
+            ? pipeline_create_graph(PIPELINE_SIGNAL_PPG, graph, 3, BLOCK_SIZE)
+            : pipeline_create_multichannel(PIPELINE_SIGNAL_PPG, graph, 3, BLOCK_SIZE, MC_SLOTS);
+    }
+    signal_pipeline_t* multi = pipelines[MC_ROWS];
+    check(pipelines[0] && pipelines[1] && pipelines[2] && multi, "Single and multi-channel pipelines created");
+    if (!multi || !pipelines[0] || !pipelines[1] || !pipelines[2]) {
+        return;
+    }
+    // Calibration of the combined chain: row r is channel r
+    for (uint32_t r = 0; r < MC_ROWS; r++) {
+        pre[MC_ROWS].params.dc_offset[r] = pre[r].params.dc_offset[r];
+        pre[MC_ROWS].params.gain_correction[r] = pre[r].params.gain_correction[r];
+    }
+    check(multi->channel_count == MC_ROWS && pipeline_channels_from_slots(0x2D) == 4,
+          "Channel count taken from the LED slot mask");
+
+    // Driver samples (array of structs): IR 1.2x red, green with a stronger pulse
+    static ppg_sample_t samples[MC_SIGNAL_S * SAMPLE_RATE_HZ];
+    float xyz[3];
+    srand(40);
+    for (uint32_t i = 0; i < MC_SIGNAL_S * SAMPLE_RATE_HZ; i++) {
+        float t = (float)i / SAMPLE_RATE_HZ;
+        float level = night_sample(NIGHT_CLEAN, t, xyz);
+        samples[i].channels[0] = (int32_t)level;
+        samples[i].channels[1] = (int32_t)(1.2f * level);
+        samples[i].channels[2] = (int32_t)(30000.0f + 2000.0f * ppg_sim_generate_heartbeat(t, 58.0f / 60.0f));
+        samples[i].led_slots = MC_SLOTS;
+    }
+
+    const uint32_t blocks = MC_SIGNAL_S * SAMPLE_RATE_HZ / BLOCK_SIZE;
+    float rows[MC_ROWS][BLOCK_SIZE];
+    uint32_t mismatches = 0;
+    for (uint32_t b = 0; b < blocks; b++) {
+        uint32_t count = pipeline_deinterleave_samples(&samples[b * BLOCK_SIZE], BLOCK_SIZE,
+                                                       MC_SLOTS, &rows[0][0], BLOCK_SIZE);
+        signal_buffer_t input = { .data = &rows[0][0], .length = BLOCK_SIZE, .sample_rate = SAMPLE_RATE_HZ,
+                                  .channels = count, .stride = BLOCK_SIZE };
+        pipeline_process(multi, &input);
+        const signal_buffer_t* out = pipeline_get_node_output(multi, "filter");
+
+        for (uint32_t r = 0; r < MC_ROWS; r++) {
+            signal_buffer_t single = { .data = rows[r], .length = BLOCK_SIZE, .sample_rate = SAMPLE_RATE_HZ };
+            pipeline_process(pipelines[r], &single);
+            const signal_buffer_t* ref = pipeline_get_node_output(pipelines[r], "filter");
+            if (!out || out->channels != MC_ROWS || !ref ||
+                memcmp(SIGNAL_CHANNEL(out, r), ref->data, BLOCK_SIZE * sizeof(float)) != 0) {
+                mismatches++;
+            }
+        }
+    }
+    printf("   %u blocks x %u rows, %u mismatched rows, HR %.1f bpm (row 0)\n",
+           blocks, MC_ROWS, mismatches, hr[MC_ROWS].last_hr_bpm);
+    check(mismatches == 0, "Every row identical to its own single-channel pipeline");
+    check(hr[MC_ROWS].last_hr_bpm == hr[0].last_hr_bpm && fabsf(hr[0].last_hr_bpm - 58.0f) < 3.0f,
+          "HR node runs on row 0");
+
+    // Cost of one pass over all rows against one pipeline per LED
+    static float recording[MC_ROWS][MC_SIGNAL_S * SAMPLE_RATE_HZ];
+    const uint32_t total = MC_SIGNAL_S * SAMPLE_RATE_HZ;
+    pipeline_deinterleave_samples(samples, total, MC_SLOTS, &recording[0][0], total);
+    const uint32_t repeats = 3600 / MC_SIGNAL_S;
+    clock_t start = clock();
+    for (uint32_t k = 0; k < repeats; k++) {
+        for (uint32_t r = 0; r < MC_ROWS; r++) {
+            signal_buffer_t single = { .data = recording[r], .length = total, .sample_rate = SAMPLE_RATE_HZ };
+            pipeline_process(pipelines[r], &single);
+        }
+    }
+    float separate_ns = elapsed_ns(start, repeats * total);
+    start = clock();
+    for (uint32_t k = 0; k < repeats; k++) {
+        signal_buffer_t input = { .data = &recording[0][0], .length = total, .sample_rate = SAMPLE_RATE_HZ,
+                                  .channels = MC_ROWS, .stride = total };
+        pipeline_process(multi, &input);
+    }
+    float multi_ns = elapsed_ns(start, repeats * total);
+    printf("   %u pipelines: %.1f ns per multi-sample, one SoA pipeline: %.1f ns (%.1fx)\n",
+           MC_ROWS, separate_ns, multi_ns, multi_ns > 0.0f ? separate_ns / multi_ns : 0.0f);
+    check(multi->errors == 0, "No pipeline errors");
+
+    // More rows than the pipeline was created for
+    signal_buffer_t wide = { .data = &recording[0][0], .length = BLOCK_SIZE, .sample_rate = SAMPLE_RATE_HZ,
+                             .channels = MC_ROWS + 1, .stride = BLOCK_SIZE };
+    bool multi_refused = !pipeline_process(multi, &wide);
+    wide.channels = 2;
+    check(multi_refused && !pipeline_process(pipelines[0], &wide),
+          "Blocks with more rows than the pipeline are rejected");
+
+    for (uint32_t p = 0; p <= MC_ROWS; p++) {
+        pipeline_destroy(pipelines[p]);
+    }
+
+    // Every other stage kind over all rows: canceller and SQI carry them, the decimator filters each
+    static ppg_preprocess_stage_t all_pre;
+    static ppg_artifact_removal_stage_t artifact;
+    static motion_canceller_t canceller;
+    static ppg_filter_stage_t all_filter;
+    static ppg_filter_state_t all_filter_state;
+    static pipeline_stage_t sqi_stage, dec_stage, spo2_stage, resp_stage;
+    static sqi_state_t sqi;
+    static decimator_t dec, row_dec[MC_ROWS];
+    static ppg_feature_stage_t all_hr;
+    static ppg_feature_state_t all_hr_state;
+    static spo2_estimator_t est;
+    static resp_estimator_t resp;
+    pipeline_stage_config_t all_configs[8];
+    const char* names[8] = { "pre", "artifact", "filter", "sqi", "hr", "spo2", "resp", "decimate" };
+
+    for (uint32_t i = 0; i < 8; i++) {
+        all_configs[i] = stage_config(names[i]);
+    }
+    all_configs[5].parameters[SPO2_PARAM_RED_ROW] = 0.0f;
+    all_configs[5].parameters[SPO2_PARAM_IR_ROW] = 1.0f;
+    all_configs[5].parameter_count = SPO2_PARAM_COUNT;
+    all_configs[6].parameters[RESP_PARAM_ROW] = 1.0f;
+    all_configs[6].parameter_count = RESP_PARAM_COUNT;
+    all_configs[7].parameters[DECIMATOR_PARAM_FACTOR] = 2.0f;
+    all_configs[7].parameter_count = DECIMATOR_PARAM_COUNT;
+    artifact.imu_buffer = NULL;
+    bool bound = ppg_preprocess_stage_bind(&all_pre, &all_configs[0]) &&
+                 motion_canceller_stage_bind(&artifact, &canceller, &all_configs[1]) &&
+                 ppg_filter_stage_bind(&all_filter, &all_filter_state, &all_configs[2]) &&
+                 sqi_stage_bind(&sqi_stage, &sqi, &all_configs[3]) &&
+                 ppg_feature_stage_bind(&all_hr, &all_hr_state, &all_configs[4]) &&
+                 spo2_stage_bind(&spo2_stage, &est, &all_configs[5]) &&
+                 resp_stage_bind(&resp_stage, &resp, &all_configs[6]) &&
+                 decimator_stage_bind(&dec_stage, &dec, &all_configs[7]);
+    const pipeline_node_desc_t all[] = {
+        { &all_pre.base,    { PIPELINE_SOURCE_NAME_0 }, false },
+        { &artifact.base,   { "pre" },                  true  },
+        { &all_filter.base, { "artifact" },             true  },
+        { &sqi_stage,       { "filter", "pre" },        true  },
+        { &all_hr.base,     { "sqi" },                  true  },
+        { &spo2_stage,      { "hr", "pre", "pre" },     true  },
+        { &resp_stage,      { "hr", "pre" },            true  },
+        { &dec_stage,       { "sqi" },                  true  },
+    };
+    signal_pipeline_t* every = bound ? pipeline_create_multichannel(PIPELINE_SIGNAL_PPG, all, 8, BLOCK_SIZE, MC_SLOTS)
+                                     : NULL;
+    uint32_t dropped = 0;
+    uint32_t row_mismatches = 0;
+    for (uint32_t r = 0; r < MC_ROWS; r++) {
+        decimator_init(&row_dec[r], &dec.config);
+    }
+    for (uint32_t b = 0; every && b < blocks; b++) {
+        pipeline_deinterleave_samples(&samples[b * BLOCK_SIZE], BLOCK_SIZE, MC_SLOTS, &rows[0][0], BLOCK_SIZE);
+        signal_buffer_t input = { .data = &rows[0][0], .length = BLOCK_SIZE, .sample_rate = SAMPLE_RATE_HZ,
+                                  .channels = MC_ROWS, .stride = BLOCK_SIZE };
+        pipeline_process(every, &input);
+        const signal_buffer_t* cleaned = pipeline_get_node_output(every, "artifact");
+        const signal_buffer_t* filtered = pipeline_get_node_output(every, "filter");
+        const signal_buffer_t* scored = pipeline_get_node_output(every, "sqi");
+        const signal_buffer_t* decimated = pipeline_get_node_output(every, "decimate");
+        if (!cleaned || !filtered || !scored || !decimated || cleaned->channels != MC_ROWS ||
+            scored->channels != MC_ROWS || decimated->channels != MC_ROWS) {
+            dropped++;
+            continue;
+        }
+        for (uint32_t r = 0; r < MC_ROWS; r++) {
+            float ref[BLOCK_SIZE];
+            uint32_t produced = decimator_process(&row_dec[r], SIGNAL_CHANNEL(scored, r), scored->length, ref);
+            if (memcmp(SIGNAL_CHANNEL(cleaned, r), rows[r], BLOCK_SIZE * sizeof(float)) != 0 ||
+                memcmp(SIGNAL_CHANNEL(scored, r), SIGNAL_CHANNEL(filtered, r), BLOCK_SIZE * sizeof(float)) != 0 ||
+                produced != decimated->length ||
+                memcmp(SIGNAL_CHANNEL(decimated, r), ref, produced * sizeof(float)) != 0) {
+                row_mismatches++;
+            }
+        }
+    }
+    const spo2_result_t* spo2 = spo2_estimator_get_result(&est);
+    printf("   Full graph: %u blocks without all rows, %u mismatched rows, R %.3f (IR = 1.2 x Red)\n",
+           dropped, row_mismatches, spo2->ratio);
+    check(every && dropped == 0 && row_mismatches == 0,
+          "Canceller, SQI and decimator carry every row; each row decimated on its own");
+    check(every && every->errors == 0 && spo2->valid && fabsf(spo2->ratio - 1.0f) < 0.05f,
+          "SpO2 takes Red and IR as rows of one node");
+    pipeline_destroy(every);
+
+    pipeline_stage_t single_row = { .name = "probe", .ops = &probe_ops, .config = { .enabled = true } };
+    const pipeline_node_desc_t unaware[] = {
+        { &all_pre.base, { PIPELINE_SOURCE_NAME_0 }, false },
+        { &single_row,   { "pre" },                  true  },
+    };
+    check(pipeline_create_multichannel(PIPELINE_SIGNAL_PPG, unaware, 2, BLOCK_SIZE, MC_SLOTS) == NULL,
+          "Stage without multichannel support refused by a multi-row pipeline");
+
+    const pipeline_node_desc_t one[] = { { &pre[0].base, { PIPELINE_SOURCE_NAME_0 }, true } };
+    check(pipeline_create_multichannel(PIPELINE_SIGNAL_PPG, one, 1, BLOCK_SIZE, 0x30) == NULL,
+          "Slots beyond the sample channels are refused");
+}
+
+int main(void)
+{
+    printf("🧬 PPG Pipeline Host Test\n");
+    printf("=========================\n");
+
+    test_motion_canceller();
+    test_pipeline_graph();
+    test_spo2();
+    test_respiration();
+    test_signal_quality();
+    test_decimator();
+    test_live_reconfig();
+    test_sleep_checkpoint();
+    test_static_pool();
+#ifdef CONFIG_PIPELINE_PROFILING
+    test_pipeline_profile();
+#endif
+    test_sensor_retune();
+    test_static_pipeline();
+    test_running_filters();
+    test_rr_artifacts();
+    test_multichannel();
+
+    printf("\n📊 Results: %d passed, %d failed\n", tests_passed, tests_failed);
+    return tests_failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,194 @@
+/*
+ * Flash Dump Scanner
+ *
+ * Summarises the sensor blocks in device flash dumps on the host, using
+ * the firmware's own log mount and block parsing over a read-only mmap
+ * of each file (flash_map.h). A file may hold one region or an archive
+ * of regions back to back; each region is mounted as the device would
+ * mount it after a reboot, then its blocks are walked in place.
+ *
+ * Per file: one line per sensor (blocks, samples, data bytes, time span)
+ * plus torn and corrupt record counts; at the end, the scan rate.
+ *
+ * Usage: flash_dump [-r region_bytes] [-n sensor_name]... image...
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "flash_io/flash_map.h"
+#include "flash_io/flash_log.h"
+#include "sensor_store.h"
+
+#define MAX_TYPES               32
+#define MAX_NAMES               32
+
+typedef struct {
+    uint16_t sensor_type;
+    uint64_t blocks;
+    uint64_t samples;
+    uint64_t data_bytes;
+    uint32_t first_ms;
+    uint32_t last_ms;
+} type_summary_t;
+
+typedef struct {
+    type_summary_t types[MAX_TYPES];
+    uint32_t type_count;
+    uint32_t regions;
+    uint32_t unmounted;
+    uint64_t torn;
+    uint64_t corrupt;
+} file_summary_t;
+
+static const char* names[MAX_NAMES] = { "ppg", "imu", "temp", "event", "hr", "hrv", "spo2", "resp" };
+static uint32_t name_count = 8;
+
+// =============================================================================
+// Scan
+// =============================================================================
+
+static type_summary_t* summary_for(file_summary_t* file, uint16_t sensor_type)
+{
+    for (uint32_t i = 0; i < file->type_count; i++) {
+        if (file->types[i].sensor_type == sensor_type) {
+            return &file->types[i];
+        }
+    }
+    if (file->type_count == MAX_TYPES) {
+        return NULL;
+    }
+    type_summary_t* summary = &file->types[file->type_count++];
+    memset(summary, 0, sizeof(type_summary_t));
+    summary->sensor_type = sensor_type;
+    summary->first_ms = UINT32_MAX;
+    return summary;
+}
+
+static void scan_region(const flash_device_t* dev, file_summary_t* file)
+{
+    static sensor_store_t store;
+    flash_log_cursor_t cursor;
+    const sensor_data_header_t* block;
+
+    memset(&store, 0, sizeof(store));
+    if (!sensor_store_open(&store, dev, false)) {
+        file->unmounted++;
+        return;
+    }
+
+    flash_log_cursor_first(&store.log, &cursor);
+    while ((block = sensor_store_next_block(&store, &cursor)) != NULL) {
+        type_summary_t* summary = summary_for(file, block->sensor_type);
+        if (!summary) {
+            continue;
+        }
+        summary->blocks++;
+        summary->samples += block->sample_count;
+        summary->data_bytes += block->data_size;
+        summary->first_ms = block->timestamp_start < summary->first_ms ? block->timestamp_start : summary->first_ms;
+        summary->last_ms = block->timestamp_start > summary->last_ms ? block->timestamp_start : summary->last_ms;
+    }
+    file->regions++;
+    file->torn += store.log.stats.torn_records;
+    file->corrupt += store.log.stats.corrupt_records;
+}
+
+static const char* type_name(uint16_t sensor_type)
+{
+    for (uint32_t i = 0; i < name_count; i++) {
+        if (sensor_store_type_of(names[i]) == sensor_type) {
+            return names[i];
+        }
+    }
+    return NULL;
+}
+
+static void print_summary(const char* path, const file_summary_t* file)
+{
+    printf("%s: %u regions (%u not mountable), %llu torn, %llu corrupt records\n", path, file->regions,
+           file->unmounted, (unsigned long long)file->torn, (unsigned long long)file->corrupt);
+    for (uint32_t i = 0; i < file->type_count; i++) {
+        const type_summary_t* t = &file->types[i];
+        const char* name = type_name(t->sensor_type);
+        char label[16];
+
+        if (!name) {
+            snprintf(label, sizeof(label), "0x%04x", t->sensor_type);
+            name = label;
+        }
+        printf("  %-8s %10llu blocks %12llu samples %12llu bytes  %u..%u ms\n", name,
+               (unsigned long long)t->blocks, (unsigned long long)t->samples,
+               (unsigned long long)t->data_bytes, t->first_ms, t->last_ms);
+    }
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+int main(int argc, char** argv)
+{
+    uint32_t region_size = FLASH_LOG_REGION_BYTES;
+    uint64_t mapped_bytes = 0;
+    int files = 0;
+    int status = 0;
+
+    int arg = 1;
+    for (; arg < argc && argv[arg][0] == '-'; arg++) {
+        if (strcmp(argv[arg], "-r") == 0 && arg + 1 < argc) {
+            region_size = (uint32_t)strtoul(argv[++arg], NULL, 0);
+        } else if (strcmp(argv[arg], "-n") == 0 && arg + 1 < argc && name_count < MAX_NAMES) {
+            names[name_count++] = argv[++arg];
+        } else {
+            break;
+        }
+    }
+    if (arg >= argc || region_size == 0 || region_size % FLASH_SECTOR_SIZE != 0 ||
+        region_size / FLASH_SECTOR_SIZE > FLASH_LOG_MAX_SECTORS) {
+        fprintf(stderr, "Usage: %s [-r region_bytes] [-n sensor_name]... image...\n", argv[0]);
+        fprintf(stderr, "  region_bytes: multiple of %u, at most %u (default)\n",
+                FLASH_SECTOR_SIZE, FLASH_LOG_REGION_BYTES);
+        return 2;
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (; arg < argc; arg++) {
+        static file_summary_t file;
+        flash_map_t map;
+        flash_device_t dev;
+
+        if (!flash_map_open(&map, argv[arg])) {
+            status = 1;
+            continue;
+        }
+
+        // A file shorter than a region is one region of whatever sectors it holds
+        uint32_t size = map.size < region_size ? (uint32_t)map.size - (uint32_t)map.size % FLASH_SECTOR_SIZE
+                                               : region_size;
+        uint32_t count = size ? flash_map_region_count(&map, size) : 0;
+
+        memset(&file, 0, sizeof(file));
+        for (uint32_t r = 0; r < count; r++) {
+            if (flash_map_region(&map, (uint64_t)r * size, size, &dev)) {
+                scan_region(&dev, &file);
+            }
+        }
+        print_summary(argv[arg], &file);
+        mapped_bytes += (uint64_t)count * size;
+        flash_map_close(&map);
+        files++;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("Scanned %d files, %.1f MB in %.3f s (%.0f MB/s)\n", files, (double)mapped_bytes / 1e6, seconds,
+           seconds > 0 ? (double)mapped_bytes / 1e6 / seconds : 0.0);
+    return status;
+}
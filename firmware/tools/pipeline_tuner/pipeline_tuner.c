@@ -0,0 +1,801 @@
+/*
+ * PPG Pipeline Auto-Tuner
+ *
+ * Sweeps PPG stage parameters over a per-sensor corpus and writes the
+ * Pareto-optimal configurations as C (pipeline_tuned_configs.c):
+ *
+ *   pre -> artifact (NLMS, accel reference) -> filter -> hr
+ *
+ * Every (sensor, candidate, recording) triple is one task on a
+ * work-stealing thread pool; each task builds the real pipeline from the
+ * candidate's pipeline_stage_config_t, streams the recording through it in
+ * 0.5 s blocks and accumulates HR error against the reference and thread
+ * CPU time spent in pipeline_process(). Candidates are then ranked per
+ * sensor on (HR error, time per sample).
+ *
+ * The corpus is simulated from a per-sensor optical model (perfusion
+ * depth, noise, motion coupling, ADC quantization) across rest, desk,
+ * walking, running and cold-hands recordings. Recorded data can be added
+ * with --csv SENSOR=path: one sample per line at 50 Hz,
+ * "ppg,ax,ay,az,hr_ref" with accel in g; lines starting with '#' are
+ * skipped.
+ *
+ * Usage: pipeline_tuner [-j threads] [-o output.c] [--csv SENSOR=path]...
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "interfaces/signal_pipeline_interfaces.h"
+#include "ppg_stages.h"
+#include "motion_canceller.h"
+#include "pipeline_pool.h"
+#include "pipeline_tuning.h"
+#include "work_stealing_pool.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define TUNE_RATE_HZ            50
+#define TUNE_BLOCK              25
+#define SEGMENT_SECONDS         120
+#define WARMUP_SECONDS          10      /* Not scored: detector still filling its window */
+#define MISS_PENALTY_BPM        20.0f   /* Error charged for a block without HR */
+#define BALANCED_MARGIN_BPM     1.0f
+#define LOW_POWER_BUDGET_BPM    5.0f
+#define COST_TOLERANCE          0.05f   /* Timing noise: costs this close are equal */
+#define TIMING_PASSES           3       /* Cost is the fastest pass over a recording */
+#define MAX_SENSORS             8
+#define MAX_SEGMENTS            64
+
+// =============================================================================
+// Corpus
+// =============================================================================
+
+typedef struct {
+    const char* name;
+    float dc;                         /* Counts at the photodiode */
+    float pulse_depth;                /* AC/DC at full perfusion */
+    float noise;                      /* White noise, fraction of DC */
+    float motion_coupling;            /* Artifact per g of arm motion, fraction of DC */
+} sensor_model_t;
+
+static const sensor_model_t sensor_models[] = {
+    // Integrated optics, 15-bit: shallow pulse, noisier, tight mechanical coupling
+    { "MAX30101", 40000.0f,  0.010f, 0.0015f, 0.012f },
+    // External LEDs at 50 mA, 19-bit: deep pulse, quiet, more tissue movement
+    { "MAX86141", 150000.0f, 0.020f, 0.0004f, 0.025f },
+};
+
+typedef struct {
+    const char* name;
+    float hr_start_bpm;
+    float hr_end_bpm;
+    float hrv_bpm;                    /* Sinus arrhythmia amplitude */
+    float cadence_hz;                 /* Arm swing (0: still) */
+    float perfusion;                  /* Pulse depth scale */
+} scenario_t;
+
+static const scenario_t scenarios[] = {
+    { "rest", 56.0f,  56.0f,  2.0f, 0.0f, 1.0f  },
+    { "desk", 72.0f,  76.0f,  3.0f, 0.0f, 1.0f  },
+    { "walk", 95.0f,  100.0f, 2.0f, 1.8f, 1.0f  },
+    { "run",  110.0f, 145.0f, 0.0f, 2.6f, 1.0f  },
+    { "cold", 64.0f,  64.0f,  2.0f, 0.0f, 0.25f },
+};
+
+typedef struct {
+    uint32_t sensor;                  /* Index into sensor_names */
+    const char* name;
+    bool recorded;                    /* From --csv rather than simulated */
+    float* ppg;
+    float* accel;                     /* x/y/z interleaved, g */
+    float* hr_ref;
+    uint32_t length;
+} segment_t;
+
+static const char* sensor_names[MAX_SENSORS];
+static uint32_t sensor_count;
+static segment_t segments[MAX_SEGMENTS];
+static uint32_t segment_count;
+static uint32_t rng_state = 36u;
+
+static float uniform(void)
+{
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return (float)(rng_state >> 8) / 16777216.0f;
+}
+
+static uint32_t sensor_index(const char* name)
+{
+    for (uint32_t i = 0; i < sensor_count; i++) {
+        if (strcmp(sensor_names[i], name) == 0) {
+            return i;
+        }
+    }
+    if (sensor_count == MAX_SENSORS) {
+        fprintf(stderr, "Too many sensors\n");
+        exit(1);
+    }
+    sensor_names[sensor_count] = name;
+    return sensor_count++;
+}
+
+static segment_t* new_segment(uint32_t sensor, const char* name, uint32_t length)
+{
+    if (segment_count == MAX_SEGMENTS) {
+        fprintf(stderr, "Too many recordings\n");
+        exit(1);
+    }
+
+    segment_t* seg = &segments[segment_count++];
+    seg->sensor = sensor;
+    seg->name = name;
+    seg->length = length;
+    seg->ppg = malloc(length * sizeof(float));
+    seg->accel = malloc(3 * length * sizeof(float));
+    seg->hr_ref = malloc(length * sizeof(float));
+    if (!seg->ppg || !seg->accel || !seg->hr_ref) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    return seg;
+}
+
+/** Systolic peak and dicrotic wave over one beat, phase in [0, 1) */
+static float pulse_shape(float phase)
+{
+    float s = (phase - 0.15f) / 0.06f;
+    float d = (phase - 0.45f) / 0.08f;
+    return expf(-0.5f * s * s) + 0.35f * expf(-0.5f * d * d);
+}
+
+static void simulate(const sensor_model_t* model, const scenario_t* scenario)
+{
+    uint32_t length = SEGMENT_SECONDS * TUNE_RATE_HZ;
+    segment_t* seg = new_segment(sensor_index(model->name), scenario->name, length);
+    float dt = 1.0f / TUNE_RATE_HZ;
+    float phase = 0.0f;
+
+    for (uint32_t n = 0; n < length; n++) {
+        float t = n * dt;
+        float hr = scenario->hr_start_bpm + (scenario->hr_end_bpm - scenario->hr_start_bpm) * t / SEGMENT_SECONDS +
+                   scenario->hrv_bpm * sinf(2.0f * (float)M_PI * 0.25f * t);
+        phase += hr / 60.0f * dt;
+        phase -= floorf(phase);
+
+        float f = scenario->cadence_hz;
+        float ax = 0.0f, ay = 0.0f, az = 0.0f;
+        if (f > 0.0f) {
+            ax = 0.30f * sinf(2.0f * (float)M_PI * f * t);
+            ay = 0.20f * sinf(2.0f * (float)M_PI * f * t + 0.8f) + 0.10f * sinf(4.0f * (float)M_PI * f * t);
+            az = 0.15f * sinf(4.0f * (float)M_PI * f * t + 0.3f);
+        }
+        seg->accel[3 * n] = ax + 0.002f * (uniform() - 0.5f);
+        seg->accel[3 * n + 1] = ay + 0.002f * (uniform() - 0.5f);
+        seg->accel[3 * n + 2] = 1.0f + az + 0.002f * (uniform() - 0.5f);
+
+        float artifact = model->motion_coupling * (2.5f * ax - 1.5f * ay + 1.0f * az);
+        float breathing = 0.3f * model->pulse_depth * sinf(2.0f * (float)M_PI * 0.25f * t);
+        float pulse = model->pulse_depth * scenario->perfusion * pulse_shape(phase);
+        float noise = model->noise * (uniform() - 0.5f);
+
+        seg->ppg[n] = floorf(model->dc * (1.0f + pulse + breathing + artifact + noise) + 0.5f);
+        seg->hr_ref[n] = hr;
+    }
+}
+
+static bool load_csv(const char* spec)
+{
+    const char* eq = strchr(spec, '=');
+    if (!eq || eq == spec) {
+        return false;
+    }
+
+    size_t name_len = (size_t)(eq - spec);
+    char* sensor = malloc(name_len + 1);
+    memcpy(sensor, spec, name_len);
+    sensor[name_len] = '\0';
+
+    FILE* f = fopen(eq + 1, "r");
+    if (!f) {
+        perror(eq + 1);
+        return false;
+    }
+
+    uint32_t lines = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        lines += line[0] != '#';
+    }
+    rewind(f);
+
+    segment_t* seg = new_segment(sensor_index(sensor), eq + 1, lines);
+    seg->recorded = true;
+    uint32_t n = 0;
+    while (n < lines && fgets(line, sizeof(line), f)) {
+        if (line[0] == '#') {
+            continue;
+        }
+        if (sscanf(line, "%f,%f,%f,%f,%f", &seg->ppg[n], &seg->accel[3 * n], &seg->accel[3 * n + 1],
+                   &seg->accel[3 * n + 2], &seg->hr_ref[n]) == 5) {
+            n++;
+        }
+    }
+    fclose(f);
+
+    seg->length = n;
+    fprintf(stderr, "Loaded %u samples for %s from %s\n", n, sensor, eq + 1);
+    return n >= (WARMUP_SECONDS + 10) * TUNE_RATE_HZ;
+}
+
+// =============================================================================
+// Candidates
+// =============================================================================
+
+typedef struct {
+    pipeline_stage_config_t filter;
+    pipeline_stage_config_t artifact;
+    pipeline_stage_config_t feature;
+} candidate_t;
+
+static const float sweep_low_hz[] = { 0.25f, 0.4f, 0.7f };
+static const float sweep_high_hz[] = { 3.0f, 4.0f, 5.0f };
+static const float sweep_order[] = { 2.0f, 4.0f };
+static const float sweep_taps[] = { 4.0f, 8.0f };
+static const float sweep_step[] = { 0.005f, 0.01f, 0.02f };
+static const float sweep_hysteresis[] = { 0.3f, 0.45f, 0.6f };
+static const float sweep_hr_window[] = { 4.0f, 8.0f };
+
+#define COUNT_OF(a) (sizeof(a) / sizeof((a)[0]))
+
+static candidate_t* candidates;
+static uint32_t candidate_count;
+
+static pipeline_stage_config_t named_config(const char* name)
+{
+    pipeline_stage_config_t config = { .enabled = true, .buffer_size = TUNE_BLOCK };
+    strncpy(config.algorithm_name, name, sizeof(config.algorithm_name) - 1);
+    return config;
+}
+
+static void build_candidates(void)
+{
+    uint32_t artifact_variants = 1 + COUNT_OF(sweep_taps) * COUNT_OF(sweep_step);
+    uint32_t total = COUNT_OF(sweep_low_hz) * COUNT_OF(sweep_high_hz) * COUNT_OF(sweep_order) *
+                     artifact_variants * COUNT_OF(sweep_hysteresis) * COUNT_OF(sweep_hr_window);
+
+    candidates = calloc(total, sizeof(candidate_t));
+    if (!candidates) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+
+    for (uint32_t lo = 0; lo < COUNT_OF(sweep_low_hz); lo++)
+    for (uint32_t hi = 0; hi < COUNT_OF(sweep_high_hz); hi++)
+    for (uint32_t order = 0; order < COUNT_OF(sweep_order); order++)
+    for (uint32_t a = 0; a < artifact_variants; a++)
+    for (uint32_t h = 0; h < COUNT_OF(sweep_hysteresis); h++)
+    for (uint32_t w = 0; w < COUNT_OF(sweep_hr_window); w++) {
+        candidate_t* c = &candidates[candidate_count++];
+
+        c->filter = named_config("filter");
+        c->filter.parameters[PPG_FILTER_PARAM_LOW_HZ] = sweep_low_hz[lo];
+        c->filter.parameters[PPG_FILTER_PARAM_HIGH_HZ] = sweep_high_hz[hi];
+        c->filter.parameters[PPG_FILTER_PARAM_ORDER] = sweep_order[order];
+        c->filter.parameters[PPG_FILTER_PARAM_DC_ALPHA] = 0.99f;
+        c->filter.parameter_count = PPG_FILTER_PARAM_COUNT;
+
+        // Variant 0 bypasses the canceller
+        c->artifact = named_config("artifact");
+        c->artifact.enabled = a > 0;
+        c->artifact.parameters[MOTION_CANCELLER_PARAM_TAPS] =
+            a > 0 ? sweep_taps[(a - 1) / COUNT_OF(sweep_step)] : (float)MOTION_CANCELLER_DEFAULT_CONFIG.taps;
+        c->artifact.parameters[MOTION_CANCELLER_PARAM_STEP_SIZE] =
+            a > 0 ? sweep_step[(a - 1) % COUNT_OF(sweep_step)] : MOTION_CANCELLER_DEFAULT_CONFIG.step_size;
+        c->artifact.parameters[MOTION_CANCELLER_PARAM_MOTION_THRESHOLD] = MOTION_CANCELLER_DEFAULT_CONFIG.motion_threshold;
+        c->artifact.parameters[MOTION_CANCELLER_PARAM_CORRELATION] = MOTION_CANCELLER_DEFAULT_CONFIG.correlation_threshold;
+        c->artifact.parameters[MOTION_CANCELLER_PARAM_HANGOVER] = (float)MOTION_CANCELLER_DEFAULT_CONFIG.hangover_blocks;
+        c->artifact.parameter_count = MOTION_CANCELLER_PARAM_COUNT;
+
+        c->feature = named_config("hr");
+        c->feature.parameters[PPG_FEATURE_PARAM_HYSTERESIS] = sweep_hysteresis[h];
+        c->feature.parameters[PPG_FEATURE_PARAM_MIN_DISTANCE_MS] = 270.0f;
+        c->feature.parameters[PPG_FEATURE_PARAM_HR_WINDOW] = sweep_hr_window[w];
+        c->feature.parameter_count = PPG_FEATURE_PARAM_COUNT;
+    }
+}
+
+// =============================================================================
+// Evaluation
+// =============================================================================
+
+typedef struct {
+    double error_sum;                 /* bpm, misses at MISS_PENALTY_BPM */
+    uint32_t scored;                  /* Blocks after warm-up */
+    uint32_t valid;                   /* Scored blocks with an HR */
+    uint64_t cpu_ns;
+    uint32_t samples;
+    bool failed;
+} task_result_t;
+
+static task_result_t* results;        /* [candidate * segment_count + segment] */
+
+static uint64_t thread_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void evaluate(void* context, uint32_t index, uint32_t worker)
+{
+    (void)context;
+    (void)worker;
+
+    const candidate_t* c = &candidates[index / segment_count];
+    const segment_t* seg = &segments[index % segment_count];
+    task_result_t* r = &results[index];
+
+    ppg_preprocess_stage_t pre;
+    ppg_artifact_removal_stage_t artifact;
+    motion_canceller_t mc;
+    ppg_filter_stage_t filter;
+    ppg_filter_state_t filter_state;
+    ppg_feature_stage_t hr;
+    ppg_feature_state_t hr_state;
+    pipeline_stage_config_t pre_config = named_config("pre");
+
+    if (!ppg_preprocess_stage_bind(&pre, &pre_config) ||
+        !motion_canceller_stage_bind(&artifact, &mc, &c->artifact) ||
+        !ppg_filter_stage_bind(&filter, &filter_state, &c->filter) ||
+        !ppg_feature_stage_bind(&hr, &hr_state, &c->feature)) {
+        r->failed = true;
+        return;
+    }
+
+    const pipeline_node_desc_t graph[] = {
+        { &pre.base,      { PIPELINE_SOURCE_NAME_0 }, false },
+        { &artifact.base, { "pre" },                  false },
+        { &filter.base,   { "artifact" },             false },
+        { &hr.base,       { "filter" },               true  },
+    };
+    signal_pipeline_t* pipeline = pipeline_create_graph(PIPELINE_SIGNAL_PPG, graph, 4, TUNE_BLOCK);
+    if (!pipeline) {
+        r->failed = true;
+        return;
+    }
+
+    signal_buffer_t imu = { .length = TUNE_BLOCK * MOTION_CANCELLER_AXES, .sample_rate = TUNE_RATE_HZ };
+    artifact.imu_buffer = &imu;
+
+    for (uint32_t pass = 0; pass < TIMING_PASSES; pass++) {
+        uint64_t pass_ns = 0;
+
+        if (pass > 0) {
+            pipeline_reset(pipeline);
+        }
+
+        for (uint32_t start = 0; start + TUNE_BLOCK <= seg->length; start += TUNE_BLOCK) {
+            signal_buffer_t input = {
+                .data = &seg->ppg[start],
+                .length = TUNE_BLOCK,
+                .sample_rate = TUNE_RATE_HZ,
+                .timestamp_start = start * 1000u / TUNE_RATE_HZ
+            };
+            imu.data = &seg->accel[MOTION_CANCELLER_AXES * start];
+
+            uint64_t t0 = thread_ns();
+            pipeline_process(pipeline, &input);
+            pass_ns += thread_ns() - t0;
+            if (pass == 0) {
+                r->samples += TUNE_BLOCK;
+            }
+
+            // Accuracy is deterministic; score the first pass only
+            if (pass > 0 || start < WARMUP_SECONDS * TUNE_RATE_HZ) {
+                continue;
+            }
+
+            float reference = seg->hr_ref[start + TUNE_BLOCK - 1];
+            float error = MISS_PENALTY_BPM;
+            if (hr.last_hr_bpm > 0.0f) {
+                error = fminf(fabsf(hr.last_hr_bpm - reference), MISS_PENALTY_BPM);
+                r->valid++;
+            }
+            r->error_sum += error;
+            r->scored++;
+        }
+
+        if (pass == 0 || pass_ns < r->cpu_ns) {
+            r->cpu_ns = pass_ns;
+        }
+    }
+
+    r->failed = pipeline->errors != 0;
+    pipeline_destroy(pipeline);
+}
+
+// =============================================================================
+// Pareto Front
+// =============================================================================
+
+typedef struct {
+    uint32_t candidate;
+    float error_bpm;
+    float coverage;
+    float ns_per_sample;
+    uint32_t use_cases;               /* pipeline_use_case_t flags */
+} score_t;
+
+static int by_cost(const void* a, const void* b)
+{
+    const score_t* x = (const score_t*)a;
+    const score_t* y = (const score_t*)b;
+    if (x->ns_per_sample != y->ns_per_sample) {
+        return x->ns_per_sample < y->ns_per_sample ? -1 : 1;
+    }
+    return x->error_bpm < y->error_bpm ? -1 : (x->error_bpm > y->error_bpm);
+}
+
+/** Score every candidate on one sensor's recordings, keep the front */
+static uint32_t pareto_front(uint32_t sensor, score_t* front)
+{
+    score_t* all = calloc(candidate_count, sizeof(score_t));
+    uint32_t count = 0;
+
+    for (uint32_t c = 0; c < candidate_count; c++) {
+        double error = 0.0;
+        uint64_t ns = 0;
+        uint32_t scored = 0, valid = 0, samples = 0;
+        bool failed = false;
+
+        for (uint32_t s = 0; s < segment_count; s++) {
+            const task_result_t* r = &results[c * segment_count + s];
+            if (segments[s].sensor != sensor) {
+                continue;
+            }
+            error += r->error_sum;
+            scored += r->scored;
+            valid += r->valid;
+            ns += r->cpu_ns;
+            samples += r->samples;
+            failed |= r->failed;
+        }
+        if (failed || scored == 0) {
+            continue;
+        }
+
+        all[count].candidate = c;
+        all[count].error_bpm = (float)(error / scored);
+        all[count].coverage = (float)valid / scored;
+        all[count].ns_per_sample = (float)ns / samples;
+        count++;
+    }
+
+    qsort(all, count, sizeof(score_t), by_cost);
+
+    // Sorted by cost, a point survives only by beating every cheaper one;
+    // points within the timing noise of a cheaper point must beat it too
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        bool dominated = false;
+        for (uint32_t j = 0; j < count && !dominated; j++) {
+            if (j == i) {
+                continue;
+            }
+            bool cheaper = all[j].ns_per_sample <= all[i].ns_per_sample * (1.0f + COST_TOLERANCE);
+            dominated = cheaper && (all[j].error_bpm < all[i].error_bpm ||
+                                    (all[j].error_bpm == all[i].error_bpm && j < i));
+        }
+        if (!dominated) {
+            front[kept++] = all[i];
+        }
+    }
+    free(all);
+
+    if (kept == 0) {
+        return 0;
+    }
+
+    uint32_t best = 0;
+    for (uint32_t i = 1; i < kept; i++) {
+        if (front[i].error_bpm < front[best].error_bpm) {
+            best = i;
+        }
+    }
+    front[best].use_cases |= PIPELINE_USE_ACCURACY;
+
+    for (uint32_t i = 0; i < kept; i++) {
+        if (front[i].error_bpm <= front[best].error_bpm + BALANCED_MARGIN_BPM) {
+            front[i].use_cases |= PIPELINE_USE_BALANCED;
+            break;
+        }
+    }
+
+    uint32_t low_power = best;
+    for (uint32_t i = 0; i < kept; i++) {
+        if (front[i].error_bpm <= LOW_POWER_BUDGET_BPM) {
+            low_power = i;
+            break;
+        }
+    }
+    front[low_power].use_cases |= PIPELINE_USE_LOW_POWER;
+
+    return kept;
+}
+
+// =============================================================================
+// Code Generation
+// =============================================================================
+
+/** Shortest float literal that reads back as the same value */
+static const char* float_literal(float value, char* text, size_t size)
+{
+    snprintf(text, size, "%.6g", value);
+    if (!strpbrk(text, ".e")) {
+        strncat(text, ".0", size - strlen(text) - 1);
+    }
+    strncat(text, "f", size - strlen(text) - 1);
+    return text;
+}
+
+static void emit_config(FILE* out, const char* indent, const pipeline_stage_config_t* config,
+                        const char* const* param_names, uint32_t buffer_size)
+{
+    fprintf(out, "{\n");
+    fprintf(out, "%s    .enabled = %s,\n", indent, config->enabled ? "true" : "false");
+    fprintf(out, "%s    .buffer_size = %u,\n", indent, buffer_size);
+    fprintf(out, "%s    .parameters = {\n", indent);
+    for (uint32_t i = 0; i < config->parameter_count; i++) {
+        char literal[24];
+        fprintf(out, "%s        [%s] = %s,\n", indent, param_names[i],
+                float_literal(config->parameters[i], literal, sizeof(literal)));
+    }
+    fprintf(out, "%s    },\n", indent);
+    fprintf(out, "%s    .parameter_count = %s,\n", indent, param_names[config->parameter_count]);
+    fprintf(out, "%s    .algorithm_name = \"%s\"\n", indent, config->algorithm_name);
+    fprintf(out, "%s}", indent);
+}
+
+static const char* const filter_param_names[] = {
+    "PPG_FILTER_PARAM_LOW_HZ", "PPG_FILTER_PARAM_HIGH_HZ", "PPG_FILTER_PARAM_ORDER",
+    "PPG_FILTER_PARAM_DC_ALPHA", "PPG_FILTER_PARAM_COUNT"
+};
+static const char* const artifact_param_names[] = {
+    "MOTION_CANCELLER_PARAM_TAPS", "MOTION_CANCELLER_PARAM_STEP_SIZE",
+    "MOTION_CANCELLER_PARAM_MOTION_THRESHOLD", "MOTION_CANCELLER_PARAM_CORRELATION",
+    "MOTION_CANCELLER_PARAM_HANGOVER", "MOTION_CANCELLER_PARAM_COUNT"
+};
+static const char* const feature_param_names[] = {
+    "PPG_FEATURE_PARAM_HYSTERESIS", "PPG_FEATURE_PARAM_MIN_DISTANCE_MS",
+    "PPG_FEATURE_PARAM_HR_WINDOW", "PPG_FEATURE_PARAM_COUNT"
+};
+
+static void emit_use_cases(FILE* out, uint32_t use_cases)
+{
+    static const struct { uint32_t flag; const char* name; } names[] = {
+        { PIPELINE_USE_ACCURACY,  "PIPELINE_USE_ACCURACY" },
+        { PIPELINE_USE_BALANCED,  "PIPELINE_USE_BALANCED" },
+        { PIPELINE_USE_LOW_POWER, "PIPELINE_USE_LOW_POWER" },
+    };
+    bool first = true;
+
+    for (uint32_t i = 0; i < COUNT_OF(names); i++) {
+        if (use_cases & names[i].flag) {
+            fprintf(out, "%s%s", first ? "" : " | ", names[i].name);
+            first = false;
+        }
+    }
+    if (first) {
+        fprintf(out, "0");
+    }
+}
+
+static void emit(FILE* out, score_t* const* fronts, const uint32_t* front_sizes)
+{
+    uint32_t simulated = 0, recorded = 0;
+    for (uint32_t s = 0; s < segment_count; s++) {
+        if (segments[s].recorded) {
+            recorded++;
+        } else {
+            simulated++;
+        }
+    }
+
+    fprintf(out, "/*\n");
+    fprintf(out, " * Tuned PPG Stage Configurations\n");
+    fprintf(out, " *\n");
+    fprintf(out, " * GENERATED by tools/pipeline_tuner (make tune) - do not edit.\n");
+    fprintf(out, " *\n");
+    fprintf(out, " * %u configurations per sensor scored on %u simulated and %u recorded\n",
+            candidate_count, simulated, recorded);
+    fprintf(out, " * recordings at %u Hz. Error is mean |HR - reference| per 0.5 s block after\n", TUNE_RATE_HZ);
+    fprintf(out, " * %u s warm-up, a block without HR counting %.0f bpm; cost is host CPU\n",
+            WARMUP_SECONDS, MISS_PENALTY_BPM);
+    fprintf(out, " * time per sample and only ranks the candidates against each other.\n");
+    fprintf(out, " */\n\n");
+    fprintf(out, "#include \"pipeline_tuning.h\"\n");
+    fprintf(out, "#include \"ppg_stages.h\"\n");
+    fprintf(out, "#include \"motion_canceller.h\"\n\n");
+
+    fprintf(out, "const pipeline_tuned_point_t pipeline_tuned_points[] = {\n");
+    for (uint32_t s = 0; s < sensor_count; s++) {
+        for (uint32_t i = 0; i < front_sizes[s]; i++) {
+            const score_t* p = &fronts[s][i];
+            const candidate_t* c = &candidates[p->candidate];
+
+            fprintf(out, "    {\n");
+            fprintf(out, "        .sensor = \"%s\",\n", sensor_names[s]);
+            fprintf(out, "        .use_cases = ");
+            emit_use_cases(out, p->use_cases);
+            fprintf(out, ",\n");
+            fprintf(out, "        .hr_error_bpm = %.3ff,\n", p->error_bpm);
+            fprintf(out, "        .coverage = %.3ff,\n", p->coverage);
+            fprintf(out, "        .cost_ns_per_sample = %.1ff,\n", p->ns_per_sample);
+            fprintf(out, "        .filter = ");
+            emit_config(out, "        ", &c->filter, filter_param_names, PIPELINE_DEFAULT_BLOCK_SIZE);
+            fprintf(out, ",\n        .artifact = ");
+            emit_config(out, "        ", &c->artifact, artifact_param_names, PIPELINE_DEFAULT_BLOCK_SIZE);
+            fprintf(out, ",\n        .feature = ");
+            emit_config(out, "        ", &c->feature, feature_param_names, PIPELINE_DEFAULT_BLOCK_SIZE);
+            fprintf(out, "\n    },\n");
+        }
+    }
+    fprintf(out, "};\n\n");
+    fprintf(out, "const uint32_t pipeline_tuned_point_count =\n");
+    fprintf(out, "    sizeof(pipeline_tuned_points) / sizeof(pipeline_tuned_points[0]);\n");
+
+    // Balanced point of each modelled sensor as the named constants
+    for (uint32_t m = 0; m < COUNT_OF(sensor_models); m++) {
+        uint32_t s = sensor_index(sensor_models[m].name);
+        const score_t* balanced = NULL;
+        for (uint32_t i = 0; i < front_sizes[s]; i++) {
+            if (fronts[s][i].use_cases & PIPELINE_USE_BALANCED) {
+                balanced = &fronts[s][i];
+            }
+        }
+        if (!balanced) {
+            continue;
+        }
+
+        const candidate_t* c = &candidates[balanced->candidate];
+        const char* name = sensor_models[m].name;
+        pipeline_stage_config_t pre = named_config("pre");
+        static const char* const pre_param_names[] = {
+            "PPG_PREPROCESS_PARAM_CHANNEL", "PPG_PREPROCESS_PARAM_SCALE", "PPG_PREPROCESS_PARAM_COUNT"
+        };
+        pre.parameters[PPG_PREPROCESS_PARAM_SCALE] = 1.0f;
+        pre.parameter_count = PPG_PREPROCESS_PARAM_COUNT;
+
+        fprintf(out, "\n// %s balanced: %.2f bpm, %.0f%% coverage\n", name, balanced->error_bpm,
+                100.0f * balanced->coverage);
+        fprintf(out, "const pipeline_stage_config_t PPG_%s_PREPROCESS_CONFIG = ", name);
+        emit_config(out, "", &pre, pre_param_names, PIPELINE_DEFAULT_BLOCK_SIZE);
+        fprintf(out, ";\n\nconst pipeline_stage_config_t PPG_%s_FILTER_CONFIG = ", name);
+        emit_config(out, "", &c->filter, filter_param_names, PIPELINE_DEFAULT_BLOCK_SIZE);
+        fprintf(out, ";\n\nconst pipeline_stage_config_t PPG_%s_ARTIFACT_CONFIG = ", name);
+        emit_config(out, "", &c->artifact, artifact_param_names, PIPELINE_DEFAULT_BLOCK_SIZE);
+        fprintf(out, ";\n\nconst pipeline_stage_config_t PPG_%s_FEATURE_CONFIG = ", name);
+        emit_config(out, "", &c->feature, feature_param_names, PIPELINE_DEFAULT_BLOCK_SIZE);
+        fprintf(out, ";\n");
+    }
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+int main(int argc, char** argv)
+{
+    uint32_t workers = 0;
+    const char* output_path = NULL;
+
+    // Modelled sensors keep their indices so the named constants line up
+    for (uint32_t m = 0; m < COUNT_OF(sensor_models); m++) {
+        sensor_index(sensor_models[m].name);
+    }
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            workers = (uint32_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output_path = argv[++i];
+        } else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+            if (!load_csv(argv[++i])) {
+                fprintf(stderr, "Cannot use recording %s\n", argv[i]);
+                return 1;
+            }
+        } else {
+            fprintf(stderr, "Usage: %s [-j threads] [-o output.c] [--csv SENSOR=path]...\n", argv[0]);
+            return 1;
+        }
+    }
+
+    for (uint32_t m = 0; m < COUNT_OF(sensor_models); m++) {
+        for (uint32_t s = 0; s < COUNT_OF(scenarios); s++) {
+            simulate(&sensor_models[m], &scenarios[s]);
+        }
+    }
+    build_candidates();
+
+    // Every worker holds one pipeline at a time
+    if (workers == 0 || workers > PIPELINE_POOL_SLOTS) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        workers = workers ? workers : (cpus > 0 ? (uint32_t)cpus : 1);
+        if (workers > PIPELINE_POOL_SLOTS) {
+            workers = PIPELINE_POOL_SLOTS;
+        }
+    }
+
+    uint32_t tasks = candidate_count * segment_count;
+    results = calloc(tasks, sizeof(task_result_t));
+    if (!results) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    fprintf(stderr, "Sweeping %u configurations x %u recordings on %u threads...\n",
+            candidate_count, segment_count, workers);
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    ws_stats_t stats;
+    if (!ws_pool_run(workers, tasks, evaluate, NULL, &stats)) {
+        fprintf(stderr, "Could not start worker threads\n");
+        return 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    fprintf(stderr, "%u tasks in %.1f s, %u stolen\n", stats.tasks,
+            (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9, stats.steals);
+
+    score_t* fronts[MAX_SENSORS];
+    uint32_t front_sizes[MAX_SENSORS];
+    for (uint32_t s = 0; s < sensor_count; s++) {
+        fronts[s] = calloc(candidate_count, sizeof(score_t));
+        front_sizes[s] = pareto_front(s, fronts[s]);
+
+        fprintf(stderr, "\n%s: %u Pareto-optimal of %u\n", sensor_names[s], front_sizes[s], candidate_count);
+        fprintf(stderr, "  %8s %8s %8s  %-24s %-14s %s\n", "ns/smp", "err bpm", "cover", "filter", "nlms", "beats");
+        for (uint32_t i = 0; i < front_sizes[s]; i++) {
+            const score_t* p = &fronts[s][i];
+            const candidate_t* c = &candidates[p->candidate];
+            char filter[32], nlms[24];
+            snprintf(filter, sizeof(filter), "%.1f-%.1f Hz order %.0f",
+                     c->filter.parameters[PPG_FILTER_PARAM_LOW_HZ], c->filter.parameters[PPG_FILTER_PARAM_HIGH_HZ],
+                     c->filter.parameters[PPG_FILTER_PARAM_ORDER]);
+            if (c->artifact.enabled) {
+                snprintf(nlms, sizeof(nlms), "%.0f taps mu %.3f", c->artifact.parameters[MOTION_CANCELLER_PARAM_TAPS],
+                         c->artifact.parameters[MOTION_CANCELLER_PARAM_STEP_SIZE]);
+            } else {
+                snprintf(nlms, sizeof(nlms), "off");
+            }
+            fprintf(stderr, "  %8.1f %8.2f %7.0f%%  %-24s %-14s h %.2f w %.0f %s%s%s\n",
+                    p->ns_per_sample, p->error_bpm, 100.0f * p->coverage, filter, nlms,
+                    c->feature.parameters[PPG_FEATURE_PARAM_HYSTERESIS],
+                    c->feature.parameters[PPG_FEATURE_PARAM_HR_WINDOW],
+                    (p->use_cases & PIPELINE_USE_ACCURACY) ? " [accuracy]" : "",
+                    (p->use_cases & PIPELINE_USE_BALANCED) ? " [balanced]" : "",
+                    (p->use_cases & PIPELINE_USE_LOW_POWER) ? " [low_power]" : "");
+        }
+    }
+
+    FILE* out = output_path ? fopen(output_path, "w") : stdout;
+    if (!out) {
+        perror(output_path);
+        return 1;
+    }
+    emit(out, fronts, front_sizes);
+    if (output_path) {
+        fclose(out);
+        fprintf(stderr, "\nWrote %s\n", output_path);
+    }
+
+    return 0;
+}
@@ -0,0 +1,168 @@
+/*
+ * Work-Stealing Thread Pool
+ *
+ * Each deque is a slice of one shared index array guarded by its own
+ * mutex; the owner takes from the tail and thieves from the head, so the
+ * two only contend on the last task of a deque. Tasks never spawn tasks,
+ * so a worker that finds every deque empty can exit.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "work_stealing_pool.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+typedef struct {
+    pthread_mutex_t lock;
+    uint32_t* items;
+    uint32_t head;                    /* Next task to steal */
+    uint32_t tail;                    /* One past the next task to pop */
+} ws_deque_t;
+
+typedef struct {
+    ws_deque_t* deques;
+    uint32_t workers;
+    ws_task_fn task;
+    void* context;
+    pthread_mutex_t stats_lock;
+    uint32_t steals;
+} ws_pool_t;
+
+typedef struct {
+    ws_pool_t* pool;
+    uint32_t id;
+} ws_worker_t;
+
+/* ==== PRIVATE FUNCTIONS ==== */
+
+static bool pop_back(ws_deque_t* deque, uint32_t* index)
+{
+    bool found = false;
+
+    pthread_mutex_lock(&deque->lock);
+    if (deque->tail > deque->head) {
+        *index = deque->items[--deque->tail];
+        found = true;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return found;
+}
+
+static bool steal_front(ws_deque_t* deque, uint32_t* index)
+{
+    bool found = false;
+
+    pthread_mutex_lock(&deque->lock);
+    if (deque->tail > deque->head) {
+        *index = deque->items[deque->head++];
+        found = true;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return found;
+}
+
+static void* worker_main(void* arg)
+{
+    ws_worker_t* worker = (ws_worker_t*)arg;
+    ws_pool_t* pool = worker->pool;
+    uint32_t stolen = 0;
+    uint32_t index;
+
+    for (;;) {
+        if (pop_back(&pool->deques[worker->id], &index)) {
+            pool->task(pool->context, index, worker->id);
+            continue;
+        }
+
+        // Own deque drained: sweep the others starting from the next worker
+        bool found = false;
+        for (uint32_t k = 1; k < pool->workers && !found; k++) {
+            found = steal_front(&pool->deques[(worker->id + k) % pool->workers], &index);
+        }
+        if (!found) {
+            break;
+        }
+        pool->task(pool->context, index, worker->id);
+        stolen++;
+    }
+
+    pthread_mutex_lock(&pool->stats_lock);
+    pool->steals += stolen;
+    pthread_mutex_unlock(&pool->stats_lock);
+    return NULL;
+}
+
+/* ==== PUBLIC FUNCTIONS ==== */
+
+bool ws_pool_run(uint32_t workers, uint32_t count, ws_task_fn task, void* context, ws_stats_t* stats)
+{
+    if (!task) {
+        return false;
+    }
+
+    if (workers == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        workers = cpus > 0 ? (uint32_t)cpus : 1;
+    }
+    if (workers > count && count > 0) {
+        workers = count;
+    }
+
+    ws_pool_t pool = { .workers = workers, .task = task, .context = context };
+    uint32_t* items = malloc((count ? count : 1) * sizeof(uint32_t));
+    pool.deques = calloc(workers, sizeof(ws_deque_t));
+    pthread_t* threads = calloc(workers, sizeof(pthread_t));
+    ws_worker_t* args = calloc(workers, sizeof(ws_worker_t));
+    bool ok = items && pool.deques && threads && args;
+
+    if (ok) {
+        pthread_mutex_init(&pool.stats_lock, NULL);
+
+        // Deal round-robin, stored contiguously per worker
+        uint32_t pos = 0;
+        for (uint32_t w = 0; w < workers; w++) {
+            ws_deque_t* deque = &pool.deques[w];
+            pthread_mutex_init(&deque->lock, NULL);
+            deque->items = &items[pos];
+            deque->head = 0;
+            for (uint32_t i = w; i < count; i += workers) {
+                deque->items[deque->tail++] = i;
+            }
+            pos += deque->tail;
+        }
+
+        // Started threads steal from every deque, so a partial start still finishes
+        uint32_t started = 0;
+        while (started < workers) {
+            args[started].pool = &pool;
+            args[started].id = started;
+            if (pthread_create(&threads[started], NULL, worker_main, &args[started]) != 0) {
+                break;
+            }
+            started++;
+        }
+        for (uint32_t w = 0; w < started; w++) {
+            pthread_join(threads[w], NULL);
+        }
+        ok = started > 0;
+
+        for (uint32_t w = 0; w < workers; w++) {
+            pthread_mutex_destroy(&pool.deques[w].lock);
+        }
+        pthread_mutex_destroy(&pool.stats_lock);
+    }
+
+    if (stats) {
+        stats->workers = workers;
+        stats->tasks = count;
+        stats->steals = pool.steals;
+    }
+
+    free(args);
+    free(threads);
+    free(pool.deques);
+    free(items);
+    return ok;
+}
@@ -0,0 +1,44 @@
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @file work_stealing_pool.h
+ * @brief Fixed thread pool with per-worker deques and work stealing
+ *
+ * Tasks are indices 0..count-1 dealt round-robin onto one deque per
+ * worker. A worker pops from the back of its own deque (the tasks it was
+ * given last, still warm in its cache) and, once empty, steals from the
+ * front of the other deques, so uneven task costs (a 4th-order filter with
+ * the canceller on vs. a bare 2nd-order chain) do not leave cores idle at
+ * the end of a sweep.
+ */
+
+/**
+ * @brief Task body; must only write state owned by its index
+ */
+typedef void (*ws_task_fn)(void* context, uint32_t index, uint32_t worker);
+
+/**
+ * @brief Per-run statistics
+ */
+typedef struct {
+    uint32_t workers;                 ///< Threads used
+    uint32_t tasks;                   ///< Tasks run
+    uint32_t steals;                  ///< Tasks run by a worker other than the one dealt
+} ws_stats_t;
+
+/**
+ * @brief Run count tasks on a pool of threads and wait for all of them
+ * @param workers Thread count (0: one per online CPU)
+ * @param count Number of tasks
+ * @param task Task body
+ * @param context Passed to every task
+ * @param stats Optional statistics
+ * @return false if the threads could not be started
+ */
+bool ws_pool_run(uint32_t workers, uint32_t count, ws_task_fn task, void* context, ws_stats_t* stats);
+
+#endif // WORK_STEALING_POOL_H